@@ -0,0 +1,74 @@
+#define LOG_MODULE LogModule::Threads // 本文件的日志属于线程模块 (见 log.h)
+#include "cancellation.h"
+#include "log.h"
+#include "utils.h" // For Utf8ToWide
+
+#include <algorithm>
+
+void CancellationRegistration::Unregister() noexcept {
+    if (!m_state) {
+        return;
+    }
+    CancellationDetail::State& state = *m_state;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    auto it = std::find_if(state.callbacks.begin(), state.callbacks.end(),
+        [this](const std::pair<unsigned long long, std::function<void()>>& entry) { return entry.first == m_id; });
+    if (it != state.callbacks.end()) {
+        state.callbacks.erase(it);
+    }
+    else if (state.runningId == m_id && state.cancellingThread != std::this_thread::get_id()) {
+        // 回调正在其他线程上执行：等它结束后调用方才能安全地销毁回调引用的对象
+        // (在回调内部注销自己时不等待，否则会死锁)
+        state.callbackFinished.wait(lock, [&state, this] { return state.runningId != m_id; });
+    }
+    lock.unlock();
+    m_state.reset();
+    m_id = 0;
+}
+
+CancellationRegistration CancellationToken::Register(std::function<void()> callback) const {
+    if (!m_state) {
+        return CancellationRegistration();
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (!m_state->cancelled.load()) {
+            unsigned long long id = m_state->nextId++;
+            m_state->callbacks.emplace_back(id, std::move(callback));
+            return CancellationRegistration(m_state, id);
+        }
+    }
+    callback(); // 已经取消
+    return CancellationRegistration();
+}
+
+void CancellationSource::Cancel() {
+    CancellationDetail::State& state = *m_state;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    if (state.cancelled.load()) {
+        return;
+    }
+    state.cancelled.store(true, std::memory_order_release);
+    state.cancellingThread = std::this_thread::get_id();
+
+    // 回调可能注销其他回调，因此每次只取出一个，并在锁外执行
+    while (!state.callbacks.empty()) {
+        std::pair<unsigned long long, std::function<void()>> entry = std::move(state.callbacks.back());
+        state.callbacks.pop_back();
+        state.runningId = entry.first;
+        lock.unlock();
+        try {
+            entry.second();
+        }
+        catch (const std::exception& e) {
+            LOG_WARNING(L"Exception in cancellation callback: ", Utf8ToWide(e.what()).c_str());
+        }
+        catch (...) {
+            LOG_WARNING(L"Unknown exception in cancellation callback.");
+        }
+        lock.lock();
+        state.runningId = 0;
+        state.callbackFinished.notify_all();
+    }
+    state.cancellingThread = std::thread::id();
+}
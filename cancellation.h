@@ -0,0 +1,125 @@
+#ifndef CANCELLATION_H
+#define CANCELLATION_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional> // For std::function
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 协作式取消：
+// CancellationSource 发出取消请求，CancellationToken 交给任务观察。取消只设置一个标志，
+// 任务在合适的位置检查 IsCancellationRequested，或注册回调来打断阻塞操作 (例如关闭等待中的套接字)。
+// 默认构造的令牌永远不会被取消，可以作为 "不可取消" 的默认参数。
+
+// 操作因取消而没有完成 (例如线程池关闭时丢弃的任务，其 future 抛出此异常)
+class OperationCanceledError : public std::runtime_error {
+public:
+    OperationCanceledError() : std::runtime_error("Operation canceled") {}
+};
+
+namespace CancellationDetail {
+
+    struct State {
+        std::atomic<bool> cancelled{ false };
+        std::mutex mutex;
+        std::condition_variable callbackFinished;
+        std::vector<std::pair<unsigned long long, std::function<void()>>> callbacks;
+        unsigned long long nextId = 1;
+        unsigned long long runningId = 0;     // 正在执行的回调 (0 表示没有)
+        std::thread::id cancellingThread;     // 正在执行回调的线程
+    };
+
+} // namespace CancellationDetail
+
+// Register 返回的注册句柄，析构时注销回调
+class CancellationRegistration {
+public:
+    CancellationRegistration() noexcept = default;
+    CancellationRegistration(CancellationRegistration&& other) noexcept
+        : m_state(std::move(other.m_state)), m_id(std::exchange(other.m_id, 0)) {}
+    CancellationRegistration& operator=(CancellationRegistration&& other) noexcept {
+        if (this != &other) {
+            Unregister();
+            m_state = std::move(other.m_state);
+            m_id = std::exchange(other.m_id, 0);
+        }
+        return *this;
+    }
+    CancellationRegistration(const CancellationRegistration&) = delete;
+    CancellationRegistration& operator=(const CancellationRegistration&) = delete;
+    ~CancellationRegistration() { Unregister(); }
+
+    /**
+     * @brief 注销回调。回调正在其他线程上执行时等待它结束，返回后回调不会再被调用。
+     */
+    void Unregister() noexcept;
+
+private:
+    friend class CancellationToken;
+    CancellationRegistration(std::shared_ptr<CancellationDetail::State> state, unsigned long long id)
+        : m_state(std::move(state)), m_id(id) {}
+
+    std::shared_ptr<CancellationDetail::State> m_state;
+    unsigned long long m_id = 0;
+};
+
+class CancellationToken {
+public:
+    CancellationToken() noexcept = default;
+
+    /**
+     * @brief 是否已请求取消 (不加锁，可以在循环中频繁调用)。
+     */
+    bool IsCancellationRequested() const noexcept {
+        return m_state && m_state->cancelled.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 令牌是否关联了 CancellationSource (默认构造的令牌返回 false)。
+     */
+    bool CanBeCanceled() const noexcept { return static_cast<bool>(m_state); }
+
+    /**
+     * @brief 已请求取消时抛出 OperationCanceledError。
+     */
+    void ThrowIfCancellationRequested() const {
+        if (IsCancellationRequested()) throw OperationCanceledError();
+    }
+
+    /**
+     * @brief 注册取消时执行的回调 (在调用 Cancel 的线程上执行)；已经取消时在当前线程上立即执行。
+     * @param callback 回调，应当很轻且不抛出异常。
+     * @return 注册句柄，销毁时注销回调。
+     */
+    CancellationRegistration Register(std::function<void()> callback) const;
+
+private:
+    friend class CancellationSource;
+    explicit CancellationToken(std::shared_ptr<CancellationDetail::State> state) noexcept : m_state(std::move(state)) {}
+
+    std::shared_ptr<CancellationDetail::State> m_state;
+};
+
+class CancellationSource {
+public:
+    CancellationSource() : m_state(std::make_shared<CancellationDetail::State>()) {}
+
+    CancellationToken GetToken() const { return CancellationToken(m_state); }
+
+    bool IsCancellationRequested() const noexcept { return m_state->cancelled.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 请求取消并在当前线程上依次执行已注册的回调 (重复调用无效果)。
+     */
+    void Cancel();
+
+private:
+    std::shared_ptr<CancellationDetail::State> m_state;
+};
+
+#endif // CANCELLATION_H
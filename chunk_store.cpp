@@ -0,0 +1,467 @@
+#define LOG_MODULE LogModule::Network // 本文件的日志属于网络模块 (见 log.h)
+#include "chunk_store.h"
+#include "threads.h"
+#include "task_group.h"
+#include "parallel.h"
+#include "network.h"
+#include "log.h"
+#include "utils.h"
+
+#include <array>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace Chunking {
+
+    // Gear 哈希表：由固定种子的 splitmix64 生成，发布端和客户端必须完全一致
+    static constexpr std::array<unsigned long long, 256> MakeGearTable() {
+        std::array<unsigned long long, 256> table{};
+        unsigned long long state = 0x6E657773666F7268ULL; // "newsforh"
+        for (size_t i = 0; i < table.size(); ++i) {
+            state += 0x9E3779B97F4A7C15ULL;
+            unsigned long long z = state;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            table[i] = z ^ (z >> 31);
+        }
+        return table;
+    }
+
+    static constexpr std::array<unsigned long long, 256> kGearTable = MakeGearTable();
+
+    // 查找下一个块边界，返回块长度
+    static size_t FindChunkBoundary(const unsigned char* data, size_t size) {
+        if (size <= kMinChunkSize) {
+            return size;
+        }
+        size_t limit = size < kMaxChunkSize ? size : kMaxChunkSize;
+        unsigned long long hash = 0;
+        for (size_t i = 0; i < limit; ++i) {
+            hash = (hash << 1) + kGearTable[data[i]];
+            // 高位依赖最近 64 个字节，用它们判断边界比低位更稳定
+            if (i + 1 >= kMinChunkSize && (hash & kChunkBoundaryMask) == 0) {
+                return i + 1;
+            }
+        }
+        return limit;
+    }
+
+    std::vector<ChunkInfo> ComputeChunks(const unsigned char* data, size_t size, ThreadPool* pool) {
+        std::vector<ChunkInfo> chunks;
+        size_t pos = 0;
+        while (pos < size) {
+            size_t len = FindChunkBoundary(data + pos, size - pos);
+            chunks.push_back({ std::string(), pos, len });
+            pos += len;
+        }
+
+        // 哈希比查找边界慢得多，且各块互不相关
+        auto hashChunk = [&chunks, data](size_t i) {
+            chunks[i].hash = Sha256Hex(data + static_cast<size_t>(chunks[i].offset), chunks[i].size);
+        };
+        if (pool) {
+            Parallel::For(*pool, static_cast<size_t>(0), chunks.size(), hashChunk);
+        }
+        else {
+            for (size_t i = 0; i < chunks.size(); ++i) {
+                hashChunk(i);
+            }
+        }
+        return chunks;
+    }
+
+    // 块哈希直接用作块库中的文件名：只接受 64 个小写十六进制字符，防止索引中的 ..\ 之类的路径
+    static bool IsChunkHash(const std::string& hash) {
+        if (hash.size() != 64) {
+            return false;
+        }
+        for (char c : hash) {
+            if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool ParseChunkIndex(const std::string& text, ChunkIndex& outIndex) {
+        outIndex = ChunkIndex();
+        bool haveSize = false;
+        unsigned long long expectedOffset = 0;
+
+        std::istringstream stream(text);
+        std::string line;
+        while (std::getline(stream, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            std::istringstream lineStream(line);
+            std::string first;
+            lineStream >> first;
+            if (first == "size") {
+                haveSize = static_cast<bool>(lineStream >> outIndex.totalSize);
+            }
+            else if (first == "sha256") {
+                lineStream >> outIndex.packageHash;
+            }
+            else {
+                ChunkInfo chunk;
+                chunk.hash = first;
+                if (!(lineStream >> chunk.offset >> chunk.size) || !IsChunkHash(chunk.hash) ||
+                    chunk.size == 0 || chunk.size > kMaxChunkSize) {
+                    LOG_WARNING(L"Malformed chunk index line: ", Utf8ToWide(line).c_str());
+                    return false;
+                }
+                if (chunk.offset != expectedOffset) {
+                    LOG_WARNING(L"Chunk index is not contiguous at offset ", chunk.offset, L", expected ", expectedOffset);
+                    return false;
+                }
+                expectedOffset += chunk.size;
+                outIndex.chunks.push_back(chunk);
+            }
+        }
+
+        if (!haveSize || expectedOffset != outIndex.totalSize) {
+            LOG_WARNING(L"Chunk index size mismatch. Declared: ", outIndex.totalSize, L", chunks cover: ", expectedOffset);
+            return false;
+        }
+        return true;
+    }
+
+    std::string SerializeChunkIndex(const ChunkIndex& index) {
+        std::ostringstream out;
+        out << "size " << index.totalSize << "\n";
+        if (!index.packageHash.empty()) {
+            out << "sha256 " << index.packageHash << "\n";
+        }
+        for (const ChunkInfo& chunk : index.chunks) {
+            out << chunk.hash << " " << chunk.offset << " " << chunk.size << "\n";
+        }
+        return out.str();
+    }
+
+
+    ChunkStore::ChunkStore(const std::wstring& rootDir) : m_rootDir(rootDir) {
+        if (!DirectoryExists(m_rootDir) && !CreateDirectoryRecursive(m_rootDir)) {
+            LOG_WARNING(L"Failed to create chunk store directory: ", m_rootDir.c_str());
+        }
+    }
+
+    std::wstring ChunkStore::GetChunkPath(const std::string& hash) const {
+        if (!IsChunkHash(hash)) {
+            // 调用方应只传入 ParseChunkIndex 校验过的哈希；返回空路径使后续的文件操作全部失败
+            LOG_WARNING(L"Invalid chunk hash rejected: ", Utf8ToWide(hash).c_str());
+            return std::wstring();
+        }
+        std::wstring wideHash = Utf8ToWide(hash);
+        return m_rootDir + L"\\" + wideHash.substr(0, 2) + L"\\" + wideHash;
+    }
+
+    bool ChunkStore::Contains(const std::string& hash) const {
+        std::wstring path = GetChunkPath(hash);
+        return !path.empty() && FileExists(path);
+    }
+
+    bool ChunkStore::Read(const std::string& hash, std::string& outData) const {
+        std::wstring path = GetChunkPath(hash);
+        if (path.empty() || !ReadFileToString(path, outData)) {
+            return false;
+        }
+        if (Sha256Hex(outData.data(), outData.size()) != hash) {
+            LOG_WARNING(L"Corrupted chunk removed from store: ", path.c_str());
+            DeleteFileW(path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    bool ChunkStore::Write(const std::string& hash, const char* data, size_t size) {
+        if (Sha256Hex(data, size) != hash) {
+            LOG_WARNING(L"Chunk content does not match its hash: ", Utf8ToWide(hash).c_str());
+            return false;
+        }
+
+        std::wstring path = GetChunkPath(hash);
+        if (path.empty()) {
+            return false;
+        }
+        if (FileExists(path)) {
+            return true;
+        }
+
+        std::wstring dir = path.substr(0, path.find_last_of(L'\\'));
+        if (!DirectoryExists(dir) && !CreateDirectoryRecursive(dir)) {
+            LOG_ERROR(L"Failed to create chunk directory: ", dir.c_str());
+            return false;
+        }
+
+        // 先写临时文件再重命名，避免并发写入或中断时留下半个块
+        std::wstring tempPath = path + L".tmp" + std::to_wstring(GetCurrentThreadId());
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                LOG_ERROR(L"Failed to open chunk file for writing: ", tempPath.c_str());
+                return false;
+            }
+            out.write(data, size);
+            if (out.fail()) {
+                out.close();
+                DeleteFileW(tempPath.c_str());
+                LOG_ERROR(L"Failed to write chunk file: ", tempPath.c_str());
+                return false;
+            }
+        }
+
+        if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            DWORD error = GetLastError();
+            DeleteFileW(tempPath.c_str());
+            if (!FileExists(path)) {
+                LOG_ERROR(L"Failed to move chunk into store: ", path.c_str(), L" Error: ", error);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t ChunkStore::IngestFile(const std::wstring& filePath, ThreadPool* pool, const CancellationToken& cancellation) {
+        if (cancellation.IsCancellationRequested()) {
+            return 0;
+        }
+        std::string content;
+        if (!ReadFileToString(filePath, content)) {
+            LOG_WARNING(L"Failed to read file for chunk ingestion: ", filePath.c_str());
+            return 0;
+        }
+
+        size_t added = 0;
+        std::vector<ChunkInfo> chunks = ComputeChunks(reinterpret_cast<const unsigned char*>(content.data()), content.size(), pool);
+        for (const ChunkInfo& chunk : chunks) {
+            if (cancellation.IsCancellationRequested()) {
+                LOG_INFO(L"Chunk ingestion canceled: ", filePath.c_str());
+                return added;
+            }
+            if (!Contains(chunk.hash) && Write(chunk.hash, content.data() + chunk.offset, chunk.size)) {
+                ++added;
+            }
+        }
+        LOG_INFO(L"Ingested ", filePath.c_str(), L" into chunk store: ", chunks.size(), L" chunks, ", added, L" new.");
+        return added;
+    }
+
+    size_t ChunkStore::Prune(const ChunkIndex& keepIndex, const CancellationToken& cancellation) {
+        std::unordered_set<std::wstring> keep;
+        for (const ChunkInfo& chunk : keepIndex.chunks) {
+            keep.insert(Utf8ToWide(chunk.hash));
+        }
+
+        size_t removed = 0;
+        WIN32_FIND_DATAW dirData;
+        HANDLE hDirs = FindFirstFileW((m_rootDir + L"\\*").c_str(), &dirData);
+        if (hDirs == INVALID_HANDLE_VALUE) {
+            return 0;
+        }
+        do {
+            if (cancellation.IsCancellationRequested()) {
+                break;
+            }
+            if (!(dirData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || dirData.cFileName[0] == L'.') {
+                continue;
+            }
+            std::wstring subDir = m_rootDir + L"\\" + dirData.cFileName;
+            WIN32_FIND_DATAW fileData;
+            HANDLE hFiles = FindFirstFileW((subDir + L"\\*").c_str(), &fileData);
+            if (hFiles == INVALID_HANDLE_VALUE) {
+                continue;
+            }
+            do {
+                if (fileData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                    continue;
+                }
+                if (keep.find(fileData.cFileName) == keep.end()) {
+                    if (DeleteFileW((subDir + L"\\" + fileData.cFileName).c_str())) {
+                        ++removed;
+                    }
+                }
+            } while (FindNextFileW(hFiles, &fileData));
+            FindClose(hFiles);
+        } while (FindNextFileW(hDirs, &dirData));
+        FindClose(hDirs);
+
+        LOG_INFO(L"Chunk store pruned. Removed ", removed, L" unreferenced chunks.");
+        return removed;
+    }
+
+
+    // 连续缺失的块合并为一个 Range 请求，但单个请求不超过此大小，以便多个请求并行
+    static const unsigned long long kMaxRangeBytes = 4ULL * 1024 * 1024;
+
+    struct ChunkRange {
+        size_t firstChunk;
+        size_t chunkCount;
+        unsigned long long offset;
+        unsigned long long length;
+    };
+
+    // 下载一个 Range 并把其中的块写入块库。只接受与请求一致的 206 响应：
+    // 服务器忽略 Range 时返回的是整个文件，继续分段只会把整包重复下载许多遍，应直接失败并改为整包下载
+    static bool FetchChunkRange(const std::string& packageUrl, const ChunkIndex& index, const ChunkRange& range, ChunkStore& store,
+        const CancellationToken& cancellation) {
+        std::string body;
+        long long first = static_cast<long long>(range.offset);
+        long long last = static_cast<long long>(range.offset + range.length - 1);
+        if (!Network::HttpGetRange(packageUrl, first, last, body, nullptr, nullptr, 30000, cancellation)) {
+            if (!cancellation.IsCancellationRequested()) {
+                LOG_WARNING(L"Range request failed for ", Utf8ToWide(packageUrl).c_str(), L" (bytes ", first, L"-", last, L")");
+            }
+            return false;
+        }
+
+        for (size_t i = range.firstChunk; i < range.firstChunk + range.chunkCount; ++i) {
+            const ChunkInfo& chunk = index.chunks[i];
+            size_t start = static_cast<size_t>(chunk.offset - range.offset);
+            if (!store.Write(chunk.hash, body.data() + start, chunk.size)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool AssembleFromChunks(
+        const std::string& packageUrl,
+        const ChunkIndex& index,
+        ChunkStore& store,
+        ThreadPool* pool,
+        const std::wstring& outputPath,
+        std::function<void(long long, long long)> progressCallback,
+        const CancellationToken& callerCancellation)
+    {
+        CancellationToken cancellation = (callerCancellation.CanBeCanceled() || !pool) ? callerCancellation : pool->GetShutdownToken();
+
+        // 1. 找出缺失的块并合并成 Range
+        std::vector<ChunkRange> ranges;
+        unsigned long long presentBytes = 0;
+        for (size_t i = 0; i < index.chunks.size(); ++i) {
+            const ChunkInfo& chunk = index.chunks[i];
+            if (store.Contains(chunk.hash)) {
+                presentBytes += chunk.size;
+                continue;
+            }
+            if (!ranges.empty()) {
+                ChunkRange& last = ranges.back();
+                if (last.firstChunk + last.chunkCount == i && last.length + chunk.size <= kMaxRangeBytes) {
+                    ++last.chunkCount;
+                    last.length += chunk.size;
+                    continue;
+                }
+            }
+            ranges.push_back({ i, 1, chunk.offset, chunk.size });
+        }
+
+        LOG_INFO(L"Chunked download: ", index.chunks.size(), L" chunks, ", presentBytes, L" of ", index.totalSize,
+            L" bytes already local, ", ranges.size(), L" range requests needed.");
+
+        long long total = static_cast<long long>(index.totalSize);
+        long long ready = static_cast<long long>(presentBytes);
+        if (progressCallback) {
+            progressCallback(ready, total);
+        }
+
+        // 2. 并行下载缺失的块。调用方通常本身就是 I/O 执行器上的任务，用任务组等待：
+        //    等待的线程会自己执行还没被取走的 Range 请求，I/O 执行器只有一个线程时也不会死锁。
+        //    任一 Range 失败时任务组被取消，其余请求随之中止；cancellation 被取消时同样如此。
+        bool allFetched = true;
+        if (pool) {
+            std::mutex progressMutex;
+            auto reportRange = [&](const ChunkRange& range) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                ready += static_cast<long long>(range.length);
+                if (progressCallback) {
+                    progressCallback(ready, total);
+                }
+            };
+
+            TaskOptions blocking;
+            blocking.blocking = true;
+            blocking.tag = "chunk-fetch";
+            blocking.cancellation = cancellation;
+            TaskGroup group(*pool, blocking);
+            for (const ChunkRange& range : ranges) {
+                group.Spawn([&packageUrl, &index, &store, &reportRange, range](const CancellationToken& cancellation) {
+                    if (!FetchChunkRange(packageUrl, index, range, store, cancellation)) {
+                        throw std::runtime_error("chunk range request failed");
+                    }
+                    reportRange(range);
+                });
+            }
+            try {
+                group.Wait();
+            }
+            catch (const std::exception& e) {
+                LOG_WARNING(L"Chunk range download stopped: ", Utf8ToWide(e.what()).c_str());
+                allFetched = false;
+            }
+        }
+        else {
+            for (const ChunkRange& range : ranges) {
+                if (!FetchChunkRange(packageUrl, index, range, store, cancellation)) {
+                    allFetched = false;
+                    break;
+                }
+                ready += static_cast<long long>(range.length);
+                if (progressCallback) {
+                    progressCallback(ready, total);
+                }
+            }
+        }
+
+        if (cancellation.IsCancellationRequested()) {
+            LOG_INFO(L"Chunked download canceled: ", Utf8ToWide(packageUrl).c_str());
+            return false;
+        }
+        if (!allFetched) {
+            LOG_ERROR(L"Failed to fetch all missing chunks from: ", Utf8ToWide(packageUrl).c_str());
+            return false;
+        }
+
+        // 3. 按索引顺序拼装
+        std::ofstream outFile(outputPath, std::ios::binary | std::ios::trunc);
+        if (!outFile.is_open()) {
+            LOG_ERROR(L"Failed to open output file for chunk assembly: ", outputPath.c_str());
+            return false;
+        }
+
+        std::string chunkData;
+        for (const ChunkInfo& chunk : index.chunks) {
+            if (!store.Read(chunk.hash, chunkData) || chunkData.size() != chunk.size) {
+                LOG_ERROR(L"Chunk missing or invalid during assembly: ", Utf8ToWide(chunk.hash).c_str());
+                outFile.close();
+                DeleteFileW(outputPath.c_str());
+                return false;
+            }
+            outFile.write(chunkData.data(), chunkData.size());
+        }
+        outFile.close();
+        if (outFile.fail()) {
+            LOG_ERROR(L"Failed to write assembled package: ", outputPath.c_str());
+            DeleteFileW(outputPath.c_str());
+            return false;
+        }
+
+        if (!index.packageHash.empty()) {
+            std::string actualHash;
+            if (!Sha256FileHex(outputPath, actualHash) || actualHash != index.packageHash) {
+                LOG_ERROR(L"Assembled package hash mismatch: ", outputPath.c_str());
+                DeleteFileW(outputPath.c_str());
+                return false;
+            }
+        }
+
+        LOG_INFO(L"Package assembled from chunks: ", outputPath.c_str());
+        return true;
+    }
+
+} // namespace Chunking
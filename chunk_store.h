@@ -0,0 +1,133 @@
+#ifndef CHUNK_STORE_H
+#define CHUNK_STORE_H
+
+#include <string>
+#include <vector>
+#include <functional> // For std::function (progress callback)
+
+#include "cancellation.h"
+
+class ThreadPool;
+
+// 基于内容分块 (content-defined chunking) 的增量下载支持，思路同 casync/zsync：
+// 发布时用滚动哈希 (Gear hash) 切分更新包并生成块索引；客户端在 g_appDataDir 下维护
+// 一个去重的本地块库，只下载本地缺失的块 (HTTP Range)，再按索引顺序拼装出完整更新包。
+
+namespace Chunking {
+
+    // 分块参数，必须与发布端生成块索引时使用的参数一致
+    constexpr size_t kMinChunkSize = 16 * 1024;
+    constexpr size_t kMaxChunkSize = 256 * 1024;
+    // 16 位：超过 kMinChunkSize 后每个字节以 1/64K 的概率成为边界，在 kMaxChunkSize 处强制切分。
+    // 平均块长 = kMinChunkSize + 64KB × (1 - e^(-(kMaxChunkSize - kMinChunkSize) / 64KB))，当前参数下约 78KB
+    constexpr unsigned long long kChunkBoundaryMask = 0xFFFF000000000000ULL;
+
+    struct ChunkInfo {
+        std::string hash;          // 块内容的 SHA-256 (小写十六进制)
+        unsigned long long offset; // 块在更新包中的偏移
+        size_t size;               // 块长度（字节）
+    };
+
+    struct ChunkIndex {
+        unsigned long long totalSize = 0; // 更新包总大小
+        std::string packageHash;          // 整个更新包的 SHA-256 (可选)
+        std::vector<ChunkInfo> chunks;    // 按偏移排列、首尾相接的块列表
+    };
+
+    /**
+     * @brief 用 Gear 滚动哈希计算内容定义的分块边界并计算每块的哈希。
+     * @param data 数据指针。
+     * @param size 数据长度（字节）。
+     * @param pool 可选的线程池：边界查找是顺序的，各块的 SHA-256 在线程池上并行计算。
+     * @return 按偏移排列的块列表。
+     */
+    std::vector<ChunkInfo> ComputeChunks(const unsigned char* data, size_t size, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief 解析块索引文本。
+     * @param text 块索引文件内容。格式：
+     *   size <总字节数>
+     *   sha256 <整包哈希>        (可选)
+     *   <块哈希> <偏移> <长度>   (每块一行)
+     * @param outIndex [out] 解析结果。
+     * @return 格式正确且各块首尾相接时返回 true。
+     */
+    bool ParseChunkIndex(const std::string& text, ChunkIndex& outIndex);
+
+    /**
+     * @brief 将块索引序列化为文本 (与 ParseChunkIndex 互逆，供发布工具使用)。
+     */
+    std::string SerializeChunkIndex(const ChunkIndex& index);
+
+    // 本地去重块库：每个块以其哈希命名，存放在 <root>\<哈希前两位>\<哈希>。
+    // 写入先落到临时文件再原子重命名，因此可被多个线程同时写入。
+    class ChunkStore {
+    public:
+        explicit ChunkStore(const std::wstring& rootDir);
+
+        /**
+         * @brief 检查块库中是否已有指定块。
+         */
+        bool Contains(const std::string& hash) const;
+
+        /**
+         * @brief 读取块内容并校验哈希。
+         * @return 块存在且内容完整时返回 true。
+         */
+        bool Read(const std::string& hash, std::string& outData) const;
+
+        /**
+         * @brief 校验哈希后写入一个块 (已存在则直接返回 true)。
+         */
+        bool Write(const std::string& hash, const char* data, size_t size);
+
+        /**
+         * @brief 对本地文件分块，并把块库中缺失的块加入块库。
+         * @param pool 可选的线程池，用于并行计算块哈希。
+         * @param cancellation 取消令牌 (可选)：取消后不再写入新的块。
+         * @return 新加入的块数量。
+         */
+        size_t IngestFile(const std::wstring& filePath, ThreadPool* pool = nullptr,
+            const CancellationToken& cancellation = CancellationToken());
+
+        /**
+         * @brief 删除不被指定索引引用的块，使块库只保留最新版本所需的数据。
+         * @param cancellation 取消令牌 (可选)：取消后停止删除，剩下的块留到下次清理。
+         * @return 删除的块数量。
+         */
+        size_t Prune(const ChunkIndex& keepIndex, const CancellationToken& cancellation = CancellationToken());
+
+        const std::wstring& GetRootDir() const { return m_rootDir; }
+
+    private:
+        std::wstring GetChunkPath(const std::string& hash) const;
+
+        std::wstring m_rootDir;
+    };
+
+    /**
+     * @brief 下载缺失的块并拼装出完整的更新包。
+     * @param packageUrl 更新包的 URL (缺失的块通过 Range 请求从此处获取)。
+     * @param index 更新包的块索引。
+     * @param store 本地块库。
+     * @param pool 用于并行下载的线程池 (为空则在当前线程顺序下载)。
+     * @param outputPath 拼装结果的保存路径。
+     * @param progressCallback 进度回调 (已就绪字节数, 总字节数)，本地已有的块计为已就绪。
+     * @param cancellation 取消令牌 (可选)：取消时中止未完成的 Range 请求并返回 false。
+     *        不可取消的默认令牌表示使用线程池的关闭令牌。
+     * @return 拼装成功且校验通过返回 true。任一 Range 请求失败 (包括服务器不支持 Range、返回 200 和整个文件)
+     *         时立即中止其余请求并返回 false，由调用方改为整包下载。
+     */
+    bool AssembleFromChunks(
+        const std::string& packageUrl,
+        const ChunkIndex& index,
+        ChunkStore& store,
+        ThreadPool* pool,
+        const std::wstring& outputPath,
+        std::function<void(long long, long long)> progressCallback = nullptr,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+} // namespace Chunking
+
+#endif // CHUNK_STORE_H
@@ -0,0 +1,462 @@
+#include "compression.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Compression {
+
+    // --- CRC-32 ---
+
+    static std::array<uint32_t, 256> MakeCrcTable() {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        return table;
+    }
+
+    uint32_t Crc32(const void* data, size_t size, uint32_t crc) {
+        static const std::array<uint32_t, 256> table = MakeCrcTable();
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+
+    // --- DEFLATE 解码 ---
+
+    namespace {
+
+        constexpr int kMaxBits = 15;
+        constexpr int kFastBits = 10; // 10 位查表可直接解出绝大多数符号
+
+        struct Huffman {
+            uint16_t counts[kMaxBits + 1];
+            uint16_t symbols[288];
+            uint16_t fast[1 << kFastBits]; // (码长 << 9) | 符号，0 表示需要走慢速路径
+        };
+
+        const uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        const uint16_t kDistBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        const uint8_t kDistExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        const uint8_t kCodeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+        class BitReader {
+        public:
+            BitReader(const uint8_t* src, size_t size) : m_src(src), m_size(size) {}
+
+            // 保证缓冲中至少有 57 位；越过输入末尾时补零并记录越界
+            void Refill() {
+                while (m_bitCount <= 56) {
+                    uint64_t byte = 0;
+                    if (m_pos < m_size) {
+                        byte = m_src[m_pos];
+                    }
+                    else {
+                        m_overrun += 8;
+                    }
+                    ++m_pos;
+                    m_bits |= byte << m_bitCount;
+                    m_bitCount += 8;
+                }
+            }
+
+            uint32_t Peek(int n) const { return static_cast<uint32_t>(m_bits & ((1ULL << n) - 1)); }
+            void Consume(int n) { m_bits >>= n; m_bitCount -= n; }
+
+            uint32_t Read(int n) {
+                if (n == 0) return 0;
+                if (m_bitCount < n) Refill();
+                uint32_t v = Peek(n);
+                Consume(n);
+                return v;
+            }
+
+            void AlignToByte() { Consume(m_bitCount & 7); }
+
+            // 对齐到字节边界并丢弃预读的字节，返回下一个未消耗字节的位置 (用于未压缩块)
+            size_t BytePosition() {
+                AlignToByte();
+                size_t pos = m_pos - static_cast<size_t>(m_bitCount / 8);
+                m_pos = pos;
+                m_bits = 0;
+                m_bitCount = 0;
+                m_overrun = 0;
+                return pos;
+            }
+
+            void Skip(size_t bytes) { m_pos += bytes; }
+
+            // 实际消耗的位是否超出了输入
+            bool Overrun() const { return m_overrun > static_cast<size_t>(m_bitCount); }
+
+            int m_bitCount = 0;
+
+        private:
+            const uint8_t* m_src;
+            size_t m_size;
+            size_t m_pos = 0;
+            uint64_t m_bits = 0;
+            size_t m_overrun = 0;
+        };
+
+        bool BuildHuffman(Huffman& h, const uint8_t* lengths, int count) {
+            std::memset(h.counts, 0, sizeof(h.counts));
+            std::memset(h.fast, 0, sizeof(h.fast));
+            for (int i = 0; i < count; ++i) {
+                h.counts[lengths[i]]++;
+            }
+            h.counts[0] = 0;
+
+            int left = 1;
+            for (int len = 1; len <= kMaxBits; ++len) {
+                left <<= 1;
+                left -= h.counts[len];
+                if (left < 0) {
+                    return false; // 码长集合超额订阅
+                }
+            }
+
+            uint16_t offsets[kMaxBits + 2];
+            offsets[1] = 0;
+            for (int len = 1; len <= kMaxBits; ++len) {
+                offsets[len + 1] = static_cast<uint16_t>(offsets[len] + h.counts[len]);
+            }
+            for (int i = 0; i < count; ++i) {
+                if (lengths[i]) {
+                    h.symbols[offsets[lengths[i]]++] = static_cast<uint16_t>(i);
+                }
+            }
+
+            // 填充快速表：规范 Huffman 码按 MSB 优先分配，而 DEFLATE 按 LSB 优先读位，因此需要翻转
+            uint32_t code = 0;
+            int index = 0;
+            for (int len = 1; len <= kFastBits; ++len) {
+                for (int n = 0; n < h.counts[len]; ++n, ++index, ++code) {
+                    uint32_t reversed = 0;
+                    for (int b = 0; b < len; ++b) {
+                        reversed |= ((code >> b) & 1u) << (len - 1 - b);
+                    }
+                    uint16_t entry = static_cast<uint16_t>((len << 9) | h.symbols[index]);
+                    for (uint32_t fill = reversed; fill < (1u << kFastBits); fill += (1u << len)) {
+                        h.fast[fill] = entry;
+                    }
+                }
+                code <<= 1;
+            }
+            return true;
+        }
+
+        int DecodeSymbol(BitReader& br, const Huffman& h) {
+            if (br.m_bitCount < kMaxBits) br.Refill();
+            uint16_t entry = h.fast[br.Peek(kFastBits)];
+            if (entry) {
+                br.Consume(entry >> 9);
+                return entry & 0x1FF;
+            }
+
+            // 慢速路径：逐位按规范码解码 (码长 > kFastBits)
+            int code = 0, first = 0, index = 0;
+            for (int len = 1; len <= kMaxBits; ++len) {
+                code |= static_cast<int>(br.Read(1));
+                int count = h.counts[len];
+                if (code - count < first) {
+                    return h.symbols[index + (code - first)];
+                }
+                index += count;
+                first += count;
+                first <<= 1;
+                code <<= 1;
+            }
+            return -1;
+        }
+
+        bool InflateBlockData(BitReader& br, const Huffman& lit, const Huffman& dist,
+            uint8_t* dst, size_t dstSize, size_t& out)
+        {
+            for (;;) {
+                int sym = DecodeSymbol(br, lit);
+                if (sym < 0) return false;
+                if (sym < 256) {
+                    if (out >= dstSize) return false;
+                    dst[out++] = static_cast<uint8_t>(sym);
+                    continue;
+                }
+                if (sym == 256) {
+                    return true;
+                }
+
+                sym -= 257;
+                if (sym >= 29) return false;
+                size_t length = kLengthBase[sym] + br.Read(kLengthExtra[sym]);
+
+                int dsym = DecodeSymbol(br, dist);
+                if (dsym < 0 || dsym >= 30) return false;
+                size_t distance = kDistBase[dsym] + br.Read(kDistExtra[dsym]);
+
+                if (distance > out || length > dstSize - out) return false;
+                const uint8_t* from = dst + out - distance;
+                if (distance >= length) {
+                    std::memcpy(dst + out, from, length);
+                }
+                else {
+                    for (size_t i = 0; i < length; ++i) dst[out + i] = from[i]; // 重叠复制必须逐字节
+                }
+                out += length;
+            }
+        }
+
+        bool BuildFixedTables(Huffman& lit, Huffman& dist) {
+            uint8_t lengths[288];
+            int i = 0;
+            for (; i < 144; ++i) lengths[i] = 8;
+            for (; i < 256; ++i) lengths[i] = 9;
+            for (; i < 280; ++i) lengths[i] = 7;
+            for (; i < 288; ++i) lengths[i] = 8;
+            if (!BuildHuffman(lit, lengths, 288)) return false;
+            for (i = 0; i < 30; ++i) lengths[i] = 5;
+            return BuildHuffman(dist, lengths, 30);
+        }
+
+        bool BuildDynamicTables(BitReader& br, Huffman& lit, Huffman& dist) {
+            int hlit = static_cast<int>(br.Read(5)) + 257;
+            int hdist = static_cast<int>(br.Read(5)) + 1;
+            int hclen = static_cast<int>(br.Read(4)) + 4;
+            if (hlit > 286 || hdist > 30) return false;
+
+            uint8_t lengths[288 + 32] = { 0 };
+            for (int i = 0; i < hclen; ++i) {
+                lengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(br.Read(3));
+            }
+            Huffman codeLengths;
+            if (!BuildHuffman(codeLengths, lengths, 19)) return false;
+
+            std::memset(lengths, 0, sizeof(lengths));
+            int n = 0;
+            while (n < hlit + hdist) {
+                int sym = DecodeSymbol(br, codeLengths);
+                if (sym < 0) return false;
+                if (sym < 16) {
+                    lengths[n++] = static_cast<uint8_t>(sym);
+                    continue;
+                }
+                uint8_t value = 0;
+                int repeat = 0;
+                if (sym == 16) {
+                    if (n == 0) return false;
+                    value = lengths[n - 1];
+                    repeat = 3 + static_cast<int>(br.Read(2));
+                }
+                else if (sym == 17) {
+                    repeat = 3 + static_cast<int>(br.Read(3));
+                }
+                else {
+                    repeat = 11 + static_cast<int>(br.Read(7));
+                }
+                if (n + repeat > hlit + hdist) return false;
+                while (repeat--) lengths[n++] = value;
+            }
+
+            if (lengths[256] == 0) return false; // 必须有块结束符
+            return BuildHuffman(lit, lengths, hlit) && BuildHuffman(dist, lengths + hlit, hdist);
+        }
+
+    } // namespace
+
+    bool Inflate(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize, size_t* outWritten) {
+        BitReader br(src, srcSize);
+        size_t out = 0;
+        Huffman lit, dist;
+        bool last = false;
+
+        while (!last) {
+            last = br.Read(1) != 0;
+            uint32_t type = br.Read(2);
+
+            if (type == 0) {
+                size_t pos = br.BytePosition();
+                if (pos + 4 > srcSize) return false;
+                uint16_t len = static_cast<uint16_t>(src[pos] | (src[pos + 1] << 8));
+                uint16_t nlen = static_cast<uint16_t>(src[pos + 2] | (src[pos + 3] << 8));
+                if (len != static_cast<uint16_t>(~nlen)) return false;
+                pos += 4;
+                if (pos + len > srcSize || len > dstSize - out) return false;
+                std::memcpy(dst + out, src + pos, len);
+                out += len;
+                br.Skip(4 + static_cast<size_t>(len));
+            }
+            else if (type == 1) {
+                if (!BuildFixedTables(lit, dist)) return false;
+                if (!InflateBlockData(br, lit, dist, dst, dstSize, out)) return false;
+            }
+            else if (type == 2) {
+                if (!BuildDynamicTables(br, lit, dist)) return false;
+                if (!InflateBlockData(br, lit, dist, dst, dstSize, out)) return false;
+            }
+            else {
+                return false;
+            }
+
+            if (br.Overrun()) return false;
+        }
+
+        if (outWritten) *outWritten = out;
+        return true;
+    }
+
+
+    // --- DEFLATE 编码 ---
+
+    namespace {
+
+        constexpr size_t kWindowSize = 32768;
+        constexpr size_t kMinMatch = 3;
+        constexpr size_t kMaxMatch = 258;
+        constexpr int kHashBits = 15;
+        constexpr int kMaxChain = 64; // 每个位置最多比较的候选数，限制最坏情况下的耗时
+
+        class BitWriter {
+        public:
+            explicit BitWriter(std::vector<uint8_t>& out) : m_out(out) {}
+
+            // 按 DEFLATE 的位序 (低位在前) 写入 count 位
+            void Write(uint32_t value, int count) {
+                m_bits |= static_cast<uint64_t>(value) << m_bitCount;
+                m_bitCount += count;
+                while (m_bitCount >= 8) {
+                    m_out.push_back(static_cast<uint8_t>(m_bits));
+                    m_bits >>= 8;
+                    m_bitCount -= 8;
+                }
+            }
+
+            // Huffman 码从最高位开始写入
+            void WriteCode(uint32_t code, int length) {
+                uint32_t reversed = 0;
+                for (int i = 0; i < length; ++i) {
+                    reversed = (reversed << 1) | ((code >> i) & 1);
+                }
+                Write(reversed, length);
+            }
+
+            void Finish() {
+                if (m_bitCount > 0) {
+                    m_out.push_back(static_cast<uint8_t>(m_bits));
+                    m_bits = 0;
+                    m_bitCount = 0;
+                }
+            }
+
+        private:
+            std::vector<uint8_t>& m_out;
+            uint64_t m_bits = 0;
+            int m_bitCount = 0;
+        };
+
+        // 固定 Huffman 表 (RFC 1951 3.2.6) 中的字面量/长度符号
+        void WriteFixedSymbol(BitWriter& bw, uint32_t symbol) {
+            if (symbol < 144) bw.WriteCode(0x30 + symbol, 8);
+            else if (symbol < 256) bw.WriteCode(0x190 + (symbol - 144), 9);
+            else if (symbol < 280) bw.WriteCode(symbol - 256, 7);
+            else bw.WriteCode(0xC0 + (symbol - 280), 8);
+        }
+
+        void WriteMatch(BitWriter& bw, size_t length, size_t distance) {
+            int lengthCode = 28;
+            while (kLengthBase[lengthCode] > length) --lengthCode;
+            WriteFixedSymbol(bw, 257 + static_cast<uint32_t>(lengthCode));
+            bw.Write(static_cast<uint32_t>(length - kLengthBase[lengthCode]), kLengthExtra[lengthCode]);
+
+            int distCode = 29;
+            while (kDistBase[distCode] > distance) --distCode;
+            bw.WriteCode(static_cast<uint32_t>(distCode), 5);
+            bw.Write(static_cast<uint32_t>(distance - kDistBase[distCode]), kDistExtra[distCode]);
+        }
+
+        uint32_t Hash3(const uint8_t* p) {
+            return ((static_cast<uint32_t>(p[0]) << 10) ^ (static_cast<uint32_t>(p[1]) << 5) ^ p[2]) & ((1u << kHashBits) - 1);
+        }
+
+    } // namespace
+
+    void Deflate(const uint8_t* src, size_t srcSize, std::vector<uint8_t>& out) {
+        BitWriter bw(out);
+        bw.Write(1, 1); // BFINAL
+        bw.Write(1, 2); // BTYPE = 01 固定 Huffman
+
+        // 哈希链：head 为每个哈希值最近的位置，prev 为窗口内同一哈希值的上一个位置 (位置 + 1，0 表示没有)
+        std::vector<uint32_t> head(static_cast<size_t>(1) << kHashBits, 0);
+        std::vector<uint32_t> prev(kWindowSize, 0);
+        auto insert = [&](size_t pos) {
+            uint32_t h = Hash3(src + pos);
+            prev[pos & (kWindowSize - 1)] = head[h];
+            head[h] = static_cast<uint32_t>(pos + 1);
+        };
+
+        size_t pos = 0;
+        while (pos < srcSize) {
+            size_t bestLength = 0;
+            size_t bestDistance = 0;
+            if (srcSize - pos >= kMinMatch) {
+                size_t maxLength = (std::min)(kMaxMatch, srcSize - pos);
+                uint32_t candidate = head[Hash3(src + pos)];
+                for (int chain = 0; candidate != 0 && chain < kMaxChain; ++chain) {
+                    size_t start = candidate - 1;
+                    if (pos - start > kWindowSize) break;
+                    if (src[start + bestLength] == src[pos + bestLength]) {
+                        size_t length = 0;
+                        while (length < maxLength && src[start + length] == src[pos + length]) ++length;
+                        if (length > bestLength) {
+                            bestLength = length;
+                            bestDistance = pos - start;
+                            if (length == maxLength) break;
+                        }
+                    }
+                    candidate = prev[start & (kWindowSize - 1)];
+                }
+                insert(pos);
+            }
+
+            if (bestLength >= kMinMatch) {
+                WriteMatch(bw, bestLength, bestDistance);
+                for (size_t i = 1; i < bestLength; ++i) {
+                    if (srcSize - (pos + i) >= kMinMatch) insert(pos + i);
+                }
+                pos += bestLength;
+            }
+            else {
+                WriteFixedSymbol(bw, src[pos]);
+                ++pos;
+            }
+        }
+
+        WriteFixedSymbol(bw, 256); // 块结束
+        bw.Finish();
+    }
+
+    void GzipCompress(const uint8_t* src, size_t srcSize, std::vector<uint8_t>& out) {
+        // ID1 ID2 CM=8 (deflate) FLG=0 MTIME=0 XFL=0 OS=255 (未知)
+        static const uint8_t kHeader[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+        out.insert(out.end(), kHeader, kHeader + sizeof(kHeader));
+        Deflate(src, srcSize, out);
+
+        uint32_t crc = Crc32(src, srcSize);
+        uint32_t size = static_cast<uint32_t>(srcSize); // ISIZE 为长度对 2^32 取模
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(crc >> (8 * i)));
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(size >> (8 * i)));
+    }
+
+} // namespace Compression
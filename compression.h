@@ -0,0 +1,52 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 轻量级的 DEFLATE (RFC 1951) 编解码与 CRC-32 实现，用于解压 ZIP 更新包和压缩归档的日志，
+// 避免为此引入 zlib 依赖。
+
+namespace Compression {
+
+    /**
+     * @brief 计算 CRC-32 (ZIP/gzip 使用的 IEEE 802.3 多项式)。
+     * @param data 数据指针。
+     * @param size 数据长度（字节）。
+     * @param crc 之前的 CRC 值，用于分段计算 (首段传 0)。
+     * @return 更新后的 CRC 值。
+     */
+    uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0);
+
+    /**
+     * @brief 解码原始 DEFLATE 数据流 (无 zlib/gzip 头)。
+     * @param src 压缩数据。
+     * @param srcSize 压缩数据长度。
+     * @param dst 输出缓冲区 (调用方按已知的解压后大小预先分配)。
+     * @param dstSize 输出缓冲区大小。
+     * @param outWritten [out] 实际写入的字节数。
+     * @return 数据流完整且未越界时返回 true。
+     */
+    bool Inflate(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize, size_t* outWritten);
+
+    /**
+     * @brief 把数据编码为原始 DEFLATE 数据流 (LZ77 哈希链匹配 + 固定 Huffman 编码，单个数据块)。
+     * @param src 原始数据。
+     * @param srcSize 原始数据长度。
+     * @param out [out] 追加压缩后的数据。
+     * @note 面向日志这类重复较多的文本，不追求最高压缩率。
+     */
+    void Deflate(const uint8_t* src, size_t srcSize, std::vector<uint8_t>& out);
+
+    /**
+     * @brief 生成 gzip (RFC 1952) 格式的数据：文件头 + DEFLATE 数据流 + CRC-32 + 原始长度。
+     * @param src 原始数据。
+     * @param srcSize 原始数据长度。
+     * @param out [out] 追加 gzip 数据。
+     */
+    void GzipCompress(const uint8_t* src, size_t srcSize, std::vector<uint8_t>& out);
+
+} // namespace Compression
+
+#endif // COMPRESSION_H
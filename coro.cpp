@@ -0,0 +1,96 @@
+#define LOG_MODULE LogModule::Threads // 本文件的日志属于线程模块 (见 log.h)
+#include "coro.h"
+#include "log.h"
+#include "utils.h" // For Utf8ToWide
+#include <system_error>
+
+namespace Coro {
+
+    bool HttpGetAwaiter::await_suspend(std::coroutine_handle<> handle) {
+        // 完成回调可能在 HttpGetAsync 返回之前执行 (参数无效或请求已停止时在当前线程上，请求很快结束时在事件循环线程上)。
+        // 回调和本函数谁后到谁负责继续：回调后到时提交恢复任务；本函数后到时返回 false，协程直接在当前线程继续
+        ThreadPool* pool = &m_pool;
+        Network::HttpGetAsync(m_url, [this, pool, handle](Network::HttpResponse& response) {
+            m_response = std::move(response);
+            if (!m_completed.exchange(true)) {
+                return;
+            }
+            // 提交成功后协程随时可能恢复并销毁本对象，之后不能再访问成员
+            try {
+                pool->post(ResumeTask{ handle, &m_response, std::this_thread::get_id() });
+            }
+            catch (const std::exception& e) {
+                // 线程池已停止 (或队列已满且策略为 Fail)：不在事件循环线程上运行协程
+                LOG_WARNING(L"Failed to schedule coroutine resumption, resuming on a new thread: ", Utf8ToWide(e.what()).c_str());
+                m_response.success = false;
+                m_response.canceled = true;
+                ResumeOnNewThread(handle);
+            }
+        }, m_requestHeaders.empty() ? nullptr : &m_requestHeaders, m_timeoutMs, m_cancellation);
+        return !m_completed.exchange(true);
+    }
+
+    void HttpGetAwaiter::ResumeTask::Cancel() {
+        response->success = false;
+        response->canceled = true;
+        Resume();
+    }
+
+    void HttpGetAwaiter::ResumeTask::Resume() {
+        // QueueFullPolicy::RunOnCaller 的线程池可能直接在提交线程 (事件循环线程) 上执行任务
+        if (std::this_thread::get_id() == reactorThread) {
+            ResumeOnNewThread(handle);
+        }
+        else {
+            handle.resume();
+        }
+    }
+
+    void HttpGetAwaiter::ResumeOnNewThread(std::coroutine_handle<> handle) {
+        try {
+            std::thread([handle] { handle.resume(); }).detach();
+        }
+        catch (const std::system_error& e) {
+            LOG_WARNING(L"Failed to create a thread to resume coroutine, it will never finish: ", Utf8ToWide(e.what()).c_str());
+        }
+    }
+
+    Task<bool> DownloadFile(ThreadPool& pool, std::string url, std::wstring outputPath,
+        std::function<void(long long, long long)> progressCallback,
+        CancellationToken cancellation)
+    {
+        LOG_INFO(L"Attempting to download file from URL: ", Utf8ToWide(url).c_str(), L" to: ", outputPath.c_str());
+
+        Network::HttpResponse response = co_await HttpGet(pool, url, nullptr, 15000 /* 15 sec timeout */, cancellation);
+        if (response.canceled) {
+            LOG_INFO(L"Download canceled: ", Utf8ToWide(url).c_str());
+            co_return false;
+        }
+        if (!response.success) {
+            LOG_ERROR(L"Failed to GET file content from URL: ", Utf8ToWide(url).c_str());
+            co_return false;
+        }
+
+        long long totalSize = -1;
+        auto itHeader = response.headers.find("Content-Length");
+        if (itHeader != response.headers.end()) {
+            try {
+                totalSize = std::stoll(itHeader->second);
+            }
+            catch (const std::exception&) { /* ignore parse error */ }
+        }
+
+        if (!Network::SaveToFile(response.body, outputPath)) {
+            co_return false;
+        }
+
+        if (progressCallback) {
+            long long size = static_cast<long long>(response.body.size());
+            progressCallback(size, totalSize > 0 ? totalSize : size);
+        }
+
+        LOG_INFO(L"File downloaded successfully: ", outputPath.c_str(), L" (Size: ", response.body.size(), L" bytes)");
+        co_return true;
+    }
+
+} // namespace Coro
@@ -0,0 +1,249 @@
+#ifndef CORO_H
+#define CORO_H
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional> // For std::function (progress callback)
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "threads.h"
+#include "task_future.h"
+#include "network.h"
+
+// C++20 协程支持：
+//   Coro::Task<T>      惰性启动的协程，被 co_await 时才开始执行，结束后恢复等待它的协程
+//   pool.schedule()    co_await 后在线程池的工作线程上继续执行
+//   Coro::HttpGet      co_await 时挂起协程，请求由 Network::HttpGetAsync 的事件循环驱动，完成后在线程池上恢复
+//   Coro::Spawn        从普通代码启动协程，返回 TaskFuture
+// 协程帧从 TaskMemory 的线程缓存分配；挂起中的请求只占用协程帧，不占用线程。
+
+namespace Coro {
+
+    template<typename T> class Task;
+
+    namespace Detail {
+
+        // 协程帧的分配：小帧复用 TaskMemory 的空闲块
+        struct FrameAllocation {
+            static void* operator new(size_t size) { return TaskMemory::Allocate(size); }
+            static void operator delete(void* p, size_t size) noexcept { TaskMemory::Deallocate(p, size); }
+        };
+
+        // 结束时恢复等待者 (对称转移，不会因为长链的 co_await 而栈溢出)
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                std::coroutine_handle<> continuation = handle.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+            void await_resume() const noexcept {}
+        };
+
+        template<typename T>
+        struct PromiseBase : FrameAllocation {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+            void unhandled_exception() noexcept { error = std::current_exception(); }
+        };
+
+        template<typename T>
+        struct Promise : PromiseBase<T> {
+            std::optional<T> value;
+
+            Task<T> get_return_object();
+            template<typename U>
+            void return_value(U&& v) { value.emplace(std::forward<U>(v)); }
+
+            T Result() {
+                if (this->error) std::rethrow_exception(this->error);
+                return std::move(*value);
+            }
+        };
+
+        template<>
+        struct Promise<void> : PromiseBase<void> {
+            Task<void> get_return_object();
+            void return_void() const noexcept {}
+
+            void Result() {
+                if (this->error) std::rethrow_exception(this->error);
+            }
+        };
+
+    } // namespace Detail
+
+    template<typename T = void>
+    class Task {
+    public:
+        using promise_type = Detail::Promise<T>;
+
+        Task() noexcept = default;
+        explicit Task(std::coroutine_handle<promise_type> handle) noexcept : m_handle(handle) {}
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (m_handle) m_handle.destroy();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() {
+            if (m_handle) m_handle.destroy();
+        }
+
+        // co_await task：启动协程并在它结束后继续 (结果或异常在这里取回)
+        auto operator co_await() && noexcept {
+            struct Awaiter {
+                std::coroutine_handle<promise_type> handle;
+                bool await_ready() const noexcept { return !handle || handle.done(); }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                    handle.promise().continuation = awaiting;
+                    return handle;
+                }
+                T await_resume() { return handle.promise().Result(); }
+            };
+            return Awaiter{ m_handle };
+        }
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    namespace Detail {
+
+        template<typename T>
+        Task<T> Promise<T>::get_return_object() {
+            return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> Promise<void>::get_return_object() {
+            return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+        }
+
+        // Spawn 使用的驱动协程：立即开始，结束时自动销毁
+        struct Detached {
+            struct promise_type : FrameAllocation {
+                Detached get_return_object() const noexcept { return {}; }
+                std::suspend_never initial_suspend() const noexcept { return {}; }
+                std::suspend_never final_suspend() const noexcept { return {}; }
+                void return_void() const noexcept {}
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+        template<typename T>
+        Detached Drive(ThreadPool& pool, TaskOptions options, Task<T> task, TaskPromise<T> promise) {
+            try {
+                co_await pool.schedule(options);
+                if constexpr (std::is_void<T>::value) {
+                    co_await std::move(task);
+                    promise.SetValue();
+                }
+                else {
+                    promise.SetValue(co_await std::move(task));
+                }
+            }
+            catch (...) {
+                promise.SetException(std::current_exception());
+            }
+        }
+
+    } // namespace Detail
+
+    /**
+     * @brief 在线程池上启动协程。
+     * @param pool 线程池。
+     * @param task 要执行的协程。
+     * @param options 首次调度的提交选项 (优先级等)。
+     * @return 协程结束时完成的 future (可以用 Then 继续组合)。
+     */
+    template<typename T>
+    TaskFuture<T> Spawn(ThreadPool& pool, Task<T> task, const TaskOptions& options = TaskOptions()) {
+        TaskPromise<T> promise;
+        TaskFuture<T> future = promise.GetFuture();
+        Detail::Drive(pool, options, std::move(task), promise);
+        return future;
+    }
+
+    // co_await Coro::HttpGet(...) 的等待体
+    class HttpGetAwaiter {
+    public:
+        HttpGetAwaiter(ThreadPool& pool, std::string url, const std::map<std::string, std::string>* requestHeaders, int timeoutMs,
+            CancellationToken cancellation)
+            : m_pool(pool), m_url(std::move(url)), m_timeoutMs(timeoutMs), m_cancellation(std::move(cancellation)), m_completed(false) {
+            if (requestHeaders) m_requestHeaders = *requestHeaders;
+        }
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        Network::HttpResponse await_resume() { return std::move(m_response); }
+
+    private:
+        // 请求完成后提交到线程池的恢复任务。线程池关闭时被丢弃 (Cancel) 也会恢复协程，结果标记为 canceled，
+        // 协程因此总能结束 (Spawn 返回的 future 随之完成)。不会在事件循环线程上恢复协程
+        struct ResumeTask {
+            std::coroutine_handle<> handle;
+            Network::HttpResponse* response;
+            std::thread::id reactorThread;
+
+            void operator()() { Resume(); }
+            void Cancel();
+            void Resume();
+        };
+
+        // 线程池已经不能执行任务时的退路：在新建的线程上恢复协程
+        static void ResumeOnNewThread(std::coroutine_handle<> handle);
+
+        ThreadPool& m_pool;
+        std::string m_url;
+        std::map<std::string, std::string> m_requestHeaders;
+        int m_timeoutMs;
+        CancellationToken m_cancellation;
+        Network::HttpResponse m_response;
+        std::atomic<bool> m_completed; // 完成回调和 await_suspend 各置一次，后到的一方负责继续协程
+    };
+
+    /**
+     * @brief 异步 HTTP GET：co_await 时挂起协程，完成后在线程池的工作线程上恢复。
+     * @param pool 恢复协程的线程池。须在请求结束之前一直有效：程序退出时先调用 Network::StopAsyncRequests
+     *             结束未完成的请求，再关闭线程池 (关闭时被丢弃的恢复任务以 canceled 结果恢复协程)。
+     * @param url 完整的 URL (仅支持 http)。
+     * @param requestHeaders 附加的请求头 (可选，发起请求时拷贝)。
+     * @param timeoutMs 空闲超时（毫秒）。
+     * @param cancellation 取消令牌 (可选)：取消后协程尽快恢复，结果的 canceled 为 true。
+     * @return co_await 的结果为 Network::HttpResponse。
+     */
+    inline HttpGetAwaiter HttpGet(ThreadPool& pool, std::string url,
+        const std::map<std::string, std::string>* requestHeaders = nullptr, int timeoutMs = 5000,
+        const CancellationToken& cancellation = CancellationToken()) {
+        return HttpGetAwaiter(pool, std::move(url), requestHeaders, timeoutMs, cancellation);
+    }
+
+    /**
+     * @brief 异步下载文件 (Network::DownloadFile 的协程版本)。
+     * @param pool 线程池。
+     * @param url 文件的 URL。
+     * @param outputPath 文件保存的本地路径。
+     * @param progressCallback 进度回调 (可选)，下载完成后调用一次。
+     * @param cancellation 取消令牌 (可选)，取消后不会写入文件。
+     * @return 下载并写入成功时结果为 true。
+     */
+    Task<bool> DownloadFile(ThreadPool& pool, std::string url, std::wstring outputPath,
+        std::function<void(long long, long long)> progressCallback = nullptr,
+        CancellationToken cancellation = CancellationToken());
+
+} // namespace Coro
+
+#endif // CORO_H
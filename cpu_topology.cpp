@@ -0,0 +1,163 @@
+#define LOG_MODULE LogModule::Threads // 本文件的日志属于线程模块 (见 log.h)
+#include "cpu_topology.h"
+#include "log.h"
+
+#include <windows.h>
+#include <algorithm> // For std::sort
+#include <thread>
+
+namespace CpuTopology {
+
+    // 某个处理器组内的一组逻辑处理器
+    struct GroupMask {
+        WORD group;
+        KAFFINITY mask;
+        unsigned id;
+    };
+
+    static Topology FallbackTopology() {
+        Topology topology;
+        unsigned count = (std::max)(std::thread::hardware_concurrency(), 1u);
+        for (unsigned i = 0; i < count && i < 64; ++i) {
+            LogicalProcessor processor;
+            processor.number = static_cast<unsigned char>(i);
+            processor.core = i;
+            topology.processors.push_back(processor);
+        }
+        topology.coreCount = topology.processors.size();
+        topology.nodeCount = 1;
+        return topology;
+    }
+
+    static Topology Discover() {
+        DWORD length = 0;
+        GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || length == 0) {
+            LOG_WARNING(L"GetLogicalProcessorInformationEx failed. Error: ", GetLastError(), L". Assuming a single NUMA node.");
+            return FallbackTopology();
+        }
+        std::vector<unsigned char> buffer(length);
+        if (!GetLogicalProcessorInformationEx(RelationAll, reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data()), &length)) {
+            LOG_WARNING(L"GetLogicalProcessorInformationEx failed. Error: ", GetLastError(), L". Assuming a single NUMA node.");
+            return FallbackTopology();
+        }
+
+        // 记录是变长的：先收集各核心和各 NUMA 节点覆盖的处理器掩码
+        std::vector<GroupMask> cores;
+        std::vector<GroupMask> nodes;
+        unsigned coreId = 0;
+        for (DWORD offset = 0; offset < length;) {
+            auto* entry = reinterpret_cast<PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX>(buffer.data() + offset);
+            if (entry->Relationship == RelationProcessorCore) {
+                for (WORD i = 0; i < entry->Processor.GroupCount; ++i) {
+                    cores.push_back({ entry->Processor.GroupMask[i].Group, entry->Processor.GroupMask[i].Mask, coreId });
+                }
+                ++coreId;
+            }
+            else if (entry->Relationship == RelationNumaNode) {
+                nodes.push_back({ entry->NumaNode.GroupMask.Group, entry->NumaNode.GroupMask.Mask, static_cast<unsigned>(nodes.size()) });
+            }
+            if (entry->Size == 0) break;
+            offset += entry->Size;
+        }
+
+        Topology topology;
+        for (const GroupMask& core : cores) {
+            for (unsigned bit = 0; bit < sizeof(KAFFINITY) * 8; ++bit) {
+                KAFFINITY processorBit = static_cast<KAFFINITY>(1) << bit;
+                if (!(core.mask & processorBit)) continue;
+                LogicalProcessor processor;
+                processor.group = core.group;
+                processor.number = static_cast<unsigned char>(bit);
+                processor.core = core.id;
+                for (const GroupMask& node : nodes) {
+                    if (node.group == core.group && (node.mask & processorBit)) {
+                        processor.node = node.id;
+                        break;
+                    }
+                }
+                topology.processors.push_back(processor);
+            }
+        }
+        if (topology.processors.empty()) {
+            return FallbackTopology();
+        }
+
+        std::sort(topology.processors.begin(), topology.processors.end(), [](const LogicalProcessor& a, const LogicalProcessor& b) {
+            if (a.node != b.node) return a.node < b.node;
+            if (a.core != b.core) return a.core < b.core;
+            if (a.group != b.group) return a.group < b.group;
+            return a.number < b.number;
+        });
+        topology.coreCount = coreId;
+        topology.nodeCount = (std::max)(nodes.size(), static_cast<size_t>(1));
+        return topology;
+    }
+
+    const Topology& Get() {
+        static const Topology topology = [] {
+            Topology discovered = Discover();
+            LOG_INFO(L"CPU topology: ", discovered.processors.size(), L" logical processors, ", discovered.coreCount,
+                L" cores, ", discovered.nodeCount, L" NUMA nodes.");
+            return discovered;
+        }();
+        return topology;
+    }
+
+    std::vector<LogicalProcessor> PlanPlacement(const Topology& topology, size_t count) {
+        std::vector<LogicalProcessor> placement;
+        if (topology.processors.empty() || count == 0) {
+            return placement;
+        }
+
+        // 每个节点内按 "第几个超线程" 分层：先是各核心的第一个逻辑处理器，然后是第二个……
+        std::vector<std::vector<LogicalProcessor>> perNode(topology.nodeCount);
+        {
+            std::vector<std::vector<std::vector<LogicalProcessor>>> layers(topology.nodeCount);
+            unsigned previousCore = 0;
+            size_t sibling = 0;
+            bool first = true;
+            for (const LogicalProcessor& processor : topology.processors) {
+                sibling = (!first && processor.core == previousCore) ? sibling + 1 : 0;
+                previousCore = processor.core;
+                first = false;
+                std::vector<std::vector<LogicalProcessor>>& nodeLayers = layers[processor.node % topology.nodeCount];
+                if (nodeLayers.size() <= sibling) nodeLayers.resize(sibling + 1);
+                nodeLayers[sibling].push_back(processor);
+            }
+            for (size_t node = 0; node < layers.size(); ++node) {
+                for (const std::vector<LogicalProcessor>& layer : layers[node]) {
+                    perNode[node].insert(perNode[node].end(), layer.begin(), layer.end());
+                }
+            }
+        }
+
+        // 各节点轮流取下一个处理器
+        std::vector<LogicalProcessor> order;
+        order.reserve(topology.processors.size());
+        for (size_t rank = 0; order.size() < topology.processors.size(); ++rank) {
+            for (const std::vector<LogicalProcessor>& node : perNode) {
+                if (rank < node.size()) order.push_back(node[rank]);
+            }
+        }
+
+        placement.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            placement.push_back(order[i % order.size()]);
+        }
+        return placement;
+    }
+
+    bool PinCurrentThread(const LogicalProcessor& processor) {
+        GROUP_AFFINITY affinity;
+        ZeroMemory(&affinity, sizeof(affinity));
+        affinity.Group = processor.group;
+        affinity.Mask = static_cast<KAFFINITY>(1) << processor.number;
+        if (!SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr)) {
+            LOG_WARNING(L"SetThreadGroupAffinity failed for processor ", processor.group, L":", static_cast<unsigned>(processor.number), L". Error: ", GetLastError());
+            return false;
+        }
+        return true;
+    }
+
+} // namespace CpuTopology
@@ -0,0 +1,47 @@
+#ifndef CPU_TOPOLOGY_H
+#define CPU_TOPOLOGY_H
+
+#include <cstddef>
+#include <vector>
+
+// CPU 拓扑：
+// 查询逻辑处理器、物理核心与 NUMA 节点之间的对应关系 (GetLogicalProcessorInformationEx)，
+// 供线程池把工作线程绑定到核心，并让工作窃取优先选择同一 NUMA 节点上的线程。
+
+namespace CpuTopology {
+
+    struct LogicalProcessor {
+        unsigned short group = 0;  // 处理器组 (超过 64 个逻辑处理器的系统有多个组)
+        unsigned char number = 0;  // 组内编号
+        unsigned core = 0;         // 物理核心编号 (同一核心上的超线程相同)
+        unsigned node = 0;         // NUMA 节点编号 (从 0 开始连续编号)
+    };
+
+    struct Topology {
+        std::vector<LogicalProcessor> processors; // 按 NUMA 节点、核心、组内编号排序
+        size_t coreCount = 0;
+        size_t nodeCount = 0;
+    };
+
+    /**
+     * @brief 获取本机的 CPU 拓扑 (首次调用时查询系统并缓存)。
+     * @note 查询失败时退化为单个 NUMA 节点、每个逻辑处理器一个核心。
+     */
+    const Topology& Get();
+
+    /**
+     * @brief 为 count 个线程选择逻辑处理器。
+     * @return 第 i 个元素是第 i 个线程应绑定的处理器。先给每个物理核心分配一个线程，
+     *         各 NUMA 节点轮流分配以均衡内存带宽；核心用完后再使用超线程，仍不够时从头循环。
+     */
+    std::vector<LogicalProcessor> PlanPlacement(const Topology& topology, size_t count);
+
+    /**
+     * @brief 把当前线程绑定到指定的逻辑处理器。
+     * @return 成功返回 true。
+     */
+    bool PinCurrentThread(const LogicalProcessor& processor);
+
+} // namespace CpuTopology
+
+#endif // CPU_TOPOLOGY_H
@@ -0,0 +1,431 @@
+#define LOG_MODULE LogModule::Update // 本文件的日志属于更新模块 (见 log.h)
+#include "install.h"
+#include "globals.h"
+#include "log.h"
+#include "system_ops.h"
+#include "utils.h"
+
+#include <algorithm> // For std::replace
+#include <sstream>
+#include <unordered_map>
+
+namespace Install {
+
+    const wchar_t* const kManifestFileName = L"files.manifest";
+
+    // 指针文件：内容为版本目录名
+    static const wchar_t* kCurrentPointer = L"current";
+    static const wchar_t* kPreviousPointer = L"previous";
+    // 切换后尚未确认启动成功的版本："<版本>"，该版本的进程开始运行后改为 "<版本> started"
+    static const wchar_t* kPendingPointer = L"pending";
+    static const wchar_t* kPendingStartedSuffix = L" started";
+
+    static std::wstring GetVersionsDir() {
+        return GetInstallRoot() + L"\\versions";
+    }
+
+    bool IsValidVersionName(const std::wstring& versionString) {
+        if (versionString.empty() || versionString.size() > 64 || versionString.front() == L'.' || versionString.back() == L'.') {
+            return false;
+        }
+        for (size_t i = 0; i < versionString.size(); ++i) {
+            wchar_t c = versionString[i];
+            if (c == L'.') {
+                if (versionString[i - 1] == L'.') return false;
+            }
+            else if (c < L'0' || c > L'9') {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool IsSafeRelativePath(const std::wstring& path) {
+        if (path.empty() || path[0] == L'\\' || path.find(L':') != std::wstring::npos) {
+            return false;
+        }
+        std::wstring wrapped = L"\\" + path + L"\\";
+        return wrapped.find(L"\\..\\") == std::wstring::npos;
+    }
+
+    static std::wstring ReadPointer(const wchar_t* name) {
+        std::string content;
+        if (!ReadFileToString(GetInstallRoot() + L"\\" + name, content)) {
+            return L"";
+        }
+        std::wstring value = Utf8ToWide(content);
+        size_t end = value.find_last_not_of(L" \t\r\n");
+        return end == std::wstring::npos ? L"" : value.substr(0, end + 1);
+    }
+
+    // 先写临时文件再用 MoveFileEx 替换，NTFS 上替换是原子的：读者只会看到旧值或新值
+    static bool WritePointer(const wchar_t* name, const std::wstring& value) {
+        std::wstring path = GetInstallRoot() + L"\\" + name;
+        std::wstring tempPath = path + L".tmp";
+        std::string utf8 = WideToUtf8(value);
+
+        HANDLE hFile = CreateFileW(tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) {
+            LOG_ERROR(L"Failed to create pointer file: ", tempPath.c_str(), L" Error: ", GetLastError());
+            return false;
+        }
+        DWORD written = 0;
+        bool ok = WriteFile(hFile, utf8.data(), static_cast<DWORD>(utf8.size()), &written, NULL) && written == utf8.size();
+        ok = FlushFileBuffers(hFile) && ok;
+        CloseHandle(hFile);
+
+        if (!ok || !MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            LOG_ERROR(L"Failed to update pointer file: ", path.c_str(), L" Error: ", GetLastError());
+            DeleteFileW(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    static bool GetFileSize64(const std::wstring& path, unsigned long long& outSize) {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data) || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            return false;
+        }
+        outSize = (static_cast<unsigned long long>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        return true;
+    }
+
+    // 删除旧版本目录时会清除文件的只读属性，而硬链接共享属性：删除后给保留的版本重新设置
+    static void MarkVersionReadOnly(const std::wstring& versionDir) {
+        std::vector<FileRecord> files;
+        if (!LoadManifest(versionDir + L"\\" + kManifestFileName, files)) {
+            return;
+        }
+        for (const FileRecord& record : files) {
+            SetFileAttributesW((versionDir + L"\\" + record.relativePath).c_str(), FILE_ATTRIBUTE_READONLY);
+        }
+    }
+
+    bool LoadManifest(const std::wstring& manifestPath, std::vector<FileRecord>& outRecords) {
+        outRecords.clear();
+        std::string content;
+        if (!ReadFileToString(manifestPath, content)) {
+            return false;
+        }
+
+        std::istringstream stream(content);
+        std::string line;
+        while (std::getline(stream, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+
+            // 路径放在最后，可以包含空格
+            size_t firstSpace = line.find(' ');
+            size_t secondSpace = firstSpace == std::string::npos ? std::string::npos : line.find(' ', firstSpace + 1);
+            if (secondSpace == std::string::npos) {
+                LOG_WARNING(L"Malformed manifest line: ", Utf8ToWide(line).c_str());
+                return false;
+            }
+
+            FileRecord record;
+            record.hash = line.substr(0, firstSpace);
+            try {
+                record.size = std::stoull(line.substr(firstSpace + 1, secondSpace - firstSpace - 1));
+            }
+            catch (const std::exception&) {
+                LOG_WARNING(L"Invalid size in manifest line: ", Utf8ToWide(line).c_str());
+                return false;
+            }
+            record.relativePath = Utf8ToWide(line.substr(secondSpace + 1));
+            std::replace(record.relativePath.begin(), record.relativePath.end(), L'/', L'\\');
+
+            if (record.hash.size() != 64 || !IsSafeRelativePath(record.relativePath)) {
+                LOG_WARNING(L"Rejected manifest entry: ", Utf8ToWide(line).c_str());
+                return false;
+            }
+            outRecords.push_back(std::move(record));
+        }
+        return true;
+    }
+
+    std::wstring GetInstallRoot() {
+        return g_appDataDir + L"\\App";
+    }
+
+    std::wstring GetCurrentVersionDir() {
+        std::wstring current = ReadPointer(kCurrentPointer);
+        if (!IsValidVersionName(current)) {
+            return L"";
+        }
+        std::wstring dir = GetVersionsDir() + L"\\" + current;
+        return DirectoryExists(dir) ? dir : L"";
+    }
+
+    bool InstallStagedVersion(
+        const std::wstring& stagingDir,
+        const std::wstring& versionString,
+        std::function<void(long long, long long)> progressCallback,
+        std::wstring* outVersionDir,
+        const CancellationToken& cancellation)
+    {
+        if (!IsValidVersionName(versionString)) {
+            LOG_ERROR(L"Refusing to install invalid version name: ", versionString);
+            return false;
+        }
+        std::vector<FileRecord> files;
+        if (!LoadManifest(stagingDir + L"\\" + kManifestFileName, files)) {
+            LOG_ERROR(L"Staged update has no valid file manifest: ", stagingDir.c_str());
+            return false;
+        }
+
+        std::wstring versionsDir = GetVersionsDir();
+        std::wstring targetDir = versionsDir + L"\\" + versionString;
+        std::wstring buildDir = targetDir + L".partial";
+        std::wstring currentDir = GetCurrentVersionDir();
+
+        if (!currentDir.empty() && currentDir == targetDir) {
+            LOG_INFO(L"Version ", versionString, L" is already the current side-by-side installation.");
+            if (outVersionDir) *outVersionDir = targetDir;
+            return true;
+        }
+        if (!CreateDirectoryRecursive(versionsDir)) {
+            LOG_ERROR(L"Failed to create versions directory: ", versionsDir.c_str());
+            return false;
+        }
+        // 上次中断留下的半成品；目标目录不是当前版本，可以安全重建
+        if (!DeleteDirectoryUnder(versionsDir, buildDir) || !DeleteDirectoryUnder(versionsDir, targetDir)) {
+            LOG_ERROR(L"Failed to clear old version directory: ", targetDir.c_str());
+            return false;
+        }
+        if (!currentDir.empty()) {
+            MarkVersionReadOnly(currentDir);
+        }
+
+        // 当前版本中可复用的文件：hash -> 路径。
+        // 首次并排安装时没有旧清单，退而检查程序目录中同路径同大小的文件。
+        // 程序目录不受版本目录只读约定的保护 (可能被外部安装程序原地改写)，从那里复用的文件复制而不是硬链接。
+        std::unordered_map<std::string, std::wstring> reusable;
+        bool reuseByLink = !currentDir.empty();
+        if (!currentDir.empty()) {
+            std::vector<FileRecord> currentFiles;
+            if (LoadManifest(currentDir + L"\\" + kManifestFileName, currentFiles)) {
+                for (const FileRecord& record : currentFiles) {
+                    reusable.emplace(record.hash, currentDir + L"\\" + record.relativePath);
+                }
+            }
+        }
+        else {
+            std::wstring exeDir = GetExecutableDir();
+            for (const FileRecord& record : files) {
+                std::wstring candidate = exeDir + L"\\" + record.relativePath;
+                unsigned long long size = 0;
+                std::string hash;
+                if (GetFileSize64(candidate, size) && size == record.size && Sha256FileHex(candidate, hash) && hash == record.hash) {
+                    reusable.emplace(record.hash, candidate);
+                }
+            }
+        }
+
+        long long totalBytes = 0;
+        for (const FileRecord& record : files) {
+            totalBytes += static_cast<long long>(record.size);
+        }
+        long long doneBytes = 0;
+        unsigned long long linkedBytes = 0, movedBytes = 0, copiedBytes = 0;
+
+        for (const FileRecord& record : files) {
+            if (cancellation.IsCancellationRequested()) {
+                LOG_INFO(L"Side-by-side installation of version ", versionString, L" canceled.");
+                DeleteDirectoryUnder(versionsDir, buildDir);
+                return false;
+            }
+            std::wstring dest = buildDir + L"\\" + record.relativePath;
+            std::wstring destDir = dest.substr(0, dest.find_last_of(L'\\'));
+            if (!DirectoryExists(destDir) && !CreateDirectoryRecursive(destDir)) {
+                LOG_ERROR(L"Failed to create directory in new version: ", destDir.c_str());
+                DeleteDirectoryUnder(versionsDir, buildDir);
+                return false;
+            }
+
+            bool placed = false;
+            auto reuse = reusable.find(record.hash);
+            if (reuse != reusable.end()) {
+                // 未变化的文件：硬链接不产生数据 I/O；跨卷等情况下退化为复制
+                if (reuseByLink && CreateHardLinkW(dest.c_str(), reuse->second.c_str(), NULL)) {
+                    linkedBytes += record.size;
+                    placed = true;
+                }
+                else if (CopyFileW(reuse->second.c_str(), dest.c_str(), TRUE)) {
+                    copiedBytes += record.size;
+                    placed = true;
+                }
+            }
+
+            if (!placed) {
+                std::wstring staged = stagingDir + L"\\" + record.relativePath;
+                std::string hash;
+                if (!Sha256FileHex(staged, hash) || hash != record.hash) {
+                    LOG_ERROR(L"Changed file missing from update package or hash mismatch: ", record.relativePath.c_str());
+                    DeleteDirectoryUnder(versionsDir, buildDir);
+                    return false;
+                }
+                // 暂存目录与安装目录同在 g_appDataDir 下，通常只是重命名
+                if (!MoveFileExW(staged.c_str(), dest.c_str(), MOVEFILE_COPY_ALLOWED)) {
+                    LOG_ERROR(L"Failed to move staged file into new version: ", staged.c_str(), L" Error: ", GetLastError());
+                    DeleteDirectoryUnder(versionsDir, buildDir);
+                    return false;
+                }
+                movedBytes += record.size;
+            }
+
+            // 硬链接共享数据和属性：只读属性让任何原地写入失败，而不是悄悄改掉其他版本中的同一个文件
+            if (!SetFileAttributesW(dest.c_str(), FILE_ATTRIBUTE_READONLY)) {
+                LOG_WARNING(L"Failed to mark installed file read-only: ", dest.c_str(), L" Error: ", GetLastError());
+            }
+
+            doneBytes += static_cast<long long>(record.size);
+            if (progressCallback) {
+                progressCallback(doneBytes, totalBytes);
+            }
+        }
+
+        std::wstring manifestDest = buildDir + L"\\" + kManifestFileName;
+        if (!CopyFileW((stagingDir + L"\\" + kManifestFileName).c_str(), manifestDest.c_str(), FALSE)) {
+            LOG_ERROR(L"Failed to copy manifest into new version: ", manifestDest.c_str());
+            DeleteDirectoryUnder(versionsDir, buildDir);
+            return false;
+        }
+        SetFileAttributesW(manifestDest.c_str(), FILE_ATTRIBUTE_READONLY);
+
+        // 构建完成后才把目录改成正式名称，指针永远不会指向半成品
+        if (!MoveFileExW(buildDir.c_str(), targetDir.c_str(), 0)) {
+            LOG_ERROR(L"Failed to finalize version directory: ", targetDir.c_str(), L" Error: ", GetLastError());
+            DeleteDirectoryUnder(versionsDir, buildDir);
+            return false;
+        }
+
+        std::wstring previousName = ReadPointer(kCurrentPointer);
+        if (!previousName.empty()) {
+            WritePointer(kPreviousPointer, previousName);
+        }
+        if (!WritePointer(kCurrentPointer, versionString)) {
+            return false;
+        }
+        WritePointer(kPendingPointer, versionString);
+
+        LOG_INFO(L"Installed version ", versionString, L" side by side. Linked: ", linkedBytes,
+            L" bytes, moved: ", movedBytes, L" bytes, copied: ", copiedBytes, L" bytes.");
+        if (outVersionDir) *outVersionDir = targetDir;
+        return true;
+    }
+
+    bool RollbackToPreviousVersion() {
+        std::wstring previous = ReadPointer(kPreviousPointer);
+        std::wstring current = ReadPointer(kCurrentPointer);
+        if (!IsValidVersionName(previous) || !DirectoryExists(GetVersionsDir() + L"\\" + previous)) {
+            if (current.empty()) {
+                LOG_WARNING(L"No previous version available for rollback.");
+                return false;
+            }
+            // 第一次并排安装之前运行的是程序目录中的原始安装：删除指针即回到它
+            if (!DeleteFileW((GetInstallRoot() + L"\\" + kCurrentPointer).c_str()) && GetLastError() != ERROR_FILE_NOT_FOUND) {
+                LOG_ERROR(L"Failed to remove current version pointer. Error: ", GetLastError());
+                return false;
+            }
+            LOG_INFO(L"Rolled back from version ", current, L" to the original installation.");
+            return true;
+        }
+        if (!WritePointer(kCurrentPointer, previous)) {
+            return false;
+        }
+        if (!current.empty()) {
+            WritePointer(kPreviousPointer, current);
+        }
+        LOG_INFO(L"Rolled back from version ", current, L" to ", previous);
+        return true;
+    }
+
+    bool RedirectToCurrentVersion(const std::wstring& commandLine) {
+        std::wstring pending = ReadPointer(kPendingPointer);
+        std::wstring pendingVersion = pending.substr(0, pending.find(L' '));
+        if (!pending.empty() && pendingVersion != ReadPointer(kCurrentPointer)) {
+            // 已经手动回滚或安装了其他版本
+            DeleteFileW((GetInstallRoot() + L"\\" + kPendingPointer).c_str());
+            pending.clear();
+        }
+        if (!pending.empty() && pending != pendingVersion) {
+            LOG_WARNING(L"Version ", pendingVersion, L" did not finish its first start. Rolling back.");
+            if (RollbackToPreviousVersion()) {
+                DeleteFileW((GetInstallRoot() + L"\\" + kPendingPointer).c_str());
+            }
+            pending.clear();
+        }
+
+        std::wstring currentDir = GetCurrentVersionDir();
+        if (currentDir.empty()) {
+            return false;
+        }
+        if (lstrcmpiW(GetExecutableDir().c_str(), currentDir.c_str()) == 0) {
+            if (!pending.empty()) {
+                // 本进程就是待确认的新版本：在 ConfirmVersionStarted 之前退出的话，下次启动时回滚
+                WritePointer(kPendingPointer, pendingVersion + kPendingStartedSuffix);
+            }
+            return false;
+        }
+
+        std::wstring exePath = GetExecutablePath();
+        std::wstring targetPath = currentDir + exePath.substr(exePath.find_last_of(L"\\/"));
+        if (!FileExists(targetPath)) {
+            LOG_WARNING(L"Current version directory has no executable, running this installation: ", targetPath.c_str());
+            return false;
+        }
+        PROCESS_INFORMATION pi;
+        if (!SystemOps::ExecuteProcess(targetPath, commandLine, currentDir, false, &pi, false)) {
+            LOG_ERROR(L"Failed to start current version: ", targetPath.c_str());
+            return false;
+        }
+        LOG_INFO(L"Started current version: ", targetPath.c_str(), L" PID: ", pi.dwProcessId);
+        CloseHandle(pi.hProcess);
+        CloseHandle(pi.hThread);
+        return true;
+    }
+
+    void ConfirmVersionStarted() {
+        std::wstring pending = ReadPointer(kPendingPointer);
+        if (pending.empty()) {
+            return;
+        }
+        if (DeleteFileW((GetInstallRoot() + L"\\" + kPendingPointer).c_str())) {
+            LOG_INFO(L"Version ", pending.substr(0, pending.find(L' ')), L" started successfully.");
+        }
+    }
+
+    size_t RemoveStaleVersions() {
+        std::wstring current = ReadPointer(kCurrentPointer);
+        std::wstring previous = ReadPointer(kPreviousPointer);
+        std::wstring versionsDir = GetVersionsDir();
+
+        size_t removed = 0;
+        WIN32_FIND_DATAW findData;
+        HANDLE hFind = FindFirstFileW((versionsDir + L"\\*").c_str(), &findData);
+        if (hFind == INVALID_HANDLE_VALUE) {
+            return 0;
+        }
+        do {
+            std::wstring name = findData.cFileName;
+            if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || name == L"." || name == L".." || name == current || name == previous) {
+                continue;
+            }
+            if (DeleteDirectoryUnder(versionsDir, versionsDir + L"\\" + name)) {
+                LOG_INFO(L"Removed stale version directory: ", name);
+                ++removed;
+            }
+        } while (FindNextFileW(hFind, &findData));
+        FindClose(hFind);
+
+        if (removed > 0) {
+            if (IsValidVersionName(current)) MarkVersionReadOnly(versionsDir + L"\\" + current);
+            if (IsValidVersionName(previous)) MarkVersionReadOnly(versionsDir + L"\\" + previous);
+        }
+        return removed;
+    }
+
+} // namespace Install
@@ -0,0 +1,103 @@
+#ifndef INSTALL_H
+#define INSTALL_H
+
+#include <string>
+#include <vector>
+#include <functional> // For std::function (progress callback)
+
+#include "cancellation.h"
+
+// 并排 (side-by-side) 安装引擎：
+// 每个版本安装在 <安装根目录>\versions\<版本> 下，互不覆盖。新版本目录在当前版本旁边构建，
+// 与当前版本内容相同的文件 (按清单中的 SHA-256 判断) 直接建立硬链接，只有变化的文件才从暂存目录移入。
+// 切换版本只是原子地替换 "current" 指针文件，回滚同样只需把指针指回上一个版本。
+// 程序启动时由 RedirectToCurrentVersion 跟随指针启动当前版本；新版本首次启动没有成功时自动回滚，
+// 也可以用命令行开关 --rollback 手动回滚。
+// 注意：版本目录之间通过硬链接共享数据，安装后的版本目录是只读的：安装时每个文件都设置只读属性，
+// 原地写入会失败而不会改动其他版本。配置、日志等可写数据都在 g_appDataDir 中，不放在版本目录里。
+// 首次并排安装从程序目录复用的文件是复制的，程序目录本身不受影响。
+
+namespace Install {
+
+    // 文件清单名：位于暂存目录和每个版本目录的根目录
+    // 每行格式：<sha256> <字节数> <相对路径>
+    extern const wchar_t* const kManifestFileName;
+
+    struct FileRecord {
+        std::string hash;           // SHA-256 (小写十六进制)
+        unsigned long long size;    // 文件大小
+        std::wstring relativePath;  // 相对于版本目录的路径 ('\' 分隔)
+    };
+
+    /**
+     * @brief 读取文件清单。
+     * @param manifestPath 清单文件路径。
+     * @param outRecords [out] 清单中的文件记录。
+     * @return 读取并解析成功返回 true。
+     */
+    bool LoadManifest(const std::wstring& manifestPath, std::vector<FileRecord>& outRecords);
+
+    /**
+     * @brief 检查版本号能否用作版本目录名：只由数字和点组成 (例如 "1.2.3")，不以点开头或结尾，没有连续的点。
+     * @note 版本号来自更新服务器，必须先通过这个检查才能拼接到路径中。
+     */
+    bool IsValidVersionName(const std::wstring& versionString);
+
+    /**
+     * @brief 获取并排安装的根目录 (g_appDataDir\App)。
+     */
+    std::wstring GetInstallRoot();
+
+    /**
+     * @brief 获取 "current" 指针指向的版本目录。
+     * @return 版本目录的完整路径；尚未进行过并排安装时返回空字符串。
+     */
+    std::wstring GetCurrentVersionDir();
+
+    /**
+     * @brief 用暂存目录中的文件构建新版本目录并原子切换到该版本。
+     * @param stagingDir 解压后的暂存目录，根目录须包含文件清单。
+     *        暂存目录可以只包含变化的文件，未变化的文件从当前版本硬链接。
+     * @param versionString 新版本号 (用作版本目录名)。
+     * @param progressCallback 进度回调 (已处理字节数, 总字节数)。
+     * @param outVersionDir [out] 新版本目录的完整路径 (可选)。
+     * @param cancellation 取消令牌 (可选)：切换之前被取消时删除未完成的版本目录并返回 false。
+     * @return 新版本构建完成并已切换为当前版本时返回 true。
+     */
+    bool InstallStagedVersion(
+        const std::wstring& stagingDir,
+        const std::wstring& versionString,
+        std::function<void(long long, long long)> progressCallback = nullptr,
+        std::wstring* outVersionDir = nullptr,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+    /**
+     * @brief 把 "current" 指针切回上一个版本 (只修改指针，不复制任何文件)。
+     *        没有上一个并排版本时删除 "current" 指针，回到程序目录中的原始安装。
+     * @return 存在可回退的版本且切换成功返回 true。
+     */
+    bool RollbackToPreviousVersion();
+
+    /**
+     * @brief 启动时调用：如果 "current" 指向的版本不是正在运行的这个程序，启动该版本并返回 true，调用方应立即退出。
+     *        新安装的版本上一次启动没有调用 ConfirmVersionStarted (启动失败或崩溃) 时，先自动回滚到上一个版本。
+     * @param commandLine 转发给新进程的命令行参数。
+     * @return 已启动 "current" 版本的进程时返回 true；应继续在本进程中运行时返回 false。
+     */
+    bool RedirectToCurrentVersion(const std::wstring& commandLine);
+
+    /**
+     * @brief 新版本首次启动成功 (主窗口已创建) 后调用，清除待确认标记，之后不再因启动失败而自动回滚。
+     */
+    void ConfirmVersionStarted();
+
+    /**
+     * @brief 删除既不是当前版本也不是上一个版本的旧版本目录。
+     * @return 删除的版本目录数量。
+     */
+    size_t RemoveStaleVersions();
+
+} // namespace Install
+
+#endif // INSTALL_H
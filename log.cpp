@@ -1,105 +1,1027 @@
-#include "log.h"
-#include "globals.h" // ڻȡ־ļ·
-#include <iostream>  // ־ļʧʱ̨
-#include <time.h>    // For time_t, tm, localtime_s, wcsftime
-
-// Logger class implementation
-Logger::Logger() : m_logLevel(LogLevel::DEBUG) { // Ĭ־
-    // Constructor
-}
-
-Logger::~Logger() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_logFile.is_open()) {
-        m_logFile.flush();
-        m_logFile.close();
-    }
-}
-
-Logger& Logger::GetInstance() {
-    static Logger instance;
-    return instance;
-}
-
-void Logger::SetLogLevel(LogLevel level) {
-    m_logLevel = level;
-}
-
-bool Logger::SetLogFile(const std::wstring& filePath) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_logFile.is_open()) {
-        m_logFile.close();
-    }
-    // Open in append mode. Use std::ios_base::app for wofstream as well.
-    m_logFile.open(filePath, std::ios_base::out | std::ios_base::app);
-    if (!m_logFile.is_open()) {
-        std::wcerr << L"Failed to open log file: " << filePath << std::endl;
-        return false;
-    }
-    // Set locale for the file stream to handle Unicode correctly, especially if writing UTF-8
-    // This might be needed if default locale causes issues with wofstream and Unicode.
-    // try {
-    //     m_logFile.imbue(std::locale(std::locale(), new std::codecvt_utf8<wchar_t>));
-    // } catch (const std::exception& e) {
-    //     std::wcerr << L"Warning: Could not imbue UTF-8 locale to log file: " << e.what() << std::endl;
-    // }
-
-    m_logFile << GetTimestamp() << L" [INFO] Log file opened. Logging level: " << LogLevelToString(m_logLevel) << std::endl;
-    return true;
-}
-
-void Logger::LogInternal(LogLevel level, std::wstringstream& wss) {
-    // This function assumes level check has been done by the caller (Log template function)
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (!m_logFile.is_open()) {
-        // Fallback: print to console if file not open
-        std::wcerr << GetTimestamp() << L" [" << LogLevelToString(level) << L"] " << wss.str() << std::endl;
-        return;
-    }
-
-    m_logFile << GetTimestamp() << L" [" << LogLevelToString(level) << L"] " << wss.str() << std::endl;
-    m_logFile.flush();
-
-    if (level == LogLevel::FATAL) {
-        // For FATAL errors, consider more drastic actions if needed, e.g.,
-        // m_logFile.close();
-        // exit(EXIT_FAILURE); // Or std::terminate();
-    }
-}
-
-
-std::wstring Logger::LogLevelToString(LogLevel level) {
-    switch (level) {
-    case LogLevel::DEBUG:   return L"DEBUG";
-    case LogLevel::INFO:    return L"INFO";
-    case LogLevel::WARNING: return L"WARNING";
-    //case LogLevel::ERROR:   return L"ERROR";/*THis is wrong*/
-    case LogLevel::FATAL:   return L"FATAL"; // C2838 was on the template declaration, not here.
-    default:                return L"UNKNOWN";
-    }
-}
-
-std::wstring Logger::GetTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto now_c = std::chrono::system_clock::to_time_t(now);
-
-    std::tm timeinfo_tm; // Use a local tm struct for localtime_s
-
-    // Use localtime_s for safety (C4996)
-    if (localtime_s(&timeinfo_tm, &now_c) != 0) {
-        // Error handling for localtime_s
-        return L"[Error getting time] ";
-    }
-
-    std::wstringstream wss;
-    // std::put_time is fine with VS2022 and <iomanip>
-    // The error C2589, C2062 was likely due to missing <iomanip> or incorrect usage context.
-    // Ensure <iomanip> is included in log.h.
-    wss << std::put_time(&timeinfo_tm, L"%Y-%m-%d %H:%M:%S");
-
-    // Add milliseconds
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
-    wss << L'.' << std::setfill(L'0') << std::setw(3) << ms.count();
-
-    return wss.str();
-}
+#include "log.h"
+#include "globals.h" // 用于获取日志文件路径
+#include "config.h"
+#include "utils.h"       // For ReadFileToString
+#include "compression.h" // For GzipCompress
+#include <iostream>  // 用于在日志文件打开失败时输出到控制台
+#include <time.h>    // For time_t, tm, localtime_s, wcsftime
+#include <algorithm> // For std::max, std::sort
+#include <map>
+
+// Logger class implementation
+Logger::Logger()
+    : m_stageText(false),
+    m_logLevel(LogLevel::DEBUG), // 默认日志级别
+    m_format(LogOutputFormat::Text),
+    m_maxFileBytes(LoggerOptions().maxFileBytes),
+    m_rotateDaily(LoggerOptions().rotateDaily),
+    m_maxArchives(LoggerOptions().maxArchives),
+    m_compressArchives(LoggerOptions().compressArchives),
+    m_fileBytes(0),
+    m_archivePending(false),
+    m_stopArchiver(false),
+    m_queue(nullptr),
+    m_async(false),
+    m_overflowPolicy(static_cast<int>(LogOverflowPolicy::Block)),
+    m_sampleRate(16),
+    m_batchSize(256),
+    m_writerSleeping(false),
+    m_stopWriter(false),
+    m_drainWaiters(0),
+    m_flushRequested(0),
+    m_flushCompleted(0),
+    m_dropped(0),
+    m_sampledOut(0),
+    m_sampleCounter(0) {
+    for (size_t i = 0; i < kModuleCount; ++i) {
+        m_moduleOverrides[i] = -1;
+        m_moduleLevels[i].store(static_cast<int>(LogLevel::DEBUG));
+    }
+}
+
+Logger::~Logger() {
+    // 先停归档线程 (它也会写日志)；尚未压缩的归档留给下一次轮转处理
+    {
+        std::lock_guard<std::mutex> lock(m_archiveMutex);
+        m_stopArchiver.store(true);
+    }
+    m_archiveCondition.notify_all();
+    if (m_archiver.joinable()) {
+        m_archiver.join();
+    }
+    StopWriter();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CloseFilesLocked();
+}
+
+Logger& Logger::GetInstance() {
+    static Logger instance;
+    return instance;
+}
+
+void Logger::SetLogLevel(LogLevel level) {
+    std::lock_guard<std::mutex> lock(m_levelMutex);
+    m_logLevel = level;
+    UpdateModuleLevelsLocked();
+}
+
+void Logger::SetModuleLevel(LogModule module, LogLevel level) {
+    std::lock_guard<std::mutex> lock(m_levelMutex);
+    m_moduleOverrides[static_cast<size_t>(module)] = static_cast<int>(level);
+    UpdateModuleLevelsLocked();
+}
+
+void Logger::ClearModuleLevel(LogModule module) {
+    std::lock_guard<std::mutex> lock(m_levelMutex);
+    m_moduleOverrides[static_cast<size_t>(module)] = -1;
+    UpdateModuleLevelsLocked();
+}
+
+void Logger::UpdateModuleLevelsLocked() {
+    for (size_t i = 0; i < kModuleCount; ++i) {
+        int level = m_moduleOverrides[i] >= 0 ? m_moduleOverrides[i] : static_cast<int>(m_logLevel.load());
+        m_moduleLevels[i].store(level, std::memory_order_relaxed);
+    }
+}
+
+static bool ParseLogLevel(const std::wstring& text, LogLevel& level) {
+    if (text == L"Debug") level = LogLevel::DEBUG;
+    else if (text == L"Info") level = LogLevel::INFO;
+    else if (text == L"Warning") level = LogLevel::WARNING;
+    else if (text == L"Error") level = LogLevel::ERR;
+    else if (text == L"Fatal") level = LogLevel::FATAL;
+    else return false;
+    return true;
+}
+
+void Logger::ApplyLevels(const Config& config) {
+    static const struct {
+        LogModule module;
+        const wchar_t* key;
+    } kModuleKeys[] = {
+        { LogModule::Network, L"NetworkLevel" },
+        { LogModule::Update, L"UpdateLevel" },
+        { LogModule::Threads, L"ThreadsLevel" },
+        { LogModule::Config, L"ConfigLevel" },
+    };
+
+    // 先在锁外读取配置：配置的读取本身可能记录日志
+    const wchar_t* section = L"Log";
+    LogLevel global;
+    std::wstring globalText = config.GetString(section, L"Level", L"");
+    bool hasGlobal = ParseLogLevel(globalText, global);
+    if (!hasGlobal && !globalText.empty()) {
+        LOG_WARNING(L"Unknown [Log] Level: ", globalText.c_str());
+    }
+    int overrides[kModuleCount];
+    for (size_t i = 0; i < kModuleCount; ++i) {
+        overrides[i] = -1;
+    }
+    for (const auto& entry : kModuleKeys) {
+        std::wstring text = config.GetString(section, entry.key, L"");
+        LogLevel level;
+        if (ParseLogLevel(text, level)) {
+            overrides[static_cast<size_t>(entry.module)] = static_cast<int>(level);
+        }
+        else if (!text.empty()) {
+            LOG_WARNING(L"Unknown [Log] level:", (std::wstring(entry.key) + L"=" + text).c_str());
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_levelMutex);
+    if (hasGlobal) {
+        m_logLevel = global;
+    }
+    for (size_t i = 0; i < kModuleCount; ++i) {
+        m_moduleOverrides[i] = overrides[i];
+    }
+    UpdateModuleLevelsLocked();
+}
+
+namespace {
+
+    // 去掉扩展名的路径，例如 C:\\dir\\app.log -> C:\\dir\\app
+    std::wstring StripExtension(const std::wstring& path) {
+        size_t slash = path.find_last_of(L"\\/");
+        size_t dot = path.find_last_of(L'.');
+        if (dot != std::wstring::npos && (slash == std::wstring::npos || dot > slash)) {
+            return path.substr(0, dot);
+        }
+        return path;
+    }
+
+    std::wstring BinaryLogPath(const std::wstring& logFilePath) {
+        return StripExtension(logFilePath) + L".nlog";
+    }
+
+    bool QueryFile(const std::wstring& path, uint64_t& size, std::chrono::system_clock::time_point& lastWrite) {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data) || (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+            return false;
+        }
+        size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        // FILETIME 为 1601 年起的 100 纳秒数
+        uint64_t ticks = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) | data.ftLastWriteTime.dwLowDateTime;
+        const uint64_t kEpochDifference = 116444736000000000ull; // 1601-01-01 到 1970-01-01
+        int64_t unixMicroseconds = ticks >= kEpochDifference ? static_cast<int64_t>((ticks - kEpochDifference) / 10) : 0;
+        lastWrite = std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(
+            std::chrono::microseconds(unixMicroseconds)));
+        return true;
+    }
+
+    // time 所在的本地日期的零点 (dayOffset 为 1 时是下一天的零点)
+    std::chrono::system_clock::time_point LocalMidnight(std::chrono::system_clock::time_point time, int dayOffset) {
+        std::time_t t = std::chrono::system_clock::to_time_t(time);
+        std::tm local;
+        if (localtime_s(&local, &t) != 0) {
+            return time + std::chrono::hours(24 * dayOffset);
+        }
+        local.tm_hour = 0;
+        local.tm_min = 0;
+        local.tm_sec = 0;
+        local.tm_mday += dayOffset;
+        local.tm_isdst = -1;
+        return std::chrono::system_clock::from_time_t(std::mktime(&local));
+    }
+
+    // 归档文件名中的时间戳：yyyyMMdd-HHmmss (按文件名排序即按时间排序)
+    const size_t kStampLength = 15;
+
+    std::wstring FormatStamp(std::chrono::system_clock::time_point time) {
+        std::time_t t = std::chrono::system_clock::to_time_t(time);
+        std::tm local;
+        if (localtime_s(&local, &t) != 0) {
+            return L"00000000-000000";
+        }
+        wchar_t buffer[32];
+        std::wcsftime(buffer, sizeof(buffer) / sizeof(buffer[0]), L"%Y%m%d-%H%M%S", &local);
+        return buffer;
+    }
+
+    bool IsStamp(const std::wstring& text, size_t offset) {
+        if (text.size() < offset + kStampLength) return false;
+        for (size_t i = 0; i < kStampLength; ++i) {
+            wchar_t c = text[offset + i];
+            if (i == 8 ? c != L'-' : (c < L'0' || c > L'9')) return false;
+        }
+        return true;
+    }
+
+    // 归档的先后顺序：时间戳，同一秒内再按序号 (没有序号的最早)
+    unsigned ArchiveSequence(const std::wstring& name, size_t stampOffset) {
+        size_t pos = stampOffset + kStampLength;
+        unsigned sequence = 0;
+        if (pos < name.size() && name[pos] == L'-') {
+            while (++pos < name.size() && name[pos] >= L'0' && name[pos] <= L'9') {
+                sequence = sequence * 10 + static_cast<unsigned>(name[pos] - L'0');
+            }
+        }
+        return sequence;
+    }
+
+    // 把 path 改名为同目录下的 <文件名>.<时间戳>.<扩展名>；同一秒内多次轮转时追加序号。返回归档路径，失败时返回空字符串
+    std::wstring MoveToArchive(const std::wstring& path, const std::wstring& stamp) {
+        std::wstring stem = StripExtension(path);
+        std::wstring extension = path.substr(stem.size());
+        for (int attempt = 0; attempt < 100; ++attempt) {
+            std::wstring archive = stem + L"." + stamp + (attempt ? L"-" + std::to_wstring(attempt) : L"") + extension;
+            if (FileExists(archive) || FileExists(archive + L".gz")) continue;
+            return MoveFileExW(path.c_str(), archive.c_str(), 0) ? archive : std::wstring();
+        }
+        return std::wstring();
+    }
+
+    bool GzipFile(const std::wstring& path, uint64_t& compressedSize) {
+        std::string content;
+        if (!ReadFileToString(path, content)) {
+            return false;
+        }
+        std::vector<uint8_t> compressed;
+        Compression::GzipCompress(reinterpret_cast<const uint8_t*>(content.data()), content.size(), compressed);
+
+        // 先写临时文件再改名：中途退出不会留下不完整的 .gz
+        std::wstring target = path + L".gz";
+        std::wstring temp = target + L".tmp";
+        {
+            std::ofstream out(temp, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+            out.write(reinterpret_cast<const char*>(compressed.data()), static_cast<std::streamsize>(compressed.size()));
+            if (!out) {
+                out.close();
+                DeleteFileW(temp.c_str());
+                return false;
+            }
+        }
+        if (!MoveFileExW(temp.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            DeleteFileW(temp.c_str());
+            return false;
+        }
+        DeleteFileW(path.c_str());
+        compressedSize = compressed.size();
+        return true;
+    }
+
+} // namespace
+
+bool Logger::SetLogFile(const std::wstring& filePath) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 缓冲区中的记录属于旧文件
+    WriteBatchLocked(SIZE_MAX);
+    CloseFilesLocked();
+    m_logFilePath = filePath;
+    if (filePath.empty()) {
+        return true; // 只关闭文件
+    }
+
+    // 上次运行留下的文件不是今天写的：先归档再开始新的一天
+    uint64_t size;
+    std::chrono::system_clock::time_point lastWrite;
+    auto now = std::chrono::system_clock::now();
+    bool opened;
+    if (m_rotateDaily && QueryFile(filePath, size, lastWrite) && size > 0 && lastWrite < LocalMidnight(now, 0)) {
+        RotateFilesLocked(lastWrite);
+        opened = m_logFile.IsOpen();
+    }
+    else {
+        opened = OpenFilesLocked();
+    }
+    FlushFilesLocked();
+    return opened;
+}
+
+bool Logger::LogFile::Open(const std::wstring& path) {
+    Close();
+    // FILE_APPEND_DATA：每次写入都追加到文件末尾；其他进程可以同时打开查看
+    m_handle = CreateFileW(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    return m_handle != INVALID_HANDLE_VALUE;
+}
+
+bool Logger::LogFile::Write(const std::string& data) {
+    const char* bytes = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        DWORD chunk = static_cast<DWORD>((std::min)(remaining, static_cast<size_t>(1) << 30));
+        DWORD written = 0;
+        if (!WriteFile(m_handle, bytes, chunk, &written, NULL) || written == 0) {
+            return false;
+        }
+        bytes += written;
+        remaining -= written;
+    }
+    return true;
+}
+
+void Logger::LogFile::Close() {
+    if (m_handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_handle);
+        m_handle = INVALID_HANDLE_VALUE;
+    }
+}
+
+bool Logger::OpenFilesLocked() {
+    OpenBinaryFileLocked();
+    if (!m_logFile.Open(m_logFilePath)) {
+        std::wcerr << L"Failed to open log file: " << m_logFilePath << std::endl;
+        return false;
+    }
+
+    // 轮转依据：已有内容的大小和下一个零点
+    uint64_t textSize = 0;
+    uint64_t binarySize = 0;
+    std::chrono::system_clock::time_point lastWrite;
+    QueryFile(m_logFilePath, textSize, lastWrite);
+    if (m_binaryFile.IsOpen()) {
+        QueryFile(BinaryLogPath(m_logFilePath), binarySize, lastWrite);
+    }
+    m_fileBytes = textSize + binarySize + m_binaryBuffer.size();
+    auto now = std::chrono::system_clock::now();
+    m_nextDailyRotation = LocalMidnight(now, 1);
+    m_stageText.store(!m_binaryFile.IsOpen(), std::memory_order_relaxed);
+
+    WriteTextLocked(LogLevel::INFO, now, L"Log file opened. Logging level: " + LogLevelToString(m_logLevel));
+    return true;
+}
+
+void Logger::CloseFilesLocked() {
+    m_stageText.store(false, std::memory_order_relaxed);
+    FlushFilesLocked();
+    m_logFile.Close();
+    m_binaryFile.Close();
+}
+
+bool Logger::RotationDueLocked(std::chrono::system_clock::time_point time) const {
+    if (m_logFilePath.empty() || time < m_rotationRetryAt) {
+        return false;
+    }
+    return (m_maxFileBytes != 0 && m_fileBytes >= m_maxFileBytes) || (m_rotateDaily && time >= m_nextDailyRotation);
+}
+
+void Logger::RotateFilesLocked(std::chrono::system_clock::time_point time) {
+    CloseFilesLocked();
+    // 改名只是元数据操作；压缩和清理旧文件交给归档线程
+    std::wstring stamp = FormatStamp(time);
+    std::wstring archive = MoveToArchive(m_logFilePath, stamp);
+    DWORD error = archive.empty() ? GetLastError() : 0;
+    if (m_format == LogOutputFormat::Binary && !archive.empty()) {
+        std::wstring binaryPath = BinaryLogPath(m_logFilePath);
+        if (FileExists(binaryPath)) {
+            MoveToArchive(binaryPath, stamp);
+        }
+    }
+
+    auto now = std::chrono::system_clock::now();
+    if (archive.empty()) {
+        // 文件可能被其他进程打开：继续追加，一分钟后再试
+        m_rotationRetryAt = now + std::chrono::minutes(1);
+    }
+    if (!OpenFilesLocked()) {
+        return;
+    }
+    if (archive.empty()) {
+        WriteTextLocked(LogLevel::WARNING, now, L"Log rotation failed. Error: " + std::to_wstring(error));
+        return;
+    }
+    WriteTextLocked(LogLevel::INFO, now, L"Log rotated. Previous file: " + archive);
+    ScheduleArchiveMaintenanceLocked();
+}
+
+void Logger::ScheduleArchiveMaintenanceLocked() {
+    if (!m_compressArchives && m_maxArchives == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_archiveMutex);
+    if (m_stopArchiver.load()) {
+        return;
+    }
+    m_archiveJob.logFilePath = m_logFilePath;
+    m_archiveJob.maxArchives = m_maxArchives;
+    m_archiveJob.compress = m_compressArchives;
+    m_archivePending = true;
+    if (!m_archiver.joinable()) {
+        m_archiver = std::thread(&Logger::ArchiveThread, this);
+    }
+    m_archiveCondition.notify_one();
+}
+
+void Logger::ArchiveThread() {
+    std::unique_lock<std::mutex> lock(m_archiveMutex);
+    for (;;) {
+        m_archiveCondition.wait(lock, [this] { return m_archivePending || m_stopArchiver.load(); });
+        if (m_stopArchiver.load()) {
+            break;
+        }
+        ArchiveJob job = m_archiveJob;
+        m_archivePending = false;
+        lock.unlock();
+        MaintainArchives(job);
+        lock.lock();
+    }
+}
+
+void Logger::MaintainArchives(const ArchiveJob& job) {
+    std::wstring stem = StripExtension(job.logFilePath);
+    size_t slash = stem.find_last_of(L"\\/");
+    std::wstring directory = slash == std::wstring::npos ? std::wstring(L".") : stem.substr(0, slash);
+    std::wstring prefix = (slash == std::wstring::npos ? stem : stem.substr(slash + 1)) + L".";
+
+    // 同一日志的归档：<文件名>.<时间戳>[-序号].<扩展名>[.gz]
+    std::vector<std::wstring> archives;
+    WIN32_FIND_DATAW data;
+    HANDLE find = FindFirstFileW((directory + L"\\" + prefix + L"*").c_str(), &data);
+    if (find != INVALID_HANDLE_VALUE) {
+        do {
+            std::wstring name = data.cFileName;
+            if (!(data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) &&
+                name.compare(0, prefix.size(), prefix) == 0 && IsStamp(name, prefix.size()) &&
+                name.find(L".tmp", prefix.size()) == std::wstring::npos) {
+                archives.push_back(name);
+            }
+        } while (FindNextFileW(find, &data));
+        FindClose(find);
+    }
+
+    const std::wstring gz = L".gz";
+    auto isCompressed = [&gz](const std::wstring& name) {
+        return name.size() > gz.size() && name.compare(name.size() - gz.size(), gz.size(), gz) == 0;
+    };
+
+    if (job.compress) {
+        for (std::wstring& name : archives) {
+            if (m_stopArchiver.load()) {
+                return;
+            }
+            if (isCompressed(name)) {
+                continue;
+            }
+            std::wstring path = directory + L"\\" + name;
+            uint64_t originalSize = 0;
+            uint64_t compressedSize = 0;
+            std::chrono::system_clock::time_point lastWrite;
+            QueryFile(path, originalSize, lastWrite);
+            if (GzipFile(path, compressedSize)) {
+                LOG_INFO(L"Compressed log archive", name, L"(", originalSize, L"->", compressedSize, L"bytes)");
+                name += gz;
+            }
+            else {
+                LOG_WARNING(L"Failed to compress log archive:", name);
+            }
+        }
+    }
+
+    if (job.maxArchives == 0) {
+        return;
+    }
+    // 文本和二进制归档分别保留最新的 maxArchives 个
+    std::map<std::wstring, std::vector<std::wstring>> byKind;
+    for (const std::wstring& name : archives) {
+        std::wstring base = isCompressed(name) ? name.substr(0, name.size() - gz.size()) : name;
+        size_t dot = base.find_last_of(L'.');
+        byKind[dot == std::wstring::npos ? std::wstring() : base.substr(dot)].push_back(name);
+    }
+    for (auto& entry : byKind) {
+        std::vector<std::wstring>& names = entry.second;
+        if (names.size() <= job.maxArchives) {
+            continue;
+        }
+        size_t stampOffset = prefix.size();
+        std::sort(names.begin(), names.end(), [stampOffset](const std::wstring& a, const std::wstring& b) {
+            int order = a.compare(stampOffset, kStampLength, b, stampOffset, kStampLength);
+            return order != 0 ? order < 0 : ArchiveSequence(a, stampOffset) < ArchiveSequence(b, stampOffset);
+        });
+        for (size_t i = 0; i + job.maxArchives < names.size(); ++i) {
+            if (DeleteFileW((directory + L"\\" + names[i]).c_str())) {
+                LOG_INFO(L"Deleted old log archive:", names[i]);
+            }
+        }
+    }
+}
+
+void Logger::LogInternal(LogLevel level, std::wstringstream& wss) {
+    // This function assumes level check has been done by the caller (Log template function)
+    LogRecord record;
+    record.level = level;
+    record.time = std::chrono::system_clock::now();
+    record.text = wss.str();
+    Submit(std::move(record));
+}
+
+void Logger::Submit(LogRecord&& record) {
+    LogLevel level = record.level;
+    if (m_async.load(std::memory_order_acquire)) {
+        RecordQueue* queue = m_queue.load(std::memory_order_acquire);
+        Enqueue(*queue, std::move(record));
+        if (level == LogLevel::FATAL) {
+            // FATAL 之后进程通常会退出：等它真正写进文件
+            Flush();
+        }
+        return;
+    }
+
+    // 同步模式：文本格式时先在锁外把整行格式化为 UTF-8 放进本线程的暂存缓冲区，锁内只追加和写文件
+    thread_local std::wstring messageScratch;
+    thread_local std::string staged;
+    bool stage = m_stageText.load(std::memory_order_relaxed);
+    if (stage) {
+        staged.clear();
+        AppendLine(staged, record.level, record.time, MessageText(record, messageScratch));
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // 刚切换回同步模式时缓冲区中可能还有其他线程提交的记录，先写出它们以保持顺序
+    WriteBatchLocked(SIZE_MAX);
+    if (stage && m_stageText.load(std::memory_order_relaxed) && !RotationDueLocked(record.time)) {
+        m_textBuffer += staged;
+        m_fileBytes += staged.size();
+    }
+    else {
+        WriteRecordLocked(record);
+    }
+    FlushFilesLocked();
+
+    if (level == LogLevel::FATAL) {
+        // For FATAL errors, consider more drastic actions if needed, e.g.,
+        // m_logFile.close();
+        // exit(EXIT_FAILURE); // Or std::terminate();
+    }
+}
+
+LoggerOptions Logger::LoadOptions(const Config& config, const LoggerOptions& defaults) {
+    const wchar_t* section = L"Log";
+    LoggerOptions options = defaults;
+
+    std::wstring mode = config.GetString(section, L"Mode", L"");
+    if (mode == L"Sync") options.mode = LogMode::Sync;
+    else if (mode == L"Async") options.mode = LogMode::Async;
+    else if (!mode.empty()) LOG_WARNING(L"Unknown [Log] Mode: ", mode.c_str());
+
+    std::wstring overflow = config.GetString(section, L"Overflow", L"");
+    if (overflow == L"Drop") options.overflow = LogOverflowPolicy::Drop;
+    else if (overflow == L"Block") options.overflow = LogOverflowPolicy::Block;
+    else if (overflow == L"Sample") options.overflow = LogOverflowPolicy::Sample;
+    else if (!overflow.empty()) LOG_WARNING(L"Unknown [Log] Overflow: ", overflow.c_str());
+
+    std::wstring format = config.GetString(section, L"Format", L"");
+    if (format == L"Text") options.format = LogOutputFormat::Text;
+    else if (format == L"Binary") options.format = LogOutputFormat::Binary;
+    else if (!format.empty()) LOG_WARNING(L"Unknown [Log] Format: ", format.c_str());
+
+    options.queueCapacity = static_cast<size_t>((std::max)(config.GetInt(section, L"QueueSize", static_cast<int>(defaults.queueCapacity)), 16));
+    options.sampleRate = static_cast<unsigned>((std::max)(config.GetInt(section, L"SampleRate", static_cast<int>(defaults.sampleRate)), 1));
+    options.batchSize = static_cast<size_t>((std::max)(config.GetInt(section, L"BatchSize", static_cast<int>(defaults.batchSize)), 1));
+
+    int maxSizeMb = config.GetInt(section, L"MaxFileSizeMB", static_cast<int>(defaults.maxFileBytes / (1024 * 1024)));
+    options.maxFileBytes = static_cast<uint64_t>((std::max)(maxSizeMb, 0)) * 1024 * 1024;
+    options.rotateDaily = config.GetBool(section, L"RotateDaily", defaults.rotateDaily);
+    options.maxArchives = static_cast<unsigned>((std::max)(config.GetInt(section, L"MaxArchives", static_cast<int>(defaults.maxArchives)), 0));
+    options.compressArchives = config.GetBool(section, L"CompressArchives", defaults.compressArchives);
+    return options;
+}
+
+void Logger::Configure(const LoggerOptions& options) {
+    std::lock_guard<std::mutex> configLock(m_configMutex);
+    StopWriter();
+
+    m_overflowPolicy.store(static_cast<int>(options.overflow));
+    m_sampleRate.store((std::max)(options.sampleRate, 1u));
+    m_batchSize = (std::max)(options.batchSize, static_cast<size_t>(1));
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxFileBytes = options.maxFileBytes;
+        m_rotateDaily = options.rotateDaily;
+        m_maxArchives = options.maxArchives;
+        m_compressArchives = options.compressArchives;
+        if (m_format != options.format) {
+            m_format = options.format;
+            OpenBinaryFileLocked();
+            FlushFilesLocked();
+        }
+    }
+    if (options.mode != LogMode::Async) {
+        return;
+    }
+
+    if (!m_queueStorage) {
+        m_queueStorage.reset(new RecordQueue((std::max)(options.queueCapacity, static_cast<size_t>(16))));
+        m_queue.store(m_queueStorage.get(), std::memory_order_release);
+    }
+    m_stopWriter.store(false);
+    m_writer = std::thread(&Logger::WriterThread, this);
+    m_async.store(true, std::memory_order_release);
+}
+
+const LogSiteInfo* Logger::RegisterSite(LogSite& site, const char* signature, const wchar_t* format) {
+    std::lock_guard<std::mutex> lock(m_siteMutex);
+    // 多个线程同时第一次经过同一调用点时只登记一次
+    const LogSiteInfo* existing = site.info.load(std::memory_order_acquire);
+    if (existing) {
+        return existing;
+    }
+    std::unique_ptr<LogSiteInfo> info(new LogSiteInfo());
+    info->id = static_cast<uint32_t>(m_sites.size());
+    info->level = site.level;
+    info->file = site.file;
+    info->line = site.line;
+    if (format) {
+        info->format = format;
+    }
+    info->signature = signature;
+    const LogSiteInfo* result = info.get();
+    m_sites.push_back(std::move(info));
+    site.info.store(result, std::memory_order_release);
+    return result;
+}
+
+void Logger::Enqueue(RecordQueue& queue, LogRecord&& record) {
+    LogOverflowPolicy policy = static_cast<LogOverflowPolicy>(m_overflowPolicy.load(std::memory_order_relaxed));
+    LogLevel level = record.level;
+    bool minor = level < LogLevel::WARNING;
+
+    if (policy == LogOverflowPolicy::Sample && minor && queue.SizeApprox() > queue.Capacity() / 2) {
+        unsigned rate = m_sampleRate.load(std::memory_order_relaxed);
+        if (m_sampleCounter.fetch_add(1, std::memory_order_relaxed) % rate != 0) {
+            m_sampledOut.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    while (!queue.TryPush(std::move(record))) {
+        // FATAL 总是等待；Sample 策略只为 WARNING 及以上等待
+        bool wait = level == LogLevel::FATAL ||
+            policy == LogOverflowPolicy::Block ||
+            (policy == LogOverflowPolicy::Sample && !minor);
+        if (!wait) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (!m_async.load(std::memory_order_acquire)) {
+            // 写入线程已经停止 (切换回同步模式)：直接写文件
+            std::lock_guard<std::mutex> lock(m_mutex);
+            WriteBatchLocked(SIZE_MAX);
+            WriteRecordLocked(record);
+            FlushFilesLocked();
+            return;
+        }
+        WakeWriter();
+        WaitForDrain([&queue] { return queue.SizeApprox() < queue.Capacity(); });
+    }
+    WakeWriter();
+}
+
+void Logger::WakeWriter() {
+    // 与写入线程休眠前的 fence 配对：要么这里看到它在休眠，要么它在休眠前看到新记录
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_writerSleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        m_writerCondition.notify_one();
+    }
+}
+
+void Logger::WaitForDrain(const std::function<bool()>& ready) {
+    m_drainWaiters.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lock(m_writerMutex);
+        // 超时只是保险：写入线程停止时不会再发通知
+        m_drainedCondition.wait_for(lock, std::chrono::milliseconds(10), [&] {
+            return ready() || !m_async.load(std::memory_order_acquire);
+        });
+    }
+    m_drainWaiters.fetch_sub(1);
+}
+
+void Logger::Flush() {
+    if (!m_async.load(std::memory_order_acquire)) {
+        return; // 同步模式每条日志都已 flush
+    }
+    uint64_t request = m_flushRequested.fetch_add(1) + 1;
+    WakeWriter();
+    while (m_flushCompleted.load() < request) {
+        if (!m_async.load(std::memory_order_acquire)) {
+            // 写入线程已停止：StopWriter 会在返回前写完缓冲区，等它拿到文件锁
+            std::lock_guard<std::mutex> lock(m_mutex);
+            WriteBatchLocked(SIZE_MAX);
+            return;
+        }
+        WaitForDrain([this, request] { return m_flushCompleted.load() >= request; });
+    }
+}
+
+void Logger::WriterThread() {
+    for (;;) {
+        // 先读请求序号再清空缓冲区：请求之前提交的记录一定在这次清空的范围内
+        uint64_t request = m_flushRequested.load();
+        size_t written;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            written = WriteBatchLocked(m_batchSize);
+        }
+        if (written == 0 && m_flushCompleted.load() < request) {
+            m_flushCompleted.store(request);
+        }
+        if (m_drainWaiters.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_drainedCondition.notify_all();
+        }
+        if (written > 0) {
+            continue;
+        }
+        if (m_stopWriter.load()) {
+            break;
+        }
+
+        RecordQueue* queue = m_queue.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(m_writerMutex);
+        m_writerSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_writerCondition.wait(lock, [&] {
+            return queue->SizeApprox() > 0 || m_stopWriter.load() || m_flushRequested.load() != request;
+        });
+        m_writerSleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void Logger::StopWriter() {
+    if (!m_writer.joinable()) {
+        return;
+    }
+    m_async.store(false, std::memory_order_release);
+    m_stopWriter.store(true);
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        m_writerCondition.notify_one();
+        m_drainedCondition.notify_all();
+    }
+    m_writer.join();
+
+    // 停止前已经读到异步标志的线程可能刚刚提交了记录
+    std::lock_guard<std::mutex> lock(m_mutex);
+    WriteBatchLocked(SIZE_MAX);
+}
+
+size_t Logger::WriteBatchLocked(size_t maxCount) {
+    RecordQueue* queue = m_queue.load(std::memory_order_acquire);
+    if (!queue) {
+        return 0;
+    }
+    size_t count = 0;
+    LogRecord record;
+    while (count < maxCount && queue->TryPop(record)) {
+        WriteRecordLocked(record);
+        ++count;
+    }
+    ReportOverflowLocked();
+    if (count > 0) {
+        FlushFilesLocked();
+    }
+    return count;
+}
+
+void Logger::FlushFilesLocked() {
+    // 整批数据已经在连续的缓冲区中：每个文件一次 WriteFile
+    if (!m_binaryBuffer.empty()) {
+        if (m_binaryFile.IsOpen()) {
+            m_binaryFile.Write(m_binaryBuffer);
+        }
+        m_binaryBuffer.clear();
+    }
+    if (!m_textBuffer.empty()) {
+        if (m_logFile.IsOpen()) {
+            m_logFile.Write(m_textBuffer);
+        }
+        m_textBuffer.clear();
+    }
+    if (!m_logFile.IsOpen()) {
+        std::wcerr.flush();
+    }
+}
+
+void Logger::WriteRecordLocked(const LogRecord& record) {
+    if (RotationDueLocked(record.time)) {
+        RotateFilesLocked(record.time);
+    }
+    if (m_binaryFile.IsOpen()) {
+        WriteBinaryLocked(record);
+        return;
+    }
+    WriteTextLocked(record.level, record.time, MessageText(record, m_formatBuffer));
+}
+
+const std::wstring& Logger::MessageText(const LogRecord& record, std::wstring& scratch) {
+    if (!record.site) {
+        return record.text;
+    }
+    scratch.clear();
+    if (!LogFormat::FormatArgs(record.site->signature, record.site->format, record.args, record.argSize, scratch)) {
+        scratch += L" <malformed log record>";
+    }
+    return scratch;
+}
+
+namespace {
+
+    const char* LevelName(LogLevel level) {
+        switch (level) {
+        case LogLevel::DEBUG:   return "DEBUG";
+        case LogLevel::INFO:    return "INFO";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERR:     return "ERROR";
+        case LogLevel::FATAL:   return "FATAL";
+        default:                return "UNKNOWN";
+        }
+    }
+
+    // yyyy-MM-dd HH:mm:ss.fff (与 GetTimestamp 相同)。每个线程缓存当前这一秒的日期时间部分，同一秒内只调用一次 localtime_s
+    void AppendTimestamp(std::string& out, std::chrono::system_clock::time_point time) {
+        thread_local std::time_t cachedSecond = -1;
+        thread_local char cachedText[32];
+        thread_local size_t cachedLength = 0;
+
+        std::time_t second = std::chrono::system_clock::to_time_t(time);
+        if (second != cachedSecond) {
+            std::tm local;
+            if (localtime_s(&local, &second) != 0) {
+                out += "[Error getting time]";
+                return;
+            }
+            cachedLength = std::strftime(cachedText, sizeof(cachedText), "%Y-%m-%d %H:%M:%S", &local);
+            cachedSecond = second;
+        }
+        out.append(cachedText, cachedLength);
+
+        int ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count() % 1000);
+        char fraction[4] = { '.', static_cast<char>('0' + ms / 100), static_cast<char>('0' + ms / 10 % 10), static_cast<char>('0' + ms % 10) };
+        out.append(fraction, sizeof(fraction));
+    }
+
+    template<typename T>
+    void AppendRaw(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void AppendNarrow(std::string& out, const std::string& text) {
+        AppendRaw<uint32_t>(out, static_cast<uint32_t>(text.size()));
+        out += text;
+    }
+
+    void AppendWide(std::string& out, const std::wstring& text) {
+        AppendRaw<uint32_t>(out, static_cast<uint32_t>(text.size()));
+        for (wchar_t c : text) {
+            AppendRaw<uint16_t>(out, static_cast<uint16_t>(c));
+        }
+    }
+
+    int64_t ToUnixMicroseconds(std::chrono::system_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+    }
+
+} // namespace
+
+void Logger::OpenBinaryFileLocked() {
+    if (m_binaryFile.IsOpen()) {
+        m_binaryFile.Write(m_binaryBuffer);
+        m_binaryFile.Close();
+    }
+    m_binaryBuffer.clear();
+    m_sitesWritten.clear();
+    m_stageText.store(m_logFile.IsOpen() && m_format == LogOutputFormat::Text, std::memory_order_relaxed);
+    if (m_format != LogOutputFormat::Binary || m_logFilePath.empty()) {
+        return;
+    }
+
+    std::wstring path = BinaryLogPath(m_logFilePath);
+    if (!m_binaryFile.Open(path)) {
+        std::wcerr << L"Failed to open binary log file: " << path << std::endl;
+        m_stageText.store(m_logFile.IsOpen(), std::memory_order_relaxed);
+        return;
+    }
+
+    // 文件头随第一批记录写出
+    m_binaryBuffer = "NLOG";
+    AppendRaw<uint32_t>(m_binaryBuffer, LogFormat::kFileVersion);
+    if (m_logFile.IsOpen()) {
+        WriteTextLocked(LogLevel::INFO, std::chrono::system_clock::now(), L"Binary log enabled: " + path);
+    }
+}
+
+void Logger::WriteBinaryLocked(const LogRecord& record) {
+    // 记录先追加到缓冲区，FlushFilesLocked 一次写出整批
+    std::string& out = m_binaryBuffer;
+    size_t sizeBefore = out.size();
+    if (record.site) {
+        const LogSiteInfo& site = *record.site;
+        if (site.id >= m_sitesWritten.size()) {
+            m_sitesWritten.resize(site.id + 1, false);
+        }
+        if (!m_sitesWritten[site.id]) {
+            // 调用点描述符在第一条引用它的记录之前写入
+            m_sitesWritten[site.id] = true;
+            AppendRaw<uint8_t>(out, LogFormat::kSiteEntry);
+            AppendRaw<uint32_t>(out, site.id);
+            AppendRaw<uint8_t>(out, static_cast<uint8_t>(site.level));
+            AppendRaw<uint32_t>(out, static_cast<uint32_t>(site.line));
+            AppendNarrow(out, site.file ? site.file : "");
+            AppendWide(out, site.format);
+            AppendNarrow(out, site.signature);
+        }
+        AppendRaw<uint8_t>(out, LogFormat::kRecordEntry);
+        AppendRaw<uint32_t>(out, site.id);
+        AppendRaw<int64_t>(out, ToUnixMicroseconds(record.time));
+        AppendRaw<uint16_t>(out, record.argSize);
+        out.append(reinterpret_cast<const char*>(record.args), record.argSize);
+    }
+    else {
+        AppendRaw<uint8_t>(out, LogFormat::kTextEntry);
+        AppendRaw<uint8_t>(out, static_cast<uint8_t>(record.level));
+        AppendRaw<int64_t>(out, ToUnixMicroseconds(record.time));
+        AppendWide(out, record.text);
+    }
+    m_fileBytes += out.size() - sizeBefore;
+}
+
+void Logger::WriteTextLocked(LogLevel level, std::chrono::system_clock::time_point time, const std::wstring& text) {
+    if (!m_logFile.IsOpen()) {
+        // Fallback: print to console if file not open
+        std::wcerr << GetTimestamp(time) << L" [" << LogLevelToString(level) << L"] " << text << L'\n';
+        return;
+    }
+    size_t sizeBefore = m_textBuffer.size();
+    AppendLine(m_textBuffer, level, time, text);
+    m_fileBytes += m_textBuffer.size() - sizeBefore;
+}
+
+void Logger::AppendLine(std::string& out, LogLevel level, std::chrono::system_clock::time_point time, const std::wstring& text) {
+    AppendTimestamp(out, time);
+    out += " [";
+    out += LevelName(level);
+    out += "] ";
+    LogFormat::AppendUtf8(out, text.data(), text.size());
+    out += "\r\n"; // 与之前的日志文件保持相同的 Windows 换行
+}
+
+void Logger::ReportOverflowLocked() {
+    if (m_dropped.load(std::memory_order_relaxed) == 0 && m_sampledOut.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    uint64_t dropped = m_dropped.exchange(0);
+    uint64_t sampledOut = m_sampledOut.exchange(0);
+    std::wstringstream wss;
+    wss << L"Log queue overflow: dropped " << dropped << L" records, sampled out " << sampledOut << L" records.";
+    LogRecord record;
+    record.level = LogLevel::WARNING;
+    record.time = std::chrono::system_clock::now();
+    record.text = wss.str();
+    WriteRecordLocked(record);
+}
+
+void Logger::WriteCrashReport(const std::wstring& message) {
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+    for (int attempt = 0; attempt < 200 && !lock.try_lock(); ++attempt) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // 拿不到锁时写入线程多半已经无法继续：尽力写出，哪怕可能与它交错
+    WriteBatchLocked(SIZE_MAX);
+    LogRecord record;
+    record.level = LogLevel::FATAL;
+    record.time = std::chrono::system_clock::now();
+    record.text = message;
+    WriteRecordLocked(record);
+    FlushFilesLocked();
+}
+
+
+std::wstring Logger::LogLevelToString(LogLevel level) {
+    switch (level) {
+    case LogLevel::DEBUG:   return L"DEBUG";
+    case LogLevel::INFO:    return L"INFO";
+    case LogLevel::WARNING: return L"WARNING";
+    case LogLevel::ERR:     return L"ERROR";
+    case LogLevel::FATAL:   return L"FATAL";
+    default:                return L"UNKNOWN";
+    }
+}
+
+std::wstring Logger::GetTimestamp() {
+    return GetTimestamp(std::chrono::system_clock::now());
+}
+
+std::wstring Logger::GetTimestamp(std::chrono::system_clock::time_point now) {
+    auto now_c = std::chrono::system_clock::to_time_t(now);
+
+    std::tm timeinfo_tm; // Use a local tm struct for localtime_s
+
+    // Use localtime_s for safety (C4996)
+    if (localtime_s(&timeinfo_tm, &now_c) != 0) {
+        // Error handling for localtime_s
+        return L"[Error getting time] ";
+    }
+
+    std::wstringstream wss;
+    // std::put_time is fine with VS2022 and <iomanip>
+    // The error C2589, C2062 was likely due to missing <iomanip> or incorrect usage context.
+    // Ensure <iomanip> is included in log.h.
+    wss << std::put_time(&timeinfo_tm, L"%Y-%m-%d %H:%M:%S");
+
+    // Add milliseconds
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+    wss << L'.' << std::setfill(L'0') << std::setw(3) << ms.count();
+
+    return wss.str();
+}
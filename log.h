@@ -1,144 +1,489 @@
-#ifndef LOG_H
-#define LOG_H
-
-#include <string>
-#include <fstream>
-#include <sstream>
-#include <mutex>     // For std::mutex
-#include <chrono>    // For std::chrono
-#include <iomanip>   // For std::put_time, std::setfill, std::setw
-#include <vector>    // Required by some compilers for sstream parameter packing, or for general utility
-#include <ios>       // For std::ios::out, std::ios::app
-
-// Forward declaration if needed, or ensure it's included before
-// class Logger; // Not strictly needed if all definitions are within this file or .cpp
-
-// ־
-enum class LogLevel {
-    DEBUG,
-    INFO,
-    WARNING,
-    //ERROR,
-    FATAL
-};
-
-class Logger {
-public:
-    // ȡ Logger ʵ
-    static Logger& GetInstance();
-
-    // ֹ͸ֵ
-    Logger(const Logger&) = delete;
-    Logger& operator=(const Logger&) = delete;
-
-    /**
-     * @brief ־
-     * @param level Ҫõ־
-     */
-    void SetLogLevel(LogLevel level);
-
-    /**
-     * @brief ־ļ·
-     * @param filePath ־ļ·
-     * @return ɹ/־ļ򷵻 true򷵻 false
-     */
-    bool SetLogFile(const std::wstring& filePath);
-
-    /**
-     * @brief ¼־ (ʵ)
-     * @param level ־
-     * @param wss   ѸʽϢĿַ
-     */
-    void LogInternal(LogLevel level, std::wstringstream& wss);
-
-    /**
-     * @brief ¼־ (ģ汾û)
-     * @tparam Args 
-     * @param level ־
-     * @param message ־Ϣ
-     * @param args ɱƴӵϢ
-     */
-    template<typename... Args>
-    void Log(LogLevel level, const std::wstring& message, Args... args) {
-        if (level < m_logLevel) {
-            return; // 趨־¼
-        }
-
-        std::wstringstream wss;
-        wss << message;
-
-        // C++17 fold expression for cleaner variadic template argument processing
-        // ((wss << L" " << args), ...); // This can be problematic if args are not directly streamable or need formatting
-
-        // Safer way to append arguments, especially if they are of mixed types
-        // This requires C++17. If using an older standard, you'd need a recursive template or initializer list trick.
-        // For VS2022, C++17 should be fine.
-        // The issue C2760, C3878 often points to fold expressions not being parsed as expected or compiler not in C++17 mode.
-        // Let's try a helper for argument packing if fold expressions are problematic.
-        FormatArgs(wss, args...);
-
-
-        LogInternal(level, wss); // Call the internal logging function
-    }
-
-
-    template<typename... Args>
-    void Debug(const std::wstring& message, Args... args) {
-        Log(LogLevel::DEBUG, message, args...);
-    }
-
-    template<typename... Args>
-    void Info(const std::wstring& message, Args... args) {
-        Log(LogLevel::INFO, message, args...);
-    }
-
-    template<typename... Args>
-    void Warning(const std::wstring& message, Args... args) {
-        Log(LogLevel::WARNING, message, args...);
-    }
-
-    template<typename... Args>
-    void Error(const std::wstring& message, Args... args) {
-       // Log(LogLevel::ERROR, message, args...);
-    }
-
-    template<typename... Args>
-    void Fatal(const std::wstring& message, Args... args) { // C2838 was here. Ensure it's not LogLevel::FATAL
-        Log(LogLevel::FATAL, message, args...);
-    }
-
-
-private:
-    // ˽й캯ȷģʽ
-    Logger();
-    // ˽
-    ~Logger();
-
-    std::wstring LogLevelToString(LogLevel level);
-    std::wstring GetTimestamp();
-
-    // Helper for variadic template argument formatting
-    // Base case for recursion (no arguments left)
-    void FormatArgs(std::wstringstream& wss) {}
-
-    // Recursive step
-    template<typename T, typename... Rest>
-    void FormatArgs(std::wstringstream& wss, T&& first, Rest&&... rest) {
-        wss << L" " << first;
-        FormatArgs(wss, std::forward<Rest>(rest)...);
-    }
-
-
-    std::wofstream m_logFile;        // ־ļ (ʹ wofstream ֧ Unicode)
-    LogLevel m_logLevel;           // ǰ־
-    std::mutex m_mutex;            // ڱļдĻ
-};
-
-// 궨־
-#define LOG_DEBUG(...) Logger::GetInstance().Debug(__VA_ARGS__)
-#define LOG_INFO(...) Logger::GetInstance().Info(__VA_ARGS__)
-#define LOG_WARNING(...) Logger::GetInstance().Warning(__VA_ARGS__)
-#define LOG_ERROR(...) Logger::GetInstance().Error(__VA_ARGS__)
-#define LOG_FATAL(...) Logger::GetInstance().Fatal(__VA_ARGS__)
-
-#endif // LOG_H
+#ifndef LOG_H
+#define LOG_H
+
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <mutex>     // For std::mutex
+#include <functional>
+#include <memory>
+#include <chrono>    // For std::chrono
+#include <iomanip>   // For std::put_time, std::setfill, std::setw
+#include <vector>    // Required by some compilers for sstream parameter packing, or for general utility
+#include <ios>       // For std::ios::out, std::ios::app
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <windows.h> // For HANDLE
+
+#include "mpmc_queue.h"
+#include "log_format.h"
+
+class Config;
+
+// Forward declaration if needed, or ensure it's included before
+// class Logger; // Not strictly needed if all definitions are within this file or .cpp
+
+// 日志级别
+enum class LogLevel {
+    DEBUG,
+    INFO,
+    WARNING,
+    ERR,    // 不叫 ERROR：wingdi.h 把 ERROR 定义成了宏
+    FATAL
+};
+
+// 编译期最低日志级别 (0 DEBUG, 1 INFO, 2 WARNING, 3 ERR)：低于它的 LOG_* 调用连同参数一起被移除。
+// 例如发布版本在编译选项中定义 LOG_MIN_LEVEL=1 去掉全部 LOG_DEBUG。LOG_FATAL 始终保留
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+// 日志模块：每个模块的运行时级别可以单独设置 (配置 [Log] NetworkLevel 等，见 Logger::ApplyLevels)
+enum class LogModule {
+    General,
+    Network,
+    Update,
+    Threads,
+    Config,
+    Count
+};
+
+// 源文件在包含任何头文件之前定义 LOG_MODULE 来指定其中日志所属的模块，例如
+//   #define LOG_MODULE LogModule::Network
+#ifndef LOG_MODULE
+#define LOG_MODULE LogModule::General
+#endif
+
+// 日志写入方式
+enum class LogMode {
+    Sync,   // 调用线程加锁后直接写文件，每条日志 flush 一次
+    Async   // 调用线程只把记录放入无锁环形缓冲区，由写入线程批量写文件，每批 flush 一次
+};
+
+// 异步模式下缓冲区写满时的处理方式
+enum class LogOverflowPolicy {
+    Drop,   // 丢弃新记录，写入线程随后记录丢弃的条数
+    Block,  // 等待写入线程腾出空间
+    Sample  // 缓冲区超过一半后 DEBUG/INFO 每 sampleRate 条只保留一条，写满时丢弃；WARNING 及以上等待空间
+};
+
+// 日志文件格式
+enum class LogOutputFormat {
+    Text,   // UTF-8 文本日志；LOG_* 宏的参数由写入线程 (同步模式下为调用线程) 格式化
+    Binary  // 二进制日志 (日志文件名换成 .nlog)：只写入参数的原始字节，用 tools/log_decode 转换为文本
+};
+
+struct LoggerOptions {
+    LogMode mode = LogMode::Sync;
+    LogOutputFormat format = LogOutputFormat::Text;
+    size_t queueCapacity = 8192;   // 异步缓冲区的记录数 (向上取整为 2 的幂)，只在第一次切换到异步模式时生效
+    LogOverflowPolicy overflow = LogOverflowPolicy::Block;
+    unsigned sampleRate = 16;      // Sample 策略的保留比例
+    size_t batchSize = 256;        // 写入线程每批最多写入的记录数
+
+    // 轮转：当前文件改名为 app.20261018-183012.log 这样的归档文件后重新创建 (二进制日志同时轮转)
+    uint64_t maxFileBytes = 10 * 1024 * 1024; // 超过这个大小时轮转，0 表示不按大小轮转
+    bool rotateDaily = true;       // 跨过本地时间零点时轮转 (启动时发现文件不是当天写的也先轮转)
+    unsigned maxArchives = 10;     // 保留的归档文件数 (文本和二进制分别计算)，0 表示不删除
+    bool compressArchives = true;  // 在后台线程把归档文件压缩为 .gz
+};
+
+// 调用点描述符：每个调用点第一次记录日志时登记，之后只读
+struct LogSiteInfo {
+    uint32_t id = 0;               // 登记顺序，二进制日志中用它引用调用点
+    LogLevel level = LogLevel::INFO;
+    const char* file = nullptr;
+    int line = 0;
+    std::wstring format;           // 第一个参数是字符串字面量时的消息模板
+    std::string signature;         // 参数类型签名 (见 log_format.h)
+};
+
+// LOG_* 宏在每个调用点定义的静态对象 (常量初始化，没有构造开销)
+struct LogSite {
+    constexpr LogSite(LogLevel siteLevel, LogModule siteModule, const char* siteFile, int siteLine)
+        : level(siteLevel), module(siteModule), file(siteFile), line(siteLine), info(nullptr) {}
+
+    LogLevel level;
+    LogModule module;
+    const char* file;
+    int line;
+    std::atomic<const LogSiteInfo*> info;
+};
+
+class Logger {
+public:
+    // 获取 Logger 单例实例
+    static Logger& GetInstance();
+
+    // 禁止拷贝和赋值
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * @brief 设置日志级别
+     * @param level 要设置的最低日志级别
+     */
+    void SetLogLevel(LogLevel level);
+
+    /**
+     * @brief 单独设置某个模块的日志级别 (覆盖 SetLogLevel 设置的全局级别)，立即生效。
+     */
+    void SetModuleLevel(LogModule module, LogLevel level);
+
+    /**
+     * @brief 取消模块的单独级别，恢复使用全局级别。
+     */
+    void ClearModuleLevel(LogModule module);
+
+    /**
+     * @brief 从配置的 [Log] 节读取日志级别并立即生效：Level 为全局级别，
+     *        NetworkLevel / UpdateLevel / ThreadsLevel / ConfigLevel 为模块级别 (取值 Debug/Info/Warning/Error/Fatal)。
+     *        没有配置的模块恢复使用全局级别；没有配置 Level 时全局级别不变。
+     * @note 可以在运行中随时调用 (例如检测到配置文件被修改后)，不需要重启。
+     */
+    void ApplyLevels(const Config& config);
+
+    /**
+     * @brief 调用点的日志是否需要记录 (LOG_* 宏在计算参数之前调用)。
+     */
+    bool IsEnabled(const LogSite& site) const {
+        return static_cast<int>(site.level) >= m_moduleLevels[static_cast<size_t>(site.module)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 设置日志文件路径
+     * @param filePath 日志文件的完整路径
+     * @return 如果成功打开/创建日志文件则返回 true，否则返回 false
+     */
+    bool SetLogFile(const std::wstring& filePath);
+
+    /**
+     * @brief 从配置文件的 [Log] 节读取选项。
+     * @param config 已加载的配置。
+     * @param defaults 配置中没有的项使用的默认值。
+     */
+    static LoggerOptions LoadOptions(const Config& config, const LoggerOptions& defaults = LoggerOptions());
+
+    /**
+     * @brief 切换同步/异步模式并应用其他选项。切换前写出缓冲区中的全部记录。
+     */
+    void Configure(const LoggerOptions& options);
+
+    /**
+     * @brief 等待调用之前提交的日志全部写入文件并 flush。同步模式下立即返回。
+     * @note 不要在写入线程可能已经停止响应的场合 (崩溃处理) 调用，改用 WriteCrashReport。
+     */
+    void Flush();
+
+    /**
+     * @brief 崩溃路径：不依赖写入线程，在当前线程写出缓冲区中剩余的记录和 message，并 flush 文件。
+     * @note 写入线程持有文件锁不放时 (例如崩溃的正是它) 最多等待 200 毫秒，之后不加锁强行写入。
+     */
+    void WriteCrashReport(const std::wstring& message);
+
+    /**
+     * @brief 记录日志 (核心实现)
+     * @param level 日志级别
+     * @param wss   包含已格式化消息的宽字符串流
+     */
+    void LogInternal(LogLevel level, std::wstringstream& wss);
+
+    /**
+     * @brief 记录日志 (模板版本，用户调用)
+     * @tparam Args 参数类型
+     * @param level 日志级别
+     * @param message 日志消息主体
+     * @param args 可变参数，将被拼接到消息主体后
+     */
+    template<typename... Args>
+    void Log(LogLevel level, const std::wstring& message, Args... args) {
+        if (level < m_logLevel) {
+            return; // 低于设定级别的日志不记录
+        }
+
+        std::wstringstream wss;
+        wss << message;
+
+        // C++17 fold expression for cleaner variadic template argument processing
+        // ((wss << L" " << args), ...); // This can be problematic if args are not directly streamable or need formatting
+
+        // Safer way to append arguments, especially if they are of mixed types
+        // This requires C++17. If using an older standard, you'd need a recursive template or initializer list trick.
+        // For VS2022, C++17 should be fine.
+        // The issue C2760, C3878 often points to fold expressions not being parsed as expected or compiler not in C++17 mode.
+        // Let's try a helper for argument packing if fold expressions are problematic.
+        FormatArgs(wss, args...);
+
+
+        LogInternal(level, wss); // Call the internal logging function
+    }
+
+
+    /**
+     * @brief 记录日志 (LOG_* 宏使用的延迟格式化版本)。调用方已经用 IsEnabled 检查过级别。
+     * @param site 调用点的静态描述符
+     * @param args 消息主体和参数：只按类型复制原始字节，不在调用线程格式化。
+     *        参数放不下记录的内联缓冲区时退回到即时格式化。
+     */
+    template<typename First, typename... Rest>
+    void LogAt(LogSite& site, const First& first, const Rest&... rest) {
+        const LogSiteInfo* info = site.info.load(std::memory_order_acquire);
+        if (!info) {
+            info = RegisterSite(site, SiteSignature<First, Rest...>(), FormatLiteral(first));
+        }
+
+        LogRecord record;
+        record.level = site.level;
+        record.time = std::chrono::system_clock::now();
+        LogFormat::ArgWriter writer(record.args, sizeof(record.args));
+        if constexpr (!LogFormat::IsFormatLiteral<const First&>()) {
+            LogFormat::EncodeArg(writer, first);
+        }
+        (LogFormat::EncodeArg(writer, rest), ...);
+
+        if (writer.Overflowed()) {
+            std::wstringstream wss;
+            wss << first;
+            FormatArgs(wss, rest...);
+            record.text = wss.str();
+        }
+        else {
+            record.site = info;
+            record.argSize = static_cast<uint16_t>(writer.Size());
+        }
+        Submit(std::move(record));
+    }
+
+    template<typename... Args>
+    void Debug(const std::wstring& message, Args... args) {
+        Log(LogLevel::DEBUG, message, args...);
+    }
+
+    template<typename... Args>
+    void Info(const std::wstring& message, Args... args) {
+        Log(LogLevel::INFO, message, args...);
+    }
+
+    template<typename... Args>
+    void Warning(const std::wstring& message, Args... args) {
+        Log(LogLevel::WARNING, message, args...);
+    }
+
+    template<typename... Args>
+    void Error(const std::wstring& message, Args... args) {
+        Log(LogLevel::ERR, message, args...);
+    }
+
+    template<typename... Args>
+    void Fatal(const std::wstring& message, Args... args) {
+        Log(LogLevel::FATAL, message, args...);
+    }
+
+
+private:
+    // 私有构造函数，确保单例模式
+    Logger();
+    // 私有析构函数
+    ~Logger();
+
+    // 日志记录：时间戳在提交时记录。LOG_* 宏的记录只带调用点和参数字节，其他记录带已格式化的消息
+    struct LogRecord {
+        static const size_t kInlineArgBytes = 112;
+
+        LogLevel level = LogLevel::INFO;
+        std::chrono::system_clock::time_point time;
+        const LogSiteInfo* site = nullptr;       // 为空时使用 text
+        uint16_t argSize = 0;
+        unsigned char args[kInlineArgBytes];
+        std::wstring text;
+    };
+    using RecordQueue = BoundedMpmcQueue<LogRecord>;
+
+    template<typename First, typename... Rest>
+    static const char* SiteSignature() {
+        static const char signature[] = {
+            LogFormat::IsFormatLiteral<const First&>() ? LogFormat::kFormatArg : LogFormat::KindOf<First>(),
+            LogFormat::KindOf<Rest>()...,
+            '\0'
+        };
+        return signature;
+    }
+
+    template<typename T>
+    static const wchar_t* FormatLiteral(const T& first) {
+        if constexpr (LogFormat::IsFormatLiteral<const T&>()) {
+            return first;
+        }
+        else {
+            return nullptr;
+        }
+    }
+
+    // 只追加的日志文件：直接使用 Win32 句柄，不经过 CRT 的缓冲和字符转换。每批记录调用一次 Write
+    class LogFile {
+    public:
+        LogFile() : m_handle(INVALID_HANDLE_VALUE) {}
+        ~LogFile() { Close(); }
+        LogFile(const LogFile&) = delete;
+        LogFile& operator=(const LogFile&) = delete;
+
+        bool Open(const std::wstring& path);
+        bool IsOpen() const { return m_handle != INVALID_HANDLE_VALUE; }
+        bool Write(const std::string& data);
+        void Close();
+
+    private:
+        HANDLE m_handle;
+    };
+
+    const LogSiteInfo* RegisterSite(LogSite& site, const char* signature, const wchar_t* format);
+    void Submit(LogRecord&& record);
+    static const std::wstring& MessageText(const LogRecord& record, std::wstring& scratch); // site 记录格式化到 scratch
+    static void AppendLine(std::string& out, LogLevel level, std::chrono::system_clock::time_point time, const std::wstring& text);
+
+    std::wstring LogLevelToString(LogLevel level);
+    std::wstring GetTimestamp();
+    std::wstring GetTimestamp(std::chrono::system_clock::time_point time);
+
+    void Enqueue(RecordQueue& queue, LogRecord&& record);
+    void WakeWriter();
+    void WaitForDrain(const std::function<bool()>& ready);
+    void WriterThread();
+    void StopWriter();
+    size_t WriteBatchLocked(size_t maxCount);  // 调用方持有 m_mutex；返回写入的条数，写入了记录时 flush 文件
+    void FlushFilesLocked();
+    void WriteRecordLocked(const LogRecord& record);
+    void WriteTextLocked(LogLevel level, std::chrono::system_clock::time_point time, const std::wstring& text);
+    void WriteBinaryLocked(const LogRecord& record);
+    void OpenBinaryFileLocked();
+
+    // 轮转与归档
+    struct ArchiveJob {
+        std::wstring logFilePath;  // 当前日志文件，归档文件与它在同一目录、以相同的文件名开头
+        unsigned maxArchives = 0;
+        bool compress = false;
+    };
+
+    bool OpenFilesLocked();
+    void CloseFilesLocked();
+    bool RotationDueLocked(std::chrono::system_clock::time_point time) const;
+    void RotateFilesLocked(std::chrono::system_clock::time_point time);
+    void ScheduleArchiveMaintenanceLocked();
+    void ArchiveThread();
+    void MaintainArchives(const ArchiveJob& job); // 在归档线程上压缩归档文件并删除超出保留数量的旧文件
+    void ReportOverflowLocked();
+    void UpdateModuleLevelsLocked(); // 调用方持有 m_levelMutex
+
+    // Helper for variadic template argument formatting
+    // Base case for recursion (no arguments left)
+    void FormatArgs(std::wstringstream& wss) {}
+
+    // Recursive step
+    template<typename T, typename... Rest>
+    void FormatArgs(std::wstringstream& wss, T&& first, Rest&&... rest) {
+        wss << L" " << first;
+        FormatArgs(wss, std::forward<Rest>(rest)...);
+    }
+
+
+    LogFile m_logFile;               // UTF-8 文本日志
+    std::string m_textBuffer;        // 本批待写入文本日志的数据
+    std::atomic<bool> m_stageText;   // 同步模式的调用线程可以在锁外格式化整行 (文本格式且文件已打开)
+    std::atomic<LogLevel> m_logLevel; // 当前日志级别 (全局)
+    static const size_t kModuleCount = static_cast<size_t>(LogModule::Count);
+    std::mutex m_levelMutex;                           // 串行化级别的修改
+    int m_moduleOverrides[kModuleCount];               // 模块单独设置的级别，-1 表示使用全局级别
+    std::atomic<int> m_moduleLevels[kModuleCount];     // 各模块实际生效的级别，IsEnabled 无锁读取
+    std::mutex m_mutex;            // 用于保护对文件写入的互斥锁
+    std::wstring m_logFilePath;
+    LogOutputFormat m_format;
+    LogFile m_binaryFile;           // 二进制格式的输出
+    std::string m_binaryBuffer;     // 本批待写入二进制文件的数据
+    std::vector<bool> m_sitesWritten; // 已写入当前二进制文件的调用点描述符
+    std::wstring m_formatBuffer;    // 写入时格式化参数用的缓冲区
+
+    // 轮转 (由 m_mutex 保护)
+    uint64_t m_maxFileBytes;
+    bool m_rotateDaily;
+    unsigned m_maxArchives;
+    bool m_compressArchives;
+    uint64_t m_fileBytes;                              // 当前文件的大致大小 (文本和二进制之和)
+    std::chrono::system_clock::time_point m_nextDailyRotation;
+    std::chrono::system_clock::time_point m_rotationRetryAt; // 改名失败 (文件被其他进程占用) 后暂缓重试
+
+    // 归档线程：第一次轮转时创建，压缩和删除都不在写日志的线程上进行
+    std::thread m_archiver;
+    std::mutex m_archiveMutex;
+    std::condition_variable m_archiveCondition;
+    ArchiveJob m_archiveJob;
+    bool m_archivePending;
+    std::atomic<bool> m_stopArchiver;
+
+    std::mutex m_siteMutex;                            // 保护调用点登记
+    std::vector<std::unique_ptr<LogSiteInfo>> m_sites; // 描述符的地址在进程生命周期内不变
+
+    // 异步模式。缓冲区创建后一直保留到析构：切换回同步模式时可能仍有线程在向它提交记录
+    std::mutex m_configMutex;                          // 串行化 Configure
+    std::unique_ptr<RecordQueue> m_queueStorage;
+    std::atomic<RecordQueue*> m_queue;                 // 非空且 m_async 为 true 时调用线程向它提交记录
+    std::atomic<bool> m_async;
+    std::atomic<int> m_overflowPolicy;                 // LogOverflowPolicy
+    std::atomic<unsigned> m_sampleRate;
+    size_t m_batchSize;
+    std::thread m_writer;
+
+    std::mutex m_writerMutex;                          // 只用于写入线程休眠和等待者的唤醒
+    std::condition_variable m_writerCondition;         // 唤醒写入线程
+    std::condition_variable m_drainedCondition;        // 写入线程写完一批后唤醒等待空间/等待 Flush 的线程
+    std::atomic<bool> m_writerSleeping;
+    std::atomic<bool> m_stopWriter;
+    std::atomic<size_t> m_drainWaiters;
+    std::atomic<uint64_t> m_flushRequested;            // Flush 请求的序号
+    std::atomic<uint64_t> m_flushCompleted;            // 写入线程清空缓冲区时确认的最大序号
+
+    std::atomic<uint64_t> m_dropped;                   // 缓冲区满而丢弃的记录数 (写入线程报告后清零)
+    std::atomic<uint64_t> m_sampledOut;                // Sample 策略跳过的记录数 (同上)
+    std::atomic<uint64_t> m_sampleCounter;
+};
+
+// 宏定义简化日志调用
+// 每个调用点一个静态描述符，记录时只复制参数字节 (见 Logger::LogAt)。
+// 先检查级别再计算参数：被过滤的日志不会执行参数中的字符串转换等操作
+#define LOG_AT(level, ...) \
+    do { \
+        static LogSite logSite_(level, LOG_MODULE, __FILE__, __LINE__); \
+        Logger& logger_ = Logger::GetInstance(); \
+        if (logger_.IsEnabled(logSite_)) { \
+            logger_.LogAt(logSite_, __VA_ARGS__); \
+        } \
+    } while (0)
+
+// 被编译期级别移除的调用：参数只出现在 sizeof 中，不会被计算，也不会引起"未使用的变量"警告
+template<typename... Args>
+int LogDiscardArgs(const Args&...) { return 0; }
+#define LOG_DISCARD(...) do { (void)sizeof(LogDiscardArgs(__VA_ARGS__)); } while (0)
+
+#if LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(...) LOG_AT(LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#if LOG_MIN_LEVEL <= 1
+#define LOG_INFO(...) LOG_AT(LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#if LOG_MIN_LEVEL <= 2
+#define LOG_WARNING(...) LOG_AT(LogLevel::WARNING, __VA_ARGS__)
+#else
+#define LOG_WARNING(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#if LOG_MIN_LEVEL <= 3
+#define LOG_ERROR(...) LOG_AT(LogLevel::ERR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) LOG_DISCARD(__VA_ARGS__)
+#endif
+#define LOG_FATAL(...) LOG_AT(LogLevel::FATAL, __VA_ARGS__)
+
+#endif // LOG_H
@@ -0,0 +1,151 @@
+#include "log_format.h"
+
+#include <cstdarg>
+#include <cwchar>
+
+namespace LogFormat {
+
+    namespace {
+
+        class ArgReader {
+        public:
+            ArgReader(const unsigned char* data, size_t size) : m_data(data), m_size(size), m_offset(0) {}
+
+            template<typename T>
+            bool Get(T& value) {
+                if (m_size - m_offset < sizeof(T)) return false;
+                std::memcpy(&value, m_data + m_offset, sizeof(T));
+                m_offset += sizeof(T);
+                return true;
+            }
+
+            bool GetWide(std::wstring& out) {
+                uint32_t length;
+                if (!Get(length) || (m_size - m_offset) / sizeof(uint16_t) < length) return false;
+                for (uint32_t i = 0; i < length; ++i) {
+                    uint16_t unit;
+                    std::memcpy(&unit, m_data + m_offset, sizeof(unit));
+                    m_offset += sizeof(unit);
+                    out.push_back(static_cast<wchar_t>(unit));
+                }
+                return true;
+            }
+
+            bool GetNarrow(std::wstring& out) {
+                uint32_t length;
+                if (!Get(length) || m_size - m_offset < length) return false;
+                for (uint32_t i = 0; i < length; ++i) {
+                    out.push_back(static_cast<wchar_t>(m_data[m_offset + i]));
+                }
+                m_offset += length;
+                return true;
+            }
+
+        private:
+            const unsigned char* m_data;
+            size_t m_size;
+            size_t m_offset;
+        };
+
+        void AppendFormatted(std::wstring& out, const wchar_t* format, ...) {
+            wchar_t buffer[64];
+            va_list args;
+            va_start(args, format);
+            int length = std::vswprintf(buffer, sizeof(buffer) / sizeof(buffer[0]), format, args);
+            va_end(args);
+            if (length > 0) out.append(buffer, static_cast<size_t>(length));
+        }
+
+    } // namespace
+
+    bool FormatArgs(const std::string& signature, const std::wstring& format, const unsigned char* data, size_t size, std::wstring& out) {
+        ArgReader reader(data, size);
+        for (size_t index = 0; index < signature.size(); ++index) {
+            if (index > 0) out.push_back(L' ');
+            switch (signature[index]) {
+            case kFormatArg:
+                out += format;
+                break;
+            case kBoolArg: {
+                uint8_t value;
+                if (!reader.Get(value)) return false;
+                out.push_back(value ? L'1' : L'0');
+                break;
+            }
+            case kCharArg: {
+                uint32_t value;
+                if (!reader.Get(value)) return false;
+                out.push_back(static_cast<wchar_t>(value));
+                break;
+            }
+            case kIntArg: {
+                int64_t value;
+                if (!reader.Get(value)) return false;
+                out += std::to_wstring(value);
+                break;
+            }
+            case kUIntArg: {
+                uint64_t value;
+                if (!reader.Get(value)) return false;
+                out += std::to_wstring(value);
+                break;
+            }
+            case kDoubleArg: {
+                double value;
+                if (!reader.Get(value)) return false;
+                AppendFormatted(out, L"%g", value); // 与 wostream 默认的 6 位有效数字一致
+                break;
+            }
+            case kPointerArg: {
+                uint64_t value;
+                if (!reader.Get(value)) return false;
+                AppendFormatted(out, L"%016llX", static_cast<unsigned long long>(value));
+                break;
+            }
+            case kWideArg:
+            case kTextArg:
+                if (!reader.GetWide(out)) return false;
+                break;
+            case kNarrowArg:
+                if (!reader.GetNarrow(out)) return false;
+                break;
+            default:
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void AppendUtf8(std::string& out, const wchar_t* text, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            uint32_t cp = static_cast<uint32_t>(text[i]);
+            if (cp < 0x80) {
+                out.push_back(static_cast<char>(cp));
+                continue;
+            }
+            if (cp >= 0xD800 && cp < 0xDC00 && i + 1 < length) {
+                uint32_t low = static_cast<uint32_t>(text[i + 1]);
+                if (low >= 0xDC00 && low < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    ++i;
+                }
+            }
+            if (cp < 0x800) {
+                out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+            else if (cp < 0x10000) {
+                out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+            else {
+                out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+                out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+            }
+        }
+    }
+
+} // namespace LogFormat
@@ -0,0 +1,180 @@
+#ifndef LOG_FORMAT_H
+#define LOG_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// 延迟格式化的日志参数编码 (日志库和 tools/log_decode 共用)：
+// 调用点只把参数的原始字节按类型写入记录，格式化由写入线程或离线解码器完成。
+// 每个调用点的参数类型在编译期确定，类型签名 (每个参数一个字符) 随调用点描述符保存一次，记录中不再重复。
+//
+// 二进制日志文件 (小端)：
+//   文件头   "NLOG" uint32 版本
+//   调用点   uint8 kSiteEntry, uint32 编号, uint8 级别, uint32 行号, 字符串 文件名 (UTF-8), 宽字符串 消息模板, 字符串 类型签名
+//   记录     uint8 kRecordEntry, uint32 调用点编号, int64 时间 (Unix 纪元起的微秒), uint16 参数字节数, 参数
+//   文本记录 uint8 kTextEntry, uint8 级别, int64 时间, 宽字符串 消息
+// 字符串为 uint32 长度 + 字节，宽字符串为 uint32 长度 + UTF-16 码元。进程每次打开文件都重新写文件头，调用点编号从文件头起重新计算。
+
+namespace LogFormat {
+
+    // 版本 2 加入了 ERR 级别 (3)，FATAL 从 3 变为 4
+    const uint32_t kFileVersion = 2;
+    const uint8_t kSiteEntry = 1;
+    const uint8_t kRecordEntry = 2;
+    const uint8_t kTextEntry = 3;
+    // 调用点编号的上限：调用点是源码中的日志语句，数量远小于此值。
+    // 描述符按首次引用的顺序写入，编号不一定连续；解码器把更大的编号视为损坏的记录
+    const uint32_t kMaxSiteId = 65535;
+
+    // 参数类型 (类型签名中的字符)
+    const char kFormatArg = 'F';   // 第一个参数是字符串字面量：保存在调用点描述符中，记录中没有数据
+    const char kBoolArg = 'b';     // uint8
+    const char kCharArg = 'c';     // uint32 字符
+    const char kIntArg = 'i';      // int64
+    const char kUIntArg = 'u';     // uint64
+    const char kDoubleArg = 'd';   // double
+    const char kPointerArg = 'p';  // uint64 地址
+    const char kWideArg = 's';     // 宽字符串
+    const char kNarrowArg = 'a';   // 窄字符串 (按字节逐个扩展为宽字符，与 wostream 的行为一致)
+    const char kTextArg = 't';     // 其他类型：在调用线程用 wostream 格式化后按宽字符串保存
+
+    template<typename T>
+    constexpr char KindOf() {
+        using U = std::remove_cv_t<std::decay_t<T>>;
+        if constexpr (std::is_same_v<U, bool>) return kBoolArg;
+        else if constexpr (std::is_same_v<U, wchar_t> || std::is_same_v<U, char>) return kCharArg;
+        else if constexpr (std::is_enum_v<U>) return std::is_signed_v<std::underlying_type_t<U>> ? kIntArg : kUIntArg;
+        else if constexpr (std::is_integral_v<U>) return std::is_signed_v<U> ? kIntArg : kUIntArg;
+        else if constexpr (std::is_floating_point_v<U>) return kDoubleArg;
+        else if constexpr (std::is_same_v<U, const wchar_t*> || std::is_same_v<U, wchar_t*> ||
+            std::is_same_v<U, std::wstring> || std::is_same_v<U, std::wstring_view>) return kWideArg;
+        else if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) return kNarrowArg;
+        else if constexpr (std::is_pointer_v<U>) return kPointerArg;
+        else return kTextArg;
+    }
+
+    // 第一个参数是宽字符串字面量 (数组) 时作为消息模板
+    template<typename T>
+    constexpr bool IsFormatLiteral() {
+        using U = std::remove_reference_t<T>;
+        return std::is_array_v<U> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<U>>, wchar_t>;
+    }
+
+    // 把参数写入定长缓冲区；空间不足时只设置标志，由调用方改用文本记录
+    class ArgWriter {
+    public:
+        ArgWriter(unsigned char* data, size_t capacity) : m_data(data), m_capacity(capacity), m_size(0), m_overflow(false) {}
+
+        template<typename T>
+        void Put(T value) {
+            if (!Reserve(sizeof(T))) return;
+            std::memcpy(m_data + m_size, &value, sizeof(T));
+            m_size += sizeof(T);
+        }
+
+        void PutWide(const wchar_t* text, size_t length) {
+            if (!Reserve(sizeof(uint32_t) + length * sizeof(uint16_t))) return;
+            Put<uint32_t>(static_cast<uint32_t>(length));
+            if constexpr (sizeof(wchar_t) == sizeof(uint16_t)) {
+                std::memcpy(m_data + m_size, text, length * sizeof(uint16_t));
+                m_size += length * sizeof(uint16_t);
+            }
+            else {
+                for (size_t i = 0; i < length; ++i) Put<uint16_t>(static_cast<uint16_t>(text[i]));
+            }
+        }
+
+        void PutNarrow(const char* text, size_t length) {
+            if (!Reserve(sizeof(uint32_t) + length)) return;
+            Put<uint32_t>(static_cast<uint32_t>(length));
+            std::memcpy(m_data + m_size, text, length);
+            m_size += length;
+        }
+
+        size_t Size() const { return m_size; }
+        bool Overflowed() const { return m_overflow; }
+
+    private:
+        bool Reserve(size_t bytes) {
+            if (m_overflow || m_capacity - m_size < bytes) {
+                m_overflow = true;
+                return false;
+            }
+            return true;
+        }
+
+        unsigned char* m_data;
+        size_t m_capacity;
+        size_t m_size;
+        bool m_overflow;
+    };
+
+    template<typename T>
+    void EncodeArg(ArgWriter& writer, const T& value) {
+        constexpr char kind = KindOf<T>();
+        if constexpr (kind == kBoolArg) {
+            writer.Put<uint8_t>(value ? 1 : 0);
+        }
+        else if constexpr (kind == kCharArg) {
+            using U = std::remove_cv_t<T>;
+            using Unsigned = std::conditional_t<std::is_same_v<U, char>, unsigned char, std::make_unsigned_t<wchar_t>>;
+            writer.Put<uint32_t>(static_cast<uint32_t>(static_cast<Unsigned>(value)));
+        }
+        else if constexpr (kind == kIntArg) {
+            writer.Put<int64_t>(static_cast<int64_t>(value));
+        }
+        else if constexpr (kind == kUIntArg) {
+            writer.Put<uint64_t>(static_cast<uint64_t>(value));
+        }
+        else if constexpr (kind == kDoubleArg) {
+            writer.Put<double>(static_cast<double>(value));
+        }
+        else if constexpr (kind == kWideArg) {
+            if constexpr (std::is_same_v<std::remove_cv_t<T>, std::wstring> || std::is_same_v<std::remove_cv_t<T>, std::wstring_view>) {
+                writer.PutWide(value.data(), value.size());
+            }
+            else {
+                const wchar_t* text = value;
+                writer.PutWide(text, text ? std::wcslen(text) : 0);
+            }
+        }
+        else if constexpr (kind == kNarrowArg) {
+            const char* text = value;
+            writer.PutNarrow(text, text ? std::strlen(text) : 0);
+        }
+        else if constexpr (kind == kPointerArg) {
+            writer.Put<uint64_t>(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(static_cast<const volatile void*>(value))));
+        }
+        else {
+            std::wostringstream wss;
+            wss << value;
+            std::wstring text = wss.str();
+            writer.PutWide(text.data(), text.size());
+        }
+    }
+
+    /**
+     * @brief 按类型签名把参数还原为文本：与 Logger 的即时格式化相同，参数之间用一个空格分隔。
+     * @param signature 调用点的类型签名。
+     * @param format 消息模板 (签名以 kFormatArg 开头时使用)。
+     * @param data 参数字节。
+     * @param size 参数字节数。
+     * @param out [out] 追加格式化结果。
+     * @return 数据与签名不符时返回 false (out 中保留已经解出的部分)。
+     */
+    bool FormatArgs(const std::string& signature, const std::wstring& format, const unsigned char* data, size_t size, std::wstring& out);
+
+    /**
+     * @brief 把 UTF-16 文本转换为 UTF-8 追加到 out (代理对合并为一个码点，孤立的代理按原值编码)。
+     */
+    void AppendUtf8(std::string& out, const wchar_t* text, size_t length);
+
+} // namespace LogFormat
+
+#endif // LOG_FORMAT_H
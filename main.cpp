@@ -1,194 +1,339 @@
-// main.cpp : Ӧóڵ㡣
-//
-
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN             //  Windows ͷļųʹõ
-#endif
-
-#include <windows.h>
-#include <string>
-#include <iostream> // ڵ (Ҫ̨)
-
-#include "globals.h"    // ȫֱͺ
-#include "config.h"     // ù
-#include "log.h"        // ־ϵͳ
-#include "utils.h"      // ʵùߺ
-#include "network.h"    // 繦
-#include "ui.h"         // û
-#include "update.h"     // ¼Ӧ
-#include "threads.h"    // ̳߳ (Ҫ̨)
-// #include "registry.h"   // ע (Ҫ)
-// #include "system_ops.h" // ϵͳ (Ҫ)
-
-
-// ȫ Config ʵ (Ϊ)
-Config g_appConfig;
-ThreadPool* g_pThreadPool = nullptr; // ȫָ̳߳
-
-// --- Ӧó߼ ---
-void PerformBackgroundUpdateCheck() {
-    if (!g_pThreadPool) return;
-
-    g_pThreadPool->enqueue([] {
-        LOG_INFO(L"Background thread: Starting update check...");
-        UI::UpdateStatusText(L"Checking for updates...");
-        Update::VersionInfo newVersion;
-        // TODO: жȡ updateCheckUrl
-        std::string updateUrl = "YOUR_UPDATE_CHECK_URL_HERE"; //  https://example.com/update.json
-        // һ򵥵ıļ URL
-        // "https://pastebin.com/raw/XXXXXXXX"; ( pastebin raw link 滻)
-
-// ȷ URL ЧģҷԤڵĸʽ
-// ʾ:  "version|url|notes"
-// updateUrl = "http://127.0.0.1:8000/update_info.txt"; // ز
-// һ update_info.txt ļ: 1.0.1|http://127.0.0.1:8000/NewsForHeng_1.0.1.zip|Bug fixes and new features.
-
-        if (updateUrl == "YOUR_UPDATE_CHECK_URL_HERE") {
-            LOG_WARNING(L"Update check URL is not configured. Skipping update check.");
-            UI::UpdateStatusText(L"Update URL not configured.");
-            return;
-        }
-
-
-        if (Update::CheckForUpdates(g_appVersion, updateUrl, newVersion)) {
-            LOG_INFO(L"New version available: ", newVersion.versionString);
-            UI::UpdateStatusText(L"New version " + newVersion.versionString + L" available!");
-            // ʾû
-            std::wstring prompt = L"A new version (" + newVersion.versionString + L") is available.\n\nRelease Notes:\n" + newVersion.releaseNotes + L"\n\nDo you want to download and install it now?";
-            if (MessageBoxW(g_hMainWnd, prompt.c_str(), g_appName.c_str(), MB_YESNO | MB_ICONINFORMATION) == IDYES) {
-                UI::UpdateStatusText(L"Downloading update " + newVersion.versionString + L"...");
-                Update::DownloadAndApplyUpdate(newVersion,
-                    [](long long downloaded, long long total) { // Progress callback
-                        std::wstringstream wss;
-                        if (total > 0) {
-                            wss << L"Downloading: " << (downloaded * 100 / total) << L"% ("
-                                << downloaded / (1024 * 1024) << L"MB / " << total / (1024 * 1024) << L"MB)";
-                        }
-                        else {
-                            wss << L"Downloading: " << downloaded / (1024 * 1024) << L"MB";
-                        }
-                        UI::UpdateStatusText(wss.str());
-                    },
-                    []() -> bool { // Restart callback
-                        LOG_INFO(L"Update downloaded. Requesting application restart.");
-                        // ֪ͨѭ˳˳ǰ³
-                        // ͨͨһȫֱ־ȻϢѭ֮
-                        // ֱ PostQuitMessageȻ WinMain ǰ
-                        if (g_hMainWnd) SendMessage(g_hMainWnd, WM_CLOSE, 0, 0); // Politely ask to close
-                        // Actual restart logic (launching updater) should happen after main loop exits.
-                        // For now, this callback signals that restart is desired.
-                        return true; // Signify restart was initiated from UI's perspective
-                    }
-                );
-            }
-        }
-        else {
-            LOG_INFO(L"No new updates found or failed to check.");
-            UI::UpdateStatusText(L"Application is up to date.");
-        }
-        });
-}
-
-bool AppExitRequested() {
-    // ִ˳ǰȷ
-    // 磬̳߳еĹؼ񣬿Ҫȴʾû
-    if (g_pThreadPool && g_pThreadPool->GetTaskQueueSize() > 0) {
-        if (MessageBoxW(g_hMainWnd, L"Tasks are still running in the background. Are you sure you want to exit?", g_appName.c_str(), MB_YESNO | MB_ICONWARNING) == IDNO) {
-            return false; // ֹ˳
-        }
-    }
-    return true; // ˳
-}
-
-
-//  WinMain
-int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
-    _In_opt_ HINSTANCE hPrevInstance,
-    _In_ LPWSTR    lpCmdLine,
-    _In_ int       nCmdShow)
-{
-    UNREFERENCED_PARAMETER(hPrevInstance); // δʹõĲ
-    UNREFERENCED_PARAMETER(lpCmdLine);
-
-    // 1. ʼȫֱ
-    InitializeGlobals(); //  g_configFilePath, g_logFilePath 
-
-    // 2. ʼ־ϵͳ
-    // ȷ־Ŀ¼ (InitializeGlobals ӦѾ g_appDataDir Ĵ)
-    Logger::GetInstance().SetLogFile(g_logFilePath); // ʹ globals õ·
-    Logger::GetInstance().SetLogLevel(g_debugMode ? LogLevel::DEBUG : LogLevel::INFO);
-    LOG_INFO(L"--------------------------------------------------");
-    LOG_INFO(g_appName, L" version ", g_appVersion, L" started.");
-    LOG_INFO(L"Command line: ", lpCmdLine);
-
-
-    // 3. 
-    if (g_appConfig.Load(g_configFilePath)) {
-        LOG_INFO(L"Configuration loaded from: ", g_configFilePath);
-        g_debugMode = g_appConfig.GetBool(L"Settings", L"DebugMode", g_debugMode);
-        Logger::GetInstance().SetLogLevel(g_debugMode ? LogLevel::DEBUG : LogLevel::INFO); // ־
-        // ȡ...
-    }
-    else {
-        LOG_WARNING(L"Failed to load configuration or config file not found. Using default settings.");
-        // ԿǱһĬ
-        // g_appConfig.SetBool(L"Settings", L"DebugMode", g_debugMode);
-        // g_appConfig.Save(g_configFilePath);
-    }
-
-    // 4. ʼ (Winsock)
-    if (!Network::Initialize()) {
-        LOG_FATAL(L"Failed to initialize Winsock. Application cannot continue.");
-        MessageBoxW(NULL, L"Network initialization failed. Please check your network configuration.", L"Fatal Error", MB_ICONERROR | MB_OK);
-        return 1;
-    }
-
-    // 5. ʼ̳߳ (Ҫ)
-    g_pThreadPool = new ThreadPool(); // ʹĬ߳
-
-    // 6. 
-    UI::onCheckForUpdatesClicked = PerformBackgroundUpdateCheck; // UIص
-    UI::onExitRequested = AppExitRequested;                     // ˳ȷϻص
-
-    if (!UI::CreateMainWindow(hInstance, nCmdShow, g_appName, 800, 600)) {
-        LOG_FATAL(L"Failed to create main window. Application cannot continue.");
-        // ѳʼĲ
-        if (g_pThreadPool) delete g_pThreadPool;
-        Network::Cleanup();
-        CleanupGlobals();
-        return 1;
-    }
-
-    LOG_INFO(L"Main window created. Entering message loop.");
-    UI::UpdateStatusText(L"Welcome to " + g_appName + L"!");
-
-    // 7. ʱԶ (ѡ, ںִ̨߳)
-    // PerformBackgroundUpdateCheck(); // ͨUIť
-
-    // 8. Ϣѭ
-    int exitCode = UI::RunMessageLoop();
-    LOG_INFO(L"Message loop exited with code: ", exitCode);
-
-    // 9. 
-    LOG_INFO(L"Application shutting down...");
-
-    //  (ѡ)
-    // g_appConfig.SetBool(L"Settings", L"DebugMode", g_debugMode); // յĵģʽ״̬
-    // if (!g_appConfig.Save()) { // 浽ϴμص·
-    //     LOG_ERROR(L"Failed to save configuration to: ", g_configFilePath);
-    // } else {
-    //     LOG_INFO(L"Configuration saved to: ", g_configFilePath);
-    // }
-
-    if (g_pThreadPool) {
-        delete g_pThreadPool;
-        g_pThreadPool = nullptr;
-    }
-    Network::Cleanup(); //  Winsock
-    CleanupGlobals();   // ȫԴ
-
-    LOG_INFO(g_appName, L" exited gracefully. Exit code: ", exitCode);
-    Logger::GetInstance().SetLogFile(L""); // ر־ļ (LoggerҲ)
-
-    return exitCode;
-}
+// main.cpp : 定义应用程序的入口点。
+//
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN             // 从 Windows 头文件中排除极少使用的内容
+#endif
+
+#include <windows.h>
+#include <string>
+#include <iostream> // 用于调试输出 (如果需要控制台)
+#include <atomic>
+#include <exception>
+#include <sstream>
+
+#include "globals.h"    // 全局变量和函数
+#include "config.h"     // 配置管理
+#include "log.h"        // 日志系统
+#include "utils.h"      // 实用工具函数
+#include "network.h"    // 网络功能
+#include "ui.h"         // 用户界面
+#include "update.h"     // 更新检查与应用
+#include "threads.h"    // 线程池 (如果需要后台任务)
+#include "cpu_topology.h" // CPU 拓扑 (按物理核心确定计算线程数)
+#include "update_scheduler.h" // 定时后台更新检查
+#include "coro.h"       // 协程 (Task / Spawn)
+#include "install.h"    // 并排安装 (版本切换与回滚)
+// #include "registry.h"   // 注册表操作 (如果需要)
+// #include "system_ops.h" // 系统操作 (如果需要)
+
+
+// 全局 Config 实例 (或者作为单例管理)
+Config g_appConfig;
+ThreadPool* g_pThreadPool = nullptr; // 全局线程池指针
+UpdateScheduler* g_pUpdateScheduler = nullptr; // 定时更新检查
+
+// 命令行开关：切回上一个并排安装的版本
+static const wchar_t* kRollbackSwitch = L"--rollback";
+
+// --- 应用程序逻辑函数 ---
+
+// 更新检查地址，从配置 [Update] CheckUrl 读取，未配置时返回空字符串
+// 例如 https://example.com/update.json
+// 确保 URL 是有效的，并且服务器返回预期的格式
+static std::string GetUpdateCheckUrl() {
+    return WideToUtf8(g_appConfig.GetString(L"Update", L"CheckUrl", L""));
+}
+
+// 提示用户有新版本，并在用户确认后下载安装 (手动检查和定时检查共用)。
+// cancellation 被取消 (程序退出、调度器停止) 时关闭仍在等待回答的确认框并中止下载
+void PromptAndInstallUpdate(const Update::VersionInfo& newVersion, const CancellationToken& cancellation) {
+    if (cancellation.IsCancellationRequested()) {
+        return;
+    }
+    LOG_INFO(L"New version available: ", newVersion.versionString);
+    UI::UpdateStatusText(L"New version " + newVersion.versionString + L" available!");
+    // 提示用户更新
+    std::wstring prompt = L"A new version (" + newVersion.versionString + L") is available.\n\nRelease Notes:\n" + newVersion.releaseNotes + L"\n\nDo you want to download and install it now?";
+    int answer;
+    {
+        // 确认框运行在本线程上：取消时向本线程的窗口发送"否"，MessageBoxW 随即返回
+        DWORD promptThread = GetCurrentThreadId();
+        CancellationRegistration dismiss = cancellation.Register([promptThread]() {
+            EnumThreadWindows(promptThread, [](HWND hwnd, LPARAM) -> BOOL {
+                PostMessageW(hwnd, WM_COMMAND, IDNO, 0);
+                return TRUE;
+            }, 0);
+        });
+        answer = MessageBoxW(g_hMainWnd, prompt.c_str(), g_appName.c_str(), MB_YESNO | MB_ICONINFORMATION);
+    }
+    if (answer == IDYES && !cancellation.IsCancellationRequested()) {
+        UI::UpdateStatusText(L"Downloading update " + newVersion.versionString + L"...");
+        Update::DownloadAndApplyUpdate(newVersion,
+            [](long long downloaded, long long total) { // Progress callback
+                std::wstringstream wss;
+                if (total > 0) {
+                    wss << L"Downloading: " << (downloaded * 100 / total) << L"% ("
+                        << downloaded / (1024 * 1024) << L"MB / " << total / (1024 * 1024) << L"MB)";
+                }
+                else {
+                    wss << L"Downloading: " << downloaded / (1024 * 1024) << L"MB";
+                }
+                UI::UpdateStatusText(wss.str());
+            },
+            []() -> bool { // Restart callback
+                LOG_INFO(L"Update downloaded. Requesting application restart.");
+                // 通知主循环退出，并在退出前启动更新程序
+                // 这通常通过设置一个全局标志，然后在主消息循环之后处理
+                // 或者直接 PostQuitMessage，然后在 WinMain 返回前处理
+                if (g_hMainWnd) SendMessage(g_hMainWnd, WM_CLOSE, 0, 0); // Politely ask to close
+                // Actual restart logic (launching updater) should happen after main loop exits.
+                // For now, this callback signals that restart is desired.
+                return true; // Signify restart was initiated from UI's perspective
+            },
+            cancellation
+        );
+    }
+}
+
+// 手动检查更新：等待服务器响应期间协程挂起，不占用工作线程
+static Coro::Task<void> RunUpdateCheck(std::string updateUrl) {
+    LOG_INFO(L"Background thread: Starting update check...");
+    UI::UpdateStatusText(L"Checking for updates...");
+    Update::VersionInfo newVersion;
+    CancellationToken cancellation = g_pThreadPool->GetShutdownToken(); // 程序退出时中止请求
+
+    if (co_await Update::CheckForUpdatesAsync(*g_pThreadPool, g_appVersion, updateUrl, newVersion, nullptr, cancellation)) {
+        // 确认对话框和下载都会长时间阻塞，切换到 I/O 执行器上进行
+        TaskOptions blocking;
+        blocking.blocking = true;
+        blocking.tag = "update-install";
+        co_await g_pThreadPool->schedule(blocking);
+        PromptAndInstallUpdate(newVersion, cancellation);
+    }
+    else if (cancellation.IsCancellationRequested()) {
+        LOG_INFO(L"Update check canceled by shutdown.");
+    }
+    else {
+        LOG_INFO(L"No new updates found or failed to check.");
+        UI::UpdateStatusText(L"Application is up to date.");
+    }
+}
+
+void PerformBackgroundUpdateCheck() {
+    if (!g_pThreadPool) return;
+
+    std::string updateUrl = GetUpdateCheckUrl();
+    if (updateUrl.empty()) {
+        LOG_WARNING(L"Update check URL is not configured. Skipping update check.");
+        UI::UpdateStatusText(L"Update URL not configured.");
+        return;
+    }
+
+    // 用户手动触发的检查走 Interactive 队列，不排在后台下载 / 解压任务之后
+    TaskOptions interactive;
+    interactive.priority = TaskPriority::Interactive;
+    Coro::Spawn(*g_pThreadPool, RunUpdateCheck(updateUrl), interactive);
+}
+
+bool AppExitRequested() {
+    // 在这里可以执行退出前的清理工作或确认
+    // 例如，如果线程池中有正在运行的关键任务，可能需要等待或提示用户
+    if (g_pThreadPool && g_pThreadPool->GetTaskQueueSize() > 0) {
+        if (MessageBoxW(g_hMainWnd, L"Tasks are still running in the background and will be canceled. Are you sure you want to exit?", g_appName.c_str(), MB_YESNO | MB_ICONWARNING) == IDNO) {
+            return false; // 阻止退出
+        }
+    }
+    return true; // 允许退出
+}
+
+
+// 崩溃处理：异步日志缓冲区中的记录不依赖写入线程直接写出，随后交给系统默认处理 (WER)
+static LONG WINAPI OnUnhandledException(EXCEPTION_POINTERS* info) {
+    std::wstringstream wss;
+    wss << L"Unhandled exception 0x" << std::hex << info->ExceptionRecord->ExceptionCode
+        << L" at " << info->ExceptionRecord->ExceptionAddress << L". Terminating.";
+    Logger::GetInstance().WriteCrashReport(wss.str());
+    return EXCEPTION_CONTINUE_SEARCH;
+}
+
+static void OnTerminate() {
+    Logger::GetInstance().WriteCrashReport(L"std::terminate called (uncaught C++ exception). Terminating.");
+    std::abort();
+}
+
+// 运行中修改配置文件的 [Log] 节后，日志级别在几秒内生效，不需要重启。
+// 只读取日志级别，不替换 g_appConfig (其中可能有尚未保存的修改)
+static void ReloadLogLevelsIfChanged() {
+    static std::atomic<unsigned long long> lastWriteTime{ 0 };
+    WIN32_FILE_ATTRIBUTE_DATA attributes;
+    if (!GetFileAttributesExW(g_configFilePath.c_str(), GetFileExInfoStandard, &attributes)) {
+        return;
+    }
+    ULARGE_INTEGER writeTime;
+    writeTime.LowPart = attributes.ftLastWriteTime.dwLowDateTime;
+    writeTime.HighPart = attributes.ftLastWriteTime.dwHighDateTime;
+    if (lastWriteTime.exchange(writeTime.QuadPart) == writeTime.QuadPart) {
+        return;
+    }
+    Config config;
+    if (config.Load(g_configFilePath)) {
+        Logger::GetInstance().ApplyLevels(config);
+    }
+}
+
+// 主函数 WinMain
+int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
+    _In_opt_ HINSTANCE hPrevInstance,
+    _In_ LPWSTR    lpCmdLine,
+    _In_ int       nCmdShow)
+{
+    UNREFERENCED_PARAMETER(hPrevInstance); // 标记未使用的参数
+
+    // 1. 初始化全局变量
+    InitializeGlobals(); // 这会设置 g_configFilePath, g_logFilePath 等
+
+    // 2. 初始化日志系统
+    // 确保日志目录存在 (InitializeGlobals 应该已经处理了 g_appDataDir 的创建)
+    Logger::GetInstance().SetLogFile(g_logFilePath); // 使用 globals 中设置的路径
+    Logger::GetInstance().SetLogLevel(g_debugMode ? LogLevel::DEBUG : LogLevel::INFO);
+    SetUnhandledExceptionFilter(OnUnhandledException);
+    std::set_terminate(OnTerminate);
+    LOG_INFO(L"--------------------------------------------------");
+    LOG_INFO(g_appName, L" version ", g_appVersion, L" started.");
+    LOG_INFO(L"Command line: ", lpCmdLine);
+
+    // 并排安装：--rollback 手动切回上一个版本；"current" 指向其他版本目录时启动那个版本并退出
+    std::wstring commandLine = lpCmdLine ? lpCmdLine : L"";
+    size_t rollbackSwitch = commandLine.find(kRollbackSwitch);
+    if (rollbackSwitch != std::wstring::npos) {
+        commandLine.erase(rollbackSwitch, wcslen(kRollbackSwitch)); // 不转发给启动的版本，否则会再切换一次
+        Install::RollbackToPreviousVersion();
+    }
+    if (Install::RedirectToCurrentVersion(commandLine)) {
+        Logger::GetInstance().SetLogFile(L"");
+        CleanupGlobals();
+        return 0;
+    }
+
+
+    // 3. 加载配置
+    if (g_appConfig.Load(g_configFilePath)) {
+        LOG_INFO(L"Configuration loaded from: ", g_configFilePath);
+        g_debugMode = g_appConfig.GetBool(L"Settings", L"DebugMode", g_debugMode);
+        Logger::GetInstance().SetLogLevel(g_debugMode ? LogLevel::DEBUG : LogLevel::INFO); // 根据配置重设日志级别
+        Logger::GetInstance().ApplyLevels(g_appConfig); // [Log] Level 及各模块的级别
+        // 读取其他配置...
+    }
+    else {
+        LOG_WARNING(L"Failed to load configuration or config file not found. Using default settings.");
+        // 可以考虑保存一份默认配置
+        // g_appConfig.SetBool(L"Settings", L"DebugMode", g_debugMode);
+        // g_appConfig.Save(g_configFilePath);
+    }
+
+    // 默认使用异步日志：工作线程记录日志时不再争用文件锁、也不为每一条日志 flush
+    LoggerOptions logOptions;
+    logOptions.mode = LogMode::Async;
+    Logger::GetInstance().Configure(Logger::LoadOptions(g_appConfig, logOptions));
+
+    // 4. 初始化网络 (Winsock)
+    if (!Network::Initialize()) {
+        LOG_FATAL(L"Failed to initialize Winsock. Application cannot continue.");
+        MessageBoxW(NULL, L"Network initialization failed. Please check your network configuration.", L"Fatal Error", MB_ICONERROR | MB_OK);
+        return 1;
+    }
+
+    // 5. 初始化线程池 (如果需要)
+    // 使用默认线程数；下载、解压等任务会在工作线程内部再拆分子任务，工作窃取模式下这些子任务不经过共享队列
+    ThreadPoolOptions poolOptions;
+    poolOptions.scheduling = SchedulingMode::WorkStealing;
+    poolOptions.reservedInteractiveWorkers = 1; // 大量后台任务排队时，手动检查更新等交互操作仍能立即执行
+    // 应用大部分时间空闲：空闲线程退出到 2 个；每个核心一个计算线程，
+    // 网络请求等阻塞任务 (TaskOptions::blocking) 交给独立的 I/O 执行器，多个下载同时阻塞时在那里增加线程
+    poolOptions.minThreads = 2;
+    poolOptions.ioThreads = 4;
+    poolOptions.ioMaxThreads = 16;
+    poolOptions = ThreadPool::LoadOptions(g_appConfig, poolOptions);
+    // 预留线程只执行 Interactive 任务，不算计算线程：配置中没有指定线程数时在核数之上另加预留线程。
+    // 按物理核心而不是逻辑处理器计数，同一核心上的超线程共享执行单元，对计算任务帮助不大；
+    // 拓扑查询失败时 CpuTopology 已退化为每个逻辑处理器一个核心
+    size_t computeThreads = CpuTopology::Get().coreCount;
+    if (computeThreads == 0) computeThreads = (std::max)(std::thread::hardware_concurrency(), 1u);
+    if (poolOptions.numThreads == 0) poolOptions.numThreads = computeThreads + poolOptions.reservedInteractiveWorkers;
+    if (poolOptions.maxThreads == 0) poolOptions.maxThreads = computeThreads + poolOptions.reservedInteractiveWorkers;
+    g_pThreadPool = new ThreadPool(poolOptions);
+
+    // 定期检查配置文件中的日志级别 (线程池关闭时定时器随之取消)
+    TaskOptions logConfigOptions;
+    logConfigOptions.priority = TaskPriority::Background;
+    logConfigOptions.tag = "log-config";
+    g_pThreadPool->enqueue_every(std::chrono::seconds(5), ReloadLogLevelsIfChanged, logConfigOptions);
+
+    // 6. 创建主窗口
+    UI::onCheckForUpdatesClicked = PerformBackgroundUpdateCheck; // 设置UI回调
+    UI::onExitRequested = AppExitRequested;                     // 设置退出确认回调
+
+    if (!UI::CreateMainWindow(hInstance, nCmdShow, g_appName, 800, 600)) {
+        LOG_FATAL(L"Failed to create main window. Application cannot continue.");
+        // 清理已初始化的部分
+        Network::StopAsyncRequests();
+        if (g_pThreadPool) delete g_pThreadPool;
+        Network::Cleanup();
+        CleanupGlobals();
+        return 1;
+    }
+
+    LOG_INFO(L"Main window created. Entering message loop.");
+    Install::ConfirmVersionStarted(); // 新版本首次启动成功，不再需要自动回滚
+    UI::UpdateStatusText(L"Welcome to " + g_appName + L"!");
+
+    // 7. 启动定时更新检查 (间隔、抖动、暂停条件见 update_scheduler.h)
+    g_pUpdateScheduler = new UpdateScheduler(*g_pThreadPool, g_appConfig);
+    g_pUpdateScheduler->Start(PromptAndInstallUpdate);
+
+    // 8. 运行主消息循环
+    int exitCode = UI::RunMessageLoop();
+    LOG_INFO(L"Message loop exited with code: ", exitCode);
+
+    // 9. 清理工作
+    LOG_INFO(L"Application shutting down...");
+
+    // 保存配置 (可选)
+    // g_appConfig.SetBool(L"Settings", L"DebugMode", g_debugMode); // 保存最终的调试模式状态
+    // if (!g_appConfig.Save()) { // 保存到上次加载的路径
+    //     LOG_ERROR(L"Failed to save configuration to: ", g_configFilePath);
+    // } else {
+    //     LOG_INFO(L"Configuration saved to: ", g_configFilePath);
+    // }
+
+    // 先停止调度器 (会等待正在执行的检查)，再销毁线程池
+    if (g_pUpdateScheduler) {
+        g_pUpdateScheduler->Stop();
+        delete g_pUpdateScheduler;
+        g_pUpdateScheduler = nullptr;
+    }
+
+    // 先结束未完成的异步请求：它们的完成回调向线程池提交协程的恢复任务，线程池销毁后不能再被调用
+    Network::StopAsyncRequests();
+
+    // 限时关闭线程池：取消排队的任务并通知进行中的下载中止，而不是等待下载超时
+    if (g_pThreadPool) {
+        if (g_pThreadPool->Shutdown(std::chrono::milliseconds(500))) {
+            delete g_pThreadPool;
+        }
+        else {
+            // 仍有任务没有响应取消：析构会无限期等待它们，这里有意泄漏，交给进程退出回收
+            LOG_WARNING(L"Thread pool did not stop in time. Leaving remaining workers to process exit.");
+        }
+        g_pThreadPool = nullptr;
+    }
+    Network::Cleanup(); // 清理 Winsock
+    CleanupGlobals();   // 清理全局资源
+
+    LOG_INFO(g_appName, L" exited gracefully. Exit code: ", exitCode);
+    Logger::GetInstance().Configure(LoggerOptions()); // 停止写入线程并写出缓冲区中的记录
+    Logger::GetInstance().SetLogFile(L""); // 关闭日志文件句柄 (Logger析构函数也会做)
+
+    return exitCode;
+}
@@ -0,0 +1,433 @@
+#define LOG_MODULE LogModule::Network // 本文件的日志属于网络模块 (见 log.h)
+#include "mirrors.h"
+#include "network.h"
+#include "threads.h"
+#include "task_future.h"
+#include "log.h"
+#include "utils.h"   // For Utf8ToWide, FileExists
+#include "globals.h" // For g_appDataDir
+
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <algorithm> // For std::stable_sort
+
+namespace Mirrors {
+
+    // 延迟探测只请求 1 字节，吞吐量探测请求 256KB
+    static const long long kThroughputProbeBytes = 256 * 1024;
+    // 排序时按下载此大小所需的时间估算 (兼顾延迟和吞吐量)
+    static const double kScoreReferenceBytes = 8.0 * 1024 * 1024;
+    // 分段下载的段大小：段越小失败时损失越少，段越大请求开销越低
+    static const long long kSegmentBytes = 4LL * 1024 * 1024;
+    // 每个镜像在一次下载中允许失败的次数，全部镜像都用完后放弃
+    static const int kMaxAttemptsPerMirror = 2;
+    // 新测量值在历史记录中的权重
+    static const double kHistoryAlpha = 0.5;
+
+    static const wchar_t* kHistoryFileName = L"mirrors.dat";
+
+    // mirrors.dat 的读写互斥 (探测任务并行执行)
+    static std::mutex s_historyMutex;
+
+    struct HistoryRecord {
+        double latencyMs = 0.0;
+        double throughputBps = 0.0;
+        int failures = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    static double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // 镜像主机标识：scheme://host:port，包地址随版本变化但主机不变
+    static std::string OriginOf(const std::string& url) {
+        Network::ParsedUrl purl = Network::ParseUrl(url);
+        if (!purl.isValid) return url;
+        return purl.scheme + "://" + purl.host + ":" + std::to_string(purl.port);
+    }
+
+    static std::wstring HistoryPath() {
+        return g_appDataDir + L"\\" + kHistoryFileName;
+    }
+
+    // 每行格式：<延迟ms> <吞吐量B/s> <失败次数> <origin>
+    static std::map<std::string, HistoryRecord> LoadHistory() {
+        std::map<std::string, HistoryRecord> history;
+        std::ifstream file(HistoryPath());
+        if (!file.is_open()) return history;
+
+        std::string line;
+        while (std::getline(file, line)) {
+            std::istringstream iss(line);
+            HistoryRecord record;
+            std::string origin;
+            if (iss >> record.latencyMs >> record.throughputBps >> record.failures >> origin) {
+                history[origin] = record;
+            }
+        }
+        return history;
+    }
+
+    static void SaveHistory(const std::map<std::string, HistoryRecord>& history) {
+        std::wstring path = HistoryPath();
+        std::wstring tempPath = path + L".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::trunc);
+            if (!file.is_open()) {
+                LOG_WARNING(L"Failed to write mirror history: ", tempPath.c_str());
+                return;
+            }
+            for (const auto& kv : history) {
+                file << kv.second.latencyMs << ' ' << kv.second.throughputBps << ' ' << kv.second.failures << ' ' << kv.first << '\n';
+            }
+        }
+        if (!MoveFileExW(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+            LOG_WARNING(L"Failed to replace mirror history file. Error: ", GetLastError());
+            DeleteFileW(tempPath.c_str());
+        }
+    }
+
+    static void MergeMeasurement(HistoryRecord& record, bool hadHistory, double latencyMs, double throughputBps) {
+        if (hadHistory && record.throughputBps > 0.0) {
+            record.latencyMs = kHistoryAlpha * latencyMs + (1.0 - kHistoryAlpha) * record.latencyMs;
+            record.throughputBps = kHistoryAlpha * throughputBps + (1.0 - kHistoryAlpha) * record.throughputBps;
+        }
+        else {
+            record.latencyMs = latencyMs;
+            record.throughputBps = throughputBps;
+        }
+        record.failures = (std::max)(record.failures - 1, 0);
+    }
+
+    // 下载过程中的实测结果 (吞吐量或失败) 写回历史记录
+    static void RecordOutcome(const std::string& url, bool success, double throughputBps) {
+        std::lock_guard<std::mutex> lock(s_historyMutex);
+        std::map<std::string, HistoryRecord> history = LoadHistory();
+        std::string origin = OriginOf(url);
+        auto it = history.find(origin);
+        bool hadHistory = it != history.end();
+        HistoryRecord& record = history[origin];
+        if (success) {
+            MergeMeasurement(record, hadHistory, record.latencyMs, throughputBps);
+        }
+        else {
+            ++record.failures;
+        }
+        SaveHistory(history);
+    }
+
+    // 响应头 (名称不区分大小写)，没有时返回空字符串
+    static std::string FindHeader(const std::map<std::string, std::string>& headers, const char* name) {
+        for (const auto& kv : headers) {
+            if (_stricmp(kv.first.c_str(), name) == 0) return kv.second;
+        }
+        return std::string();
+    }
+
+    // 两个镜像是否提供同一个文件：大小相同，且双方都给出的 ETag (否则 Last-Modified) 一致
+    static bool SameObject(const MirrorStats& a, const MirrorStats& b) {
+        if (a.totalSize != b.totalSize) return false;
+        if (!a.etag.empty() && !b.etag.empty()) return a.etag == b.etag;
+        if (!a.lastModified.empty() && !b.lastModified.empty()) return a.lastModified == b.lastModified;
+        return true;
+    }
+
+    struct ProbeResult {
+        MirrorStats stats;
+    };
+
+    static ProbeResult ProbeMirror(const std::string& url, const CancellationToken& cancellation) {
+        ProbeResult result;
+        result.stats.url = url;
+
+        // 1. 延迟：请求第一个字节
+        std::map<std::string, std::string> responseHeaders;
+        std::string body;
+        long long totalSize = -1;
+        int statusCode = 0;
+        Clock::time_point start = Clock::now();
+        bool ranged = Network::HttpGetRange(url, 0, 0, body, &totalSize, &responseHeaders, 5000, cancellation, &statusCode);
+        // 206 但区间不符同样按失败处理；其他 2xx 表示服务器可用但不支持 Range
+        if (!ranged && (statusCode < 200 || statusCode >= 300 || statusCode == 206)) {
+            LOG_INFO(L"Mirror probe failed: ", Utf8ToWide(url).c_str());
+            return result;
+        }
+        result.stats.latencyMs = ElapsedMs(start);
+        result.stats.etag = FindHeader(responseHeaders, "ETag");
+        result.stats.lastModified = FindHeader(responseHeaders, "Last-Modified");
+        result.stats.reachable = true;
+
+        // 服务器不支持 Range (响应头之后即断开，没有接收整个文件) 或没有给出文件大小：
+        // 大小报告为未知，此镜像无法参与分段下载；吞吐量未知，排在可用镜像的最后
+        if (!ranged || totalSize < 0) {
+            LOG_INFO(L"Mirror does not support range requests: ", Utf8ToWide(url).c_str());
+            return result;
+        }
+        result.stats.totalSize = totalSize;
+
+        // 2. 吞吐量：请求一段较大的数据，扣除延迟后计算
+        long long probeEnd = (std::min)(kThroughputProbeBytes, totalSize) - 1;
+        start = Clock::now();
+        if (!Network::HttpGetRange(url, 0, probeEnd, body, nullptr, nullptr, 10000, cancellation)) {
+            LOG_INFO(L"Mirror throughput probe failed: ", Utf8ToWide(url).c_str());
+            result.stats.reachable = false;
+            return result;
+        }
+        double transferMs = (std::max)(ElapsedMs(start) - result.stats.latencyMs, 1.0);
+        result.stats.throughputBps = body.size() / (transferMs / 1000.0);
+        return result;
+    }
+
+    // 下载 kScoreReferenceBytes 的预计耗时 (秒)，失败越多惩罚越大
+    static double ExpectedSeconds(const MirrorStats& stats) {
+        if (stats.throughputBps <= 0.0) return 1e12;
+        return (stats.latencyMs / 1000.0 + kScoreReferenceBytes / stats.throughputBps) * (1 + stats.failures);
+    }
+
+    std::vector<MirrorStats> ProbeAndRank(
+        const std::vector<std::string>& urls,
+        ThreadPool* pool,
+        long long* outTotalSize,
+        const CancellationToken& callerCancellation)
+    {
+        if (outTotalSize) *outTotalSize = -1;
+
+        CancellationToken cancellation = (callerCancellation.CanBeCanceled() || !pool) ? callerCancellation : pool->GetShutdownToken();
+        std::vector<ProbeResult> results;
+        if (pool && urls.size() > 1) {
+            TaskOptions blocking;
+            blocking.blocking = true;
+            blocking.tag = "mirror-probe";
+            std::vector<TaskFuture<ProbeResult>> probes;
+            for (const std::string& url : urls) {
+                probes.push_back(RunAsyncWith(*pool, blocking, [url, cancellation] { return ProbeMirror(url, cancellation); }));
+            }
+            // 探测在 I/O 执行器上进行；在工作线程上调用时，等待期间帮忙执行排队的计算任务
+            results = WhenAll(probes).Get(pool);
+        }
+        else {
+            for (const std::string& url : urls) {
+                results.push_back(ProbeMirror(url, cancellation));
+            }
+        }
+
+        // 被取消的探测都以失败结束，不能当作镜像不可用记入历史
+        if (cancellation.IsCancellationRequested()) {
+            LOG_INFO(L"Mirror probing canceled.");
+            return {};
+        }
+
+        std::vector<MirrorStats> ranked;
+        {
+            std::lock_guard<std::mutex> lock(s_historyMutex);
+            std::map<std::string, HistoryRecord> history = LoadHistory();
+            for (ProbeResult& result : results) {
+                std::string origin = OriginOf(result.stats.url);
+                auto it = history.find(origin);
+                bool hadHistory = it != history.end();
+                HistoryRecord& record = history[origin];
+                if (result.stats.reachable) {
+                    MergeMeasurement(record, hadHistory, result.stats.latencyMs, result.stats.throughputBps);
+                }
+                else {
+                    ++record.failures;
+                }
+                // 排序使用合并后的历史值，单次测量的波动不会让排序频繁跳动
+                result.stats.latencyMs = record.latencyMs;
+                result.stats.throughputBps = record.throughputBps;
+                result.stats.failures = record.failures;
+                ranked.push_back(result.stats);
+            }
+            SaveHistory(history);
+        }
+
+        // 以主地址为准 (不可用时以最快的可用镜像为准)：提供不同文件的镜像不参与下载，
+        // 否则分段拼接会得到一个大小正确但内容错误的包
+        MirrorStats referenceStats;
+        if (!ranked.empty() && ranked.front().reachable) {
+            referenceStats = ranked.front(); // ranked 此时仍按 urls 的顺序排列
+        }
+        std::stable_sort(ranked.begin(), ranked.end(), [](const MirrorStats& a, const MirrorStats& b) {
+            if (a.reachable != b.reachable) return a.reachable;
+            return ExpectedSeconds(a) < ExpectedSeconds(b);
+        });
+        if (referenceStats.totalSize < 0) {
+            for (const MirrorStats& stats : ranked) {
+                if (stats.reachable && stats.totalSize >= 0) {
+                    referenceStats = stats;
+                    break;
+                }
+            }
+        }
+        if (referenceStats.totalSize >= 0) {
+            ranked.erase(std::remove_if(ranked.begin(), ranked.end(), [&referenceStats](const MirrorStats& stats) {
+                if (!stats.reachable || stats.totalSize < 0 || SameObject(stats, referenceStats)) return false;
+                LOG_WARNING(L"Mirror ", Utf8ToWide(stats.url).c_str(), L" serves a different file (size ", stats.totalSize,
+                    L", ETag ", Utf8ToWide(stats.etag).c_str(), L"). Excluded.");
+                return true;
+            }), ranked.end());
+            if (outTotalSize) *outTotalSize = referenceStats.totalSize;
+        }
+
+        for (const MirrorStats& stats : ranked) {
+            LOG_INFO(L"Mirror ", Utf8ToWide(stats.url).c_str(), (stats.reachable ? L"" : L" (unreachable)"),
+                L": latency ", static_cast<long long>(stats.latencyMs), L" ms, throughput ",
+                static_cast<long long>(stats.throughputBps / 1024), L" KB/s, failures ", stats.failures);
+        }
+        return ranked;
+    }
+
+    bool DownloadWithFailover(
+        const std::vector<MirrorStats>& rankedMirrors,
+        long long totalSize,
+        const std::wstring& outputPath,
+        std::function<void(long long, long long)> progressCallback,
+        const CancellationToken& cancellation,
+        const std::string& expectedSha256)
+    {
+        // 下载完成后的哈希校验：失败时删除文件
+        auto verify = [&outputPath, &expectedSha256]() {
+            if (expectedSha256.empty()) return true;
+            std::string actualHash;
+            if (Sha256FileHex(outputPath, actualHash) && actualHash == expectedSha256) return true;
+            LOG_ERROR(L"Downloaded file hash mismatch: ", outputPath.c_str());
+            DeleteFileW(outputPath.c_str());
+            return false;
+        };
+
+        if (rankedMirrors.empty()) {
+            LOG_ERROR(L"No mirrors to download from.");
+            return false;
+        }
+
+        // 大小未知 (探测全部失败或服务器不支持 Range)：逐个镜像整体下载
+        if (totalSize < 0) {
+            for (const MirrorStats& mirror : rankedMirrors) {
+                long long received = 0;
+                auto trackingCallback = [&received, &progressCallback](long long downloaded, long long total) {
+                    received = downloaded;
+                    if (progressCallback) progressCallback(downloaded, total);
+                };
+                Clock::time_point start = Clock::now();
+                if (Network::DownloadFile(mirror.url, outputPath, trackingCallback, cancellation)) {
+                    RecordOutcome(mirror.url, true, received / ((std::max)(ElapsedMs(start), 1.0) / 1000.0));
+                    if (verify()) {
+                        return true;
+                    }
+                    // 内容与更新信息不符：这个镜像上的文件不对，换下一个
+                    continue;
+                }
+                if (cancellation.IsCancellationRequested()) {
+                    return false;
+                }
+                LOG_WARNING(L"Download failed from mirror ", Utf8ToWide(mirror.url).c_str(), L". Trying next mirror.");
+                RecordOutcome(mirror.url, false, 0.0);
+            }
+            return false;
+        }
+
+        std::ofstream outFile(outputPath, std::ios::binary | std::ios::trunc);
+        if (!outFile.is_open()) {
+            LOG_ERROR(L"Failed to open output file for writing: ", outputPath.c_str());
+            return false;
+        }
+
+        std::vector<int> attempts(rankedMirrors.size(), 0);
+        std::vector<long long> bytesFrom(rankedMirrors.size(), 0);
+        std::vector<double> msFrom(rankedMirrors.size(), 0.0);
+        size_t current = 0;
+        long long offset = 0;
+        bool ok = true;
+
+        while (offset < totalSize) {
+            long long length = (std::min)(kSegmentBytes, totalSize - offset);
+            const MirrorStats& mirror = rankedMirrors[current];
+
+            // 只接受 206 且 Content-Range 与请求的区间完全一致的响应：忽略 Range 的 200 或其他区间不能拼进文件
+            std::map<std::string, std::string> responseHeaders;
+            std::string body;
+            long long segmentTotal = -1;
+            Clock::time_point start = Clock::now();
+            bool fetched = Network::HttpGetRange(mirror.url, offset, offset + length - 1, body, &segmentTotal, &responseHeaders, 30000, cancellation);
+            double elapsedMs = ElapsedMs(start);
+
+            // 取消不是镜像的问题：不记录失败，直接放弃
+            if (cancellation.IsCancellationRequested()) {
+                LOG_INFO(L"Mirror download canceled at offset ", offset, L" of ", totalSize);
+                ok = false;
+                break;
+            }
+
+            // 镜像上的文件在探测之后变了 (或者探测时不可用、没有比较过)：不再使用这个镜像
+            if (fetched) {
+                std::string etag = FindHeader(responseHeaders, "ETag");
+                if ((segmentTotal >= 0 && segmentTotal != totalSize) || (!mirror.etag.empty() && !etag.empty() && etag != mirror.etag)) {
+                    LOG_WARNING(L"Mirror ", Utf8ToWide(mirror.url).c_str(), L" now serves a different file. Excluded.");
+                    attempts[current] = kMaxAttemptsPerMirror - 1; // 下面按失败处理后用完尝试次数
+                    fetched = false;
+                }
+            }
+
+            if (fetched) {
+                outFile.write(body.data(), body.size());
+                if (outFile.fail()) {
+                    LOG_ERROR(L"Failed to write downloaded content to file: ", outputPath.c_str());
+                    ok = false;
+                    break;
+                }
+                offset += length;
+                bytesFrom[current] += length;
+                msFrom[current] += elapsedMs;
+                if (progressCallback) progressCallback(offset, totalSize);
+                continue;
+            }
+
+            // 当前镜像失败：记录后从同一偏移切换到下一个仍有剩余尝试次数的镜像
+            LOG_WARNING(L"Segment at offset ", offset, L" failed from mirror ", Utf8ToWide(mirror.url).c_str(), L". Failing over.");
+            ++attempts[current];
+            RecordOutcome(mirror.url, false, 0.0);
+
+            size_t next = current;
+            bool found = false;
+            for (size_t step = 1; step <= rankedMirrors.size(); ++step) {
+                size_t candidate = (current + step) % rankedMirrors.size();
+                if (attempts[candidate] < kMaxAttemptsPerMirror) {
+                    next = candidate;
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                LOG_ERROR(L"All mirrors failed. Download aborted at offset ", offset, L" of ", totalSize);
+                ok = false;
+                break;
+            }
+            current = next;
+        }
+
+        outFile.close();
+        if (!ok) {
+            DeleteFileW(outputPath.c_str());
+            return false;
+        }
+        if (!verify()) {
+            return false;
+        }
+
+        // 把本次下载的实测吞吐量写回历史记录
+        for (size_t i = 0; i < rankedMirrors.size(); ++i) {
+            if (bytesFrom[i] > 0) {
+                RecordOutcome(rankedMirrors[i].url, true, bytesFrom[i] / ((std::max)(msFrom[i], 1.0) / 1000.0));
+            }
+        }
+
+        LOG_INFO(L"File downloaded from mirrors: ", outputPath.c_str(), L" (Size: ", totalSize, L" bytes)");
+        return true;
+    }
+
+} // namespace Mirrors
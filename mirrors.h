@@ -0,0 +1,73 @@
+#ifndef MIRRORS_H
+#define MIRRORS_H
+
+#include <string>
+#include <vector>
+#include <functional> // For std::function (progress callback)
+
+#include "cancellation.h"
+
+class ThreadPool;
+
+// 多镜像下载：
+// 更新信息中可以列出多个镜像地址。下载前并行向每个镜像发送一个小的 Range 请求，
+// 测得延迟和吞吐量后按预计下载耗时排序；测量结果按镜像主机 (scheme://host:port)
+// 持久化并与历史值加权合并，使排序在多次更新之间保持稳定。
+// 下载按 Range 分段进行，某个镜像失败时从当前偏移切换到下一个镜像继续，不从头开始。
+// 不同镜像的分段会拼接到同一个文件中，因此只使用与主地址提供同一文件 (大小、ETag / Last-Modified 一致) 的镜像，
+// 并在下载完成后按更新信息中的 SHA-256 校验整个文件。
+
+namespace Mirrors {
+
+    struct MirrorStats {
+        std::string url;              // 镜像上的包地址
+        double latencyMs = 0.0;       // 首字节延迟 (毫秒)
+        double throughputBps = 0.0;   // 吞吐量 (字节/秒)
+        int failures = 0;             // 近期失败次数 (成功后衰减)
+        bool reachable = false;       // 本次探测是否成功
+        long long totalSize = -1;     // 探测响应 Content-Range 中的文件大小 (未知时为 -1)
+        std::string etag;             // 探测响应的 ETag (可选)
+        std::string lastModified;     // 探测响应的 Last-Modified (可选)
+    };
+
+    /**
+     * @brief 并行探测镜像并按预计下载耗时排序 (最快的在前)。
+     * @param urls 各镜像上的包地址。urls[0] 为主地址，其他镜像必须与它提供同一个文件。
+     * @param pool 用于并行探测的线程池 (为空则顺序探测)。线程池关闭时探测随之取消。
+     * @param outTotalSize [out] 从 Content-Range 中得到的包大小 (可选，未知时为 -1)。
+     * @param cancellation 取消令牌 (可选)：取消时中止探测并返回空列表，不记入历史。
+     *        不可取消的默认令牌表示使用线程池的关闭令牌。
+     * @return 排序后的镜像列表。大小或 ETag / Last-Modified 与主地址 (主地址不可用时为排在最前的镜像) 不一致的镜像
+     *         (例如尚未同步的旧版本) 被排除；探测失败的镜像排在最后，仍可作为最后的备选。
+     * @note 探测结果会与历史记录合并后保存到 g_appDataDir\mirrors.dat。
+     */
+    std::vector<MirrorStats> ProbeAndRank(
+        const std::vector<std::string>& urls,
+        ThreadPool* pool,
+        long long* outTotalSize = nullptr,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+    /**
+     * @brief 按排序从多个镜像分段下载文件，镜像失败时从当前偏移切换到下一个镜像。
+     * @param rankedMirrors ProbeAndRank 返回的镜像列表。
+     * @param totalSize 文件大小 (未知时传 -1，此时退化为逐个镜像整体下载)。
+     * @param outputPath 输出文件路径。
+     * @param progressCallback 进度回调 (已下载字节数, 总字节数)。
+     * @param cancellation 取消令牌 (可选)：取消时中止当前分段并删除不完整的文件，不计为镜像失败。
+     * @param expectedSha256 文件的 SHA-256 (小写十六进制，可选)：下载完成后校验，不一致时删除文件并返回 false。
+     * @return 下载完成、大小正确且 (提供了 expectedSha256 时) 哈希一致返回 true。
+     * @note 分段响应中 Content-Range 的总大小与 totalSize 不同、或 ETag 与探测时不同的镜像不再使用。
+     */
+    bool DownloadWithFailover(
+        const std::vector<MirrorStats>& rankedMirrors,
+        long long totalSize,
+        const std::wstring& outputPath,
+        std::function<void(long long, long long)> progressCallback = nullptr,
+        const CancellationToken& cancellation = CancellationToken(),
+        const std::string& expectedSha256 = std::string()
+    );
+
+} // namespace Mirrors
+
+#endif // MIRRORS_H
@@ -0,0 +1,129 @@
+#ifndef MPMC_QUEUE_H
+#define MPMC_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// 无锁有界多生产者多消费者队列 (Dmitry Vyukov 的环形缓冲区算法)。
+// 每个槽位带一个序号：生产者/消费者通过 CAS 推进各自的位置，再用序号判断槽位是否可写/可读，
+// 入队和出队都不需要锁，也不做任何内存分配。容量在构造时确定 (向上取整为 2 的幂)。
+
+template<typename T>
+class BoundedMpmcQueue {
+public:
+    explicit BoundedMpmcQueue(size_t capacity)
+        : m_enqueuePos(0), m_dequeuePos(0) {
+        size_t rounded = 2;
+        while (rounded < capacity) rounded <<= 1;
+        m_capacity = rounded;
+        m_mask = rounded - 1;
+        m_cells.reset(new Cell[rounded]);
+        for (size_t i = 0; i < rounded; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~BoundedMpmcQueue() {
+        T discarded;
+        while (TryPop(discarded)) {
+        }
+    }
+
+    // 禁止拷贝和赋值
+    BoundedMpmcQueue(const BoundedMpmcQueue&) = delete;
+    BoundedMpmcQueue& operator=(const BoundedMpmcQueue&) = delete;
+
+    /**
+     * @brief 尝试入队。
+     * @param value 要入队的值；失败时保持不变 (调用方仍可使用)。
+     * @return 队列已满时返回 false。
+     */
+    bool TryPush(T&& value) {
+        Cell* cell;
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false; // 槽位仍被上一轮占用：队列已满
+            }
+            else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->Storage()) T(std::move(value));
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 尝试出队。
+     * @param out [out] 出队的值。
+     * @return 队列为空时返回 false。
+     */
+    bool TryPop(T& out) {
+        Cell* cell;
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            }
+            else if (diff < 0) {
+                return false; // 槽位尚未写入：队列为空
+            }
+            else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        T* item = cell->Item();
+        out = std::move(*item);
+        item->~T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 近似的元素数量 (不加锁，并发修改时仅供参考)。
+     */
+    size_t SizeApprox() const {
+        size_t enq = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t deq = m_dequeuePos.load(std::memory_order_relaxed);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    size_t Capacity() const { return m_capacity; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        void* Storage() { return storage; }
+        T* Item() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    size_t m_capacity;
+    size_t m_mask;
+    std::unique_ptr<Cell[]> m_cells;
+
+    // 生产者和消费者的位置放在不同缓存行上，避免相互的伪共享
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+};
+
+#endif // MPMC_QUEUE_H
@@ -1,396 +1,1101 @@
-#include "network.h"
-#include "log.h"
-#include "utils.h"   // For string conversions
-#include <sstream>
-#include <fstream>   // For DownloadFile
-#include <algorithm> // For std::transform (tolower)
-#include <iostream>  // For std::cout, std::cerr (debugging or fallback)
-
-// <map> is now included in network.h
-
-namespace Network {
-
-    static bool g_winsockInitialized = false;
-
-    bool Initialize() {
-        if (g_winsockInitialized) {
-            return true;
-        }
-        WSADATA wsaData;
-        int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
-        if (result != 0) {
-            LOG_ERROR(L"WSAStartup failed. Error: ", result);
-            return false;
-        }
-        g_winsockInitialized = true;
-        LOG_INFO(L"Winsock initialized.");
-        return true;
-    }
-
-    void Cleanup() {
-        if (g_winsockInitialized) {
-            WSACleanup();
-            g_winsockInitialized = false;
-            LOG_INFO(L"Winsock cleaned up.");
-        }
-    }
-
-    ParsedUrl ParseUrl(const std::string& urlString) {
-        ParsedUrl parsed;
-        if (urlString.empty()) {
-            return parsed;
-        }
-
-        std::string tempUrl = urlString;
-
-        // Scheme
-        size_t schemeEnd = tempUrl.find("://");
-        if (schemeEnd != std::string::npos) {
-            parsed.scheme = tempUrl.substr(0, schemeEnd);
-            std::transform(parsed.scheme.begin(), parsed.scheme.end(), parsed.scheme.begin(),
-                [](unsigned char c) { return std::tolower(c); });
-            tempUrl = tempUrl.substr(schemeEnd + 3);
-        }
-        else {
-            // No scheme, try to infer or default
-            // For robustness, might be better to reject if no scheme for http/https
-            // Or assume http if it looks like a domain name
-            // For now, let's assume http if it doesn't look like a file path
-            if (tempUrl.find('/') == 0 || tempUrl.find(':') == 1) { // Looks like local path
-                LOG_WARNING(L"URL parsing: No scheme and looks like a local path. URL: ", Utf8ToWide(urlString).c_str());
-                // return parsed; // Invalid for network operations
-            }
-            parsed.scheme = "http"; // Default assumption
-        }
-
-        // Host and Port
-        size_t pathStart = tempUrl.find('/');
-        std::string hostPortPart = (pathStart == std::string::npos) ? tempUrl : tempUrl.substr(0, pathStart);
-
-        size_t querySeparatorInHostPort = hostPortPart.find('?'); // Query params should not be in host/port part
-        if (querySeparatorInHostPort != std::string::npos) {
-            hostPortPart = hostPortPart.substr(0, querySeparatorInHostPort);
-            // The rest is part of the path/query, adjust pathStart if necessary
-            if (pathStart == std::string::npos || pathStart > querySeparatorInHostPort) {
-                pathStart = querySeparatorInHostPort; // The actual path starts earlier
-            }
-        }
-
-
-        size_t portColon = hostPortPart.find(':');
-        if (portColon != std::string::npos) {
-            parsed.host = hostPortPart.substr(0, portColon);
-            std::string portStr = hostPortPart.substr(portColon + 1);
-            if (portStr.empty()) { // e.g. "host:"
-                LOG_WARNING(L"URL Parsing: Empty port after colon. URL: ", Utf8ToWide(urlString).c_str());
-                // Assign default based on scheme
-                if (parsed.scheme == "http") parsed.port = 80;
-                else if (parsed.scheme == "https") parsed.port = 443;
-                else parsed.port = 0; // Unknown
-            }
-            else {
-                try {
-                    int portVal = std::stoi(portStr);
-                    if (portVal <= 0 || portVal > 65535) {
-                        LOG_WARNING(L"URL Parsing: Invalid port number ", std::to_wstring(portVal).c_str(), L". URL: ", Utf8ToWide(urlString).c_str());
-                        return parsed; // Invalid port
-                    }
-                    parsed.port = static_cast<unsigned short>(portVal);
-                }
-                catch (const std::exception& e) {
-                    LOG_WARNING(L"Invalid port in URL '", Utf8ToWide(urlString).c_str(), L"': ", Utf8ToWide(e.what()).c_str());
-                    return parsed; // Invalid port
-                }
-            }
-        }
-        else {
-            parsed.host = hostPortPart;
-            if (parsed.scheme == "http") parsed.port = 80;
-            else if (parsed.scheme == "https") parsed.port = 443;
-            else {
-                LOG_WARNING(L"Unknown scheme '", Utf8ToWide(parsed.scheme).c_str(), L"' in URL, cannot determine default port.");
-                parsed.port = 0; // Indicate unknown, or default to 80
-            }
-        }
-
-        // Path and Query
-        if (pathStart != std::string::npos) {
-            std::string pathAndQuery = tempUrl.substr(pathStart);
-            size_t queryStart = pathAndQuery.find('?');
-            if (queryStart != std::string::npos) {
-                parsed.path = pathAndQuery.substr(0, queryStart);
-                parsed.query = pathAndQuery.substr(queryStart + 1);
-            }
-            else {
-                parsed.path = pathAndQuery;
-            }
-        }
-        else {
-            parsed.path = "/"; // Default path
-        }
-
-        if (parsed.host.empty()) {
-            LOG_WARNING(L"Could not parse host from URL: ", Utf8ToWide(urlString).c_str());
-            return parsed;
-        }
-        if (parsed.port == 0 && (parsed.scheme == "http" || parsed.scheme == "https")) {
-            LOG_WARNING(L"Port is 0 for known scheme, URL: ", Utf8ToWide(urlString).c_str());
-            // This might be an error or an oversight if port couldn't be parsed.
-            // Re-assign default if it was missed.
-            if (parsed.scheme == "http") parsed.port = 80;
-            else if (parsed.scheme == "https") parsed.port = 443;
-        }
-
-
-        parsed.isValid = !parsed.host.empty() && parsed.port != 0;
-        return parsed;
-    }
-
-
-    bool HttpGet(
-        const std::string& host,
-        const std::string& path,
-        unsigned short port,
-        std::string& responseBody,
-        std::map<std::string, std::string>* responseHeadersOutParam, // Renamed parameter
-        bool useHTTPSParam, // Renamed parameter
-        int timeoutMsParam   // Renamed parameter
-    )
-    {
-        if (!g_winsockInitialized) {
-            LOG_ERROR(L"Winsock not initialized. Call Network::Initialize() first.");
-            return false;
-        }
-
-        if (useHTTPSParam) { // Use renamed parameter
-            LOG_ERROR(L"HTTPS is not supported in this basic HttpGet implementation.");
-            return false;
-        }
-
-        responseBody.clear();
-        if (responseHeadersOutParam) { // Use renamed parameter
-            responseHeadersOutParam->clear();
-        }
-
-        SOCKET sock = INVALID_SOCKET;
-        addrinfo* result = nullptr, * ptr = nullptr, hints;
-
-        ZeroMemory(&hints, sizeof(hints));
-        hints.ai_family = AF_UNSPEC;
-        hints.ai_socktype = SOCK_STREAM;
-        hints.ai_protocol = IPPROTO_TCP;
-
-        std::string portStr = std::to_string(port);
-
-        if (getaddrinfo(host.c_str(), portStr.c_str(), &hints, &result) != 0) {
-            LOG_ERROR(L"getaddrinfo failed for host: ", Utf8ToWide(host).c_str(), L" Error: ", WSAGetLastError());
-            return false;
-        }
-
-        for (ptr = result; ptr != nullptr; ptr = ptr->ai_next) {
-            sock = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
-            if (sock == INVALID_SOCKET) {
-                LOG_WARNING(L"socket() failed. Error: ", WSAGetLastError());
-                continue;
-            }
-
-            if (timeoutMsParam > 0) { // Use renamed parameter
-                DWORD timeoutVal = static_cast<DWORD>(timeoutMsParam); // Corrected name
-                setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeoutVal, sizeof(timeoutVal));
-                setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeoutVal, sizeof(timeoutVal));
-            }
-
-            if (connect(sock, ptr->ai_addr, (int)ptr->ai_addrlen) == SOCKET_ERROR) {
-                LOG_WARNING(L"connect() failed to host ", Utf8ToWide(host).c_str(), L" on an address. Error: ", WSAGetLastError());
-                closesocket(sock);
-                sock = INVALID_SOCKET;
-                continue;
-            }
-            break;
-        }
-
-        freeaddrinfo(result);
-
-        if (sock == INVALID_SOCKET) {
-            LOG_ERROR(L"Unable to connect to server: ", Utf8ToWide(host).c_str());
-            return false;
-        }
-
-        std::ostringstream requestStream;
-        requestStream << "GET " << (path.empty() ? "/" : path) << " HTTP/1.1\r\n"; // Ensure path is not empty
-        requestStream << "Host: " << host << "\r\n";
-        requestStream << "Connection: close\r\n";
-        requestStream << "User-Agent: NewsForHeng/1.0 (Windows)\r\n"; // Added OS
-        requestStream << "Accept: */*\r\n";
-        requestStream << "Accept-Encoding: identity\r\n"; // Be explicit about not handling gzip etc.
-        requestStream << "\r\n";
-
-        std::string request = requestStream.str();
-
-        if (send(sock, request.c_str(), (int)request.length(), 0) == SOCKET_ERROR) {
-            LOG_ERROR(L"send() failed. Error: ", WSAGetLastError());
-            closesocket(sock);
-            return false;
-        }
-
-        std::string fullResponse;
-        char buffer[4096];
-        int bytesReceived;
-
-        do {
-            bytesReceived = recv(sock, buffer, sizeof(buffer) - 1, 0); // -1 to leave space for null terminator
-            if (bytesReceived > 0) {
-                // buffer[bytesReceived] = '\0'; // Not strictly necessary if appending with length
-                fullResponse.append(buffer, bytesReceived);
-            }
-            else if (bytesReceived == 0) {
-                LOG_INFO(L"Connection closed by peer during recv.");
-            }
-            else {
-                int error = WSAGetLastError();
-                if (error == WSAETIMEDOUT) {
-                    LOG_ERROR(L"recv() timed out. Error: ", error);
-                }
-                else {
-                    LOG_ERROR(L"recv() failed. Error: ", error);
-                }
-                closesocket(sock);
-                return false;
-            }
-        } while (bytesReceived > 0);
-
-        closesocket(sock);
-
-        size_t headerEndPos = fullResponse.find("\r\n\r\n");
-        if (headerEndPos == std::string::npos) {
-            LOG_ERROR(L"Invalid HTTP response: no CR LF CR LF sequence found (end of headers).");
-            // LOG_DEBUG(L"Full response received: ", Utf8ToWide(fullResponse).c_str()); // Log for debugging
-            return false;
-        }
-
-        std::string headersPart = fullResponse.substr(0, headerEndPos);
-        responseBody = fullResponse.substr(headerEndPos + 4);
-
-        std::istringstream headersStream(headersPart);
-        std::string statusLine;
-        std::getline(headersStream, statusLine);
-        if (!statusLine.empty() && statusLine.back() == '\r') statusLine.pop_back();
-
-        std::string httpVersion;
-        int statusCode = 0;
-        // std::string reasonPhrase; // Not strictly needed for logic
-        std::istringstream statusLineStream(statusLine);
-        statusLineStream >> httpVersion >> statusCode;
-
-        if (statusCode < 200 || statusCode >= 300) {
-            LOG_WARNING(L"HTTP GET request failed with status code: ", statusCode, L" for ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
-            return false;
-        }
-
-        LOG_INFO(L"HTTP GET successful for ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str(), L". Status: ", statusCode);
-
-        if (responseHeadersOutParam) { // Use renamed parameter
-            std::string headerLine;
-            while (std::getline(headersStream, headerLine)) {
-                if (!headerLine.empty() && headerLine.back() == '\r') headerLine.pop_back();
-                if (headerLine.empty()) break;
-
-                size_t colonPos = headerLine.find(':');
-                if (colonPos != std::string::npos) {
-                    std::string name = headerLine.substr(0, colonPos);
-                    std::string value = headerLine.substr(colonPos + 1);
-
-                    size_t first = value.find_first_not_of(" \t");
-                    if (std::string::npos != first) {
-                        size_t last = value.find_last_not_of(" \t");
-                        value = value.substr(first, (last - first + 1));
-                    }
-                    else {
-                        value.clear();
-                    }
-                    (*responseHeadersOutParam)[name] = value; // Use renamed parameter
-                }
-            }
-        }
-        return true;
-    }
-
-
-    bool DownloadFile(
-        const std::string& url, // Expects std::string
-        const std::wstring& outputPath,
-        std::function<void(long long, long long)> progressCallback)
-    {
-        ParsedUrl purl = ParseUrl(url); // url is already std::string
-        if (!purl.isValid) {
-            LOG_ERROR(L"Invalid URL for download: ", Utf8ToWide(url).c_str());
-            return false;
-        }
-
-        if (purl.scheme != "http") {
-            LOG_ERROR(L"DownloadFile currently only supports HTTP. URL: ", Utf8ToWide(url).c_str());
-            return false;
-        }
-
-        std::string responseBody;
-        std::map<std::string, std::string> responseHeadersMap; // C2039, C2065 fixed by including <map> and correct naming
-
-        LOG_INFO(L"Attempting to download file from URL: ", Utf8ToWide(url).c_str(), L" to: ", outputPath.c_str());
-
-        // Construct full path for HttpGet
-        std::string fullPath = purl.path;
-        if (!purl.query.empty()) {
-            fullPath += "?" + purl.query;
-        }
-
-        if (!HttpGet(purl.host, fullPath, purl.port, responseBody, &responseHeadersMap, (purl.scheme == "https"), 15000 /* 15 sec timeout */)) {
-            LOG_ERROR(L"Failed to GET file content from URL: ", Utf8ToWide(url).c_str());
-            return false;
-        }
-
-        long long totalSize = -1;
-        // C3536 'it' error was because responseHeadersMap might not have been properly declared or map not included.
-        auto itHeader = responseHeadersMap.find("Content-Length"); // Renamed 'it' to 'itHeader' for clarity
-        if (itHeader != responseHeadersMap.end()) {
-            try {
-                totalSize = std::stoll(itHeader->second);
-            }
-            catch (const std::exception&) { /* ignore parse error */ }
-        }
-
-        size_t lastSlash = outputPath.find_last_of(L"\\/");
-        if (lastSlash != std::wstring::npos) {
-            std::wstring dir = outputPath.substr(0, lastSlash);
-            if (!DirectoryExists(dir)) {
-                if (!CreateDirectoryRecursive(dir)) {
-                    LOG_ERROR(L"Failed to create directory for download: ", dir.c_str());
-                    return false;
-                }
-            }
-        }
-
-        std::ofstream outFile(outputPath, std::ios::binary | std::ios::trunc);
-        if (!outFile.is_open()) {
-            LOG_ERROR(L"Failed to open output file for writing: ", outputPath.c_str());
-            return false;
-        }
-
-        outFile.write(responseBody.data(), responseBody.size());
-        if (outFile.fail()) {
-            LOG_ERROR(L"Failed to write downloaded content to file: ", outputPath.c_str());
-            outFile.close();
-            DeleteFileW(outputPath.c_str()); // Clean up partial file
-            return false;
-        }
-
-        outFile.close();
-
-        if (progressCallback) {
-            progressCallback(static_cast<long long>(responseBody.size()), totalSize > 0 ? totalSize : static_cast<long long>(responseBody.size()));
-        }
-
-        LOG_INFO(L"File downloaded successfully: ", outputPath.c_str(), L" (Size: ", responseBody.size(), L" bytes)");
-        return true;
-    }
-
-} // namespace Network
+#define LOG_MODULE LogModule::Network // 本文件的日志属于网络模块 (见 log.h)
+#include "network.h"
+#include "log.h"
+#include "utils.h"   // For string conversions
+#include <sstream>
+#include <fstream>   // For DownloadFile
+#include <algorithm> // For std::transform (tolower)
+#include <iostream>  // For std::cout, std::cerr (debugging or fallback)
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// <map> is now included in network.h
+
+namespace Network {
+
+    static bool g_winsockInitialized = false;
+
+    static void StopAsyncReactor();
+    static void SetAsyncRequestsClosed(bool closed);
+
+    bool Initialize() {
+        if (g_winsockInitialized) {
+            return true;
+        }
+        WSADATA wsaData;
+        int result = WSAStartup(MAKEWORD(2, 2), &wsaData);
+        if (result != 0) {
+            LOG_ERROR(L"WSAStartup failed. Error: ", result);
+            return false;
+        }
+        g_winsockInitialized = true;
+        SetAsyncRequestsClosed(false);
+        LOG_INFO(L"Winsock initialized.");
+        return true;
+    }
+
+    void Cleanup() {
+        if (g_winsockInitialized) {
+            StopAsyncReactor(); // 未完成的异步请求以失败结束
+            WSACleanup();
+            g_winsockInitialized = false;
+            LOG_INFO(L"Winsock cleaned up.");
+        }
+    }
+
+    ParsedUrl ParseUrl(const std::string& urlString) {
+        ParsedUrl parsed;
+        if (urlString.empty()) {
+            return parsed;
+        }
+
+        std::string tempUrl = urlString;
+
+        // Scheme
+        size_t schemeEnd = tempUrl.find("://");
+        if (schemeEnd != std::string::npos) {
+            parsed.scheme = tempUrl.substr(0, schemeEnd);
+            std::transform(parsed.scheme.begin(), parsed.scheme.end(), parsed.scheme.begin(),
+                [](unsigned char c) { return std::tolower(c); });
+            tempUrl = tempUrl.substr(schemeEnd + 3);
+        }
+        else {
+            // No scheme, try to infer or default
+            // For robustness, might be better to reject if no scheme for http/https
+            // Or assume http if it looks like a domain name
+            // For now, let's assume http if it doesn't look like a file path
+            if (tempUrl.find('/') == 0 || tempUrl.find(':') == 1) { // Looks like local path
+                LOG_WARNING(L"URL parsing: No scheme and looks like a local path. URL: ", Utf8ToWide(urlString).c_str());
+                // return parsed; // Invalid for network operations
+            }
+            parsed.scheme = "http"; // Default assumption
+        }
+
+        // Host and Port
+        size_t pathStart = tempUrl.find('/');
+        std::string hostPortPart = (pathStart == std::string::npos) ? tempUrl : tempUrl.substr(0, pathStart);
+
+        size_t querySeparatorInHostPort = hostPortPart.find('?'); // Query params should not be in host/port part
+        if (querySeparatorInHostPort != std::string::npos) {
+            hostPortPart = hostPortPart.substr(0, querySeparatorInHostPort);
+            // The rest is part of the path/query, adjust pathStart if necessary
+            if (pathStart == std::string::npos || pathStart > querySeparatorInHostPort) {
+                pathStart = querySeparatorInHostPort; // The actual path starts earlier
+            }
+        }
+
+
+        size_t portColon = hostPortPart.find(':');
+        if (portColon != std::string::npos) {
+            parsed.host = hostPortPart.substr(0, portColon);
+            std::string portStr = hostPortPart.substr(portColon + 1);
+            if (portStr.empty()) { // e.g. "host:"
+                LOG_WARNING(L"URL Parsing: Empty port after colon. URL: ", Utf8ToWide(urlString).c_str());
+                // Assign default based on scheme
+                if (parsed.scheme == "http") parsed.port = 80;
+                else if (parsed.scheme == "https") parsed.port = 443;
+                else parsed.port = 0; // Unknown
+            }
+            else {
+                try {
+                    int portVal = std::stoi(portStr);
+                    if (portVal <= 0 || portVal > 65535) {
+                        LOG_WARNING(L"URL Parsing: Invalid port number ", std::to_wstring(portVal).c_str(), L". URL: ", Utf8ToWide(urlString).c_str());
+                        return parsed; // Invalid port
+                    }
+                    parsed.port = static_cast<unsigned short>(portVal);
+                }
+                catch (const std::exception& e) {
+                    LOG_WARNING(L"Invalid port in URL '", Utf8ToWide(urlString).c_str(), L"': ", Utf8ToWide(e.what()).c_str());
+                    return parsed; // Invalid port
+                }
+            }
+        }
+        else {
+            parsed.host = hostPortPart;
+            if (parsed.scheme == "http") parsed.port = 80;
+            else if (parsed.scheme == "https") parsed.port = 443;
+            else {
+                LOG_WARNING(L"Unknown scheme '", Utf8ToWide(parsed.scheme).c_str(), L"' in URL, cannot determine default port.");
+                parsed.port = 0; // Indicate unknown, or default to 80
+            }
+        }
+
+        // Path and Query
+        if (pathStart != std::string::npos) {
+            std::string pathAndQuery = tempUrl.substr(pathStart);
+            size_t queryStart = pathAndQuery.find('?');
+            if (queryStart != std::string::npos) {
+                parsed.path = pathAndQuery.substr(0, queryStart);
+                parsed.query = pathAndQuery.substr(queryStart + 1);
+            }
+            else {
+                parsed.path = pathAndQuery;
+            }
+        }
+        else {
+            parsed.path = "/"; // Default path
+        }
+
+        if (parsed.host.empty()) {
+            LOG_WARNING(L"Could not parse host from URL: ", Utf8ToWide(urlString).c_str());
+            return parsed;
+        }
+        if (parsed.port == 0 && (parsed.scheme == "http" || parsed.scheme == "https")) {
+            LOG_WARNING(L"Port is 0 for known scheme, URL: ", Utf8ToWide(urlString).c_str());
+            // This might be an error or an oversight if port couldn't be parsed.
+            // Re-assign default if it was missed.
+            if (parsed.scheme == "http") parsed.port = 80;
+            else if (parsed.scheme == "https") parsed.port = 443;
+        }
+
+
+        parsed.isValid = !parsed.host.empty() && parsed.port != 0;
+        return parsed;
+    }
+
+
+    // 把完整的 HTTP 响应拆分为状态码、响应头和响应体 (同步与异步请求共用)
+    static bool ParseHttpResponse(
+        const std::string& fullResponse,
+        std::string& responseBody,
+        std::map<std::string, std::string>* responseHeadersOutParam,
+        int& statusCode)
+    {
+        size_t headerEndPos = fullResponse.find("\r\n\r\n");
+        if (headerEndPos == std::string::npos) {
+            LOG_ERROR(L"Invalid HTTP response: no CR LF CR LF sequence found (end of headers).");
+            // LOG_DEBUG(L"Full response received: ", Utf8ToWide(fullResponse).c_str()); // Log for debugging
+            return false;
+        }
+
+        std::string headersPart = fullResponse.substr(0, headerEndPos);
+        responseBody = fullResponse.substr(headerEndPos + 4);
+
+        std::istringstream headersStream(headersPart);
+        std::string statusLine;
+        std::getline(headersStream, statusLine);
+        if (!statusLine.empty() && statusLine.back() == '\r') statusLine.pop_back();
+
+        std::string httpVersion;
+        statusCode = 0;
+        // std::string reasonPhrase; // Not strictly needed for logic
+        std::istringstream statusLineStream(statusLine);
+        statusLineStream >> httpVersion >> statusCode;
+
+        // Headers are parsed before the status check so callers can read e.g. Retry-After on 429/503
+        if (responseHeadersOutParam) { // Use renamed parameter
+            std::string headerLine;
+            while (std::getline(headersStream, headerLine)) {
+                if (!headerLine.empty() && headerLine.back() == '\r') headerLine.pop_back();
+                if (headerLine.empty()) break;
+
+                size_t colonPos = headerLine.find(':');
+                if (colonPos != std::string::npos) {
+                    std::string name = headerLine.substr(0, colonPos);
+                    std::string value = headerLine.substr(colonPos + 1);
+
+                    size_t first = value.find_first_not_of(" \t");
+                    if (std::string::npos != first) {
+                        size_t last = value.find_last_not_of(" \t");
+                        value = value.substr(first, (last - first + 1));
+                    }
+                    else {
+                        value.clear();
+                    }
+                    (*responseHeadersOutParam)[name] = value; // Use renamed parameter
+                }
+            }
+        }
+        return true;
+    }
+
+    // 同步请求使用的套接字：取消回调在其他线程上 shutdown() 套接字，使阻塞中的 send/recv 立即返回。
+    // 关闭与 shutdown 在同一把锁下进行，避免回调作用于已经关闭 (句柄可能已被复用) 的套接字。
+    class CancelableSocket {
+    public:
+        explicit CancelableSocket(const CancellationToken& cancellation) {
+            m_registration = cancellation.Register([this] {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_sock != INVALID_SOCKET) {
+                    shutdown(m_sock, SD_BOTH);
+                }
+            });
+        }
+        ~CancelableSocket() {
+            m_registration.Unregister(); // 先注销，之后回调不会再访问 this
+            Reset(INVALID_SOCKET);
+        }
+        CancelableSocket(const CancelableSocket&) = delete;
+        CancelableSocket& operator=(const CancelableSocket&) = delete;
+
+        SOCKET Get() const { return m_sock; }
+
+        // 关闭当前套接字并接管新的套接字
+        void Reset(SOCKET sock) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_sock != INVALID_SOCKET) {
+                closesocket(m_sock);
+            }
+            m_sock = sock;
+        }
+
+    private:
+        std::mutex m_mutex;
+        SOCKET m_sock = INVALID_SOCKET;
+        CancellationRegistration m_registration;
+    };
+
+    // 非阻塞 connect + 分段等待：阻塞的 connect 没有超时也无法被 shutdown 打断，
+    // 这里每 100 毫秒检查一次取消令牌，最多等待 timeoutMs (<= 0 时使用 15 秒)。
+    static bool ConnectWithCancellation(SOCKET sock, const sockaddr* address, int addressLength,
+        int timeoutMs, const CancellationToken& cancellation)
+    {
+        u_long mode = 1;
+        ioctlsocket(sock, FIONBIO, &mode);
+        bool connected = connect(sock, address, addressLength) == 0;
+        if (!connected && WSAGetLastError() == WSAEWOULDBLOCK) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 15000);
+            while (!cancellation.IsCancellationRequested()) {
+                long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+                if (remaining <= 0) {
+                    WSASetLastError(WSAETIMEDOUT);
+                    break;
+                }
+                WSAPOLLFD pollFd;
+                pollFd.fd = sock;
+                pollFd.events = POLLWRNORM;
+                pollFd.revents = 0;
+                int ready = WSAPoll(&pollFd, 1, static_cast<INT>((std::min)(remaining, 100LL)));
+                if (ready == SOCKET_ERROR) {
+                    break;
+                }
+                if (ready > 0) {
+                    int error = 0;
+                    int length = sizeof(error);
+                    getsockopt(sock, SOL_SOCKET, SO_ERROR, (char*)&error, &length);
+                    connected = error == 0 && !(pollFd.revents & (POLLERR | POLLHUP));
+                    if (!connected) {
+                        WSASetLastError(error);
+                    }
+                    break;
+                }
+            }
+        }
+        mode = 0;
+        ioctlsocket(sock, FIONBIO, &mode); // 之后的 send/recv 仍按阻塞方式使用 SO_RCVTIMEO / SO_SNDTIMEO
+        return connected;
+    }
+
+
+    bool HttpGet(
+        const std::string& host,
+        const std::string& path,
+        unsigned short port,
+        std::string& responseBody,
+        std::map<std::string, std::string>* responseHeadersOutParam, // Renamed parameter
+        bool useHTTPSParam, // Renamed parameter
+        int timeoutMsParam,   // Renamed parameter
+        const std::map<std::string, std::string>* requestHeadersParam,
+        const CancellationToken& cancellation,
+        int* statusCodeOut
+    )
+    {
+        if (statusCodeOut) *statusCodeOut = 0;
+        if (!g_winsockInitialized) {
+            LOG_ERROR(L"Winsock not initialized. Call Network::Initialize() first.");
+            return false;
+        }
+
+        if (useHTTPSParam) { // Use renamed parameter
+            LOG_ERROR(L"HTTPS is not supported in this basic HttpGet implementation.");
+            return false;
+        }
+
+        responseBody.clear();
+        if (responseHeadersOutParam) { // Use renamed parameter
+            responseHeadersOutParam->clear();
+        }
+
+        if (cancellation.IsCancellationRequested()) {
+            LOG_INFO(L"HTTP GET canceled before start: ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
+            return false;
+        }
+
+        CancelableSocket sock(cancellation);
+        addrinfo* result = nullptr, * ptr = nullptr, hints;
+
+        ZeroMemory(&hints, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        std::string portStr = std::to_string(port);
+
+        if (getaddrinfo(host.c_str(), portStr.c_str(), &hints, &result) != 0) {
+            LOG_ERROR(L"getaddrinfo failed for host: ", Utf8ToWide(host).c_str(), L" Error: ", WSAGetLastError());
+            return false;
+        }
+
+        for (ptr = result; ptr != nullptr && !cancellation.IsCancellationRequested(); ptr = ptr->ai_next) {
+            SOCKET candidate = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+            if (candidate == INVALID_SOCKET) {
+                LOG_WARNING(L"socket() failed. Error: ", WSAGetLastError());
+                continue;
+            }
+
+            if (timeoutMsParam > 0) { // Use renamed parameter
+                DWORD timeoutVal = static_cast<DWORD>(timeoutMsParam); // Corrected name
+                setsockopt(candidate, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeoutVal, sizeof(timeoutVal));
+                setsockopt(candidate, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeoutVal, sizeof(timeoutVal));
+            }
+
+            sock.Reset(candidate);
+            if (!ConnectWithCancellation(candidate, ptr->ai_addr, (int)ptr->ai_addrlen, timeoutMsParam, cancellation)) {
+                if (!cancellation.IsCancellationRequested()) {
+                    LOG_WARNING(L"connect() failed to host ", Utf8ToWide(host).c_str(), L" on an address. Error: ", WSAGetLastError());
+                }
+                sock.Reset(INVALID_SOCKET);
+                continue;
+            }
+            break;
+        }
+
+        freeaddrinfo(result);
+
+        if (cancellation.IsCancellationRequested()) {
+            LOG_INFO(L"HTTP GET canceled: ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
+            return false;
+        }
+
+        if (sock.Get() == INVALID_SOCKET) {
+            LOG_ERROR(L"Unable to connect to server: ", Utf8ToWide(host).c_str());
+            return false;
+        }
+
+        std::ostringstream requestStream;
+        requestStream << "GET " << (path.empty() ? "/" : path) << " HTTP/1.1\r\n"; // Ensure path is not empty
+        requestStream << "Host: " << host << "\r\n";
+        requestStream << "Connection: close\r\n";
+        requestStream << "User-Agent: NewsForHeng/1.0 (Windows)\r\n"; // Added OS
+        requestStream << "Accept: */*\r\n";
+        requestStream << "Accept-Encoding: identity\r\n"; // Be explicit about not handling gzip etc.
+        if (requestHeadersParam) {
+            for (const auto& header : *requestHeadersParam) {
+                requestStream << header.first << ": " << header.second << "\r\n";
+            }
+        }
+        requestStream << "\r\n";
+
+        std::string request = requestStream.str();
+
+        // 请求了 Range：收到完整的响应头后检查状态码，不是 206 时不再接收响应体 (那通常是整个文件)
+        bool checkRangeStatus = false;
+        if (requestHeadersParam) {
+            for (const auto& header : *requestHeadersParam) {
+                if (_stricmp(header.first.c_str(), "Range") == 0) checkRangeStatus = true;
+            }
+        }
+
+        if (send(sock.Get(), request.c_str(), (int)request.length(), 0) == SOCKET_ERROR) {
+            if (cancellation.IsCancellationRequested()) {
+                LOG_INFO(L"HTTP GET canceled: ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
+            }
+            else {
+                LOG_ERROR(L"send() failed. Error: ", WSAGetLastError());
+            }
+            return false;
+        }
+
+        std::string fullResponse;
+        char buffer[4096];
+        int bytesReceived;
+
+        do {
+            bytesReceived = recv(sock.Get(), buffer, sizeof(buffer) - 1, 0); // -1 to leave space for null terminator
+            if (bytesReceived > 0) {
+                // buffer[bytesReceived] = '\0'; // Not strictly necessary if appending with length
+                fullResponse.append(buffer, bytesReceived);
+                if (checkRangeStatus && fullResponse.find("\r\n\r\n") != std::string::npos) {
+                    checkRangeStatus = false;
+                    int statusCode = 0;
+                    std::string partialBody;
+                    if (ParseHttpResponse(fullResponse, partialBody, responseHeadersOutParam, statusCode) && statusCode != 206) {
+                        if (statusCodeOut) *statusCodeOut = statusCode;
+                        LOG_WARNING(L"Range request answered with status ", statusCode, L". Closing without reading the body: ",
+                            Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
+                        return false;
+                    }
+                }
+            }
+            else if (bytesReceived == 0) {
+                LOG_INFO(L"Connection closed by peer during recv.");
+            }
+            else {
+                int error = WSAGetLastError();
+                if (cancellation.IsCancellationRequested()) {
+                    LOG_INFO(L"HTTP GET canceled: ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
+                }
+                else if (error == WSAETIMEDOUT) {
+                    LOG_ERROR(L"recv() timed out. Error: ", error);
+                }
+                else {
+                    LOG_ERROR(L"recv() failed. Error: ", error);
+                }
+                return false;
+            }
+        } while (bytesReceived > 0);
+
+        sock.Reset(INVALID_SOCKET);
+
+        // shutdown() 之后 recv 返回 0，看起来像正常结束，但响应是不完整的
+        if (cancellation.IsCancellationRequested()) {
+            LOG_INFO(L"HTTP GET canceled: ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
+            return false;
+        }
+
+        int statusCode = 0;
+        if (!ParseHttpResponse(fullResponse, responseBody, responseHeadersOutParam, statusCode)) {
+            return false;
+        }
+        if (statusCodeOut) *statusCodeOut = statusCode;
+
+        if (statusCode < 200 || statusCode >= 300) {
+            LOG_WARNING(L"HTTP GET request failed with status code: ", statusCode, L" for ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str());
+            return false;
+        }
+
+        LOG_INFO(L"HTTP GET successful for ", Utf8ToWide(host).c_str(), Utf8ToWide(path).c_str(), L". Status: ", statusCode);
+        return true;
+    }
+
+
+    bool HttpGetUrl(
+        const std::string& url,
+        std::string& responseBody,
+        std::map<std::string, std::string>* responseHeadersOut,
+        const std::map<std::string, std::string>* requestHeaders,
+        int timeoutMs,
+        const CancellationToken& cancellation)
+    {
+        ParsedUrl purl = ParseUrl(url);
+        if (!purl.isValid) {
+            LOG_ERROR(L"Invalid URL for HTTP GET: ", Utf8ToWide(url).c_str());
+            return false;
+        }
+
+        std::string fullPath = purl.path;
+        if (!purl.query.empty()) {
+            fullPath += "?" + purl.query;
+        }
+
+        return HttpGet(purl.host, fullPath, purl.port, responseBody, responseHeadersOut,
+            (purl.scheme == "https"), timeoutMs, requestHeaders, cancellation);
+    }
+
+
+    // 响应头 (名称不区分大小写)，没有时返回空字符串
+    static std::string FindHeader(const std::map<std::string, std::string>& headers, const char* name) {
+        for (const auto& kv : headers) {
+            if (_stricmp(kv.first.c_str(), name) == 0) return kv.second;
+        }
+        return std::string();
+    }
+
+    // 解析 "bytes <first>-<last>/<total>"，total 为 "*" 时返回 -1
+    static bool ParseContentRange(const std::string& value, long long& first, long long& last, long long& total) {
+        if (_strnicmp(value.c_str(), "bytes ", 6) != 0) {
+            return false;
+        }
+        size_t dash = value.find('-', 6);
+        size_t slash = dash == std::string::npos ? std::string::npos : value.find('/', dash + 1);
+        if (slash == std::string::npos) {
+            return false;
+        }
+        try {
+            size_t used = 0;
+            first = std::stoll(value.substr(6, dash - 6), &used);
+            if (used != dash - 6) return false;
+            last = std::stoll(value.substr(dash + 1, slash - dash - 1), &used);
+            if (used != slash - dash - 1) return false;
+            std::string totalText = value.substr(slash + 1);
+            total = totalText == "*" ? -1 : std::stoll(totalText, &used);
+            if (totalText != "*" && used != totalText.size()) return false;
+        }
+        catch (const std::exception&) {
+            return false;
+        }
+        return first >= 0 && first <= last && (total < 0 || last < total);
+    }
+
+    bool HttpGetRange(
+        const std::string& url,
+        long long first,
+        long long last,
+        std::string& responseBody,
+        long long* outTotalSize,
+        std::map<std::string, std::string>* responseHeadersOut,
+        int timeoutMs,
+        const CancellationToken& cancellation,
+        int* statusCodeOut)
+    {
+        if (outTotalSize) *outTotalSize = -1;
+        ParsedUrl purl = ParseUrl(url);
+        if (!purl.isValid) {
+            LOG_ERROR(L"Invalid URL for HTTP range request: ", Utf8ToWide(url).c_str());
+            return false;
+        }
+        std::string fullPath = purl.path;
+        if (!purl.query.empty()) {
+            fullPath += "?" + purl.query;
+        }
+
+        std::map<std::string, std::string> requestHeaders;
+        requestHeaders["Range"] = "bytes=" + std::to_string(first) + "-" + std::to_string(last);
+        std::map<std::string, std::string> headers;
+        int statusCode = 0;
+        bool fetched = HttpGet(purl.host, fullPath, purl.port, responseBody, &headers,
+            (purl.scheme == "https"), timeoutMs, &requestHeaders, cancellation, &statusCode);
+        if (statusCodeOut) *statusCodeOut = statusCode;
+        if (responseHeadersOut) *responseHeadersOut = headers;
+        if (!fetched) {
+            return false;
+        }
+
+        // 200 表示服务器忽略了 Range，响应体是整个文件而不是请求的区间
+        if (statusCode != 206) {
+            LOG_WARNING(L"Range request not honored (status ", statusCode, L"): ", Utf8ToWide(url).c_str());
+            return false;
+        }
+        long long rangeFirst = 0, rangeLast = 0, total = -1;
+        std::string contentRange = FindHeader(headers, "Content-Range");
+        if (!ParseContentRange(contentRange, rangeFirst, rangeLast, total) || rangeFirst != first || rangeLast != last ||
+            static_cast<long long>(responseBody.size()) != last - first + 1) {
+            LOG_WARNING(L"Range response does not match request ", Utf8ToWide(requestHeaders["Range"]).c_str(),
+                L": Content-Range \"", Utf8ToWide(contentRange).c_str(), L"\", ", responseBody.size(), L" bytes from ", Utf8ToWide(url).c_str());
+            return false;
+        }
+        if (outTotalSize) *outTotalSize = total;
+        return true;
+    }
+
+
+    bool SaveToFile(const std::string& content, const std::wstring& outputPath) {
+        size_t lastSlash = outputPath.find_last_of(L"\\/");
+        if (lastSlash != std::wstring::npos) {
+            std::wstring dir = outputPath.substr(0, lastSlash);
+            if (!DirectoryExists(dir)) {
+                if (!CreateDirectoryRecursive(dir)) {
+                    LOG_ERROR(L"Failed to create directory for download: ", dir.c_str());
+                    return false;
+                }
+            }
+        }
+
+        std::ofstream outFile(outputPath, std::ios::binary | std::ios::trunc);
+        if (!outFile.is_open()) {
+            LOG_ERROR(L"Failed to open output file for writing: ", outputPath.c_str());
+            return false;
+        }
+
+        outFile.write(content.data(), content.size());
+        if (outFile.fail()) {
+            LOG_ERROR(L"Failed to write downloaded content to file: ", outputPath.c_str());
+            outFile.close();
+            DeleteFileW(outputPath.c_str()); // Clean up partial file
+            return false;
+        }
+
+        outFile.close();
+        return true;
+    }
+
+
+    bool DownloadFile(
+        const std::string& url, // Expects std::string
+        const std::wstring& outputPath,
+        std::function<void(long long, long long)> progressCallback,
+        const CancellationToken& cancellation)
+    {
+        ParsedUrl purl = ParseUrl(url); // url is already std::string
+        if (!purl.isValid) {
+            LOG_ERROR(L"Invalid URL for download: ", Utf8ToWide(url).c_str());
+            return false;
+        }
+
+        if (purl.scheme != "http") {
+            LOG_ERROR(L"DownloadFile currently only supports HTTP. URL: ", Utf8ToWide(url).c_str());
+            return false;
+        }
+
+        std::string responseBody;
+        std::map<std::string, std::string> responseHeadersMap; // C2039, C2065 fixed by including <map> and correct naming
+
+        LOG_INFO(L"Attempting to download file from URL: ", Utf8ToWide(url).c_str(), L" to: ", outputPath.c_str());
+
+        // Construct full path for HttpGet
+        std::string fullPath = purl.path;
+        if (!purl.query.empty()) {
+            fullPath += "?" + purl.query;
+        }
+
+        if (!HttpGet(purl.host, fullPath, purl.port, responseBody, &responseHeadersMap, (purl.scheme == "https"), 15000 /* 15 sec timeout */, nullptr, cancellation)) {
+            if (cancellation.IsCancellationRequested()) {
+                LOG_INFO(L"Download canceled: ", Utf8ToWide(url).c_str());
+            }
+            else {
+                LOG_ERROR(L"Failed to GET file content from URL: ", Utf8ToWide(url).c_str());
+            }
+            return false;
+        }
+
+        long long totalSize = -1;
+        // C3536 'it' error was because responseHeadersMap might not have been properly declared or map not included.
+        auto itHeader = responseHeadersMap.find("Content-Length"); // Renamed 'it' to 'itHeader' for clarity
+        if (itHeader != responseHeadersMap.end()) {
+            try {
+                totalSize = std::stoll(itHeader->second);
+            }
+            catch (const std::exception&) { /* ignore parse error */ }
+        }
+
+        if (!SaveToFile(responseBody, outputPath)) {
+            return false;
+        }
+
+        if (progressCallback) {
+            progressCallback(static_cast<long long>(responseBody.size()), totalSize > 0 ? totalSize : static_cast<long long>(responseBody.size()));
+        }
+
+        LOG_INFO(L"File downloaded successfully: ", outputPath.c_str(), L" (Size: ", responseBody.size(), L" bytes)");
+        return true;
+    }
+
+    // ---- 异步 HTTP：非阻塞套接字 + 单个 WSAPoll 事件循环线程 ----
+    // 请求在等待连接 / 发送 / 接收期间只占用一个 AsyncRequest 对象，不占用线程。
+
+    namespace {
+
+        using AsyncClock = std::chrono::steady_clock;
+
+        struct AsyncRequest {
+            enum class Phase { Connecting, Sending, Receiving };
+
+            std::string host;
+            std::string path;
+            std::string request;
+            size_t sent = 0;
+            std::string response;
+            addrinfo* addresses = nullptr;
+            addrinfo* current = nullptr;
+            SOCKET sock = INVALID_SOCKET;
+            Phase phase = Phase::Connecting;
+            std::chrono::milliseconds timeout{ 5000 };
+            AsyncClock::time_point deadline;  // 空闲超时：每次有进展时顺延，与同步版本的 SO_RCVTIMEO 含义一致
+            std::function<void(HttpResponse&)> onComplete;
+            CancellationToken cancellation;
+            CancellationRegistration registration; // 取消时唤醒事件循环；最先析构
+
+            ~AsyncRequest() {
+                if (sock != INVALID_SOCKET) closesocket(sock);
+                if (addresses) freeaddrinfo(addresses);
+            }
+        };
+
+        class AsyncReactor {
+        public:
+            static AsyncReactor& Instance() {
+                static AsyncReactor reactor;
+                return reactor;
+            }
+
+            bool Submit(std::unique_ptr<AsyncRequest> request) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (m_stopping || m_closed || !EnsureStarted()) {
+                        return false;
+                    }
+                    m_incoming.push_back(std::move(request));
+                }
+                Wake();
+                return true;
+            }
+
+            // 取消所有未完成的请求并结束事件循环线程 (Network::Cleanup 调用)
+            void Stop() {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_thread.joinable()) {
+                        return;
+                    }
+                    m_stopping = true;
+                }
+                Wake();
+                m_thread.join();
+                // 取消回调和 Submit 可能同时调用 Wake：在锁内关闭，Wake 不会向已关闭 (可能已被系统复用) 的句柄发送
+                std::lock_guard<std::mutex> lock(m_mutex);
+                closesocket(m_wakeSocket);
+                m_wakeSocket = INVALID_SOCKET;
+                m_stopping = false;
+            }
+
+            // 关闭后 Submit 一律失败 (StopAsyncRequests 使用)，不会再启动事件循环线程
+            void SetClosed(bool closed) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_closed = closed;
+            }
+
+            // 让事件循环立即醒来重新检查请求状态 (取消回调使用，可在任意线程调用)
+            void Wake() {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (m_wakeSocket == INVALID_SOCKET) {
+                    return; // 事件循环没有运行或已经停止
+                }
+                char byte = 0;
+                sendto(m_wakeSocket, &byte, 1, 0, reinterpret_cast<const sockaddr*>(&m_wakeAddress), sizeof(m_wakeAddress));
+            }
+
+        private:
+            AsyncReactor() : m_wakeSocket(INVALID_SOCKET), m_stopping(false), m_closed(false) {
+                ZeroMemory(&m_wakeAddress, sizeof(m_wakeAddress));
+            }
+
+            // 调用方持有 m_mutex
+            bool EnsureStarted() {
+                if (m_thread.joinable()) {
+                    return true;
+                }
+                // 唤醒用的回环 UDP 套接字：向自己发送一个字节即可让 WSAPoll 返回
+                m_wakeSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+                if (m_wakeSocket == INVALID_SOCKET) {
+                    LOG_ERROR(L"Failed to create async reactor wake socket. Error: ", WSAGetLastError());
+                    return false;
+                }
+                m_wakeAddress.sin_family = AF_INET;
+                m_wakeAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+                m_wakeAddress.sin_port = 0;
+                int addressLength = sizeof(m_wakeAddress);
+                u_long nonBlocking = 1;
+                if (bind(m_wakeSocket, reinterpret_cast<sockaddr*>(&m_wakeAddress), sizeof(m_wakeAddress)) == SOCKET_ERROR
+                    || getsockname(m_wakeSocket, reinterpret_cast<sockaddr*>(&m_wakeAddress), &addressLength) == SOCKET_ERROR
+                    || ioctlsocket(m_wakeSocket, FIONBIO, &nonBlocking) == SOCKET_ERROR) {
+                    LOG_ERROR(L"Failed to set up async reactor wake socket. Error: ", WSAGetLastError());
+                    closesocket(m_wakeSocket);
+                    m_wakeSocket = INVALID_SOCKET;
+                    return false;
+                }
+                m_thread = std::thread(&AsyncReactor::Run, this);
+                return true;
+            }
+
+            static void Complete(std::unique_ptr<AsyncRequest>& request, HttpResponse& response) {
+                if (request->sock != INVALID_SOCKET) {
+                    closesocket(request->sock);
+                    request->sock = INVALID_SOCKET;
+                }
+                try {
+                    request->onComplete(response);
+                }
+                catch (const std::exception& e) {
+                    LOG_ERROR(L"Exception in async HTTP completion callback: ", Utf8ToWide(e.what()).c_str());
+                }
+                request.reset();
+            }
+
+            static void Fail(std::unique_ptr<AsyncRequest>& request) {
+                HttpResponse response;
+                Complete(request, response);
+            }
+
+            static void Cancel(std::unique_ptr<AsyncRequest>& request) {
+                LOG_INFO(L"Async HTTP GET canceled: ", Utf8ToWide(request->host).c_str(), Utf8ToWide(request->path).c_str());
+                HttpResponse response;
+                response.canceled = true;
+                Complete(request, response);
+            }
+
+            static void Finish(std::unique_ptr<AsyncRequest>& request) {
+                HttpResponse response;
+                if (ParseHttpResponse(request->response, response.body, &response.headers, response.statusCode)) {
+                    response.success = response.statusCode >= 200 && response.statusCode < 300;
+                    if (response.success) {
+                        LOG_INFO(L"Async HTTP GET successful for ", Utf8ToWide(request->host).c_str(), Utf8ToWide(request->path).c_str(), L". Status: ", response.statusCode);
+                    }
+                    else {
+                        LOG_WARNING(L"Async HTTP GET failed with status code: ", response.statusCode, L" for ", Utf8ToWide(request->host).c_str(), Utf8ToWide(request->path).c_str());
+                    }
+                }
+                Complete(request, response);
+            }
+
+            // 依次尝试解析出的地址，发起非阻塞连接；所有地址都失败时返回 false
+            static bool StartConnect(AsyncRequest& request) {
+                for (; request.current != nullptr; request.current = request.current->ai_next) {
+                    if (request.sock != INVALID_SOCKET) {
+                        closesocket(request.sock);
+                    }
+                    request.sock = socket(request.current->ai_family, request.current->ai_socktype, request.current->ai_protocol);
+                    if (request.sock == INVALID_SOCKET) {
+                        continue;
+                    }
+                    u_long nonBlocking = 1;
+                    ioctlsocket(request.sock, FIONBIO, &nonBlocking);
+                    if (connect(request.sock, request.current->ai_addr, (int)request.current->ai_addrlen) == 0) {
+                        request.phase = AsyncRequest::Phase::Sending;
+                        return true;
+                    }
+                    if (WSAGetLastError() == WSAEWOULDBLOCK) {
+                        request.phase = AsyncRequest::Phase::Connecting;
+                        return true;
+                    }
+                }
+                LOG_ERROR(L"Unable to connect to server: ", Utf8ToWide(request.host).c_str());
+                return false;
+            }
+
+            // 处理一个套接字事件；请求结束 (成功或失败) 后 request 被置空
+            static void Advance(std::unique_ptr<AsyncRequest>& request, SHORT events) {
+                AsyncRequest& r = *request;
+                if (r.phase == AsyncRequest::Phase::Connecting) {
+                    int error = 0;
+                    int length = sizeof(error);
+                    getsockopt(r.sock, SOL_SOCKET, SO_ERROR, reinterpret_cast<char*>(&error), &length);
+                    if (error != 0 || (events & (POLLERR | POLLHUP))) {
+                        LOG_WARNING(L"Async connect() failed to host ", Utf8ToWide(r.host).c_str(), L" on an address. Error: ", error);
+                        r.current = r.current->ai_next;
+                        if (!StartConnect(r)) {
+                            Fail(request);
+                        }
+                        return;
+                    }
+                    if (!(events & POLLWRNORM)) {
+                        return;
+                    }
+                    r.phase = AsyncRequest::Phase::Sending;
+                }
+
+                if (r.phase == AsyncRequest::Phase::Sending) {
+                    int sentNow = send(r.sock, r.request.data() + r.sent, (int)(r.request.size() - r.sent), 0);
+                    if (sentNow == SOCKET_ERROR) {
+                        if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                            LOG_ERROR(L"Async send() failed. Error: ", WSAGetLastError());
+                            Fail(request);
+                        }
+                        return;
+                    }
+                    r.sent += static_cast<size_t>(sentNow);
+                    if (r.sent == r.request.size()) {
+                        r.phase = AsyncRequest::Phase::Receiving;
+                    }
+                    return;
+                }
+
+                // Receiving：读到对端关闭连接为止 (请求使用 Connection: close)
+                char buffer[16384];
+                while (true) {
+                    int received = recv(r.sock, buffer, sizeof(buffer), 0);
+                    if (received > 0) {
+                        r.response.append(buffer, received);
+                        continue;
+                    }
+                    if (received == 0) {
+                        Finish(request);
+                        return;
+                    }
+                    if (WSAGetLastError() != WSAEWOULDBLOCK) {
+                        LOG_ERROR(L"Async recv() failed. Error: ", WSAGetLastError());
+                        Fail(request);
+                    }
+                    return;
+                }
+            }
+
+            void Run() {
+                std::vector<std::unique_ptr<AsyncRequest>> active;
+                std::vector<WSAPOLLFD> fds;
+
+                std::vector<std::unique_ptr<AsyncRequest>> incoming;
+
+                while (true) {
+                    // 完成回调可能再次提交请求，因此不在持有 m_mutex 时处理请求
+                    bool stopping;
+                    {
+                        std::lock_guard<std::mutex> lock(m_mutex);
+                        stopping = m_stopping;
+                        incoming.swap(m_incoming);
+                    }
+                    if (stopping) {
+                        for (auto& request : incoming) active.push_back(std::move(request));
+                        incoming.clear();
+                        break;
+                    }
+                    for (auto& request : incoming) {
+                        request->deadline = AsyncClock::now() + request->timeout;
+                        if (request->cancellation.IsCancellationRequested()) {
+                            Cancel(request);
+                        }
+                        else if (StartConnect(*request)) {
+                            active.push_back(std::move(request));
+                        }
+                        else {
+                            Fail(request);
+                        }
+                    }
+                    incoming.clear();
+
+                    // 取消与超时检查，同时计算 WSAPoll 的等待时间
+                    AsyncClock::time_point now = AsyncClock::now();
+                    INT waitMs = -1;
+                    for (auto& request : active) {
+                        if (request->cancellation.IsCancellationRequested()) {
+                            Cancel(request);
+                            continue;
+                        }
+                        if (now >= request->deadline) {
+                            LOG_ERROR(L"Async HTTP request to ", Utf8ToWide(request->host).c_str(), L" timed out.");
+                            Fail(request);
+                            continue;
+                        }
+                        INT remaining = static_cast<INT>(std::chrono::duration_cast<std::chrono::milliseconds>(request->deadline - now).count()) + 1;
+                        waitMs = (waitMs < 0) ? remaining : (std::min)(waitMs, remaining);
+                    }
+                    active.erase(std::remove(active.begin(), active.end(), nullptr), active.end());
+
+                    fds.resize(active.size() + 1);
+                    fds[0].fd = m_wakeSocket;
+                    fds[0].events = POLLRDNORM;
+                    fds[0].revents = 0;
+                    for (size_t i = 0; i < active.size(); ++i) {
+                        fds[i + 1].fd = active[i]->sock;
+                        fds[i + 1].events = (active[i]->phase == AsyncRequest::Phase::Receiving) ? POLLRDNORM : POLLWRNORM;
+                        fds[i + 1].revents = 0;
+                    }
+
+                    if (WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), waitMs) == SOCKET_ERROR) {
+                        LOG_ERROR(L"WSAPoll failed. Error: ", WSAGetLastError());
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                        continue;
+                    }
+
+                    if (fds[0].revents) {
+                        char drain[64];
+                        while (recv(m_wakeSocket, drain, sizeof(drain), 0) > 0) {
+                        }
+                    }
+
+                    for (size_t i = 0; i < active.size(); ++i) {
+                        SHORT events = fds[i + 1].revents;
+                        if (!events) continue;
+                        active[i]->deadline = AsyncClock::now() + active[i]->timeout;
+                        Advance(active[i], events);
+                    }
+                    active.erase(std::remove(active.begin(), active.end(), nullptr), active.end());
+                }
+
+                // 停止：未完成的请求以失败结束
+                for (auto& request : active) {
+                    Fail(request);
+                }
+            }
+
+            std::mutex m_mutex;
+            std::vector<std::unique_ptr<AsyncRequest>> m_incoming;
+            std::thread m_thread;
+            SOCKET m_wakeSocket;           // 只在持有 m_mutex 时创建、关闭和发送；事件循环线程运行期间不会改变
+            sockaddr_in m_wakeAddress;
+            bool m_stopping;
+            bool m_closed;
+        };
+
+    } // namespace
+
+    static void StopAsyncReactor() {
+        AsyncReactor::Instance().Stop();
+    }
+
+    static void SetAsyncRequestsClosed(bool closed) {
+        AsyncReactor::Instance().SetClosed(closed);
+    }
+
+    void StopAsyncRequests() {
+        SetAsyncRequestsClosed(true);
+        StopAsyncReactor();
+        LOG_INFO(L"Async HTTP requests stopped.");
+    }
+
+    void HttpGetAsync(
+        const std::string& url,
+        std::function<void(HttpResponse&)> onComplete,
+        const std::map<std::string, std::string>* requestHeaders,
+        int timeoutMs,
+        const CancellationToken& cancellation)
+    {
+        HttpResponse failed;
+        ParsedUrl purl = ParseUrl(url);
+        if (!purl.isValid) {
+            LOG_ERROR(L"Invalid URL for async HTTP GET: ", Utf8ToWide(url).c_str());
+            onComplete(failed);
+            return;
+        }
+        if (purl.scheme == "https") {
+            LOG_ERROR(L"HTTPS is not supported in this basic HttpGet implementation.");
+            onComplete(failed);
+            return;
+        }
+        if (!g_winsockInitialized) {
+            LOG_ERROR(L"Winsock not initialized. Call Network::Initialize() first.");
+            onComplete(failed);
+            return;
+        }
+
+        std::unique_ptr<AsyncRequest> request(new AsyncRequest());
+        request->host = purl.host;
+        request->path = purl.path;
+        if (!purl.query.empty()) {
+            request->path += "?" + purl.query;
+        }
+        request->timeout = std::chrono::milliseconds(timeoutMs > 0 ? timeoutMs : 5000);
+        request->onComplete = std::move(onComplete);
+        request->cancellation = cancellation;
+
+        // 名称解析仍是同步的 (getaddrinfo)，通常命中系统 DNS 缓存
+        addrinfo hints;
+        ZeroMemory(&hints, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+        std::string portStr = std::to_string(purl.port);
+        if (getaddrinfo(purl.host.c_str(), portStr.c_str(), &hints, &request->addresses) != 0) {
+            LOG_ERROR(L"getaddrinfo failed for host: ", Utf8ToWide(purl.host).c_str(), L" Error: ", WSAGetLastError());
+            request->onComplete(failed);
+            return;
+        }
+        request->current = request->addresses;
+
+        std::ostringstream requestStream;
+        requestStream << "GET " << request->path << " HTTP/1.1\r\n";
+        requestStream << "Host: " << purl.host << "\r\n";
+        requestStream << "Connection: close\r\n";
+        requestStream << "User-Agent: NewsForHeng/1.0 (Windows)\r\n";
+        requestStream << "Accept: */*\r\n";
+        requestStream << "Accept-Encoding: identity\r\n";
+        if (requestHeaders) {
+            for (const auto& header : *requestHeaders) {
+                requestStream << header.first << ": " << header.second << "\r\n";
+            }
+        }
+        requestStream << "\r\n";
+        request->request = requestStream.str();
+
+        // 在提交前注册：提交之后请求归事件循环所有，随时可能被释放
+        request->registration = cancellation.Register([] { AsyncReactor::Instance().Wake(); });
+
+        std::function<void(HttpResponse&)> callback = request->onComplete;
+        if (!AsyncReactor::Instance().Submit(std::move(request))) {
+            callback(failed);
+        }
+    }
+
+} // namespace Network
@@ -1,97 +1,195 @@
-#ifndef NETWORK_H
-#define NETWORK_H
-
-#include <string>
-#include <vector>
-#include <functional> // For std::function (callbacks)
-#include <map>        // For std::map (was missing, caused C2039)
-
-//  WinSock2.h ֮ǰ windows.h
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
-#include <windows.h>
-#include <winsock2.h>
-#include <ws2tcpip.h> // For getaddrinfo etc.
-
-//  Ws2_32.lib
-#pragma comment(lib, "Ws2_32.lib")
-
-namespace Network {
-
-    /**
-     * @brief ʼ Winsock ⡣
-     * @return ɹ true򷵻 false
-     * @note ӦóʱӦһΡ
-     */
-    bool Initialize();
-
-    /**
-     * @brief  Winsock ⡣
-     * @note Ӧó˳ʱӦһΡ
-     */
-    void Cleanup();
-
-    // ṹ壬ڽ URL
-    struct ParsedUrl {
-        std::string scheme;
-        std::string host;
-        unsigned short port;
-        std::string path; // Should include leading slash if present
-        std::string query; // Content after '?'
-        bool isValid = false;
-
-        ParsedUrl() : port(0), isValid(false) {} // Default constructor
-    };
-
-    /**
-     * @brief  URL ַ
-     * @param urlString Ҫ URL
-     * @return ParsedUrl ṹ塣
-     */
-    ParsedUrl ParseUrl(const std::string& urlString);
-
-
-    /**
-     * @brief ִ HTTP GET 
-     * @param host  ( "www.example.com")
-     * @param path · ( "/index.html")
-     * @param port ˿ں (ͨ 80 for HTTP, 443 for HTTPS)
-     * @param responseBody [out] 洢Ӧݡ
-     * @param responseHeadersOut [out] 洢ӦͷϢ (ѡ, C2065 was here, renamed parameter)
-     * @param useHTTPS Ƿʹ HTTPS (ǰʵּֽ֧ HTTP)
-     * @param timeoutMs ʱʱ䣨룩 (C2065 was here, renamed parameter).
-     * @return ɹյ 2xx Ӧ򷵻 true
-     *
-     * @note һǳ HTTP GET ʵ֣ضHTTPS (Ҫ OpenSSL)
-     * ӵͷCookies ȡʹó HTTP ͻ˿ ( cpr, libcurl, cpprestsdk)
-     */
-    bool HttpGet(
-        const std::string& host,
-        const std::string& path,
-        unsigned short port,
-        std::string& responseBody,
-        std::map<std::string, std::string>* responseHeadersOutParam = nullptr, // Renamed to avoid conflict
-        bool useHTTPSParam = false, // Renamed
-        int timeoutMsParam = 5000  // Renamed
-    );
-
-    /**
-     * @brief ļָ·
-     * @param url ļ URL
-     * @param outputPath ļı·
-     * @param progressCallback Ȼص (ѡ)Ϊ (ǰֽ, ļֽ)
-     * ֽδ֪Ϊ -1
-     * @return سɹ true
-     * @note ˺ URLʹ HttpGet (߼) ȡݡ
-     * ͬһʵ֡
-     */
-    bool DownloadFile(
-        const std::string& url, // Expects std::string
-        const std::wstring& outputPath,
-        std::function<void(long long, long long)> progressCallback = nullptr
-    );
-
-} // namespace Network
-
-#endif // NETWORK_H
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <string>
+#include <vector>
+#include <functional> // For std::function (callbacks)
+#include <map>        // For std::map (was missing, caused C2039)
+
+// 引入 WinSock2.h 之前必须先引入 windows.h
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <winsock2.h>
+#include <ws2tcpip.h> // For getaddrinfo etc.
+
+// 链接 Ws2_32.lib
+#pragma comment(lib, "Ws2_32.lib")
+
+#include "cancellation.h"
+
+namespace Network {
+
+    /**
+     * @brief 初始化 Winsock 库。
+     * @return 如果成功返回 true，否则返回 false。
+     * @note 应用程序启动时应调用一次。
+     */
+    bool Initialize();
+
+    /**
+     * @brief 清理 Winsock 库。
+     * @note 应用程序退出时应调用一次。
+     */
+    void Cleanup();
+
+    // 辅助结构体，用于解析 URL
+    struct ParsedUrl {
+        std::string scheme;
+        std::string host;
+        unsigned short port;
+        std::string path; // Should include leading slash if present
+        std::string query; // Content after '?'
+        bool isValid = false;
+
+        ParsedUrl() : port(0), isValid(false) {} // Default constructor
+    };
+
+    /**
+     * @brief 解析 URL 字符串。
+     * @param urlString 要解析的 URL。
+     * @return ParsedUrl 结构体。
+     */
+    ParsedUrl ParseUrl(const std::string& urlString);
+
+
+    /**
+     * @brief 执行 HTTP GET 请求。
+     * @param host 主机名 (例如 "www.example.com")。
+     * @param path 请求路径 (例如 "/index.html")。
+     * @param port 端口号 (通常是 80 for HTTP, 443 for HTTPS)。
+     * @param responseBody [out] 存储服务器响应的主体内容。
+     * @param responseHeadersOut [out] 存储服务器响应的头部信息 (可选, C2065 was here, renamed parameter)，非 2xx 响应同样会填充，便于读取 Retry-After 等提示。
+     * @param useHTTPS 是否使用 HTTPS (当前实现仅支持简单 HTTP)。
+     * @param timeoutMs 超时时间（毫秒） (C2065 was here, renamed parameter).
+     * @param requestHeadersParam 附加的请求头 (可选，例如 "Range": "bytes=0-1023")。
+     * @param cancellation 取消令牌 (可选)：取消时关闭连接，阻塞中的连接 / 接收立即失败返回。
+     * @param statusCodeOut [out] HTTP 状态码 (可选)，没有收到有效响应时为 0。
+     * @return 如果请求成功且收到 2xx 响应则返回 true；被取消时返回 false。
+     *         请求头中有 Range 而响应不是 206 时，读完响应头就断开并返回 false (响应头和状态码仍会填充)。
+     *
+     * @note 这是一个非常基础的 HTTP GET 实现，不处理重定向、HTTPS (需要额外库如 OpenSSL)、
+     * 复杂的头部、Cookies 等。对于生产环境，建议使用成熟的 HTTP 客户端库 (如 cpr, libcurl, cpprestsdk)。
+     */
+    bool HttpGet(
+        const std::string& host,
+        const std::string& path,
+        unsigned short port,
+        std::string& responseBody,
+        std::map<std::string, std::string>* responseHeadersOutParam = nullptr, // Renamed to avoid conflict
+        bool useHTTPSParam = false, // Renamed
+        int timeoutMsParam = 5000,  // Renamed
+        const std::map<std::string, std::string>* requestHeadersParam = nullptr,
+        const CancellationToken& cancellation = CancellationToken(),
+        int* statusCodeOut = nullptr
+    );
+
+    /**
+     * @brief 解析 URL 并执行 HTTP GET 请求 (HttpGet 的便捷封装)。
+     * @param url 完整的 URL。
+     * @param responseBody [out] 响应体。
+     * @param responseHeadersOut [out] 响应头 (可选)。
+     * @param requestHeaders 附加的请求头 (可选)。
+     * @param timeoutMs 超时时间（毫秒）。
+     * @param cancellation 取消令牌 (可选)。
+     * @return 请求成功并收到 2xx 响应则返回 true。
+     */
+    bool HttpGetUrl(
+        const std::string& url,
+        std::string& responseBody,
+        std::map<std::string, std::string>* responseHeadersOut = nullptr,
+        const std::map<std::string, std::string>* requestHeaders = nullptr,
+        int timeoutMs = 5000,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+    /**
+     * @brief 请求 URL 的一个字节区间，只接受与请求一致的分段响应。
+     * @param url 完整的 URL。
+     * @param first 区间的第一个字节。
+     * @param last 区间的最后一个字节 (包含)，不能超过文件末尾。
+     * @param responseBody [out] 区间内容，长度为 last - first + 1。
+     * @param outTotalSize [out] Content-Range 中的文件总大小 (可选，服务器给出 "*" 时为 -1)。
+     * @param responseHeadersOut [out] 响应头 (可选)。
+     * @param timeoutMs 超时时间（毫秒）。
+     * @param cancellation 取消令牌 (可选)。
+     * @param statusCodeOut [out] HTTP 状态码 (可选)，没有收到有效响应时为 0。
+     *        返回 false 且状态码为 2xx 表示服务器不支持 Range，此时不会接收响应体。
+     * @return 收到 206 且 Content-Range 与请求的区间一致时返回 true。
+     *         服务器忽略 Range (返回 200 和整个文件) 或返回了其他区间时返回 false。
+     */
+    bool HttpGetRange(
+        const std::string& url,
+        long long first,
+        long long last,
+        std::string& responseBody,
+        long long* outTotalSize = nullptr,
+        std::map<std::string, std::string>* responseHeadersOut = nullptr,
+        int timeoutMs = 30000,
+        const CancellationToken& cancellation = CancellationToken(),
+        int* statusCodeOut = nullptr
+    );
+
+    /**
+     * @brief 下载文件到指定路径。
+     * @param url 文件的 URL。
+     * @param outputPath 文件保存的本地路径。
+     * @param progressCallback 进度回调函数 (可选)，参数为 (当前已下载字节数, 文件总字节数)。
+     * 如果总字节数未知，则为 -1。
+     * @param cancellation 取消令牌 (可选)，取消后不会写入文件。
+     * @return 如果下载成功返回 true。
+     * @note 此函数将解析 URL，并使用 HttpGet (或类似逻辑) 来获取数据。
+     * 同样，这是一个基础实现。
+     */
+    bool DownloadFile(
+        const std::string& url, // Expects std::string
+        const std::wstring& outputPath,
+        std::function<void(long long, long long)> progressCallback = nullptr,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+    /**
+     * @brief 把内容写入文件 (必要时创建目录，失败时删除不完整的文件)。
+     * @param content 文件内容。
+     * @param outputPath 文件保存的本地路径。
+     * @return 写入成功返回 true。
+     */
+    bool SaveToFile(const std::string& content, const std::wstring& outputPath);
+
+    // 异步请求的结果
+    struct HttpResponse {
+        bool success = false;   // 收到 2xx 响应
+        int statusCode = 0;     // 0 表示没有收到有效响应 (连接失败、超时、被取消等)
+        bool canceled = false;  // 因取消令牌而结束
+        std::string body;
+        std::map<std::string, std::string> headers;
+    };
+
+    /**
+     * @brief 异步执行 HTTP GET：连接、发送和接收由一个事件循环线程 (WSAPoll) 驱动，等待期间不占用调用线程。
+     * @param url 完整的 URL (仅支持 http)。
+     * @param onComplete 完成回调，在事件循环线程上调用 (参数校验失败时在调用线程上立即调用)，应尽快返回。
+     * @param requestHeaders 附加的请求头 (可选)。
+     * @param timeoutMs 空闲超时（毫秒）：连接、发送或接收在这么长时间内没有任何进展时失败。
+     * @param cancellation 取消令牌 (可选)：取消后请求尽快以 canceled 结束。
+     * @note 名称解析 (getaddrinfo) 在调用线程上同步完成。Network::Cleanup 会以失败结束所有未完成的请求。
+     */
+    void HttpGetAsync(
+        const std::string& url,
+        std::function<void(HttpResponse&)> onComplete,
+        const std::map<std::string, std::string>* requestHeaders = nullptr,
+        int timeoutMs = 5000,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+    /**
+     * @brief 以失败结束所有未完成的异步请求 (在事件循环线程上调用它们的完成回调) 并停止事件循环线程。
+     *        之后的 HttpGetAsync 立即失败，直到 Cleanup 后重新 Initialize。
+     * @note Coro::HttpGet 的完成回调会向线程池提交恢复任务，程序退出时须在关闭线程池之前调用。
+     */
+    void StopAsyncRequests();
+
+} // namespace Network
+
+#endif // NETWORK_H
@@ -0,0 +1,229 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "threads.h"
+
+// 基于 ThreadPool 的数据并行算法 (fork-join)：
+// 区间按粒度递归二分，右半部分作为任务提交，左半部分在当前线程继续执行。
+// 汇合时若右半部分还没被任何线程取走，就直接在当前线程执行 (不等待排队)；
+// 已被其他线程执行时，工作线程在等待期间帮忙执行线程池中的其他任务。
+// 因此不会额外创建线程，线程池饱和时也不会因为互相等待而死锁：最坏情况退化为调用线程串行执行。
+
+namespace Parallel {
+
+    namespace Detail {
+
+        // 被 fork 出去的一半工作：谁先把状态从 Pending 改为 Claimed 谁执行
+        struct JoinState {
+            enum : int { Pending = 0, Claimed = 1, Done = 2 };
+
+            std::atomic<int> state{ Pending };
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable doneCondition;
+
+            virtual ~JoinState() = default;
+            virtual void Invoke() = 0;
+
+            // 抢到执行权时运行并返回 true
+            bool TryRun() {
+                int expected = Pending;
+                if (!state.compare_exchange_strong(expected, Claimed)) {
+                    return false;
+                }
+                try {
+                    Invoke();
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    state.store(Done);
+                }
+                doneCondition.notify_all();
+                return true;
+            }
+        };
+
+        template<typename Fn>
+        struct ForkedCall : JoinState {
+            explicit ForkedCall(Fn& f) : fn(f) {}
+            void Invoke() override { fn(); }
+            Fn& fn; // 指向调用方栈上的可调用对象，Join 返回前一直有效
+        };
+
+        inline void Join(ThreadPool& pool, JoinState& forked) {
+            if (forked.TryRun()) {
+                return; // 还在排队：直接在当前线程执行
+            }
+            // 正在其他线程上执行
+            std::unique_lock<std::mutex> lock(forked.mutex);
+            pool.HelpWhileWaiting(lock, forked.doneCondition, [&forked] { return forked.state.load() == JoinState::Done; });
+        }
+
+        // 默认粒度：每个线程约 4 块，兼顾负载均衡与任务开销
+        inline size_t DefaultGrain(ThreadPool& pool, size_t count) {
+            size_t chunks = (std::max)(pool.GetThreadCount(), static_cast<size_t>(1)) * 4;
+            return (std::max)(count / chunks, static_cast<size_t>(1));
+        }
+
+    } // namespace Detail
+
+    /**
+     * @brief 并行执行两个函数，两者都完成后返回 (fork-join 的基本操作)。
+     * @param pool 线程池。
+     * @param left 在当前线程执行的函数。
+     * @param right 提交到线程池的函数 (线程池没有及时执行时由当前线程执行)。
+     * @note 任一函数抛出的异常在两者都结束后重新抛出 (left 的异常优先)。
+     */
+    template<typename Left, typename Right>
+    void Invoke(ThreadPool& pool, Left&& left, Right&& right) {
+        using RightFn = typename std::remove_reference<Right>::type;
+        auto forked = std::allocate_shared<Detail::ForkedCall<RightFn>>(PooledAllocator<char>(), right);
+        try {
+            pool.post([forked] { forked->TryRun(); });
+        }
+        catch (const std::exception&) {
+            // 线程池已停止或队列已满 (Fail 策略)：Join 时在当前线程执行
+        }
+
+        try {
+            left();
+        }
+        catch (...) {
+            Detail::Join(pool, *forked); // right 引用了调用方栈上的数据，必须等它结束
+            throw;
+        }
+        Detail::Join(pool, *forked);
+        if (forked->error) {
+            std::rethrow_exception(forked->error);
+        }
+    }
+
+    /**
+     * @brief 对 [begin, end) 中的每个下标并行调用 body(i)。
+     * @param pool 线程池。
+     * @param begin 起始下标。
+     * @param end 结束下标 (不包含)。
+     * @param body 循环体，会被多个线程同时调用。
+     * @param grainSize 不再拆分的最小区间长度，0 表示按线程数自动选择。
+     */
+    template<typename Index, typename Body>
+    void For(ThreadPool& pool, Index begin, Index end, const Body& body, size_t grainSize = 0) {
+        if (!(begin < end)) {
+            return;
+        }
+        size_t count = static_cast<size_t>(end - begin);
+        size_t grain = grainSize ? grainSize : Detail::DefaultGrain(pool, count);
+        if (count <= grain) {
+            for (Index i = begin; i < end; ++i) {
+                body(i);
+            }
+            return;
+        }
+        Index middle = begin + static_cast<Index>(count / 2);
+        Invoke(pool,
+            [&] { For(pool, begin, middle, body, grain); },
+            [&] { For(pool, middle, end, body, grain); });
+    }
+
+    /**
+     * @brief 并行归约：combine(map(begin), ..., map(end - 1))，从 identity 开始。
+     * @param identity combine 的单位元。
+     * @param map 把下标映射为值，会被多个线程同时调用。
+     * @param combine 满足结合律的合并函数；按下标顺序合并，结果与串行计算一致。
+     * @param grainSize 不再拆分的最小区间长度，0 表示按线程数自动选择。
+     */
+    template<typename Index, typename T, typename Map, typename Combine>
+    T Reduce(ThreadPool& pool, Index begin, Index end, T identity, const Map& map, const Combine& combine, size_t grainSize = 0) {
+        if (!(begin < end)) {
+            return identity;
+        }
+        size_t count = static_cast<size_t>(end - begin);
+        size_t grain = grainSize ? grainSize : Detail::DefaultGrain(pool, count);
+        if (count <= grain) {
+            T result = identity;
+            for (Index i = begin; i < end; ++i) {
+                result = combine(std::move(result), map(i));
+            }
+            return result;
+        }
+        Index middle = begin + static_cast<Index>(count / 2);
+        T leftResult = identity;
+        T rightResult = identity;
+        Invoke(pool,
+            [&] { leftResult = Reduce(pool, begin, middle, identity, map, combine, grain); },
+            [&] { rightResult = Reduce(pool, middle, end, identity, map, combine, grain); });
+        return combine(std::move(leftResult), std::move(rightResult));
+    }
+
+    namespace Detail {
+
+        // depthLimit 是剩余的划分层数 (内省排序)：枢轴一直选得很差时不再继续拆分，
+        // 整个区间交给 std::sort (本身保证 O(n log n))，避免退化为 O(n^2) 和过深的递归
+        template<typename RandomIt, typename Compare>
+        void SortRange(ThreadPool& pool, RandomIt first, RandomIt last, Compare& comp, size_t grain, unsigned depthLimit) {
+            size_t count = static_cast<size_t>(last - first);
+            if (count <= grain || depthLimit == 0) {
+                std::sort(first, last, comp);
+                return;
+            }
+
+            // 三数取中作为枢轴，再三路划分 (小于 / 等于 / 大于)，大量重复元素时也不会退化
+            RandomIt middle = first + count / 2;
+            RandomIt back = last - 1;
+            if (comp(*middle, *first)) std::iter_swap(middle, first);
+            if (comp(*back, *middle)) {
+                std::iter_swap(back, middle);
+                if (comp(*middle, *first)) std::iter_swap(middle, first);
+            }
+            auto pivot = *middle;
+            RandomIt lessEnd = std::partition(first, last, [&](const auto& value) { return comp(value, pivot); });
+            RandomIt equalEnd = std::partition(lessEnd, last, [&](const auto& value) { return !comp(pivot, value); });
+
+            Invoke(pool,
+                [&] { SortRange(pool, first, lessEnd, comp, grain, depthLimit - 1); },
+                [&] { SortRange(pool, equalEnd, last, comp, grain, depthLimit - 1); });
+        }
+
+    } // namespace Detail
+
+    /**
+     * @brief 并行排序 (快速排序分区 + fork-join，小区间使用 std::sort)。不稳定。
+     * @param first 随机访问迭代器。
+     * @param last 随机访问迭代器。
+     * @param comp 严格弱序比较函数。
+     * @param grainSize 不再拆分的最小区间长度，0 表示按线程数自动选择 (至少 2048)。
+     * @note 划分层数超过 2 * log2(n) 时剩余区间改用 std::sort，最坏情况仍为 O(n log n)。
+     */
+    template<typename RandomIt, typename Compare>
+    void Sort(ThreadPool& pool, RandomIt first, RandomIt last, Compare comp, size_t grainSize = 0) {
+        size_t count = static_cast<size_t>(last - first);
+        size_t grain = grainSize ? grainSize : (std::max)(Detail::DefaultGrain(pool, count), static_cast<size_t>(2048));
+        unsigned depthLimit = 0;
+        for (size_t n = count; n > 1; n >>= 1) {
+            depthLimit += 2;
+        }
+        Detail::SortRange(pool, first, last, comp, grain, depthLimit);
+    }
+
+    template<typename RandomIt>
+    void Sort(ThreadPool& pool, RandomIt first, RandomIt last) {
+        Sort(pool, first, last, std::less<typename std::iterator_traits<RandomIt>::value_type>());
+    }
+
+} // namespace Parallel
+
+#endif // PARALLEL_H
@@ -0,0 +1,95 @@
+#include "task.h"
+
+namespace TaskMemory {
+
+    // 分级大小：64 / 128 / 256 / 512 字节，更大的块直接使用全局堆
+    static const size_t kClassCount = 4;
+    static const size_t kMaxPooledBytes = 512;
+    // 每个线程每一级最多缓存的空闲块数，超出后归还全局堆
+    static const size_t kMaxCachedBlocks = 256;
+
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    // 缓存本身是平凡析构的，线程退出时由 CacheReleaser 归还其中的块；
+    // 之后 (例如其他线程局部对象析构时释放共享状态) 的分配和释放直接使用全局堆
+    struct ThreadCache {
+        FreeBlock* heads[kClassCount];
+        size_t counts[kClassCount];
+        bool released;
+    };
+
+    static thread_local ThreadCache t_cache = {};
+
+    struct CacheReleaser {
+        ~CacheReleaser() {
+            for (size_t i = 0; i < kClassCount; ++i) {
+                while (t_cache.heads[i]) {
+                    FreeBlock* block = t_cache.heads[i];
+                    t_cache.heads[i] = block->next;
+                    ::operator delete(block);
+                }
+                t_cache.counts[i] = 0;
+            }
+            t_cache.released = true;
+        }
+    };
+
+    static thread_local CacheReleaser t_releaser;
+
+    // 首次使用时注册线程退出时的归还；已归还则返回 nullptr
+    static ThreadCache* GetCache() {
+        if (t_cache.released) return nullptr;
+        (void)&t_releaser;
+        return &t_cache;
+    }
+
+    static size_t ClassIndex(size_t bytes) {
+        size_t index = 0;
+        size_t classSize = 64;
+        while (classSize < bytes) {
+            classSize <<= 1;
+            ++index;
+        }
+        return index;
+    }
+
+    static size_t ClassBytes(size_t index) {
+        return static_cast<size_t>(64) << index;
+    }
+
+    void* Allocate(size_t bytes) {
+        if (bytes > kMaxPooledBytes) {
+            return ::operator new(bytes);
+        }
+        size_t index = ClassIndex(bytes);
+        ThreadCache* cache = GetCache();
+        if (cache && cache->heads[index]) {
+            FreeBlock* block = cache->heads[index];
+            cache->heads[index] = block->next;
+            --cache->counts[index];
+            return block;
+        }
+        return ::operator new(ClassBytes(index));
+    }
+
+    void Deallocate(void* p, size_t bytes) noexcept {
+        if (!p) return;
+        if (bytes > kMaxPooledBytes) {
+            ::operator delete(p);
+            return;
+        }
+        size_t index = ClassIndex(bytes);
+        ThreadCache* cache = GetCache();
+        if (!cache || cache->counts[index] >= kMaxCachedBlocks) {
+            ::operator delete(p);
+            return;
+        }
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = cache->heads[index];
+        cache->heads[index] = block;
+        ++cache->counts[index];
+    }
+
+} // namespace TaskMemory
@@ -0,0 +1,175 @@
+#ifndef TASK_H
+#define TASK_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// 线程池任务类型：
+// Task 是只能移动的可调用对象包装，小的可调用对象 (例如只捕获几个指针和一个 std::promise 的 lambda)
+// 直接存放在对象内部的缓冲区中，不需要堆分配；放不下时才退化为一次堆分配。
+// 与 std::function 不同，它不要求可调用对象可拷贝，因此可以直接捕获 std::promise。
+
+namespace TaskMemory {
+
+    /**
+     * @brief 从当前线程的分级空闲链表分配内存 (不超过 512 字节时复用已释放的块)。
+     * @note 可以在任意线程释放，释放的块进入释放线程的空闲链表。
+     */
+    void* Allocate(size_t bytes);
+
+    /**
+     * @brief 释放 Allocate 分配的内存，bytes 须与分配时相同。
+     */
+    void Deallocate(void* p, size_t bytes) noexcept;
+
+} // namespace TaskMemory
+
+// 使用 TaskMemory 的分配器，用于 std::promise 的共享状态，避免每个任务一次全局堆分配
+template<typename T>
+struct PooledAllocator {
+    using value_type = T;
+
+    PooledAllocator() noexcept = default;
+    template<typename U>
+    PooledAllocator(const PooledAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) { return static_cast<T*>(TaskMemory::Allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) noexcept { TaskMemory::Deallocate(p, n * sizeof(T)); }
+
+    template<typename U>
+    bool operator==(const PooledAllocator<U>&) const noexcept { return true; }
+    template<typename U>
+    bool operator!=(const PooledAllocator<U>&) const noexcept { return false; }
+};
+
+namespace TaskDetail {
+
+    // 检测可调用对象是否有 Cancel() 成员 (C++17 的 void_t 写法，不依赖 C++20 requires 表达式)
+    template<typename Callable, typename = void>
+    struct HasCancel : std::false_type {};
+
+    template<typename Callable>
+    struct HasCancel<Callable, std::void_t<decltype(std::declval<Callable&>().Cancel())>> : std::true_type {};
+
+} // namespace TaskDetail
+
+class Task {
+public:
+    // 内联缓冲区大小：足够容纳捕获 std::promise、一个可调用对象和几个参数的 lambda
+    static constexpr size_t kInlineSize = 64;
+
+    Task() noexcept : m_ops(nullptr) {}
+
+    template<typename F, typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, Task>::value>::type>
+    Task(F&& f) : m_ops(nullptr) {
+        using Callable = typename std::decay<F>::type;
+        if constexpr (FitsInline<Callable>()) {
+            new (m_storage) Callable(std::forward<F>(f));
+            m_ops = &InlineOps<Callable>::ops;
+        }
+        else {
+            Callable* heap = new Callable(std::forward<F>(f));
+            new (m_storage) Callable*(heap);
+            m_ops = &HeapOps<Callable>::ops;
+        }
+    }
+
+    Task(Task&& other) noexcept : m_ops(other.m_ops) {
+        if (m_ops) {
+            m_ops->move(other.m_storage, m_storage);
+            other.m_ops = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            if (other.m_ops) {
+                other.m_ops->move(other.m_storage, m_storage);
+                m_ops = other.m_ops;
+                other.m_ops = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { Reset(); }
+
+    void operator()() { m_ops->invoke(m_storage); }
+
+    /**
+     * @brief 放弃执行并销毁任务 (任务被取消，或线程池限时关闭时丢弃未开始的任务)。
+     * @note 可调用对象提供 Cancel() 成员时先调用它，例如让等待结果的 future 得到 OperationCanceledError；
+     *       普通 lambda 直接销毁。
+     */
+    void Cancel() {
+        if (m_ops) {
+            m_ops->cancel(m_storage);
+            Reset();
+        }
+    }
+
+    explicit operator bool() const noexcept { return m_ops != nullptr; }
+
+    void Reset() noexcept {
+        if (m_ops) {
+            m_ops->destroy(m_storage);
+            m_ops = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*cancel)(void* storage);
+        void (*move)(void* from, void* to) noexcept; // 移动到 to 并销毁 from
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template<typename Callable>
+    static constexpr bool FitsInline() {
+        return sizeof(Callable) <= kInlineSize
+            && alignof(Callable) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible<Callable>::value;
+    }
+
+    template<typename Callable>
+    static void CancelCallable(Callable& callable) {
+        if constexpr (TaskDetail::HasCancel<Callable>::value) {
+            callable.Cancel();
+        }
+    }
+
+    template<typename Callable>
+    struct InlineOps {
+        static Callable* Get(void* storage) { return std::launder(static_cast<Callable*>(storage)); }
+        static void Invoke(void* storage) { (*Get(storage))(); }
+        static void Cancel(void* storage) { CancelCallable(*Get(storage)); }
+        static void Move(void* from, void* to) noexcept {
+            new (to) Callable(std::move(*Get(from)));
+            Get(from)->~Callable();
+        }
+        static void Destroy(void* storage) noexcept { Get(storage)->~Callable(); }
+        static constexpr Ops ops = { &Invoke, &Cancel, &Move, &Destroy };
+    };
+
+    template<typename Callable>
+    struct HeapOps {
+        static Callable*& Get(void* storage) { return *std::launder(static_cast<Callable**>(storage)); }
+        static void Invoke(void* storage) { (*Get(storage))(); }
+        static void Cancel(void* storage) { CancelCallable(*Get(storage)); }
+        static void Move(void* from, void* to) noexcept { new (to) Callable*(Get(from)); }
+        static void Destroy(void* storage) noexcept { delete Get(storage); }
+        static constexpr Ops ops = { &Invoke, &Cancel, &Move, &Destroy };
+    };
+
+    alignas(std::max_align_t) unsigned char m_storage[kInlineSize];
+    const Ops* m_ops;
+};
+
+#endif // TASK_H
@@ -0,0 +1,389 @@
+#ifndef TASK_FUTURE_H
+#define TASK_FUTURE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "threads.h"
+
+// 支持延续 (continuation) 的 future：
+// 与 std::future 不同，可以用 Then 注册"完成后执行"的任务，用 WhenAll / WhenAny 组合多个 future，
+// 后续任务在前驱完成时才提交到线程池，等待期间不占用任何线程。
+// TaskFuture 可以拷贝 (类似 std::shared_future)，Get 返回结果的常量引用。
+
+template<typename T> class TaskFuture;
+template<typename T> class TaskPromise;
+
+namespace FutureDetail {
+
+    // 共享状态：结果 (或异常) 加上完成时要执行的回调
+    template<typename T>
+    struct State {
+        using Stored = typename std::conditional<std::is_void<T>::value, bool, T>::type;
+
+        std::mutex mutex;
+        std::condition_variable readyCondition;
+        bool ready = false;
+        std::optional<Stored> value;
+        std::exception_ptr error;
+        std::vector<Task> callbacks; // 在完成的线程上直接执行，应当很轻 (通常只是把任务提交到线程池)
+
+        template<typename... V>
+        void SetValue(V&&... v) {
+            std::vector<Task> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ready) throw std::logic_error("TaskPromise already satisfied");
+                value.emplace(std::forward<V>(v)...);
+                ready = true;
+                pending.swap(callbacks);
+            }
+            Complete(pending);
+        }
+
+        void SetException(std::exception_ptr e) {
+            std::vector<Task> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ready) throw std::logic_error("TaskPromise already satisfied");
+                error = e;
+                ready = true;
+                pending.swap(callbacks);
+            }
+            Complete(pending);
+        }
+
+        // 已完成时立即在当前线程执行回调
+        void OnReady(Task callback) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!ready) {
+                    callbacks.push_back(std::move(callback));
+                    return;
+                }
+            }
+            callback();
+        }
+
+        bool IsReady() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return ready;
+        }
+
+    private:
+        void Complete(std::vector<Task>& pending) {
+            readyCondition.notify_all();
+            for (Task& callback : pending) {
+                callback();
+            }
+        }
+    };
+
+    // 在线程池中执行 f(args...) 并把结果写入 state
+    template<typename R, typename F, typename... Args>
+    void Fulfill(State<R>& state, F& f, Args&&... args) {
+        try {
+            if constexpr (std::is_void<R>::value) {
+                f(std::forward<Args>(args)...);
+                state.SetValue(true);
+            }
+            else {
+                state.SetValue(f(std::forward<Args>(args)...));
+            }
+        }
+        catch (...) {
+            state.SetException(std::current_exception());
+        }
+    }
+
+    // 延续函数的返回类型：void future 的延续不接受参数
+    template<typename F, typename T>
+    struct ThenResult {
+        using type = typename std::invoke_result<F, const T&>::type;
+    };
+
+    template<typename F>
+    struct ThenResult<F, void> {
+        using type = typename std::invoke_result<F>::type;
+    };
+
+    // 延续任务：前驱成功后在线程池中执行；被取消而没有执行时延续的 future 得到 OperationCanceledError
+    template<typename T, typename R, typename F>
+    struct ContinuationTask {
+        std::shared_ptr<State<T>> state;
+        std::shared_ptr<State<R>> next;
+        F func;
+
+        void operator()() {
+            if constexpr (std::is_void<T>::value) {
+                Fulfill(*next, func);
+            }
+            else {
+                Fulfill(*next, func, static_cast<const T&>(*state->value));
+            }
+        }
+
+        void Cancel() {
+            next->SetException(std::make_exception_ptr(OperationCanceledError()));
+        }
+    };
+
+} // namespace FutureDetail
+
+template<typename T>
+class TaskFuture {
+public:
+    TaskFuture() = default;
+
+    /**
+     * @brief 是否关联了共享状态 (默认构造的 future 无效)。
+     */
+    bool Valid() const { return static_cast<bool>(m_state); }
+
+    /**
+     * @brief 结果是否已经可用 (不阻塞)。
+     */
+    bool IsReady() const { return m_state->IsReady(); }
+
+    /**
+     * @brief 等待完成。
+     * @param pool 非空且当前线程是该线程池的工作线程时，等待期间帮忙执行排队的任务，避免线程池饱和时互相等待而死锁。
+     */
+    void Wait(ThreadPool* pool = nullptr) const {
+        FutureDetail::State<T>& state = *m_state;
+        std::unique_lock<std::mutex> lock(state.mutex);
+        auto ready = [&state] { return state.ready; };
+        if (pool) {
+            pool->HelpWhileWaiting(lock, state.readyCondition, ready);
+        }
+        else {
+            state.readyCondition.wait(lock, ready);
+        }
+    }
+
+    /**
+     * @brief 等待并获取结果；任务抛出的异常在这里重新抛出。
+     * @param pool 见 Wait。
+     * @return 非 void 时返回结果的常量引用 (在 future 存在期间有效)。
+     */
+    decltype(auto) Get(ThreadPool* pool = nullptr) const {
+        Wait(pool);
+        if (m_state->error) {
+            std::rethrow_exception(m_state->error);
+        }
+        if constexpr (!std::is_void<T>::value) {
+            return static_cast<const T&>(*m_state->value);
+        }
+    }
+
+    /**
+     * @brief 注册延续：本 future 成功完成后，把 f(结果) (void 时为 f()) 提交到线程池执行。
+     * @param pool 执行延续的线程池。
+     * @param f 延续函数。
+     * @param options 延续任务的提交选项 (优先级等)。
+     * @return 延续结果的 future；本 future 失败时延续不执行，直接传递同一个异常。
+     */
+    template<typename F>
+    auto Then(ThreadPool& pool, F&& f, const TaskOptions& options = TaskOptions()) const {
+        using R = typename FutureDetail::ThenResult<F, T>::type;
+
+        auto next = std::allocate_shared<FutureDetail::State<R>>(PooledAllocator<char>());
+        ThreadPool* target = &pool;
+        m_state->OnReady(Task([state = m_state, next, target, options, func = std::forward<F>(f)]() mutable {
+            if (state->error) {
+                next->SetException(state->error);
+                return;
+            }
+            try {
+                target->post_with(options, FutureDetail::ContinuationTask<T, R, typename std::decay<F>::type>{ state, next, std::move(func) });
+            }
+            catch (...) {
+                next->SetException(std::current_exception()); // 线程池已停止或队列已满
+            }
+        }));
+        return TaskFuture<R>(std::move(next));
+    }
+
+private:
+    template<typename> friend class TaskFuture;
+    template<typename> friend class TaskPromise;
+    template<typename U> friend TaskFuture<typename std::conditional<std::is_void<U>::value, void, std::vector<U>>::type>
+        WhenAll(const std::vector<TaskFuture<U>>& futures);
+    template<typename U> friend TaskFuture<size_t> WhenAny(const std::vector<TaskFuture<U>>& futures);
+
+    explicit TaskFuture(std::shared_ptr<FutureDetail::State<T>> state) : m_state(std::move(state)) {}
+
+    std::shared_ptr<FutureDetail::State<T>> m_state;
+};
+
+// 手动完成的 future，用于把回调式接口接入 Then / WhenAll
+template<typename T>
+class TaskPromise {
+public:
+    TaskPromise() : m_state(std::allocate_shared<FutureDetail::State<T>>(PooledAllocator<char>())) {}
+
+    TaskFuture<T> GetFuture() const { return TaskFuture<T>(m_state); }
+
+    template<typename... V>
+    void SetValue(V&&... v) {
+        if constexpr (std::is_void<T>::value) {
+            static_assert(sizeof...(V) == 0, "TaskPromise<void>::SetValue takes no arguments");
+            m_state->SetValue(true);
+        }
+        else {
+            m_state->SetValue(std::forward<V>(v)...);
+        }
+    }
+
+    void SetException(std::exception_ptr e) { m_state->SetException(e); }
+
+private:
+    std::shared_ptr<FutureDetail::State<T>> m_state;
+};
+
+namespace FutureDetail {
+
+    // RunAsync 提交的任务：被取消而没有执行时 future 得到 OperationCanceledError
+    template<typename R, typename F, typename ArgsTuple>
+    struct AsyncTask {
+        TaskPromise<R> promise;
+        F func;
+        ArgsTuple boundArgs;
+
+        void operator()() {
+            try {
+                if constexpr (std::is_void<R>::value) {
+                    std::apply(func, boundArgs);
+                    promise.SetValue();
+                }
+                else {
+                    promise.SetValue(std::apply(func, boundArgs));
+                }
+            }
+            catch (...) {
+                promise.SetException(std::current_exception());
+            }
+        }
+
+        void Cancel() {
+            promise.SetException(std::make_exception_ptr(OperationCanceledError()));
+        }
+    };
+
+} // namespace FutureDetail
+
+/**
+ * @brief 把 f(args...) 提交到线程池，返回可以注册延续的 future。
+ * @param pool 线程池。
+ * @param options 提交选项 (优先级、取消令牌等)。
+ * @param f 要执行的函数。
+ * @param args 函数的参数。
+ */
+template<typename F, typename... Args>
+auto RunAsyncWith(ThreadPool& pool, const TaskOptions& options, F&& f, Args&&... args) {
+    using R = typename std::invoke_result<F, Args...>::type;
+    using TaskType = FutureDetail::AsyncTask<R, typename std::decay<F>::type, decltype(std::make_tuple(std::forward<Args>(args)...))>;
+    TaskPromise<R> promise;
+    TaskFuture<R> future = promise.GetFuture();
+    pool.post_with(options, TaskType{ promise, std::forward<F>(f), std::make_tuple(std::forward<Args>(args)...) });
+    return future;
+}
+
+/**
+ * @brief 以默认选项提交，见 RunAsyncWith。
+ */
+template<typename F, typename... Args>
+auto RunAsync(ThreadPool& pool, F&& f, Args&&... args) {
+    return RunAsyncWith(pool, TaskOptions(), std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+/**
+ * @brief 所有 future 都完成后完成。
+ * @return 非 void 时为按输入顺序排列的结果；任一输入失败时传递第一个 (按输入顺序) 失败的异常。
+ */
+template<typename T>
+TaskFuture<typename std::conditional<std::is_void<T>::value, void, std::vector<T>>::type>
+WhenAll(const std::vector<TaskFuture<T>>& futures) {
+    using R = typename std::conditional<std::is_void<T>::value, void, std::vector<T>>::type;
+
+    struct Join {
+        std::vector<TaskFuture<T>> inputs;
+        std::atomic<size_t> remaining;
+        TaskPromise<R> promise;
+
+        void Finish() {
+            for (const TaskFuture<T>& input : inputs) {
+                if (input.m_state->error) {
+                    promise.SetException(input.m_state->error);
+                    return;
+                }
+            }
+            if constexpr (std::is_void<T>::value) {
+                promise.SetValue();
+            }
+            else {
+                std::vector<T> values;
+                values.reserve(inputs.size());
+                for (const TaskFuture<T>& input : inputs) {
+                    values.push_back(*input.m_state->value);
+                }
+                promise.SetValue(std::move(values));
+            }
+        }
+    };
+
+    auto join = std::make_shared<Join>();
+    join->inputs = futures;
+    join->remaining.store(futures.size());
+    TaskFuture<R> result = join->promise.GetFuture();
+    if (futures.empty()) {
+        join->Finish();
+        return result;
+    }
+    for (const TaskFuture<T>& input : futures) {
+        input.m_state->OnReady(Task([join] {
+            if (join->remaining.fetch_sub(1) == 1) {
+                join->Finish();
+            }
+        }));
+    }
+    return result;
+}
+
+/**
+ * @brief 任一 future 完成 (成功或失败) 时完成。
+ * @return 最先完成的 future 在输入中的下标；输入为空时以 std::invalid_argument 失败。
+ */
+template<typename T>
+TaskFuture<size_t> WhenAny(const std::vector<TaskFuture<T>>& futures) {
+    struct Race {
+        std::atomic<bool> decided{ false };
+        TaskPromise<size_t> promise;
+    };
+
+    auto race = std::make_shared<Race>();
+    TaskFuture<size_t> result = race->promise.GetFuture();
+    if (futures.empty()) {
+        race->promise.SetException(std::make_exception_ptr(std::invalid_argument("WhenAny on empty input")));
+        return result;
+    }
+    for (size_t i = 0; i < futures.size(); ++i) {
+        futures[i].m_state->OnReady(Task([race, i] {
+            if (!race->decided.exchange(true)) {
+                race->promise.SetValue(i);
+            }
+        }));
+    }
+    return result;
+}
+
+#endif // TASK_FUTURE_H
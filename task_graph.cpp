@@ -0,0 +1,181 @@
+#define LOG_MODULE LogModule::Threads // 本文件的日志属于线程模块 (见 log.h)
+#include "task_graph.h"
+#include "log.h"
+#include "utils.h" // For Utf8ToWide
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+    // 一次执行的状态，节点信息从图中拷贝，执行期间图本身可以被修改或销毁
+    struct GraphRun {
+        struct RunNode {
+            std::function<void()> fn;
+            std::string name;
+            TaskOptions options;
+            std::vector<size_t> successors;
+            std::atomic<size_t> remaining{ 0 };  // 尚未结束的前驱数
+            std::atomic<bool> skipped{ false };   // 有前驱失败或被跳过
+        };
+
+        ThreadPool* pool = nullptr;
+        std::unique_ptr<RunNode[]> nodes;
+        std::atomic<size_t> unfinished{ 0 };
+        TaskPromise<void> promise;
+
+        std::mutex errorMutex;
+        std::exception_ptr firstError;
+    };
+
+    void Schedule(const std::shared_ptr<GraphRun>& run, size_t index);
+
+    // 节点结束 (执行完、失败或被跳过)：通知后继，最后一个节点结束时完成整个图
+    void Finish(const std::shared_ptr<GraphRun>& run, size_t index, bool failed) {
+        GraphRun::RunNode& node = run->nodes[index];
+        for (size_t successor : node.successors) {
+            GraphRun::RunNode& next = run->nodes[successor];
+            if (failed) {
+                next.skipped.store(true);
+            }
+            if (next.remaining.fetch_sub(1) == 1) {
+                Schedule(run, successor);
+            }
+        }
+
+        if (run->unfinished.fetch_sub(1) == 1) {
+            if (run->firstError) {
+                run->promise.SetException(run->firstError);
+            }
+            else {
+                run->promise.SetValue();
+            }
+        }
+    }
+
+    void RecordError(GraphRun& run, std::exception_ptr error) {
+        std::lock_guard<std::mutex> lock(run.errorMutex);
+        if (!run.firstError) {
+            run.firstError = error;
+        }
+    }
+
+    void Execute(const std::shared_ptr<GraphRun>& run, size_t index) {
+        GraphRun::RunNode& node = run->nodes[index];
+        bool failed = false;
+        try {
+            node.fn();
+        }
+        catch (const std::exception& e) {
+            LOG_WARNING(L"Task graph node '", Utf8ToWide(node.name).c_str(), L"' failed: ", Utf8ToWide(e.what()).c_str());
+            RecordError(*run, std::current_exception());
+            failed = true;
+        }
+        catch (...) {
+            LOG_WARNING(L"Task graph node '", Utf8ToWide(node.name).c_str(), L"' failed with unknown exception.");
+            RecordError(*run, std::current_exception());
+            failed = true;
+        }
+        Finish(run, index, failed);
+    }
+
+    // 提交到线程池的节点任务；被取消 (令牌已取消或线程池关闭) 时按失败处理，下游节点被跳过
+    struct NodeTask {
+        std::shared_ptr<GraphRun> run;
+        size_t index;
+
+        void operator()() { Execute(run, index); }
+
+        void Cancel() {
+            RecordError(*run, std::make_exception_ptr(OperationCanceledError()));
+            Finish(run, index, true);
+        }
+    };
+
+    void Schedule(const std::shared_ptr<GraphRun>& run, size_t index) {
+        GraphRun::RunNode& node = run->nodes[index];
+        if (node.skipped.load()) {
+            LOG_DEBUG(L"Task graph node '", Utf8ToWide(node.name).c_str(), L"' skipped after upstream failure.");
+            Finish(run, index, true);
+            return;
+        }
+        try {
+            run->pool->post_with(node.options, NodeTask{ run, index });
+        }
+        catch (...) {
+            RecordError(*run, std::current_exception()); // 线程池已停止或队列已满
+            Finish(run, index, true);
+        }
+    }
+
+} // namespace
+
+TaskGraph::NodeId TaskGraph::Add(std::function<void()> fn, const std::string& name, const TaskOptions& options) {
+    Node node;
+    node.fn = std::move(fn);
+    node.name = name;
+    node.options = options;
+    m_nodes.push_back(std::move(node));
+    return m_nodes.size() - 1;
+}
+
+void TaskGraph::Precede(NodeId before, NodeId after) {
+    if (before >= m_nodes.size() || after >= m_nodes.size() || before == after) {
+        throw std::invalid_argument("TaskGraph::Precede: invalid node id");
+    }
+    m_nodes[before].successors.push_back(after);
+    ++m_nodes[after].predecessorCount;
+}
+
+bool TaskGraph::HasCycle() const {
+    // Kahn 算法：能按拓扑序取出所有节点则无环
+    std::vector<size_t> remaining(m_nodes.size());
+    std::vector<NodeId> ready;
+    for (NodeId i = 0; i < m_nodes.size(); ++i) {
+        remaining[i] = m_nodes[i].predecessorCount;
+        if (remaining[i] == 0) ready.push_back(i);
+    }
+    size_t visited = 0;
+    while (!ready.empty()) {
+        NodeId current = ready.back();
+        ready.pop_back();
+        ++visited;
+        for (NodeId successor : m_nodes[current].successors) {
+            if (--remaining[successor] == 0) ready.push_back(successor);
+        }
+    }
+    return visited != m_nodes.size();
+}
+
+TaskFuture<void> TaskGraph::Run(ThreadPool& pool) const {
+    if (HasCycle()) {
+        throw std::logic_error("TaskGraph contains a cycle");
+    }
+
+    auto run = std::make_shared<GraphRun>();
+    run->pool = &pool;
+    run->nodes.reset(new GraphRun::RunNode[m_nodes.size()]);
+    run->unfinished.store(m_nodes.size());
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        GraphRun::RunNode& node = run->nodes[i];
+        node.fn = m_nodes[i].fn;
+        node.name = m_nodes[i].name;
+        node.options = m_nodes[i].options;
+        node.successors = m_nodes[i].successors;
+        node.remaining.store(m_nodes[i].predecessorCount);
+    }
+
+    TaskFuture<void> result = run->promise.GetFuture();
+    if (m_nodes.empty()) {
+        run->promise.SetValue();
+        return result;
+    }
+    for (size_t i = 0; i < m_nodes.size(); ++i) {
+        if (m_nodes[i].predecessorCount == 0) {
+            Schedule(run, i);
+        }
+    }
+    return result;
+}
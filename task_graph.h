@@ -0,0 +1,59 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <string>
+#include <vector>
+#include <functional> // For std::function
+
+#include "task_future.h"
+
+// 任务依赖图：
+// 先用 Add 添加节点、用 Precede 声明先后关系，再用 Run 在线程池上执行。
+// 节点在全部前驱完成后才提交到线程池，等待前驱期间不占用线程。
+// 某个节点抛出异常时，依赖它的节点 (直接或间接) 被跳过，其余分支照常执行；
+// Run 返回的 future 在所有节点结束后完成，并传递第一个失败节点的异常。
+// 同一个图可以多次执行，执行期间修改图不影响正在进行的执行。
+
+class TaskGraph {
+public:
+    using NodeId = size_t;
+
+    /**
+     * @brief 添加一个节点。
+     * @param fn 节点要执行的函数。
+     * @param name 节点名称 (用于日志)。
+     * @param options 提交选项 (优先级等)。
+     * @return 节点编号。
+     */
+    NodeId Add(std::function<void()> fn, const std::string& name = std::string(), const TaskOptions& options = TaskOptions());
+
+    /**
+     * @brief 声明 before 完成后才能执行 after。
+     */
+    void Precede(NodeId before, NodeId after);
+
+    /**
+     * @brief 在线程池上执行整个图。
+     * @param pool 线程池。
+     * @return 所有节点结束后完成的 future。
+     * @throw std::logic_error 图中存在环。
+     */
+    TaskFuture<void> Run(ThreadPool& pool) const;
+
+    size_t Size() const { return m_nodes.size(); }
+
+private:
+    struct Node {
+        std::function<void()> fn;
+        std::string name;
+        TaskOptions options;
+        std::vector<NodeId> successors;
+        size_t predecessorCount = 0;
+    };
+
+    bool HasCycle() const;
+
+    std::vector<Node> m_nodes;
+};
+
+#endif // TASK_GRAPH_H
@@ -0,0 +1,98 @@
+#include "task_group.h"
+
+TaskGroup::TaskGroup(ThreadPool& pool, const TaskOptions& options)
+    : m_pool(pool),
+    m_options(options),
+    m_pending(0),
+    m_waiting(false) {
+    m_options.cancellation = m_source.GetToken();
+    // 上级令牌已经取消时立即取消
+    m_parentRegistration = options.cancellation.Register([this] { Cancel(); });
+}
+
+TaskGroup::~TaskGroup() {
+    m_parentRegistration.Unregister();
+    bool pending;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pending = m_pending > 0;
+    }
+    if (pending) {
+        Cancel();
+        try {
+            Wait();
+        }
+        catch (...) {
+            // 析构函数不传播子任务的异常
+        }
+    }
+}
+
+void TaskGroup::RunClaimed(Child& child) {
+    if (m_source.IsCancellationRequested()) {
+        SkipClaimed(child);
+        return;
+    }
+    try {
+        child.Invoke(m_options.cancellation);
+    }
+    catch (...) {
+        RecordError(std::current_exception());
+    }
+    Finish(child);
+}
+
+void TaskGroup::SkipClaimed(Child& child) {
+    RecordError(std::make_exception_ptr(OperationCanceledError()));
+    Finish(child);
+}
+
+void TaskGroup::RecordError(std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_error) {
+            m_error = error;
+        }
+    }
+    // 锁外取消：回调可能打断其他子任务中的阻塞操作
+    m_source.Cancel();
+}
+
+void TaskGroup::Finish(Child& child) {
+    child.state.store(Child::Done);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_pending;
+    if (m_pending == 0 || m_waiting) {
+        m_condition.notify_all();
+    }
+}
+
+void TaskGroup::Wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_waiting = true;
+    while (m_pending > 0) {
+        // 先执行还没被取走的子任务 (后提交的先执行，数据更可能还在缓存中)
+        if (!m_children.empty()) {
+            std::shared_ptr<Child> child = std::move(m_children.back());
+            m_children.pop_back();
+            lock.unlock();
+            if (child->Claim()) {
+                RunClaimed(*child);
+            }
+            lock.lock();
+            continue;
+        }
+
+        // 剩下的子任务都在其他线程上执行：等待它们结束或有新的子任务提交
+        m_pool.HelpWhileWaiting(lock, m_condition, [this] { return m_pending == 0 || !m_children.empty(); });
+    }
+    m_waiting = false;
+    m_children.clear(); // 其余记录都已被线程池中的任务执行过
+    std::exception_ptr error = std::move(m_error);
+    m_error = nullptr;
+    lock.unlock();
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
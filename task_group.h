@@ -0,0 +1,154 @@
+#ifndef TASK_GROUP_H
+#define TASK_GROUP_H
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "threads.h"
+
+// 结构化并发的任务组：
+// Spawn 把子任务提交到线程池，Wait 等待所有子任务结束。等待期间当前线程先执行还没被取走的子任务，
+// 工作线程还会帮忙执行线程池中的其他任务，因此在线程池饱和或子任务嵌套等待时也不会死锁。
+// 第一个失败的子任务的异常由 Wait 重新抛出，同时取消任务组：尚未开始的子任务被跳过，
+// 正在执行的子任务可以通过传入的 CancellationToken 得知。
+//
+//   TaskGroup group(pool);
+//   for (auto& item : items) group.Spawn([&item] { Process(item); });
+//   group.Wait();
+
+class TaskGroup {
+public:
+    /**
+     * @brief 创建任务组。
+     * @param pool 执行子任务的线程池，生命周期须长于任务组。
+     * @param options 子任务的提交选项 (优先级等)；options.cancellation 被取消时任务组随之取消。
+     */
+    explicit TaskGroup(ThreadPool& pool, const TaskOptions& options = TaskOptions());
+
+    /**
+     * @brief 还有未结束的子任务时 (例如没有调用 Wait 就因异常离开作用域)，先取消任务组再等待它们结束。
+     *        子任务的异常被忽略。
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * @brief 提交一个子任务。
+     * @param f 无参函数，或接受 const CancellationToken& 的函数 (令牌在任务组取消时被取消)。
+     * @note 可以在子任务内部继续 Spawn。任务组已取消时子任务不会执行。
+     *       线程池已停止或队列已满 (Fail 策略) 时子任务留给 Wait 在当前线程执行。
+     */
+    template<typename F>
+    void Spawn(F&& f) {
+        using Fn = typename std::decay<F>::type;
+        std::shared_ptr<Child> child = std::allocate_shared<ChildCall<Fn>>(PooledAllocator<char>(), this, std::forward<F>(f));
+        bool notify;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_pending;
+            m_children.push_back(child);
+            notify = m_waiting;
+        }
+        if (notify) {
+            m_condition.notify_all(); // 让正在 Wait 的线程直接执行它
+        }
+        try {
+            m_pool.post_with(m_options, ChildTask{ std::move(child) });
+        }
+        catch (const std::exception&) {
+            // 线程池已停止或队列已满：Wait 时在当前线程执行
+        }
+    }
+
+    /**
+     * @brief 等待所有子任务结束 (包括等待期间新提交的)。
+     * @throw 第一个失败的子任务抛出的异常；任务组被取消而跳过了子任务时抛出 OperationCanceledError。
+     * @note Wait 返回后可以继续 Spawn 并再次 Wait，但已取消的任务组不会再执行新的子任务。
+     */
+    void Wait();
+
+    /**
+     * @brief 取消任务组：尚未开始的子任务被跳过，令牌通知正在执行的子任务。
+     */
+    void Cancel() { m_source.Cancel(); }
+
+    bool IsCanceled() const { return m_source.IsCancellationRequested(); }
+
+    /**
+     * @brief 任务组的取消令牌 (子任务失败、Cancel 或上级令牌取消时被取消)。
+     */
+    CancellationToken GetToken() const { return m_source.GetToken(); }
+
+private:
+    // 子任务：线程池中的任务和 Wait 谁先把状态从 Pending 改为 Claimed 谁执行
+    struct Child {
+        enum : int { Pending = 0, Claimed = 1, Done = 2 };
+
+        explicit Child(TaskGroup* owner) : group(owner) {}
+        virtual ~Child() = default;
+        virtual void Invoke(const CancellationToken& cancellation) = 0;
+
+        bool Claim() {
+            int expected = Pending;
+            return state.compare_exchange_strong(expected, Claimed);
+        }
+
+        std::atomic<int> state{ Pending };
+        TaskGroup* group; // 只有抢到执行权后才能访问：任务组会等待所有子任务结束
+    };
+
+    template<typename Fn>
+    struct ChildCall : Child {
+        template<typename F>
+        ChildCall(TaskGroup* owner, F&& f) : Child(owner), fn(std::forward<F>(f)) {}
+
+        void Invoke(const CancellationToken& cancellation) override {
+            if constexpr (std::is_invocable<Fn&, const CancellationToken&>::value) {
+                fn(cancellation);
+            }
+            else {
+                fn();
+            }
+        }
+
+        Fn fn;
+    };
+
+    // 提交到线程池的任务；线程池放弃它时 (令牌已取消或线程池关闭) 子任务按取消处理
+    struct ChildTask {
+        std::shared_ptr<Child> child;
+        void operator()() {
+            if (child->Claim()) child->group->RunClaimed(*child);
+        }
+        void Cancel() {
+            if (child->Claim()) child->group->SkipClaimed(*child);
+        }
+    };
+
+    void RunClaimed(Child& child);
+    void SkipClaimed(Child& child);
+    void RecordError(std::exception_ptr error);
+    void Finish(Child& child);
+
+    ThreadPool& m_pool;
+    CancellationSource m_source;
+    TaskOptions m_options;                          // 子任务的提交选项，令牌换成 m_source 的
+    CancellationRegistration m_parentRegistration;
+
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<std::shared_ptr<Child>> m_children; // 可能还没被取走的子任务，Wait 从末尾开始尝试执行
+    size_t m_pending;                               // 尚未结束的子任务数
+    bool m_waiting;
+    std::exception_ptr m_error;                     // 第一个失败的子任务的异常
+};
+
+#endif // TASK_GROUP_H
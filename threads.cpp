@@ -1,82 +1,994 @@
-#include "threads.h"
-#include "log.h"
-// <deque> is now included in threads.h
-
-ThreadPool::ThreadPool(size_t numThreads) : m_stop(false) {
-    size_t hardwareThreads = std::thread::hardware_concurrency();
-    size_t threadsToCreate = (numThreads == 0) ? (hardwareThreads == 0 ? 2 : hardwareThreads) : numThreads;
-    // ޷Ӳ߳Ĭϴ2
-
-    LOG_INFO(L"Initializing ThreadPool with ", threadsToCreate, L" threads.");
-
-    m_workers.reserve(threadsToCreate);
-    for (size_t i = 0; i < threadsToCreate; ++i) {
-        m_workers.emplace_back(&ThreadPool::worker_thread, this);
-    }
-}
-
-ThreadPool::~ThreadPool() {
-    LOG_INFO(L"Shutting down ThreadPool...");
-    {
-        std::unique_lock<std::mutex> lock(m_queueMutex);
-        m_stop = true; // ֹͣ־
-    }
-    m_condition.notify_all(); // еȴ߳
-
-    for (std::thread& worker : m_workers) {
-        if (worker.joinable()) {
-            worker.join(); // ȴÿ߳̽
-        }
-    }
-    LOG_INFO(L"ThreadPool shut down complete.");
-}
-
-void ThreadPool::worker_thread() {
-    LOG_DEBUG(L"Worker thread started. ID: ", std::this_thread::get_id());
-    while (true) {
-        std::function<void()> task;
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-            // ȴвΪգֹ̳߳ͣ
-            m_condition.wait(lock, [this] { return m_stop.load() || !m_tasks.empty(); }); // Use m_stop.load() for atomic
-
-            // ֹ̳߳ͣΪգ˳߳
-            if (m_stop.load() && m_tasks.empty()) { // Use m_stop.load()
-                LOG_DEBUG(L"Worker thread stopping. ID: ", std::this_thread::get_id());
-                return;
-            }
-
-            // ȡ
-            if (!m_tasks.empty()) {
-                task = std::move(m_tasks.front()); // C2672 std::move should be fine with std::function
-                m_tasks.pop_front();
-            }
-            else {
-                continue;
-            }
-        }
-
-        if (task) {
-            try {
-                LOG_DEBUG(L"Worker thread ", std::this_thread::get_id(), L" executing task.");
-                task();
-                LOG_DEBUG(L"Worker thread ", std::this_thread::get_id(), L" finished task.");
-            }
-            catch (const std::exception& e) {
-                LOG_ERROR(L"Exception caught in worker thread while executing task: ", WideToUtf8(std::wstring(L"") + e.what()).c_str());
-            }
-            catch (...) {
-                LOG_ERROR(L"Unknown exception caught in worker thread while executing task.");
-            }
-        }
-    }
-}
-
-size_t ThreadPool::GetTaskQueueSize() const {
-    // C2665 for unique_lock: const member functions need a mutable mutex or careful handling.
-    // However, m_queueMutex is not declared mutable.
-    // For a const method that locks, the mutex itself should be locked in a way that doesn't modify the logical state
-    // of the ThreadPool from the caller's perspective. Accessing m_tasks.size() is a read operation.
-    std::unique_lock<std::mutex> lock(m_queueMutex); // This should be fine. The error might have been a cascade.
-    return m_tasks.size();
-}
+#define LOG_MODULE LogModule::Threads // 本文件的日志属于线程模块 (见 log.h)
+#include "threads.h"
+#include "log.h"
+#include "utils.h" // For Utf8ToWide
+#include "config.h"
+// <deque> is now included in threads.h
+
+#include <chrono>
+#include <cmath>   // For std::ceil
+#include <cstring> // For strcmp
+#include <bit>     // For std::bit_width
+
+// 当前线程所属的线程池及其在线程池中的编号 (非工作线程为 nullptr)
+static thread_local ThreadPool* t_currentPool = nullptr;
+static thread_local size_t t_workerIndex = 0;
+
+// 连续忙碌的工作线程至少每隔这么久把忙碌时间计入统计
+static const std::chrono::milliseconds kBusyFlushInterval(100);
+
+// 当前线程已使用的 CPU 时间 (用户态 + 内核态，微秒)
+static unsigned long long CurrentThreadCpuUs() {
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (!GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        return 0;
+    }
+    ULARGE_INTEGER kernel, user;
+    kernel.LowPart = kernelTime.dwLowDateTime;
+    kernel.HighPart = kernelTime.dwHighDateTime;
+    user.LowPart = userTime.dwLowDateTime;
+    user.HighPart = userTime.dwHighDateTime;
+    return (kernel.QuadPart + user.QuadPart) / 10; // 100 纳秒为单位
+}
+
+ThreadPool::ThreadPool(size_t numThreads)
+    : ThreadPool([numThreads] {
+        ThreadPoolOptions options;
+        options.numThreads = numThreads;
+        return options;
+    }()) {
+}
+
+ThreadPool::ThreadPool(const ThreadPoolOptions& options)
+    : m_scheduling(options.scheduling),
+    m_fullPolicy(options.fullPolicy),
+    m_reservedWorkers(0),
+    m_starvationLimit((std::max)(options.starvationLimit, 1u)),
+    m_waitStrategy(options.waitStrategy),
+    m_spinLimit((std::max)(options.spinLimit, std::chrono::microseconds(1))),
+    m_numaAwareStealing(false),
+    m_stop(false),
+    m_discardPending(false),
+    m_runningThreads(0),
+    m_pendingTasks(0),
+    m_sleepingWorkers(0),
+    m_sleepingReserved(0),
+    m_spinningWorkers(0),
+    m_blockedProducers(0),
+    m_minWorkers(0),
+    m_maxWorkers(0),
+    m_idleTimeout(options.idleTimeout),
+    m_growthThreshold(options.growthWaitThreshold),
+    m_liveWorkers(0),
+    m_lastStartTicks(Clock::now().time_since_epoch().count()),
+    m_monitorSleeping(false),
+    m_tasksRun(0),
+    m_busyUs(0),
+    m_cpuUs(0),
+    m_tags(new TagSlot[kMaxTaskTags]) {
+    m_tags[0].name.store("");
+    m_tags[kMaxTaskTags - 1].name.store("(other)");
+    Start(options);
+}
+
+void ThreadPool::Start(const ThreadPoolOptions& options) {
+    size_t hardwareThreads = std::thread::hardware_concurrency();
+    size_t threadsToCreate = (options.numThreads == 0) ? (hardwareThreads == 0 ? 2 : hardwareThreads) : options.numThreads;
+    // 如果无法检测硬件线程数，默认创建2个
+
+    // 至少保留一个普通线程，否则 Normal / Background 任务永远得不到执行
+    m_reservedWorkers = (std::min)(options.reservedInteractiveWorkers, threadsToCreate - 1);
+
+    // 预留线程不会退出，因此最少线程数至少比预留线程多一个
+    m_minWorkers = options.minThreads ? options.minThreads : threadsToCreate;
+    m_minWorkers = (std::max)(m_minWorkers, m_reservedWorkers + 1);
+    m_maxWorkers = (std::max)(options.maxThreads ? options.maxThreads : threadsToCreate, m_minWorkers);
+    threadsToCreate = (std::min)((std::max)(threadsToCreate, m_minWorkers), m_maxWorkers);
+
+    LOG_INFO(L"Initializing ThreadPool with ", threadsToCreate, L" threads (", m_minWorkers, L"-", m_maxWorkers, L", ",
+        (m_scheduling == SchedulingMode::WorkStealing ? L"work-stealing" : L"shared queue"), L", ",
+        (options.injectionQueue == InjectionQueueType::LockFree ? L"lock-free" : L"locked"), L" injection queue, ",
+        m_reservedWorkers, L" reserved for interactive tasks).");
+
+    if (options.injectionQueue == InjectionQueueType::LockFree) {
+        size_t capacity = (std::max)(options.injectionQueueCapacity, static_cast<size_t>(2));
+        for (Lane& lane : m_lanes) {
+            lane.lockFreeTasks.reset(new BoundedMpmcQueue<PendingTask>(capacity));
+        }
+    }
+
+    if (m_scheduling == SchedulingMode::WorkStealing) {
+        m_localQueues.reserve(m_maxWorkers);
+        for (size_t i = 0; i < m_maxWorkers; ++i) {
+            m_localQueues.emplace_back(new WorkerQueue());
+        }
+    }
+
+    if (options.pinWorkers) {
+        const CpuTopology::Topology& topology = CpuTopology::Get();
+        m_placement = CpuTopology::PlanPlacement(topology, m_maxWorkers);
+        m_numaAwareStealing = topology.nodeCount > 1 && m_localQueues.size() > 1;
+        LOG_INFO(L"Pinning ThreadPool workers to cores (", topology.coreCount, L" cores, ", topology.nodeCount, L" NUMA nodes",
+            (m_numaAwareStealing ? L", NUMA-aware stealing" : L""), L").");
+    }
+
+    m_workers.resize(m_maxWorkers);
+    m_workerCounters.reset(new WorkerCounters[m_maxWorkers]);
+    {
+        std::lock_guard<std::mutex> lock(m_elasticMutex);
+        for (size_t i = 0; i < threadsToCreate; ++i) {
+            SpawnWorker(i);
+        }
+    }
+
+    if (m_maxWorkers > m_minWorkers) {
+        m_monitor = std::thread(&ThreadPool::monitor_thread, this);
+    }
+
+    // I/O 执行器：线程大部分时间在等待，空闲时退到 1 个，全部阻塞时按需增加
+    if (options.ioThreads > 0) {
+        ThreadPoolOptions ioOptions;
+        ioOptions.numThreads = options.ioThreads;
+        ioOptions.minThreads = 1;
+        ioOptions.maxThreads = (std::max)(options.ioMaxThreads, options.ioThreads);
+        ioOptions.idleTimeout = options.idleTimeout;
+        ioOptions.growthWaitThreshold = options.growthWaitThreshold;
+        LOG_INFO(L"Creating blocking I/O executor for the ThreadPool.");
+        m_ioExecutor.reset(new ThreadPool(ioOptions));
+    }
+}
+
+ThreadPoolOptions ThreadPool::LoadOptions(const Config& config, const ThreadPoolOptions& defaults) {
+    const wchar_t* section = L"ThreadPool";
+    ThreadPoolOptions options = defaults;
+    options.numThreads = static_cast<size_t>((std::max)(config.GetInt(section, L"Threads", static_cast<int>(defaults.numThreads)), 0));
+    options.minThreads = static_cast<size_t>((std::max)(config.GetInt(section, L"MinThreads", static_cast<int>(defaults.minThreads)), 0));
+    options.maxThreads = static_cast<size_t>((std::max)(config.GetInt(section, L"MaxThreads", static_cast<int>(defaults.maxThreads)), 0));
+    options.reservedInteractiveWorkers = static_cast<size_t>((std::max)(
+        config.GetInt(section, L"ReservedInteractiveWorkers", static_cast<int>(defaults.reservedInteractiveWorkers)), 0));
+
+    int idleSeconds = config.GetInt(section, L"IdleTimeoutSeconds", static_cast<int>(defaults.idleTimeout.count() / 1000));
+    options.idleTimeout = std::chrono::seconds((std::max)(idleSeconds, 1));
+    int growthMs = config.GetInt(section, L"GrowthWaitMs", static_cast<int>(defaults.growthWaitThreshold.count()));
+    options.growthWaitThreshold = std::chrono::milliseconds((std::max)(growthMs, 10));
+    options.ioThreads = static_cast<size_t>((std::max)(config.GetInt(section, L"IoThreads", static_cast<int>(defaults.ioThreads)), 0));
+    options.ioMaxThreads = static_cast<size_t>((std::max)(config.GetInt(section, L"IoMaxThreads", static_cast<int>(defaults.ioMaxThreads)), 0));
+
+    std::wstring wait = config.GetString(section, L"WaitStrategy", L"");
+    if (wait == L"Block") options.waitStrategy = WaitStrategy::Block;
+    else if (wait == L"Spin") options.waitStrategy = WaitStrategy::Spin;
+    else if (wait == L"Yield") options.waitStrategy = WaitStrategy::Yield;
+    else if (wait == L"SpinThenPark") options.waitStrategy = WaitStrategy::SpinThenPark;
+    else if (!wait.empty()) LOG_WARNING(L"Unknown [ThreadPool] WaitStrategy: ", wait.c_str());
+    int spinUs = config.GetInt(section, L"SpinMicroseconds", static_cast<int>(defaults.spinLimit.count()));
+    options.spinLimit = std::chrono::microseconds((std::max)(spinUs, 1));
+    options.pinWorkers = config.GetBool(section, L"PinWorkers", defaults.pinWorkers);
+
+    // 修正不合理的配置
+    if (options.maxThreads && options.minThreads > options.maxThreads) {
+        options.maxThreads = options.minThreads;
+    }
+    return options;
+}
+
+ThreadPool::~ThreadPool() {
+    LOG_INFO(L"Shutting down ThreadPool...");
+    StopAccepting();
+
+    // 停止后不会再创建新线程；在锁外 join，退出中的线程可能还需要 m_elasticMutex
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(m_elasticMutex);
+        for (WorkerSlot& slot : m_workers) {
+            if (slot.thread.joinable()) {
+                threads.push_back(std::move(slot.thread));
+            }
+        }
+    }
+    for (std::thread& worker : threads) {
+        worker.join(); // 等待每个工作线程结束
+    }
+
+    ExecutorStats stats = GetExecutorStats();
+    LOG_INFO(L"ThreadPool ran ", stats.tasksRun, L" tasks: busy ", static_cast<long long>(stats.busyMs), L" ms, computing ",
+        static_cast<long long>(stats.computeMs), L" ms, blocked ", static_cast<long long>(stats.blockedMs), L" ms.");
+    for (const TaskTagStats& tag : GetStatsSnapshot().tags) {
+        LOG_INFO(L"  Tasks [", (tag.tag.empty() ? std::wstring(L"untagged") : Utf8ToWide(tag.tag)).c_str(), L"]: ", tag.queueWait.count,
+            L" started, wait avg ", tag.queueWait.AverageMs(), L" ms / p99 ", tag.queueWait.PercentileMs(0.99),
+            L" ms, run avg ", tag.run.AverageMs(), L" ms / p99 ", tag.run.PercentileMs(0.99), L" ms.");
+    }
+    LOG_INFO(L"ThreadPool shut down complete.");
+}
+
+void ThreadPool::StopAccepting() {
+    {
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        m_stop = true; // 设置停止标志
+    }
+    m_condition.notify_all(); // 唤醒所有等待的线程
+    m_reservedCondition.notify_all();
+    {
+        std::lock_guard<std::mutex> lock(m_spaceMutex);
+    }
+    m_spaceCondition.notify_all(); // 唤醒等待队列空位的生产者
+    {
+        std::lock_guard<std::mutex> lock(m_monitorMutex);
+    }
+    m_monitorCondition.notify_all();
+    if (m_monitor.joinable()) {
+        m_monitor.join();
+    }
+
+    // 停止计时线程：尚未到期的定时任务被取消 (enqueue_after 的 future 抛出 OperationCanceledError)
+    TimerWheel* timers;
+    {
+        std::lock_guard<std::mutex> lock(m_timerMutex);
+        timers = m_timers.get();
+    }
+    if (timers) {
+        timers->Stop();
+    }
+}
+
+bool ThreadPool::Shutdown(std::chrono::milliseconds timeout) {
+    Clock::time_point deadline = Clock::now() + timeout;
+    LOG_INFO(L"Shutting down ThreadPool (timeout ", timeout.count(), L" ms)...");
+
+    // 先让取出的任务改为放弃，再停止：工作线程退出前会把剩余任务全部取出并放弃
+    m_discardPending.store(true);
+    StopAccepting();
+    m_shutdownSource.Cancel(); // 正在执行的任务通过令牌得知 (例如中断网络请求)
+
+    // 所有工作线程都卡在任务里时，由当前线程清空注入队列 (以及可窃取的本地队列)
+    size_t discarded = 0;
+    while (TryRunPendingTask()) {
+        ++discarded;
+    }
+    if (discarded > 0) {
+        LOG_INFO(L"Discarded ", discarded, L" queued tasks during shutdown.");
+    }
+
+    // 计算任务可能在等待 I/O 任务的结果，先关闭 I/O 执行器 (共用同一个时限)
+    bool ioStopped = true;
+    if (m_ioExecutor) {
+        Clock::duration remaining = (std::max)(deadline - Clock::now(), Clock::duration::zero());
+        ioStopped = m_ioExecutor->Shutdown(std::chrono::duration_cast<std::chrono::milliseconds>(remaining));
+    }
+
+    bool allExited;
+    {
+        std::unique_lock<std::mutex> lock(m_exitMutex);
+        allExited = m_exitCondition.wait_until(lock, deadline, [this] { return m_runningThreads == 0; });
+    }
+
+    // 只 join 已经退出的线程，不会超过时限；其余的留给析构函数
+    std::vector<std::thread> exited;
+    {
+        std::lock_guard<std::mutex> elasticLock(m_elasticMutex);
+        std::lock_guard<std::mutex> exitLock(m_exitMutex);
+        for (WorkerSlot& slot : m_workers) {
+            if (slot.exited && slot.thread.joinable()) {
+                exited.push_back(std::move(slot.thread));
+            }
+        }
+    }
+    for (std::thread& worker : exited) {
+        worker.join();
+    }
+
+    if (!allExited) {
+        std::lock_guard<std::mutex> lock(m_exitMutex);
+        LOG_WARNING(L"ThreadPool shutdown timed out; ", m_runningThreads, L" worker threads are still running tasks.");
+        return false;
+    }
+    if (!ioStopped) {
+        return false;
+    }
+    LOG_INFO(L"ThreadPool shut down complete.");
+    return true;
+}
+
+void ThreadPool::OnWorkerExit(size_t index) {
+    WorkerCounters& counters = m_workerCounters[index];
+    Clock::rep since = counters.aliveSince.exchange(0, std::memory_order_relaxed);
+    counters.aliveUs.fetch_add(static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - Clock::time_point(Clock::duration(since))).count()),
+        std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(m_exitMutex);
+    m_workers[index].exited = true;
+    --m_runningThreads;
+    m_exitCondition.notify_all();
+}
+
+bool ThreadPool::IsWorkerThread() const {
+    return t_currentPool == this;
+}
+
+bool ThreadPool::PushInjection(PendingTask& pending) {
+    Lane& lane = GetLane(pending.priority);
+    if (lane.lockFreeTasks) {
+        return lane.lockFreeTasks->TryPush(std::move(pending));
+    }
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    lane.tasks.emplace_back(std::move(pending)); // C2065 for m_tasks was due to deque not being declared.
+    return true;
+}
+
+bool ThreadPool::PopInjection(TaskPriority priority, PendingTask& outTask) {
+    Lane& lane = GetLane(priority);
+    if (lane.depth.load() == 0) {
+        return false; // 快速路径：该优先级没有排队的任务，不碰队列
+    }
+    if (lane.lockFreeTasks) {
+        if (!lane.lockFreeTasks->TryPop(outTask)) {
+            return false;
+        }
+        // 有生产者在等待空位时才需要加锁通知 (生产者可能在等待不同优先级的队列)
+        if (m_blockedProducers.load() > 0) {
+            { std::lock_guard<std::mutex> lock(m_spaceMutex); }
+            m_spaceCondition.notify_all();
+        }
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    if (lane.tasks.empty()) {
+        return false;
+    }
+    outTask = std::move(lane.tasks.front());
+    lane.tasks.pop_front();
+    return true;
+}
+
+void ThreadPool::WaitForInjectionSpace(TaskPriority priority) {
+    const BoundedMpmcQueue<PendingTask>& queue = *GetLane(priority).lockFreeTasks;
+    m_blockedProducers.fetch_add(1);
+    {
+        std::unique_lock<std::mutex> lock(m_spaceMutex);
+        // 超时只是兜底：出队通知与这里的判断之间没有共同的锁
+        m_spaceCondition.wait_for(lock, std::chrono::milliseconds(1), [this, &queue] {
+            return m_stop.load() || queue.SizeApprox() < queue.Capacity();
+        });
+    }
+    m_blockedProducers.fetch_sub(1);
+}
+
+void ThreadPool::Submit(Task task, const TaskOptions& options) {
+    // 不允许在线程池停止后添加新任务
+    if (m_stop.load()) {
+        throw std::runtime_error("enqueue on stopped ThreadPool");
+    }
+
+    if (options.blocking && m_ioExecutor) {
+        m_ioExecutor->Submit(std::move(task), options);
+        return;
+    }
+
+    PendingTask pending;
+    pending.task = std::move(task);
+    pending.priority = options.priority;
+    pending.tag = options.tag ? ResolveTag(options.tag) : 0;
+    pending.enqueuedAt = Clock::now();
+    pending.cancellation = options.cancellation;
+    Lane& lane = GetLane(options.priority);
+
+    // 先增加计数再让任务可见：取走任务的线程随后减少计数，计数不会出现负值。
+    // 计数与休眠线程数都是 seq_cst，因此要么这里看到休眠线程并唤醒它，要么该线程在休眠前看到计数不为 0
+    m_pendingTasks.fetch_add(1);
+    lane.depth.fetch_add(1);
+    if (m_scheduling == SchedulingMode::WorkStealing && t_currentPool == this && options.priority == TaskPriority::Normal) {
+        // 工作线程内部提交的普通任务：放入自己的本地队列，不需要任何锁
+        // (Interactive / Background 任务仍进入各自的注入队列，保证优先级顺序)
+        void* memory = TaskMemory::Allocate(sizeof(TaskNode));
+        m_localQueues[t_workerIndex]->deque.Push(new (memory) TaskNode{ std::move(pending) });
+    }
+    else {
+        while (!PushInjection(pending)) {
+            // 无锁队列已满
+            QueueFullPolicy policy = m_fullPolicy;
+            if (policy == QueueFullPolicy::Block && t_currentPool == this) {
+                policy = QueueFullPolicy::RunOnCaller; // 工作线程阻塞等待自己所在的线程池可能永远等不到空位
+            }
+
+            if (policy == QueueFullPolicy::Fail) {
+                lane.depth.fetch_sub(1);
+                m_pendingTasks.fetch_sub(1);
+                throw ThreadPoolQueueFullError();
+            }
+            if (policy == QueueFullPolicy::RunOnCaller) {
+                lane.submitted.fetch_add(1, std::memory_order_relaxed);
+                m_pendingTasks.fetch_sub(1);
+                RunPending(pending);
+                return;
+            }
+
+            WaitForInjectionSpace(options.priority);
+            if (m_stop.load()) {
+                lane.depth.fetch_sub(1);
+                m_pendingTasks.fetch_sub(1);
+                throw std::runtime_error("enqueue on stopped ThreadPool");
+            }
+        }
+    }
+    lane.submitted.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_monitorSleeping.load()) {
+        { std::lock_guard<std::mutex> lock(m_monitorMutex); }
+        m_monitorCondition.notify_one(); // 线程池由空闲转为忙碌，开始监视任务是否卡住
+    }
+
+    // Interactive 任务优先唤醒预留线程；预留线程都在忙时由普通线程处理
+    if (options.priority == TaskPriority::Interactive && m_sleepingReserved.load() > 0) {
+        { std::lock_guard<std::mutex> lock(m_queueMutex); }
+        m_reservedCondition.notify_one();
+    }
+    else if (m_sleepingWorkers.load() > 0 && m_spinningWorkers.load() == 0) {
+        WakeOneSleeper(); // 通知一个等待的线程 (有线程在忙等时由它取走任务，不必唤醒)
+    }
+}
+
+TimerId ThreadPool::ScheduleTimer(std::chrono::milliseconds delay, std::chrono::milliseconds period, Task action, const CancellationToken& cancellation) {
+    TimerWheel* timers;
+    {
+        std::lock_guard<std::mutex> lock(m_timerMutex);
+        if (m_stop.load()) {
+            throw std::runtime_error("enqueue on stopped ThreadPool");
+        }
+        if (!m_timers) {
+            m_timers.reset(new TimerWheel());
+        }
+        timers = m_timers.get();
+    }
+    return timers->Schedule(delay, period, std::move(action), cancellation);
+}
+
+void ThreadPool::SubmitFromTimer(Task& task, const TaskOptions& options) {
+    if (m_stop.load()) {
+        CancelTask(task);
+        return;
+    }
+    try {
+        Submit(std::move(task), options);
+    }
+    catch (const std::exception& e) {
+        // 队列已满 (Fail 策略) 或线程池恰好停止：任务被放弃
+        LOG_WARNING(L"Failed to submit timer task: ", Utf8ToWide(e.what()).c_str());
+    }
+}
+
+bool ThreadPool::CancelTimer(TimerId id) {
+    TimerWheel* timers;
+    {
+        std::lock_guard<std::mutex> lock(m_timerMutex);
+        timers = m_timers.get();
+    }
+    return timers ? timers->Cancel(id) : false;
+}
+
+size_t ThreadPool::GetTimerCount() const {
+    std::lock_guard<std::mutex> lock(m_timerMutex);
+    return m_timers ? m_timers->Size() : 0;
+}
+
+uint16_t ThreadPool::ResolveTag(const char* tag) {
+    if (!*tag) {
+        return 0;
+    }
+    // 标签很少，线性查找；先比较指针，同一个字面量不必比较内容
+    for (size_t i = 1; i + 1 < kMaxTaskTags; ++i) {
+        const char* name = m_tags[i].name.load(std::memory_order_acquire);
+        if (!name && m_tags[i].name.compare_exchange_strong(name, tag, std::memory_order_acq_rel)) {
+            return static_cast<uint16_t>(i);
+        }
+        if (name == tag || strcmp(name, tag) == 0) {
+            return static_cast<uint16_t>(i);
+        }
+    }
+    return static_cast<uint16_t>(kMaxTaskTags - 1);
+}
+
+void ThreadPool::LatencyCounters::Record(unsigned long long us) {
+    size_t bucket = (std::min)(static_cast<size_t>(std::bit_width(us)), LatencyHistogram::kBuckets - 1);
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    totalUs.fetch_add(us, std::memory_order_relaxed);
+    unsigned long long previousMax = maxUs.load(std::memory_order_relaxed);
+    while (us > previousMax && !maxUs.compare_exchange_weak(previousMax, us, std::memory_order_relaxed)) {
+    }
+}
+
+LatencyHistogram ThreadPool::LatencyCounters::Read() const {
+    LatencyHistogram histogram;
+    for (size_t i = 0; i < LatencyHistogram::kBuckets; ++i) {
+        histogram.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        histogram.count += histogram.buckets[i];
+    }
+    histogram.totalMs = totalUs.load(std::memory_order_relaxed) / 1000.0;
+    histogram.maxMs = maxUs.load(std::memory_order_relaxed) / 1000.0;
+    return histogram;
+}
+
+double LatencyHistogram::PercentileMs(double fraction) const {
+    if (count == 0) {
+        return 0.0;
+    }
+    double rank = std::ceil(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(count));
+    unsigned long long target = (std::max)(static_cast<unsigned long long>(rank), 1ull);
+    unsigned long long cumulative = 0;
+    for (size_t i = 0; i + 1 < kBuckets; ++i) {
+        cumulative += buckets[i];
+        if (cumulative >= target) {
+            return (std::min)(static_cast<double>(1ull << i) / 1000.0, maxMs);
+        }
+    }
+    return maxMs; // 最后一个桶没有上界
+}
+
+ThreadPool::Clock::time_point ThreadPool::RecordStart(const PendingTask& pending) {
+    Lane& lane = GetLane(pending.priority);
+    lane.depth.fetch_sub(1);
+    lane.started.fetch_add(1, std::memory_order_relaxed);
+
+    Clock::time_point now = Clock::now();
+    m_lastStartTicks.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+    unsigned long long waitUs = static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - pending.enqueuedAt).count());
+    m_tags[pending.tag].wait.Record(waitUs);
+    lane.totalWaitUs.fetch_add(waitUs, std::memory_order_relaxed);
+    unsigned long long previousMax = lane.maxWaitUs.load(std::memory_order_relaxed);
+    while (waitUs > previousMax && !lane.maxWaitUs.compare_exchange_weak(previousMax, waitUs, std::memory_order_relaxed)) {
+    }
+
+    // 任务排队过久且没有空闲线程：增加线程吸收突发负载
+    if (m_liveWorkers.load(std::memory_order_relaxed) < m_maxWorkers
+        && waitUs > static_cast<unsigned long long>(m_growthThreshold.count()) * 1000
+        && m_pendingTasks.load() > 0 && m_sleepingWorkers.load() == 0) {
+        TryGrow();
+    }
+    return now;
+}
+
+ThreadPool::Clock::time_point ThreadPool::RunPending(PendingTask& pending) {
+    Clock::time_point startedAt = RecordStart(pending);
+    if (m_discardPending.load(std::memory_order_relaxed) || pending.cancellation.IsCancellationRequested()) {
+        CancelTask(pending.task);
+        return startedAt;
+    }
+    RunTask(pending.task);
+    Clock::time_point finishedAt = Clock::now();
+    m_tags[pending.tag].run.Record(static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(finishedAt - startedAt).count()));
+    return finishedAt;
+}
+
+void ThreadPool::BeginBusy(BusyPeriod& period) {
+    period.active = true;
+    period.wallStart = Clock::now();
+    period.cpuStartUs = CurrentThreadCpuUs();
+    period.tasks = 0;
+}
+
+void ThreadPool::EndBusy(BusyPeriod& period) {
+    if (!period.active) {
+        return;
+    }
+    period.active = false;
+    unsigned long long wallUs = static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - period.wallStart).count());
+    unsigned long long cpuNow = CurrentThreadCpuUs();
+    m_tasksRun.fetch_add(period.tasks, std::memory_order_relaxed);
+    m_busyUs.fetch_add(wallUs, std::memory_order_relaxed);
+    if (period.counters) {
+        period.counters->tasksRun.fetch_add(period.tasks, std::memory_order_relaxed);
+        period.counters->busyUs.fetch_add(wallUs, std::memory_order_relaxed);
+    }
+    m_cpuUs.fetch_add(cpuNow > period.cpuStartUs ? cpuNow - period.cpuStartUs : 0, std::memory_order_relaxed);
+}
+
+bool ThreadPool::SpinForWork(std::chrono::microseconds& spinBudget) {
+    if (m_waitStrategy == WaitStrategy::Block) {
+        return false;
+    }
+    const bool bounded = (m_waitStrategy == WaitStrategy::SpinThenPark);
+    Clock::time_point deadline = Clock::now() + spinBudget;
+    bool found = false;
+    m_spinningWorkers.fetch_add(1);
+    for (unsigned i = 1; !m_stop.load(std::memory_order_relaxed); ++i) {
+        if (m_pendingTasks.load() > 0) {
+            found = true;
+            break;
+        }
+        if (m_waitStrategy == WaitStrategy::Yield) {
+            std::this_thread::yield();
+        }
+        else {
+            YieldProcessor(); // CPU 暂停指令：降低忙等功耗，并让出超线程的执行资源
+        }
+        if (bounded && (i % 64) == 0 && Clock::now() >= deadline) {
+            break;
+        }
+    }
+    // 先减少计数再去休眠：与 Submit 中先增加任务计数再读取忙等线程数配对，二者至少有一方看到对方
+    m_spinningWorkers.fetch_sub(1);
+
+    if (bounded) {
+        // 忙等期间等到了任务说明任务到达得较密，下次多等一些；否则减半，空闲的线程池很快退化为直接休眠
+        spinBudget = found ? (std::min)(spinBudget * 2, m_spinLimit) : (std::max)(spinBudget / 2, std::chrono::microseconds(1));
+    }
+    return found;
+}
+
+void ThreadPool::WakeOneSleeper() {
+    { std::lock_guard<std::mutex> lock(m_queueMutex); }
+    m_condition.notify_one();
+}
+
+void ThreadPool::CancelTask(Task& task) {
+    try {
+        task.Cancel();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR(L"Exception caught while canceling task: ", Utf8ToWide(e.what()).c_str());
+    }
+    catch (...) {
+        LOG_ERROR(L"Unknown exception caught while canceling task.");
+    }
+}
+
+void ThreadPool::RunTask(Task& task) {
+    try {
+        task();
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR(L"Exception caught in worker thread while executing task: ", Utf8ToWide(e.what()).c_str());
+    }
+    catch (...) {
+        LOG_ERROR(L"Unknown exception caught in worker thread while executing task.");
+    }
+}
+
+void ThreadPool::TakeNode(TaskNode* node, PendingTask& outTask) {
+    outTask = std::move(node->pending);
+    node->~TaskNode();
+    TaskMemory::Deallocate(node, sizeof(TaskNode));
+}
+
+bool ThreadPool::HasLowerPriorityWork(TaskPriority priority) const {
+    for (size_t i = static_cast<size_t>(priority) + 1; i < kTaskPriorityCount; ++i) {
+        if (m_lanes[i].depth.load(std::memory_order_relaxed) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::FindReservedTask(PendingTask& outTask) {
+    return PopInjection(TaskPriority::Interactive, outTask);
+}
+
+bool ThreadPool::FindTask(size_t index, uint32_t& rngState, unsigned& highPicks, PendingTask& outTask) {
+    bool found = false;
+
+    // 0. 防饥饿：连续取了多次高优先级任务而低优先级仍在排队时，这一次从最低优先级开始取
+    if (highPicks >= m_starvationLimit) {
+        highPicks = 0;
+        if (PopInjection(TaskPriority::Background, outTask) || PopInjection(TaskPriority::Normal, outTask)) {
+            return true;
+        }
+    }
+
+    // 1. Interactive 注入队列
+    found = PopInjection(TaskPriority::Interactive, outTask);
+
+    // 2. 自己的本地队列 (后进先出)
+    if (!found && index < m_localQueues.size()) {
+        if (TaskNode* node = m_localQueues[index]->deque.Pop()) {
+            TakeNode(node, outTask);
+            found = true;
+        }
+    }
+
+    // 3. 外部线程提交的 Normal 注入队列
+    if (!found) {
+        found = PopInjection(TaskPriority::Normal, outTask);
+    }
+
+    // 4. 从其他线程窃取
+    if (!found) {
+        found = StealTask(index, rngState, outTask);
+    }
+
+    // 5. Background 注入队列
+    if (!found) {
+        found = PopInjection(TaskPriority::Background, outTask);
+    }
+
+    if (found) {
+        highPicks = HasLowerPriorityWork(outTask.priority) ? highPicks + 1 : 0;
+    }
+    return found;
+}
+
+bool ThreadPool::StealTask(size_t index, uint32_t& rngState, PendingTask& outTask) {
+    size_t count = m_localQueues.size();
+    if (count <= 1) {
+        return false;
+    }
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    size_t start = rngState % count;
+
+    // 从随机位置开始依次尝试每个线程；NUMA 感知时第一轮只试同节点的线程，第二轮再试其他节点
+    bool local = m_numaAwareStealing && index < m_placement.size();
+    for (int pass = local ? 0 : 1; pass < 2; ++pass) {
+        for (size_t i = 0; i < count; ++i) {
+            size_t victim = (start + i) % count;
+            if (victim == index) continue;
+            if (local && (m_placement[victim].node == m_placement[index].node) != (pass == 0)) continue;
+            if (TaskNode* node = m_localQueues[victim]->deque.Steal()) {
+                TakeNode(node, outTask);
+                if (index < m_workers.size()) {
+                    m_workerCounters[index].steals.fetch_add(1, std::memory_order_relaxed);
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_thread(size_t index) {
+    t_currentPool = this;
+    t_workerIndex = index;
+    if (index < m_placement.size()) {
+        CpuTopology::PinCurrentThread(m_placement[index]);
+    }
+    // 任何返回路径 (停止或空闲退出) 都通知 Shutdown
+    struct ExitNotifier {
+        ThreadPool* pool;
+        size_t index;
+        ~ExitNotifier() { pool->OnWorkerExit(index); }
+    } exitNotifier{ this, index };
+    const bool reserved = index < m_reservedWorkers;
+    const bool canRetire = !reserved && m_maxWorkers > m_minWorkers;
+    uint32_t rngState = static_cast<uint32_t>(index * 2654435761u + 1);
+    unsigned highPicks = 0;
+    Lane& interactiveLane = GetLane(TaskPriority::Interactive);
+    BusyPeriod busy;
+    busy.counters = &m_workerCounters[index];
+    std::chrono::microseconds spinBudget = m_spinLimit;
+    LOG_DEBUG(L"Worker thread started. ID: ", std::this_thread::get_id());
+
+    while (true) {
+        PendingTask pending;
+        if (reserved ? FindReservedTask(pending) : FindTask(index, rngState, highPicks, pending)) {
+            size_t remaining = m_pendingTasks.fetch_sub(1) - 1;
+            // 忙等线程存在时提交方跳过了唤醒；还有积压就由取到任务的线程补上一次
+            if (m_waitStrategy != WaitStrategy::Block && remaining > 0
+                && m_sleepingWorkers.load() > 0 && m_spinningWorkers.load() == 0) {
+                WakeOneSleeper();
+            }
+            if (!busy.active) {
+                BeginBusy(busy);
+            }
+            Clock::time_point finishedAt = RunPending(pending);
+            ++busy.tasks;
+            if (finishedAt - busy.wallStart >= kBusyFlushInterval) {
+                EndBusy(busy);
+            }
+            continue;
+        }
+        EndBusy(busy); // 即将空闲 (或退出)
+
+        if (reserved) {
+            // 预留线程只等待 Interactive 任务
+            if (interactiveLane.depth.load() > 0) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            if (m_stop.load() && interactiveLane.depth.load() == 0) {
+                LOG_DEBUG(L"Reserved worker thread stopping. ID: ", std::this_thread::get_id());
+                return;
+            }
+            m_sleepingReserved.fetch_add(1);
+            m_reservedCondition.wait(lock, [this, &interactiveLane] { return m_stop.load() || interactiveLane.depth.load() > 0; });
+            m_sleepingReserved.fetch_sub(1);
+            continue;
+        }
+
+        // 计数不为 0 说明有任务正在提交途中或刚被其他线程窃取，稍后重试
+        if (m_pendingTasks.load() > 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // 休眠前按等待策略先忙等：任务在此期间到达时不需要经过条件变量的内核唤醒
+        if (SpinForWork(spinBudget)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_queueMutex);
+        // 如果线程池已停止且没有剩余任务，则退出线程
+        if (m_stop.load() && m_pendingTasks.load() == 0) {
+            LOG_DEBUG(L"Worker thread stopping. ID: ", std::this_thread::get_id());
+            return;
+        }
+        // 等待条件：有任务提交，或者线程池已停止
+        auto hasWork = [this] { return m_stop.load() || m_pendingTasks.load() > 0; };
+        m_sleepingWorkers.fetch_add(1);
+        bool woken = true;
+        if (canRetire) {
+            woken = m_condition.wait_for(lock, m_idleTimeout, hasWork);
+        }
+        else {
+            m_condition.wait(lock, hasWork);
+        }
+        m_sleepingWorkers.fetch_sub(1);
+
+        // 空闲超时：线程数多于下限时退出 (本地队列此时为空，槽位留给以后新增的线程)
+        if (!woken && TryRetire(index)) {
+            LOG_DEBUG(L"Idle worker thread retired. ID: ", std::this_thread::get_id());
+            return;
+        }
+    }
+}
+
+void ThreadPool::SpawnWorker(size_t index) {
+    WorkerSlot& slot = m_workers[index];
+    if (slot.thread.joinable()) {
+        slot.thread.join(); // 之前在此槽位退出的线程 (已经或即将结束)
+    }
+    slot.running = true;
+    {
+        std::lock_guard<std::mutex> lock(m_exitMutex);
+        slot.exited = false;
+        ++m_runningThreads;
+    }
+    m_liveWorkers.fetch_add(1);
+    m_workerCounters[index].aliveSince.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    slot.thread = std::thread(&ThreadPool::worker_thread, this, index);
+}
+
+bool ThreadPool::TryGrow() {
+    std::lock_guard<std::mutex> lock(m_elasticMutex);
+    if (m_stop.load() || m_liveWorkers.load() >= m_maxWorkers) {
+        return false;
+    }
+    for (size_t i = m_reservedWorkers; i < m_workers.size(); ++i) {
+        if (!m_workers[i].running) {
+            SpawnWorker(i);
+            LOG_INFO(L"ThreadPool grew to ", m_liveWorkers.load(), L" threads (", m_pendingTasks.load(), L" tasks waiting).");
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::TryRetire(size_t index) {
+    size_t live = m_liveWorkers.load();
+    do {
+        if (m_stop.load() || live <= m_minWorkers) {
+            return false;
+        }
+    } while (!m_liveWorkers.compare_exchange_weak(live, live - 1));
+
+    std::lock_guard<std::mutex> lock(m_elasticMutex);
+    m_workers[index].running = false; // 线程对象由下一次 SpawnWorker 或析构函数 join
+    return true;
+}
+
+void ThreadPool::monitor_thread() {
+    std::unique_lock<std::mutex> lock(m_monitorMutex);
+    while (!m_stop.load()) {
+        if (m_pendingTasks.load() == 0) {
+            // 没有排队的任务时一直休眠，空闲的应用不会被周期性唤醒
+            m_monitorSleeping.store(true);
+            m_monitorCondition.wait(lock, [this] { return m_stop.load() || m_pendingTasks.load() > 0; });
+            m_monitorSleeping.store(false);
+            continue;
+        }
+
+        m_monitorCondition.wait_for(lock, m_growthThreshold, [this] { return m_stop.load(); });
+        if (m_stop.load()) {
+            break;
+        }
+
+        // 有任务在排队，但在整个阈值时间内没有任何任务开始执行：所有线程都被阻塞 (例如网络 I/O)
+        Clock::time_point lastStart{ Clock::duration(m_lastStartTicks.load(std::memory_order_relaxed)) };
+        if (m_pendingTasks.load() > 0 && m_sleepingWorkers.load() == 0 && Clock::now() - lastStart > m_growthThreshold) {
+            lock.unlock();
+            TryGrow();
+            lock.lock();
+        }
+    }
+}
+
+bool ThreadPool::TryRunPendingTask() {
+    static thread_local uint32_t helperRngState = 0x9E3779B9u;
+    bool worker = (t_currentPool == this);
+    unsigned highPicks = 0;
+    PendingTask pending;
+    bool found = (worker && t_workerIndex < m_reservedWorkers)
+        ? FindReservedTask(pending)
+        : FindTask(worker ? t_workerIndex : m_workers.size(), helperRngState, highPicks, pending);
+    if (!found) {
+        return false;
+    }
+    m_pendingTasks.fetch_sub(1);
+    RunPending(pending);
+    return true;
+}
+
+size_t ThreadPool::GetTaskQueueSize() const {
+    return m_pendingTasks.load() + (m_ioExecutor ? m_ioExecutor->GetTaskQueueSize() : 0);
+}
+
+LaneStats ThreadPool::GetLaneStats(TaskPriority priority) const {
+    const Lane& lane = GetLane(priority);
+    LaneStats stats;
+    stats.queueDepth = lane.depth.load(std::memory_order_relaxed);
+    stats.submitted = lane.submitted.load(std::memory_order_relaxed);
+    stats.started = lane.started.load(std::memory_order_relaxed);
+    if (stats.started > 0) {
+        stats.averageWaitMs = lane.totalWaitUs.load(std::memory_order_relaxed) / 1000.0 / stats.started;
+    }
+    stats.maxWaitMs = lane.maxWaitUs.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+ExecutorStats ThreadPool::GetExecutorStats(ExecutorKind kind) const {
+    if (kind == ExecutorKind::BlockingIo) {
+        return m_ioExecutor ? m_ioExecutor->GetExecutorStats() : ExecutorStats();
+    }
+    ExecutorStats stats;
+    stats.threads = m_liveWorkers.load(std::memory_order_relaxed);
+    stats.tasksRun = m_tasksRun.load(std::memory_order_relaxed);
+    stats.busyMs = m_busyUs.load(std::memory_order_relaxed) / 1000.0;
+    // 线程 CPU 时间按时钟周期计入，短时间内可能略大于墙钟时间
+    stats.computeMs = (std::min)(m_cpuUs.load(std::memory_order_relaxed) / 1000.0, stats.busyMs);
+    stats.blockedMs = stats.busyMs - stats.computeMs;
+    return stats;
+}
+
+ThreadPoolStatsSnapshot ThreadPool::GetStatsSnapshot(ExecutorKind kind) const {
+    if (kind == ExecutorKind::BlockingIo) {
+        return m_ioExecutor ? m_ioExecutor->GetStatsSnapshot() : ThreadPoolStatsSnapshot();
+    }
+    ThreadPoolStatsSnapshot snapshot;
+    snapshot.executor = GetExecutorStats();
+    for (size_t i = 0; i < kTaskPriorityCount; ++i) {
+        snapshot.lanes[i] = GetLaneStats(static_cast<TaskPriority>(i));
+    }
+
+    for (size_t i = 0; i < kMaxTaskTags; ++i) {
+        const char* name = m_tags[i].name.load(std::memory_order_acquire);
+        if (!name) continue;
+        TaskTagStats tag;
+        tag.queueWait = m_tags[i].wait.Read();
+        if (tag.queueWait.count == 0) continue;
+        tag.tag = name;
+        tag.run = m_tags[i].run.Read();
+        snapshot.tags.push_back(std::move(tag));
+    }
+
+    Clock::time_point now = Clock::now();
+    snapshot.workers.resize(m_workers.size());
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        const WorkerCounters& counters = m_workerCounters[i];
+        WorkerStats& worker = snapshot.workers[i];
+        Clock::rep since = counters.aliveSince.load(std::memory_order_relaxed);
+        unsigned long long aliveUs = counters.aliveUs.load(std::memory_order_relaxed);
+        if (since != 0) {
+            worker.running = true;
+            aliveUs += static_cast<unsigned long long>(
+                std::chrono::duration_cast<std::chrono::microseconds>(now - Clock::time_point(Clock::duration(since))).count());
+        }
+        worker.tasksRun = counters.tasksRun.load(std::memory_order_relaxed);
+        worker.steals = counters.steals.load(std::memory_order_relaxed);
+        worker.busyMs = counters.busyUs.load(std::memory_order_relaxed) / 1000.0;
+        worker.aliveMs = aliveUs / 1000.0;
+    }
+    return snapshot;
+}
@@ -1,89 +1,684 @@
-#ifndef THREADS_H
-#define THREADS_H
-
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <functional>
-#include <vector>
-#include <atomic>
-#include <future>    // For std::async, std::future
-#include <deque>     // For std::deque (was missing, caused C2039)
-#include <type_traits> // For std::invoke_result (C++17) or std::result_of (C++11/14)
-
-// 򵥵̳߳ʾ
-// ע⣺һǳ̳߳ءпҪӵԣ
-// ȼ̬߳õĴȡơ
-
-class ThreadPool {
-public:
-    /**
-     * @brief 캯ָĹ̡߳
-     * @param numThreads ̳߳е߳ĬΪӲ
-     */
-    ThreadPool(size_t numThreads = 0);
-
-    /**
-     * @brief ȴɲ̡߳
-     */
-    ~ThreadPool();
-
-    // ֹ͸ֵ
-    ThreadPool(const ThreadPool&) = delete;
-    ThreadPool& operator=(const ThreadPool&) = delete;
-
-    /**
-     * @brief ̳߳ύһ
-     * @tparam F ͡
-     * @tparam Args ͡
-     * @param f Ҫִеĺ
-     * @param args Ĳ
-     * @return std::future<typename std::result_of<F(Args...)>::type> ڻȡ
-     */
-    template<class F, class... Args>
-    auto enqueue(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
-        // For C++14 or earlier, use std::result_of<F(Args...)>::type
-        // For C++17 and later, std::invoke_result is preferred.
-        // VS2022 supports C++17 and later well.
-        using return_type = typename std::invoke_result<F, Args...>::type;
-
-        // ʹ std::packaged_task װԱȡ future
-        auto task = std::make_shared<std::packaged_task<return_type()>>(
-            std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-        );
-
-        std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(m_queueMutex);
-
-            // ֹ̳߳ͣ
-            if (m_stop) {
-                throw std::runtime_error("enqueue on stopped ThreadPool");
-            }
-
-            m_tasks.emplace_back([task]() { (*task)(); }); // C2065 for m_tasks was due to deque not being declared.
-        }
-        m_condition.notify_one(); // ֪ͨһȴ߳
-        return res;
-    }
-
-
-    /**
-     * @brief ȡǰе
-     * @return 
-     */
-    size_t GetTaskQueueSize() const;
-
-
-private:
-    void worker_thread(); // ̵ִ߳к
-
-    std::vector<std::thread> m_workers;            // 洢̵߳
-    std::deque<std::function<void()>> m_tasks;     //  (std::deque was missing include)
-
-    std::mutex m_queueMutex;                       // еĻ
-    std::condition_variable m_condition;           // ֪ͨ߳
-    std::atomic<bool> m_stop;                      // ԭӲֵֹͣ߳
-};
-
-#endif // THREADS_H
+#ifndef THREADS_H
+#define THREADS_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <atomic>
+#include <future>    // For std::async, std::future
+#include <deque>     // For std::deque (was missing, caused C2039)
+#include <memory>    // For std::unique_ptr
+#include <stdexcept> // For std::runtime_error
+#include <tuple>     // For std::apply
+#include <chrono>
+#include <algorithm> // For std::min
+#include <string>
+#include <type_traits> // For std::invoke_result (C++17) or std::result_of (C++11/14)
+
+class Config;
+
+#include "task.h"
+#include "cancellation.h"
+#include "cpu_topology.h"
+#include "timer_wheel.h"
+#include "work_stealing_deque.h"
+#include "mpmc_queue.h"
+
+// 线程池：
+// 任务按优先级进入 Interactive / Normal / Background 三条队列，高优先级先执行，低优先级等待过久时插队以防饿死；
+// 可以预留只执行 Interactive 任务的工作线程 (ThreadPoolOptions::reservedInteractiveWorkers)。
+// 线程数在 minThreads 与 maxThreads 之间弹性伸缩；标记为 blocking 的任务交给独立的 I/O 执行器，
+// 不占用计算线程。Shutdown 丢弃尚未开始的任务并取消 GetShutdownToken() 返回的令牌，执行中的任务据此尽快结束。
+
+// 任务调度方式
+enum class SchedulingMode {
+    SharedQueue,   // 所有任务进入一个由互斥锁保护的共享队列 (默认)
+    WorkStealing   // 每个工作线程一个 Chase-Lev 双端队列，空闲线程从随机的其他线程窃取任务
+};
+
+// 外部线程提交任务使用的注入队列
+enum class InjectionQueueType {
+    Locked,   // 互斥锁保护的 std::deque，容量不限 (默认)
+    LockFree  // 无锁有界 MPMC 环形队列 (见 mpmc_queue.h)，大量线程提交小任务时没有锁竞争
+};
+
+// 有界注入队列已满时的处理方式
+enum class QueueFullPolicy {
+    Block,       // 等待队列出现空位 (工作线程自己提交时改为在当前线程执行，避免线程池自锁)
+    Fail,        // 抛出 ThreadPoolQueueFullError
+    RunOnCaller  // 在提交任务的线程上直接执行
+};
+
+// 空闲工作线程等待新任务的方式
+enum class WaitStrategy {
+    Block,        // 直接在条件变量上休眠 (默认)，不占用 CPU；新任务需要一次内核唤醒
+    Spin,         // 一直忙等 (CPU 暂停指令)，延迟最低，但每个空闲线程占满一个核
+    Yield,        // 一直循环让出时间片，延迟略高于 Spin，有其他可运行线程时让给它们
+    SpinThenPark  // 先忙等一段时间再休眠；忙等时长按最近的任务到达情况自适应调整
+};
+
+// 任务优先级 (每个优先级一条独立的队列)
+enum class TaskPriority {
+    Interactive = 0, // 用户触发、需要尽快响应的操作 (例如手动检查更新)
+    Normal = 1,      // 默认
+    Background = 2   // 批量后台工作 (例如预取、清理)
+};
+
+static const size_t kTaskPriorityCount = 3;
+
+struct ThreadPoolOptions {
+    size_t numThreads = 0; // 初始线程数，0 表示使用硬件并发数
+    // 弹性线程数：空闲超过 idleTimeout 的线程退出 (不少于 minThreads)；
+    // 任务排队等待超过 growthWaitThreshold 且没有空闲线程时增加线程 (不超过 maxThreads)。0 表示等于初始线程数
+    size_t minThreads = 0;
+    size_t maxThreads = 0;
+    std::chrono::milliseconds idleTimeout{ 30000 };
+    std::chrono::milliseconds growthWaitThreshold{ 100 };
+    SchedulingMode scheduling = SchedulingMode::SharedQueue;
+    InjectionQueueType injectionQueue = InjectionQueueType::Locked;
+    size_t injectionQueueCapacity = 4096;  // 仅 LockFree 时有效 (每个优先级队列各自的容量)
+    QueueFullPolicy fullPolicy = QueueFullPolicy::Block;
+    // 只执行 Interactive 任务的预留线程数 (包含在 numThreads 内，至少保留一个普通线程)
+    size_t reservedInteractiveWorkers = 0;
+    // 防饥饿：高优先级任务连续被取走这么多次而低优先级队列仍有任务时，下一次先取最低优先级的任务
+    unsigned starvationLimit = 8;
+    // 独立的阻塞 I/O 执行器：TaskOptions::blocking 的任务在这些线程上执行，慢速的网络 / 磁盘操作不占用计算线程。
+    // 0 表示不创建，blocking 任务与其他任务一样在本线程池执行
+    size_t ioThreads = 0;
+    size_t ioMaxThreads = 0; // I/O 线程全部阻塞时可临时增加到的上限，0 表示等于 ioThreads
+    // 空闲普通线程的等待方式 (预留线程总是 Block)
+    WaitStrategy waitStrategy = WaitStrategy::Block;
+    std::chrono::microseconds spinLimit{ 50 }; // SpinThenPark：休眠前最多忙等的时间
+    // 把工作线程绑定到各自的核心 (见 CpuTopology::PlanPlacement)。多 NUMA 节点时工作窃取优先选择同一节点的线程，
+    // 任务数据尽量留在分配它的节点上
+    bool pinWorkers = false;
+};
+
+// 提交任务时的选项
+struct TaskOptions {
+    TaskPriority priority = TaskPriority::Normal;
+    // 任务开始执行前令牌已被取消时不再执行 (见 Task::Cancel)；执行中的任务需要自己检查令牌
+    CancellationToken cancellation;
+    // 任务大部分时间阻塞在网络 / 磁盘 I/O 上：配置了 I/O 执行器时提交到那里 (见 ThreadPoolOptions::ioThreads)
+    bool blocking = false;
+    // 统计标签：GetStatsSnapshot 按标签分别统计排队和执行时间。必须是静态存储期的字符串 (通常是字符串字面量)
+    const char* tag = nullptr;
+};
+
+// 执行器类型 (GetExecutorStats)
+enum class ExecutorKind {
+    Compute,    // 线程池本身
+    BlockingIo  // 执行 blocking 任务的 I/O 执行器
+};
+
+// 执行器的忙碌时间统计 (只统计工作线程执行的任务)
+struct ExecutorStats {
+    size_t threads = 0;               // 当前线程数
+    unsigned long long tasksRun = 0;
+    double busyMs = 0.0;              // 执行任务的墙钟时间
+    double computeMs = 0.0;           // 其中占用 CPU 的时间 (线程 CPU 时间，精度约为一个系统时钟周期)
+    double blockedMs = 0.0;           // busyMs - computeMs：等待 I/O、锁或其他任务的时间
+};
+
+// 单个优先级队列的统计信息
+struct LaneStats {
+    size_t queueDepth = 0;       // 当前排队的任务数
+    unsigned long long submitted = 0;
+    unsigned long long started = 0;
+    double averageWaitMs = 0.0;  // 从提交到开始执行的平均等待时间
+    double maxWaitMs = 0.0;
+};
+
+// 耗时直方图：第 i 个桶统计 [2^(i-1), 2^i) 微秒的样本，第 0 个桶统计不足 1 微秒的样本
+struct LatencyHistogram {
+    static const size_t kBuckets = 32;
+    unsigned long long buckets[kBuckets] = {};
+    unsigned long long count = 0;
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+
+    double AverageMs() const { return count ? totalMs / count : 0.0; }
+
+    /**
+     * @brief 估算分位数 (返回样本所在桶的上界，最多偏大一倍)。
+     * @param fraction 0 到 1 之间，例如 0.99。
+     */
+    double PercentileMs(double fraction) const;
+};
+
+// 某个标签的任务统计
+struct TaskTagStats {
+    std::string tag;             // 未设置标签的任务为空字符串；不同标签超过上限后其余的计入 "(other)"
+    LatencyHistogram queueWait;  // 从提交到开始执行
+    LatencyHistogram run;        // 执行时间 (不含被放弃的任务)
+};
+
+// 工作线程槽位的统计 (槽位上的线程空闲退出后由新线程继续累计)
+struct WorkerStats {
+    bool running = false;           // 槽位上当前有线程
+    unsigned long long tasksRun = 0;
+    unsigned long long steals = 0;  // 从其他线程的本地队列窃取到的任务数
+    double busyMs = 0.0;            // 正在进行的忙碌区间最多延迟 100 毫秒计入
+    double aliveMs = 0.0;           // 槽位上有线程的累计时间
+
+    double BusyRatio() const { return aliveMs > 0.0 ? (std::min)(busyMs / aliveMs, 1.0) : 0.0; }
+};
+
+// GetStatsSnapshot 的结果
+struct ThreadPoolStatsSnapshot {
+    ExecutorStats executor;
+    LaneStats lanes[kTaskPriorityCount];
+    std::vector<TaskTagStats> tags;     // 只包含执行过任务的标签
+    std::vector<WorkerStats> workers;   // 按槽位编号
+};
+
+// QueueFullPolicy::Fail 时队列已满抛出的异常
+class ThreadPoolQueueFullError : public std::runtime_error {
+public:
+    ThreadPoolQueueFullError() : std::runtime_error("ThreadPool injection queue is full") {}
+};
+
+namespace PoolDetail {
+
+    // enqueue 提交的任务：结果写入 promise；任务被取消而没有执行时 future 抛出 OperationCanceledError
+    template<typename R, typename F, typename ArgsTuple>
+    struct PromiseTask {
+        std::promise<R> promise;
+        F func;
+        ArgsTuple boundArgs;
+
+        void operator()() {
+            try {
+                if constexpr (std::is_void<R>::value) {
+                    std::apply(func, boundArgs);
+                    promise.set_value();
+                }
+                else {
+                    promise.set_value(std::apply(func, boundArgs));
+                }
+            }
+            catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+
+        void Cancel() {
+            promise.set_exception(std::make_exception_ptr(OperationCanceledError()));
+        }
+    };
+
+} // namespace PoolDetail
+
+class ThreadPool {
+public:
+    /**
+     * @brief 构造函数，创建指定数量的工作线程。
+     * @param numThreads 线程池中的线程数量。默认为硬件并发数。
+     */
+    ThreadPool(size_t numThreads = 0);
+
+    /**
+     * @brief 按选项构造线程池。
+     * @param options 线程数量和调度方式等选项。
+     * @note 工作窃取模式下，工作线程内部提交的任务进入该线程自己的双端队列 (后进先出)，
+     *       外部线程提交的任务进入共享的注入队列。
+     */
+    explicit ThreadPool(const ThreadPoolOptions& options);
+
+    /**
+     * @brief 析构函数，等待所有任务完成并销毁线程 (已经调用过 Shutdown 时只等待尚未退出的线程)。
+     */
+    ~ThreadPool();
+
+    /**
+     * @brief 限时关闭：不再接受新任务，丢弃所有尚未开始的任务 (见 Task::Cancel)，
+     *        取消 GetShutdownToken() 返回的令牌，然后最多等待 timeout 让工作线程退出。
+     * @param timeout 等待工作线程退出的最长时间。
+     * @return 所有工作线程都已退出时返回 true。超时返回 false：仍有任务没有响应取消，
+     *         析构函数会继续等待它们，调用方可以选择在进程退出前不再销毁线程池。
+     */
+    bool Shutdown(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief 线程池关闭时被取消的令牌，长时间运行的任务 (例如下载) 应当观察它。
+     */
+    CancellationToken GetShutdownToken() const { return m_shutdownSource.GetToken(); }
+
+    /**
+     * @brief 从配置的 [ThreadPool] 节读取线程池选项 (未配置的项沿用 defaults，并修正不合理的取值)。
+     * @param config 配置对象。
+     * @param defaults 默认选项。
+     */
+    static ThreadPoolOptions LoadOptions(const Config& config, const ThreadPoolOptions& defaults = ThreadPoolOptions());
+
+    // 禁止拷贝和赋值
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief 向线程池提交一个任务。
+     * @tparam F 函数类型。
+     * @tparam Args 参数类型。
+     * @param f 要执行的函数。
+     * @param args 函数的参数。
+     * @return std::future<typename std::result_of<F(Args...)>::type> 用于获取任务结果。
+     */
+    template<class F, class... Args>
+    auto enqueue(F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
+        return enqueue_with(TaskOptions(), std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief 按指定选项 (优先级等) 提交任务。
+     * @param options 任务选项。
+     * @param f 要执行的函数。
+     * @param args 函数的参数。
+     * @return 用于获取任务结果的 future。
+     */
+    template<class F, class... Args>
+    auto enqueue_with(const TaskOptions& options, F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
+        // For C++14 or earlier, use std::result_of<F(Args...)>::type
+        // For C++17 and later, std::invoke_result is preferred.
+        // VS2022 supports C++17 and later well.
+        using return_type = typename std::invoke_result<F, Args...>::type;
+        using TaskType = PoolDetail::PromiseTask<return_type, typename std::decay<F>::type,
+            decltype(std::make_tuple(std::forward<Args>(args)...))>;
+
+        // promise 直接放在任务内 (Task 不要求可拷贝)，共享状态从 TaskMemory 分配，
+        // 小任务整个提交过程不经过全局堆
+        std::promise<return_type> promise(std::allocator_arg, PooledAllocator<char>());
+        std::future<return_type> res = promise.get_future();
+        Submit(Task(TaskType{ std::move(promise), std::forward<F>(f), std::make_tuple(std::forward<Args>(args)...) }), options);
+        return res;
+    }
+
+    /**
+     * @brief 提交一个不需要结果的任务 (不创建 future，也没有共享状态)。
+     * @param f 要执行的函数。
+     * @param args 函数的参数。
+     * @note 任务抛出的异常会被工作线程捕获并记录日志。
+     */
+    template<class F, class... Args>
+    void post(F&& f, Args&&... args) {
+        post_with(TaskOptions(), std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief 按指定选项提交一个不需要结果的任务。
+     */
+    template<class F, class... Args>
+    void post_with(const TaskOptions& options, F&& f, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0) {
+            Submit(Task(std::forward<F>(f)), options);
+        }
+        else {
+            Submit(Task([func = std::forward<F>(f), boundArgs = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+                std::apply(func, boundArgs);
+            }), options);
+        }
+    }
+
+    /**
+     * @brief 延迟 delay 后提交任务 (到期时由计时线程提交，精度约 1 毫秒)。
+     * @return 用于获取任务结果的 future。线程池关闭时尚未到期的任务被取消，future 抛出 OperationCanceledError。
+     */
+    template<class F, class... Args>
+    auto enqueue_after(std::chrono::milliseconds delay, F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
+        return enqueue_after_with(TaskOptions(), delay, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief 按指定选项延迟提交任务。
+     * @param options 任务选项。options.cancellation 被取消时立即取消定时器，future 抛出 OperationCanceledError。
+     * @param delay 延迟时间。
+     */
+    template<class F, class... Args>
+    auto enqueue_after_with(const TaskOptions& options, std::chrono::milliseconds delay, F&& f, Args&&... args) -> std::future<typename std::invoke_result<F, Args...>::type> {
+        using return_type = typename std::invoke_result<F, Args...>::type;
+        using TaskType = PoolDetail::PromiseTask<return_type, typename std::decay<F>::type,
+            decltype(std::make_tuple(std::forward<Args>(args)...))>;
+
+        std::promise<return_type> promise(std::allocator_arg, PooledAllocator<char>());
+        std::future<return_type> res = promise.get_future();
+        Task task(TaskType{ std::move(promise), std::forward<F>(f), std::make_tuple(std::forward<Args>(args)...) });
+        ScheduleTimer(delay, std::chrono::milliseconds::zero(), Task(TimerSubmit{ this, options, std::move(task) }), options.cancellation);
+        return res;
+    }
+
+    /**
+     * @brief 延迟 delay 后提交一个不需要结果的任务。
+     * @return 定时器句柄，可以用 CancelTimer 在到期前取消。
+     */
+    template<class F>
+    TimerId post_after(std::chrono::milliseconds delay, F&& f, const TaskOptions& options = TaskOptions()) {
+        return ScheduleTimer(delay, std::chrono::milliseconds::zero(), Task(TimerSubmit{ this, options, Task(std::forward<F>(f)) }), options.cancellation);
+    }
+
+    /**
+     * @brief 每隔 period 提交一次任务 (第一次在 period 之后)，直到 CancelTimer、options.cancellation 被取消或线程池关闭。
+     * @param f 可拷贝的函数，每次提交一份拷贝。上一次还没有执行完时照常提交下一次。
+     * @return 定时器句柄。
+     */
+    template<class F>
+    TimerId enqueue_every(std::chrono::milliseconds period, F&& f, const TaskOptions& options = TaskOptions()) {
+        using FuncType = typename std::decay<F>::type;
+        return ScheduleTimer(period, period, Task(TimerRepeat<FuncType>{ this, options, std::forward<F>(f) }), options.cancellation);
+    }
+
+    /**
+     * @brief 取消 post_after / enqueue_every 返回的定时器 (O(1))。
+     * @return 阻止了后续的提交时返回 true；单次任务已经提交或句柄已失效时返回 false。
+     */
+    bool CancelTimer(TimerId id);
+
+    /**
+     * @brief 尚未到期的定时任务数量 (包括周期任务)。
+     */
+    size_t GetTimerCount() const;
+
+    // co_await pool.schedule() 的等待体：挂起当前协程，并把恢复操作作为任务提交到线程池 (见 coro.h)
+    class ScheduleAwaiter {
+    public:
+        ScheduleAwaiter(ThreadPool& pool, const TaskOptions& options) : m_pool(pool), m_options(options), m_canceled(false) {}
+        bool await_ready() const noexcept { return false; }
+        template<typename Handle>
+        void await_suspend(Handle handle) {
+            // 提交后协程可能立即在其他线程恢复并销毁本对象，先把成员拷贝到栈上
+            ThreadPool& pool = m_pool;
+            TaskOptions options = m_options;
+            pool.post_with(options, ResumeTask<Handle>{ handle, &m_canceled });
+        }
+        void await_resume() const {
+            if (m_canceled) throw OperationCanceledError();
+        }
+    private:
+        // 恢复任务被取消 (令牌已取消或线程池关闭) 时在丢弃它的线程上恢复协程，co_await 抛出 OperationCanceledError
+        template<typename Handle>
+        struct ResumeTask {
+            Handle handle;
+            bool* canceled;
+            void operator()() { handle.resume(); }
+            void Cancel() {
+                *canceled = true;
+                handle.resume();
+            }
+        };
+
+        ThreadPool& m_pool;
+        TaskOptions m_options;
+        bool m_canceled;
+    };
+
+    /**
+     * @brief 在协程中使用 co_await pool.schedule() 切换到本线程池的工作线程上继续执行。
+     * @param options 恢复任务的提交选项 (优先级、取消令牌等)。
+     * @note 线程池已停止或队列已满 (Fail 策略) 时，co_await 抛出相应异常；
+     *       恢复前令牌被取消或线程池被 Shutdown 时抛出 OperationCanceledError。
+     */
+    ScheduleAwaiter schedule(const TaskOptions& options = TaskOptions()) { return ScheduleAwaiter(*this, options); }
+
+    /**
+     * @brief 获取当前队列中的任务数量 (已提交但尚未开始执行，包括 I/O 执行器中的，不加锁)。
+     * @return 任务数量。
+     */
+    size_t GetTaskQueueSize() const;
+
+
+    /**
+     * @brief 获取当前工作线程数量 (弹性线程数时会随负载变化)。
+     */
+    size_t GetThreadCount() const { return m_liveWorkers.load(); }
+
+    /**
+     * @brief 当前线程是否是本线程池的工作线程。
+     */
+    bool IsWorkerThread() const;
+
+    /**
+     * @brief 获取某个优先级队列的统计信息 (不加锁)。
+     */
+    LaneStats GetLaneStats(TaskPriority priority) const;
+
+    /**
+     * @brief 获取线程池或 I/O 执行器的忙碌 / 阻塞时间统计 (不加锁)。
+     * @note 没有配置 I/O 执行器时 BlockingIo 返回全 0。正在进行的忙碌区间最多延迟 100 毫秒计入。
+     */
+    ExecutorStats GetExecutorStats(ExecutorKind kind = ExecutorKind::Compute) const;
+
+    /**
+     * @brief 获取统计快照：各优先级队列、各标签的排队 / 执行时间直方图、各工作线程的忙碌比例和窃取次数。
+     * @note 不加锁，各计数分别读取，彼此之间可能有微小的不一致。BlockingIo 返回 I/O 执行器的快照。
+     */
+    ThreadPoolStatsSnapshot GetStatsSnapshot(ExecutorKind kind = ExecutorKind::Compute) const;
+
+    /**
+     * @brief 在当前线程上取出并执行一个排队中的任务 (等待子任务时帮忙执行，见 parallel.h)。
+     * @return 没有可执行的任务时返回 false。
+     * @note 工作线程按自己的调度顺序取任务 (包括自己的本地队列)；其他线程从注入队列取或从工作线程窃取。
+     */
+    bool TryRunPendingTask();
+
+    /**
+     * @brief 等待 done() 成立 (TaskGroup::Wait、Parallel 的 Join、TaskFuture::Wait 共用)。
+     * @param lock 已锁定的互斥锁，保护 done 读取的状态；返回时仍处于锁定状态。
+     * @param condition 状态变化时被通知的条件变量。
+     * @param done 完成条件，在持有锁时调用。
+     * @note 本线程池的工作线程在等待期间释放锁，用 TryRunPendingTask 帮忙执行排队的任务
+     *       (预留线程只取 Interactive 任务)，没有任务时最多休眠 1 毫秒再检查，线程池饱和时也不会互相等待而死锁。
+     *       其他线程不执行无关的任务 (它们可能运行很久)，直接在条件变量上等待。
+     */
+    template<typename Predicate>
+    void HelpWhileWaiting(std::unique_lock<std::mutex>& lock, std::condition_variable& condition, Predicate done) {
+        if (!IsWorkerThread()) {
+            condition.wait(lock, done);
+            return;
+        }
+        while (!done()) {
+            lock.unlock();
+            bool ran = TryRunPendingTask();
+            lock.lock();
+            if (!ran) {
+                condition.wait_for(lock, std::chrono::milliseconds(1), done);
+            }
+        }
+    }
+
+private:
+    // 定时器到期时在计时线程上执行：把任务提交到线程池；定时器被取消时放弃任务
+    struct TimerSubmit {
+        ThreadPool* pool;
+        TaskOptions options;
+        Task task;
+        void operator()() { pool->SubmitFromTimer(task, options); }
+        void Cancel() { CancelTask(task); }
+    };
+
+    // 周期定时器每次到期时提交函数的一份拷贝
+    template<typename F>
+    struct TimerRepeat {
+        ThreadPool* pool;
+        TaskOptions options;
+        F func;
+        void operator()() {
+            Task task(func);
+            pool->SubmitFromTimer(task, options);
+        }
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    // 排队中的任务：记录提交时间以统计等待时间
+    struct PendingTask {
+        Task task;
+        TaskPriority priority = TaskPriority::Normal;
+        uint16_t tag = 0;  // m_tags 中的编号
+        Clock::time_point enqueuedAt;
+        CancellationToken cancellation;
+    };
+
+    // 本地队列的元素：Chase-Lev 队列只能存放指针，节点从 TaskMemory 的线程缓存分配
+    struct TaskNode {
+        PendingTask pending;
+    };
+
+    // 每个优先级一条注入队列及其统计
+    struct Lane {
+        std::deque<PendingTask> tasks;                                 // 互斥锁保护的队列 (m_queueMutex)
+        std::unique_ptr<BoundedMpmcQueue<PendingTask>> lockFreeTasks;  // 选择无锁注入队列时代替 tasks
+        std::atomic<size_t> depth{ 0 };
+        std::atomic<unsigned long long> submitted{ 0 };
+        std::atomic<unsigned long long> started{ 0 };
+        std::atomic<unsigned long long> totalWaitUs{ 0 };
+        std::atomic<unsigned long long> maxWaitUs{ 0 };
+    };
+
+    // 工作窃取模式下每个工作线程的本地队列
+    struct WorkerQueue {
+        WorkStealingDeque<TaskNode*> deque;
+    };
+
+    // 直方图的计数部分：每个样本只有一次桶计数和一次累加，最大值只在变大时写入
+    struct LatencyCounters {
+        std::atomic<unsigned long long> buckets[LatencyHistogram::kBuckets] = {};
+        std::atomic<unsigned long long> totalUs{ 0 };
+        std::atomic<unsigned long long> maxUs{ 0 };
+
+        void Record(unsigned long long us);
+        LatencyHistogram Read() const;
+    };
+
+    // 一个统计标签：名称在第一次使用时写入，之后不再改变
+    struct TagSlot {
+        std::atomic<const char*> name{ nullptr };
+        LatencyCounters wait;
+        LatencyCounters run;
+    };
+
+    // 每个工作线程槽位的计数，独占缓存行避免线程之间互相干扰
+    struct alignas(64) WorkerCounters {
+        std::atomic<unsigned long long> tasksRun{ 0 };
+        std::atomic<unsigned long long> busyUs{ 0 };
+        std::atomic<unsigned long long> steals{ 0 };
+        std::atomic<unsigned long long> aliveUs{ 0 };  // 已退出的线程在槽位上的时间
+        std::atomic<Clock::rep> aliveSince{ 0 };      // 当前线程的启动时间，0 表示没有线程
+    };
+
+    // 工作线程的忙碌区间：从取到任务起到线程空闲 (或连续忙碌超过 100 毫秒) 为止，
+    // 结束时把墙钟时间和线程 CPU 时间计入统计。按区间读取 CPU 时间，小任务不必各自付出一次系统调用
+    struct BusyPeriod {
+        WorkerCounters* counters = nullptr;
+        bool active = false;
+        Clock::time_point wallStart;
+        unsigned long long cpuStartUs = 0;
+        unsigned long long tasks = 0;
+    };
+
+    // 工作线程槽位：按 maxThreads 预先分配，线程退出后槽位 (及其本地队列) 留给新线程复用
+    struct WorkerSlot {
+        std::thread thread;
+        bool running = false; // m_elasticMutex 保护
+        bool exited = false;  // 线程函数已经返回 (m_exitMutex 保护)，Shutdown 只 join 这些线程
+    };
+
+    void Start(const ThreadPoolOptions& options);
+    void Submit(Task task, const TaskOptions& options = TaskOptions()); // 把包装好的任务放入合适的队列并唤醒工作线程
+    TimerId ScheduleTimer(std::chrono::milliseconds delay, std::chrono::milliseconds period, Task action, const CancellationToken& cancellation); // 首次使用时创建时间轮
+    void SubmitFromTimer(Task& task, const TaskOptions& options); // 提交失败 (线程池已停止等) 时放弃任务
+    bool PushInjection(PendingTask& pending); // 队列已满 (仅无锁队列) 时返回 false，pending 保持不变
+    bool PopInjection(TaskPriority priority, PendingTask& outTask);
+    void WaitForInjectionSpace(TaskPriority priority);
+    void worker_thread(size_t index);   // 工作线程的执行函数
+    bool FindTask(size_t index, uint32_t& rngState, unsigned& highPicks, PendingTask& outTask); // index 不是工作线程时跳过本地队列
+    bool FindReservedTask(PendingTask& outTask);
+    bool HasLowerPriorityWork(TaskPriority priority) const;
+    Clock::time_point RecordStart(const PendingTask& pending); // 返回开始时间
+    Clock::time_point RunPending(PendingTask& pending); // 执行取出的任务，已取消或线程池正在关闭时改为放弃 (Task::Cancel)；返回结束时间
+    uint16_t ResolveTag(const char* tag); // 标签名 -> m_tags 中的编号 (第一次使用时登记)
+    void BeginBusy(BusyPeriod& period);
+    void EndBusy(BusyPeriod& period);
+    bool StealTask(size_t index, uint32_t& rngState, PendingTask& outTask);
+    bool SpinForWork(std::chrono::microseconds& spinBudget); // 按等待策略在休眠前等待任务，等到任务或停止时返回 true
+    void WakeOneSleeper();
+    static void TakeNode(TaskNode* node, PendingTask& outTask);
+    static void RunTask(Task& task);
+    static void CancelTask(Task& task);
+    void StopAccepting();               // 设置停止标志，唤醒所有等待者并结束监视线程
+    void OnWorkerExit(size_t index);
+    void SpawnWorker(size_t index);     // 调用方持有 m_elasticMutex
+    bool TryGrow();
+    bool TryRetire(size_t index);
+    void monitor_thread();              // 弹性线程数：发现所有线程都卡住时增加线程
+
+    Lane& GetLane(TaskPriority priority) { return m_lanes[static_cast<size_t>(priority)]; }
+    const Lane& GetLane(TaskPriority priority) const { return m_lanes[static_cast<size_t>(priority)]; }
+
+    SchedulingMode m_scheduling;
+    QueueFullPolicy m_fullPolicy;
+    size_t m_reservedWorkers;                      // 编号小于此值的工作线程只执行 Interactive 任务
+    unsigned m_starvationLimit;
+    WaitStrategy m_waitStrategy;
+    std::chrono::microseconds m_spinLimit;
+    std::vector<WorkerSlot> m_workers;             // 存储工作线程的容器 (大小为 maxThreads)
+    Lane m_lanes[kTaskPriorityCount];              // 各优先级的注入队列
+    std::vector<std::unique_ptr<WorkerQueue>> m_localQueues; // 工作窃取模式：每个工作线程一个 (只存放 Normal 任务)
+    std::vector<CpuTopology::LogicalProcessor> m_placement;  // pinWorkers 时每个线程槽位绑定的处理器 (否则为空)
+    bool m_numaAwareStealing;                      // 已绑定且有多个 NUMA 节点：先窃取同节点线程的任务
+
+    mutable std::mutex m_queueMutex;               // 保护任务队列的互斥锁
+    std::condition_variable m_condition;           // 条件变量，用于通知工作线程有新任务
+    std::condition_variable m_reservedCondition;   // 通知预留线程有新的 Interactive 任务
+    std::atomic<bool> m_stop;                      // 原子布尔值，用于停止所有线程
+    std::atomic<bool> m_discardPending;            // Shutdown：取出的任务不再执行而是放弃
+    CancellationSource m_shutdownSource;
+
+    // 已启动但线程函数尚未返回的工作线程数，Shutdown 据此限时等待
+    std::mutex m_exitMutex;
+    std::condition_variable m_exitCondition;
+    size_t m_runningThreads;
+
+    // 尚未被取走的任务总数和正在休眠的线程数，提交时只有存在休眠线程才需要加锁唤醒
+    std::atomic<size_t> m_pendingTasks;
+    std::atomic<size_t> m_sleepingWorkers;
+    std::atomic<size_t> m_sleepingReserved;
+    std::atomic<size_t> m_spinningWorkers;         // 正在忙等的线程会自己发现新任务，提交时不必唤醒休眠线程
+
+    // 无锁注入队列已满时按 Block 策略等待空位的生产者
+    std::mutex m_spaceMutex;
+    std::condition_variable m_spaceCondition;
+    std::atomic<size_t> m_blockedProducers;
+
+    // 弹性线程数
+    size_t m_minWorkers;
+    size_t m_maxWorkers;
+    std::chrono::milliseconds m_idleTimeout;
+    std::chrono::milliseconds m_growthThreshold;
+    std::atomic<size_t> m_liveWorkers;
+    std::atomic<Clock::rep> m_lastStartTicks;     // 最近一次有任务开始执行的时间
+    std::mutex m_elasticMutex;                     // 保护 m_workers 中的线程槽位
+    std::thread m_monitor;
+    std::mutex m_monitorMutex;
+    std::condition_variable m_monitorCondition;
+    std::atomic<bool> m_monitorSleeping;
+
+    // 忙碌时间统计 (微秒)
+    std::atomic<unsigned long long> m_tasksRun;
+    std::atomic<unsigned long long> m_busyUs;
+    std::atomic<unsigned long long> m_cpuUs;
+
+    // 按标签的耗时直方图 (0 号是未设置标签的任务，最后一个收纳超出上限的标签) 和按槽位的工作线程计数
+    static const size_t kMaxTaskTags = 32;
+    std::unique_ptr<TagSlot[]> m_tags;
+    std::unique_ptr<WorkerCounters[]> m_workerCounters;
+
+    // blocking 任务的执行器 (ioThreads 为 0 时为空)。析构函数等待本线程池的工作线程退出后才销毁它，
+    // 计算任务在退出前仍可以等待 I/O 任务的结果
+    std::unique_ptr<ThreadPool> m_ioExecutor;
+
+    // enqueue_after / enqueue_every 的时间轮，第一次使用时才创建 (及其计时线程)。StopAccepting 停止它，但直到析构才销毁
+    mutable std::mutex m_timerMutex;
+    std::unique_ptr<TimerWheel> m_timers;
+};
+
+#endif // THREADS_H
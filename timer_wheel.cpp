@@ -0,0 +1,359 @@
+#define LOG_MODULE LogModule::Threads // 本文件的日志属于线程模块 (见 log.h)
+#include "timer_wheel.h"
+#include "log.h"
+#include "utils.h" // For Utf8ToWide
+
+#include <algorithm>
+#include <bit> // For std::bit_width, std::countr_zero
+
+// 单个定时器的最长延迟/周期 (约 34 年)，保证到期时间始终落在最高层的范围内
+static const uint64_t kMaxDelayTicks = 1ull << 40;
+
+static uint64_t ClampTicks(std::chrono::milliseconds duration) {
+    if (duration.count() <= 0) return 0;
+    return (std::min)(static_cast<uint64_t>(duration.count()), kMaxDelayTicks);
+}
+
+TimerWheel::TimerWheel()
+    : m_start(Clock::now()), m_current(0), m_sleepUntil(0), m_stop(false), m_count(0), m_freeList(kNone) {
+    for (unsigned level = 0; level < kLevels; ++level) {
+        for (unsigned slot = 0; slot < kSlots; ++slot) {
+            m_heads[level][slot] = kNone;
+        }
+        m_occupied[level] = 0;
+    }
+    m_thread = std::thread(&TimerWheel::TimerThread, this);
+}
+
+TimerWheel::~TimerWheel() {
+    Stop();
+}
+
+uint64_t TimerWheel::NowTick() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - m_start).count());
+}
+
+uint32_t TimerWheel::AllocateNode() {
+    uint32_t index;
+    if (m_freeList != kNone) {
+        index = m_freeList;
+        m_freeList = m_nodes[index].next;
+    }
+    else {
+        index = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+    Node& node = m_nodes[index];
+    node.prev = kNone;
+    node.next = kNone;
+    node.cancelRequested = false;
+    ++m_count;
+    return index;
+}
+
+void TimerWheel::ReleaseNode(uint32_t index, Task& actionOut, CancellationRegistration& registrationOut) {
+    Node& node = m_nodes[index];
+    actionOut = std::move(node.action);
+    registrationOut = std::move(node.registration);
+    node.state = NodeState::Free;
+    node.cancelRequested = false;
+    ++node.generation;
+    node.prev = kNone;
+    node.next = m_freeList;
+    m_freeList = index;
+    --m_count;
+}
+
+void TimerWheel::Insert(uint32_t index) {
+    Node& node = m_nodes[index];
+    if (node.expires <= m_current) {
+        node.state = NodeState::Due;
+        m_due.push_back(index);
+        return;
+    }
+
+    // 到期时间与当前时间最高的不同位决定层级：该层以上的各位相同，该层的槽号一定大于当前槽号，
+    // 因此时间推进到这个槽之前不会绕回来与其他轮次的定时器混在一起
+    unsigned level = (static_cast<unsigned>(std::bit_width(node.expires ^ m_current)) - 1) / kSlotBits;
+    if (level >= kLevels) level = kLevels - 1;
+    unsigned slot = static_cast<unsigned>(node.expires >> (level * kSlotBits)) & (kSlots - 1);
+
+    node.level = static_cast<uint8_t>(level);
+    node.slot = static_cast<uint8_t>(slot);
+    node.prev = kNone;
+    node.next = m_heads[level][slot];
+    if (node.next != kNone) {
+        m_nodes[node.next].prev = index;
+    }
+    m_heads[level][slot] = index;
+    m_occupied[level] |= 1ull << slot;
+    node.state = NodeState::Armed;
+}
+
+void TimerWheel::Unlink(uint32_t index) {
+    Node& node = m_nodes[index];
+    if (node.prev != kNone) {
+        m_nodes[node.prev].next = node.next;
+    }
+    else {
+        m_heads[node.level][node.slot] = node.next;
+        if (node.next == kNone) {
+            m_occupied[node.level] &= ~(1ull << node.slot);
+        }
+    }
+    if (node.next != kNone) {
+        m_nodes[node.next].prev = node.prev;
+    }
+    node.prev = kNone;
+    node.next = kNone;
+}
+
+uint64_t TimerWheel::NextEventTick() const {
+    uint64_t next = UINT64_MAX;
+    for (unsigned level = 0; level < kLevels; ++level) {
+        if (!m_occupied[level]) continue;
+        unsigned shift = level * kSlotBits;
+        unsigned digit = static_cast<unsigned>(m_current >> shift) & (kSlots - 1);
+        uint64_t later = (digit + 1 < kSlots) ? (m_occupied[level] & (~0ull << (digit + 1))) : 0;
+        if (!later) continue;
+        uint64_t slot = static_cast<uint64_t>(std::countr_zero(later));
+        // 当前轮次的起点 + 槽的偏移：低层是到期时间，高层是需要把槽中的定时器下放的时间
+        uint64_t tick = ((m_current >> (shift + kSlotBits)) << (shift + kSlotBits)) | (slot << shift);
+        next = (std::min)(next, tick);
+    }
+    return next;
+}
+
+void TimerWheel::Advance(uint64_t now) {
+    while (m_current < now) {
+        uint64_t next = NextEventTick();
+        if (next > now) {
+            // 中间没有非空的槽，直接跳过
+            m_current = now;
+            break;
+        }
+        m_current = next;
+
+        // 从高层往低层下放：到达某层槽的起点时，该槽中的定时器按剩余时间重新放入更低的层
+        for (unsigned level = kLevels - 1; level >= 1; --level) {
+            unsigned shift = level * kSlotBits;
+            if (m_current & ((1ull << shift) - 1)) continue;
+            unsigned slot = static_cast<unsigned>(m_current >> shift) & (kSlots - 1);
+            if (!(m_occupied[level] & (1ull << slot))) continue;
+            uint32_t index = m_heads[level][slot];
+            m_heads[level][slot] = kNone;
+            m_occupied[level] &= ~(1ull << slot);
+            while (index != kNone) {
+                uint32_t following = m_nodes[index].next;
+                Insert(index);
+                index = following;
+            }
+        }
+
+        unsigned slot = static_cast<unsigned>(m_current) & (kSlots - 1);
+        if (m_occupied[0] & (1ull << slot)) {
+            uint32_t index = m_heads[0][slot];
+            m_heads[0][slot] = kNone;
+            m_occupied[0] &= ~(1ull << slot);
+            while (index != kNone) {
+                Node& node = m_nodes[index];
+                uint32_t following = node.next;
+                node.prev = kNone;
+                node.next = kNone;
+                node.state = NodeState::Due;
+                m_due.push_back(index);
+                index = following;
+            }
+        }
+    }
+}
+
+TimerId TimerWheel::Schedule(std::chrono::milliseconds delay, std::chrono::milliseconds period, Task action,
+    const CancellationToken& cancellation) {
+    TimerId id;
+    bool wake = false;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_stop) {
+            lock.unlock();
+            action.Cancel();
+            return id;
+        }
+        uint32_t index = AllocateNode();
+        Node& node = m_nodes[index];
+        node.action = std::move(action);
+        node.period = ClampTicks(period);
+        // 刻度向下取整，多加一个刻度保证不会早于 delay 触发
+        uint64_t delayTicks = ClampTicks(delay);
+        node.expires = (std::max)(NowTick() + delayTicks + (delayTicks ? 1 : 0), m_current);
+        Insert(index);
+        id.index = index;
+        id.generation = node.generation;
+        wake = node.state == NodeState::Due || node.expires < m_sleepUntil;
+    }
+    if (wake) {
+        m_condition.notify_one();
+    }
+
+    if (cancellation.CanBeCanceled()) {
+        // 锁外注册：令牌已经取消时回调会立即执行 Cancel
+        CancellationRegistration registration = cancellation.Register([this, id] { Cancel(id); });
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Node& node = m_nodes[id.index];
+        if (node.generation == id.generation && node.state != NodeState::Free) {
+            node.registration = std::move(registration);
+        }
+        // 否则定时器已经结束：lock 先于 registration 析构，注销在锁外进行
+    }
+    return id;
+}
+
+bool TimerWheel::Cancel(TimerId id) {
+    Task action;
+    CancellationRegistration registration;
+    bool prevented = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!id.IsValid() || id.index >= m_nodes.size()) {
+            return false;
+        }
+        Node& node = m_nodes[id.index];
+        if (node.generation != id.generation) {
+            return false;
+        }
+        switch (node.state) {
+        case NodeState::Armed:
+            Unlink(id.index);
+            ReleaseNode(id.index, action, registration);
+            prevented = true;
+            break;
+        case NodeState::Due:
+            // 已经交给计时线程，由它在执行前检查标志
+            prevented = !node.cancelRequested;
+            node.cancelRequested = true;
+            break;
+        case NodeState::Firing:
+            // 正在执行：周期定时器不再安排下一次
+            prevented = node.period != 0 && !node.cancelRequested;
+            node.cancelRequested = true;
+            break;
+        case NodeState::Free:
+            break;
+        }
+    }
+    action.Cancel();
+    return prevented;
+}
+
+void TimerWheel::TimerThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        Advance(NowTick());
+
+        if (!m_due.empty()) {
+            uint32_t index = m_due.back();
+            m_due.pop_back();
+            Node& node = m_nodes[index];
+            if (node.cancelRequested) {
+                Task action;
+                CancellationRegistration registration;
+                ReleaseNode(index, action, registration);
+                lock.unlock();
+                action.Cancel();
+                registration.Unregister();
+                lock.lock();
+                continue;
+            }
+
+            // 执行期间节点保持 Firing 状态，Cancel 只设置标志；动作移出节点，避免数组扩容时移动正在执行的对象
+            node.state = NodeState::Firing;
+            Task action = std::move(node.action);
+            lock.unlock();
+            try {
+                action();
+            }
+            catch (const std::exception& e) {
+                LOG_WARNING(L"Exception in timer callback: ", Utf8ToWide(e.what()).c_str());
+            }
+            catch (...) {
+                LOG_WARNING(L"Unknown exception in timer callback.");
+            }
+            lock.lock();
+
+            Node& fired = m_nodes[index];
+            if (fired.period != 0 && !fired.cancelRequested && !m_stop) {
+                fired.action = std::move(action);
+                fired.expires += fired.period;
+                if (fired.expires <= m_current) {
+                    // 落后超过一个周期 (例如系统休眠后恢复)：不补发，从现在起重新计时
+                    fired.expires = m_current + fired.period;
+                }
+                Insert(index);
+            }
+            else {
+                Task finished;
+                CancellationRegistration registration;
+                ReleaseNode(index, finished, registration);
+                lock.unlock();
+                action.Reset();
+                finished.Reset();
+                registration.Unregister();
+                lock.lock();
+            }
+            continue;
+        }
+
+        uint64_t next = NextEventTick();
+        m_sleepUntil = next;
+        if (next == UINT64_MAX) {
+            m_condition.wait(lock);
+        }
+        else {
+            m_condition.wait_until(lock, m_start + std::chrono::milliseconds(next));
+        }
+        // 醒着时会在休眠前重新计算下一次事件，Schedule 不必再唤醒
+        m_sleepUntil = 0;
+    }
+}
+
+void TimerWheel::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id()) {
+        m_thread.join();
+    }
+
+    std::vector<Task> actions;
+    std::vector<CancellationRegistration> registrations;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t index = 0; index < m_nodes.size(); ++index) {
+            if (m_nodes[index].state == NodeState::Free) continue;
+            actions.emplace_back();
+            registrations.emplace_back();
+            ReleaseNode(index, actions.back(), registrations.back());
+        }
+        for (unsigned level = 0; level < kLevels; ++level) {
+            for (unsigned slot = 0; slot < kSlots; ++slot) {
+                m_heads[level][slot] = kNone;
+            }
+            m_occupied[level] = 0;
+        }
+        m_due.clear();
+    }
+    if (!actions.empty()) {
+        LOG_INFO(L"Timer wheel stopped. Canceled ", actions.size(), L" pending timers.");
+    }
+    for (Task& action : actions) {
+        action.Cancel();
+    }
+    registrations.clear();
+}
+
+size_t TimerWheel::Size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_count;
+}
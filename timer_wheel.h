@@ -0,0 +1,120 @@
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "task.h"
+#include "cancellation.h"
+
+// 分层时间轮：
+// 7 层、每层 64 个槽，最低层一格 1 毫秒，每往上一层一格扩大 64 倍 (覆盖约 139 年)。
+// 定时器按到期时间与当前时间最高的不同位放入对应层；时间走到高层某个槽时，把其中的定时器重新放入更低的层。
+// 每层一个 64 位占用位图，下一次事件的时间直接由位图算出，空闲时计时线程一直休眠，不会逐毫秒空转。
+// 定时器节点存放在数组中、以编号组成双向链表，插入和取消都是 O(1)，几十万个定时器只占用连续的内存。
+
+// 定时器句柄：节点编号 + 代数。定时器触发 (单次) 或取消后节点被复用，旧句柄自动失效
+struct TimerId {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+};
+
+class TimerWheel {
+public:
+    /**
+     * @brief 创建时间轮并启动计时线程。
+     */
+    TimerWheel();
+
+    /**
+     * @brief 调用 Stop()。
+     */
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief 添加定时器。
+     * @param delay 首次触发前的延迟。
+     * @param period 触发周期，0 表示只触发一次。周期按固定频率计算，落后时不补发错过的次数。
+     * @param action 到期时在计时线程上执行，应当很短 (通常只是把任务提交到线程池)。
+     *        定时器被取消或时间轮停止时，如果 action 还没有执行过则改为调用 Task::Cancel。
+     * @param cancellation 令牌被取消时自动取消定时器 (可选)。
+     * @return 用于 Cancel 的句柄。时间轮已停止时返回无效句柄，并对 action 调用 Task::Cancel。
+     */
+    TimerId Schedule(std::chrono::milliseconds delay, std::chrono::milliseconds period, Task action,
+        const CancellationToken& cancellation = CancellationToken());
+
+    /**
+     * @brief 取消定时器。
+     * @return 阻止了后续的触发时返回 true；单次定时器已经触发或句柄已失效时返回 false。
+     */
+    bool Cancel(TimerId id);
+
+    /**
+     * @brief 停止计时线程并取消所有未触发的定时器 (重复调用无效果)。
+     */
+    void Stop();
+
+    /**
+     * @brief 当前的定时器数量。
+     */
+    size_t Size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    static const unsigned kLevels = 7;
+    static const unsigned kSlotBits = 6;
+    static const unsigned kSlots = 1u << kSlotBits;
+    static const uint32_t kNone = UINT32_MAX;
+
+    enum class NodeState : uint8_t { Free, Armed, Due, Firing };
+
+    struct Node {
+        Task action;
+        CancellationRegistration registration;
+        uint64_t expires = 0;      // 到期时刻 (毫秒刻度)
+        uint64_t period = 0;       // 0 表示单次
+        uint32_t prev = kNone;
+        uint32_t next = kNone;     // 空闲节点用它组成空闲链表
+        uint32_t generation = 0;
+        uint8_t level = 0;
+        uint8_t slot = 0;
+        NodeState state = NodeState::Free;
+        bool cancelRequested = false; // Due / Firing 状态下被取消
+    };
+
+    uint64_t NowTick() const;
+    uint32_t AllocateNode();
+    void ReleaseNode(uint32_t index, Task& actionOut, CancellationRegistration& registrationOut); // 调用方在锁外销毁取出的对象
+    void Insert(uint32_t index);     // 按 expires 放入时间轮，已到期的放入 m_due
+    void Unlink(uint32_t index);
+    uint64_t NextEventTick() const;  // 下一个需要处理的刻度 (低层到期或高层槽下放)，没有定时器时为 UINT64_MAX
+    void Advance(uint64_t now);      // 把时间推进到 now，到期的定时器放入 m_due
+    void TimerThread();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::thread m_thread;
+    Clock::time_point m_start;
+    uint64_t m_current;              // 时间轮已经处理到的刻度
+    uint64_t m_sleepUntil;           // 计时线程计划醒来的刻度，插入更早的定时器时唤醒它
+    bool m_stop;
+    size_t m_count;
+
+    std::vector<Node> m_nodes;
+    uint32_t m_freeList;
+    uint32_t m_heads[kLevels][kSlots];
+    uint64_t m_occupied[kLevels];    // 每层的非空槽位图
+    std::vector<uint32_t> m_due;     // 已到期、等待计时线程执行的定时器
+};
+
+#endif // TIMER_WHEEL_H
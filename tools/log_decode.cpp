@@ -0,0 +1,228 @@
+// log_decode.cpp : 把二进制日志 (.nlog，见 log_format.h) 转换为与文本日志相同格式的文本。
+//
+// 用法: log_decode <app.nlog> [输出文件]
+// 不指定输出文件时写到标准输出。输出为 UTF-8。
+// 构建: cl /std:c++17 /EHsc /I.. log_decode.cpp ..\log_format.cpp
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../log_format.h"
+
+namespace {
+
+    struct Site {
+        bool defined = false;
+        uint8_t level = 0;
+        uint32_t line = 0;
+        std::string file;
+        std::wstring format;
+        std::string signature;
+    };
+
+    class Reader {
+    public:
+        explicit Reader(const std::vector<unsigned char>& data) : m_data(data), m_offset(0) {}
+
+        bool AtEnd() const { return m_offset >= m_data.size(); }
+        size_t Offset() const { return m_offset; }
+
+        template<typename T>
+        bool Get(T& value) {
+            if (m_data.size() - m_offset < sizeof(T)) return false;
+            std::memcpy(&value, m_data.data() + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+            return true;
+        }
+
+        bool GetBytes(size_t size, const unsigned char*& bytes) {
+            if (m_data.size() - m_offset < size) return false;
+            bytes = m_data.data() + m_offset;
+            m_offset += size;
+            return true;
+        }
+
+        bool GetNarrow(std::string& out) {
+            uint32_t length;
+            const unsigned char* bytes;
+            if (!Get(length) || !GetBytes(length, bytes)) return false;
+            out.assign(reinterpret_cast<const char*>(bytes), length);
+            return true;
+        }
+
+        bool GetWide(std::wstring& out) {
+            uint32_t length;
+            const unsigned char* bytes;
+            if (!Get(length) || !GetBytes(static_cast<size_t>(length) * 2, bytes)) return false;
+            out.clear();
+            for (uint32_t i = 0; i < length; ++i) {
+                uint16_t unit;
+                std::memcpy(&unit, bytes + i * 2, sizeof(unit));
+                out.push_back(static_cast<wchar_t>(unit));
+            }
+            return true;
+        }
+
+        bool StartsWith(const char* magic) const {
+            size_t length = std::strlen(magic);
+            return m_data.size() - m_offset >= length && std::memcmp(m_data.data() + m_offset, magic, length) == 0;
+        }
+
+        void Skip(size_t size) { m_offset += size; }
+
+    private:
+        const std::vector<unsigned char>& m_data;
+        size_t m_offset;
+    };
+
+    const char* LevelName(uint8_t level) {
+        // 与 LogLevel 的取值一致
+        switch (level) {
+        case 0: return "DEBUG";
+        case 1: return "INFO";
+        case 2: return "WARNING";
+        case 3: return "ERROR";
+        case 4: return "FATAL";
+        default: return "UNKNOWN";
+        }
+    }
+
+    // 版本 1 的文件没有 ERR 级别，3 是 FATAL
+    uint8_t ReadLevel(uint8_t level, uint32_t version) {
+        return version < 2 && level == 3 ? 4 : level;
+    }
+
+    std::string FormatTimestamp(int64_t unixMicroseconds) {
+        std::time_t seconds = static_cast<std::time_t>(unixMicroseconds / 1000000);
+        int milliseconds = static_cast<int>((unixMicroseconds / 1000) % 1000);
+        char buffer[64];
+        std::tm* local = std::localtime(&seconds);
+        if (!local || !std::strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", local)) {
+            return "[Error getting time]";
+        }
+        char result[80];
+        std::snprintf(result, sizeof(result), "%s.%03d", buffer, milliseconds);
+        return result;
+    }
+
+    void WriteLine(std::ostream& out, int64_t time, uint8_t level, const std::wstring& text) {
+        std::string line = FormatTimestamp(time);
+        line += " [";
+        line += LevelName(level);
+        line += "] ";
+        LogFormat::AppendUtf8(line, text.data(), text.size());
+        line.push_back('\n');
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::fprintf(stderr, "Usage: log_decode <app.nlog> [output.txt]\n");
+        return 2;
+    }
+
+    std::ifstream in(argv[1], std::ios_base::in | std::ios_base::binary);
+    if (!in) {
+        std::fprintf(stderr, "Cannot open %s\n", argv[1]);
+        return 1;
+    }
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    std::ofstream file;
+    if (argc >= 3) {
+        file.open(argv[2], std::ios_base::out | std::ios_base::binary);
+        if (!file) {
+            std::fprintf(stderr, "Cannot create %s\n", argv[2]);
+            return 1;
+        }
+    }
+    std::ostream& out = argc >= 3 ? static_cast<std::ostream&>(file) : std::cout;
+
+    Reader reader(data);
+    std::vector<Site> sites;
+    uint32_t version = LogFormat::kFileVersion;
+    std::wstring text;
+    size_t records = 0;
+    while (!reader.AtEnd()) {
+        size_t entryOffset = reader.Offset();
+        if (reader.StartsWith("NLOG")) {
+            // 新的进程会话：调用点编号重新开始
+            reader.Skip(4);
+            if (!reader.Get(version) || version < 1 || version > LogFormat::kFileVersion) {
+                std::fprintf(stderr, "Unsupported file version at offset %zu\n", entryOffset);
+                return 1;
+            }
+            sites.clear();
+            continue;
+        }
+
+        uint8_t type;
+        reader.Get(type);
+        bool ok = false;
+        if (type == LogFormat::kSiteEntry) {
+            uint32_t id;
+            Site site;
+            ok = reader.Get(id) && reader.Get(site.level) && reader.Get(site.line) &&
+                reader.GetNarrow(site.file) && reader.GetWide(site.format) && reader.GetNarrow(site.signature);
+            if (ok && id > LogFormat::kMaxSiteId) {
+                // 编号来自文件内容：损坏的文件可能给出巨大的编号，按它扩展 sites 会耗尽内存
+                std::fprintf(stderr, "Log site id %u out of range at offset %zu.\n", static_cast<unsigned>(id), entryOffset);
+                ok = false;
+            }
+            if (ok) {
+                site.level = ReadLevel(site.level, version);
+                if (id >= sites.size()) sites.resize(id + 1);
+                site.defined = true;
+                sites[id] = std::move(site);
+            }
+        }
+        else if (type == LogFormat::kRecordEntry) {
+            uint32_t id;
+            int64_t time;
+            uint16_t size;
+            const unsigned char* args;
+            ok = reader.Get(id) && reader.Get(time) && reader.Get(size) && reader.GetBytes(size, args);
+            if (ok) {
+                text.clear();
+                if (id >= sites.size() || !sites[id].defined) {
+                    text = L"<unknown log site>";
+                    WriteLine(out, time, 0xFF, text);
+                }
+                else {
+                    const Site& site = sites[id];
+                    if (!LogFormat::FormatArgs(site.signature, site.format, args, size, text)) {
+                        text += L" <malformed log record>";
+                    }
+                    WriteLine(out, time, site.level, text);
+                }
+                ++records;
+            }
+        }
+        else if (type == LogFormat::kTextEntry) {
+            uint8_t level;
+            int64_t time;
+            ok = reader.Get(level) && reader.Get(time) && reader.GetWide(text);
+            if (ok) {
+                WriteLine(out, time, ReadLevel(level, version), text);
+                ++records;
+            }
+        }
+
+        if (!ok) {
+            // 进程崩溃时最后一条记录可能不完整
+            std::fprintf(stderr, "Truncated or corrupt entry at offset %zu, stopping.\n", entryOffset);
+            break;
+        }
+    }
+
+    std::fprintf(stderr, "Decoded %zu records.\n", records);
+    return 0;
+}
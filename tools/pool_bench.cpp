@@ -0,0 +1,410 @@
+// pool_bench.cpp : ThreadPool 基准测试。
+//
+// 用法: pool_bench scaling [最大线程数] [重复次数]
+//       pool_bench tasks [线程数] [重复次数]
+//       pool_bench latency [线程数] [间隔微秒]
+//       pool_bench numa [线程数] [重复次数]
+//   scaling  线程数从 1 翻倍到最大线程数 (默认 64)，分别用共享队列和工作窃取执行同一组递归拆分的小任务，
+//            输出每秒完成的任务数和工作窃取相对共享队列的倍数。线程数超过逻辑处理器数时结果只反映超额订阅的开销。
+//   tasks    一个外部线程连续提交只做一次原子加法的小任务，比较 post、enqueue 和原来
+//            make_shared<packaged_task> + std::function 的提交方式每秒完成的任务数 (线程数默认为硬件并发数)。
+//   latency  依次使用各种 WaitStrategy，每次提交一个任务并等它开始执行，再间隔一段时间 (默认 200 微秒，
+//            让工作线程回到空闲状态) 提交下一个，输出从提交到开始执行的延迟分布 (线程数默认为 2)。
+//            Spin / Yield 会占满每个工作线程所在的核心，线程数不要超过空闲核心数。
+//   numa     模拟建索引这类内存密集的任务：生产任务分配并填充一块内存 (首次写入决定页面所在的 NUMA 节点)，
+//            再从工作线程内提交若干个读取这块内存计算哈希的任务。比较不绑定工作线程与 pinWorkers
+//            (绑定核心、优先窃取同一节点的任务) 时读取任务在其他节点上执行的比例、据此估算的跨节点读取量和吞吐量
+//            (线程数默认为硬件并发数)。跨节点流量按任务开始时所在的节点估算，不是硬件计数器的测量值；
+//            只有一个 NUMA 节点的机器上跨节点读取量总是 0。
+// scaling / tasks / numa 的每个配置重复运行 (默认 3 次) 取最好的一次。
+// 构建: cl /std:c++20 /EHsc /O2 /I.. pool_bench.cpp ..\threads.cpp ..\task.cpp ..\timer_wheel.cpp ..\cancellation.cpp
+//       ..\cpu_topology.cpp ..\log.cpp ..\log_format.cpp ..\config.cpp ..\utils.cpp ..\compression.cpp
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <windows.h>
+
+#include "../threads.h"
+#include "../log.h"
+
+namespace {
+
+    using Clock = std::chrono::steady_clock;
+
+    // 等待固定数量的任务完成
+    class Latch {
+    public:
+        explicit Latch(size_t count) : m_remaining(count) {}
+
+        void CountDown() {
+            if (m_remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_done = true;
+                m_cv.notify_all();
+            }
+        }
+
+        void Wait() {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_done; });
+        }
+
+    private:
+        std::atomic<size_t> m_remaining;
+        std::mutex m_mutex;
+        std::condition_variable m_cv;
+        bool m_done = false;
+    };
+
+    // 模拟几百纳秒的计算
+    void Spin(unsigned iterations) {
+        volatile unsigned value = 0;
+        for (unsigned i = 0; i < iterations; ++i) value = value + i;
+    }
+
+    ThreadPoolOptions MakeOptions(size_t threads, SchedulingMode mode) {
+        ThreadPoolOptions options;
+        options.numThreads = threads;
+        options.minThreads = threads; // 固定线程数，排除弹性伸缩的影响
+        options.maxThreads = threads;
+        options.scheduling = mode;
+        return options;
+    }
+
+    // --- scaling ---
+
+    const unsigned kForkRoots = 64;   // 外部线程提交的根任务数 (进入注入队列)
+    const unsigned kForkDepth = 14;   // 每个根任务在工作线程内递归拆分的深度
+    const unsigned kLeafWork = 200;   // 每个任务的计算量 (Spin 迭代次数)
+
+    size_t ForkTaskCount() {
+        return static_cast<size_t>(kForkRoots) * ((size_t(1) << (kForkDepth + 1)) - 1);
+    }
+
+    // 每个任务先做一点计算，再在工作线程内提交两个子任务 (工作窃取模式下进入本线程的双端队列)
+    void Fork(ThreadPool& pool, unsigned depth, Latch& done) {
+        Spin(kLeafWork);
+        if (depth > 0) {
+            pool.post([&pool, depth, &done] { Fork(pool, depth - 1, done); });
+            pool.post([&pool, depth, &done] { Fork(pool, depth - 1, done); });
+        }
+        done.CountDown();
+    }
+
+    double RunFork(size_t threads, SchedulingMode mode) {
+        ThreadPool pool(MakeOptions(threads, mode));
+        Latch done(ForkTaskCount());
+        Clock::time_point start = Clock::now();
+        for (unsigned i = 0; i < kForkRoots; ++i) {
+            pool.post([&pool, &done] { Fork(pool, kForkDepth, done); });
+        }
+        done.Wait();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return ForkTaskCount() / seconds;
+    }
+
+    int RunScaling(size_t maxThreads, int repeats) {
+        std::printf("scaling: %zu tasks per run (%u roots x depth %u), %u logical processors\n",
+            ForkTaskCount(), kForkRoots, kForkDepth, std::thread::hardware_concurrency());
+        std::printf("%8s %16s %16s %8s\n", "threads", "shared tasks/s", "stealing tasks/s", "ratio");
+        for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            double best[2] = { 0.0, 0.0 };
+            const SchedulingMode modes[2] = { SchedulingMode::SharedQueue, SchedulingMode::WorkStealing };
+            for (int r = 0; r < repeats; ++r) {
+                for (int m = 0; m < 2; ++m) {
+                    best[m] = (std::max)(best[m], RunFork(threads, modes[m]));
+                }
+            }
+            std::printf("%8zu %16.0f %16.0f %7.2fx\n", threads, best[0], best[1], best[1] / best[0]);
+        }
+        return 0;
+    }
+
+    // --- tasks ---
+
+    const size_t kTinyTasks = 1000000;
+
+    enum class SubmitKind {
+        Post,          // ThreadPool::post：Task 内联存放 lambda，没有 future
+        Enqueue,       // ThreadPool::enqueue：promise 放在 Task 内，共享状态从 TaskMemory 分配
+        PackagedTask   // 原来的 enqueue：make_shared<packaged_task> + std::function 包装，每个任务多次堆分配
+    };
+
+    const char* SubmitKindName(SubmitKind kind) {
+        switch (kind) {
+        case SubmitKind::Post: return "post";
+        case SubmitKind::Enqueue: return "enqueue";
+        default: return "packaged_task";
+        }
+    }
+
+    double RunTinyTasks(size_t threads, SubmitKind kind) {
+        ThreadPool pool(MakeOptions(threads, SchedulingMode::SharedQueue));
+        std::atomic<size_t> counter{ 0 };
+        Latch done(kTinyTasks);
+        auto body = [&counter, &done] {
+            counter.fetch_add(1, std::memory_order_relaxed);
+            done.CountDown();
+        };
+
+        Clock::time_point start = Clock::now();
+        for (size_t i = 0; i < kTinyTasks; ++i) {
+            switch (kind) {
+            case SubmitKind::Post:
+                pool.post(body);
+                break;
+            case SubmitKind::Enqueue:
+                pool.enqueue(body); // 丢弃 future 不会等待任务完成
+                break;
+            case SubmitKind::PackagedTask: {
+                auto task = std::make_shared<std::packaged_task<void()>>(std::bind(body));
+                std::function<void()> wrapper = [task] { (*task)(); };
+                pool.post(std::move(wrapper));
+                break;
+            }
+            }
+        }
+        done.Wait();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return kTinyTasks / seconds;
+    }
+
+    int RunTasks(size_t threads, int repeats) {
+        std::printf("tasks: %zu tiny tasks per run submitted from one thread, %zu worker threads\n", kTinyTasks, threads);
+        std::printf("%14s %14s %10s\n", "submit", "tasks/s", "ns/task");
+        const SubmitKind kinds[3] = { SubmitKind::Post, SubmitKind::Enqueue, SubmitKind::PackagedTask };
+        for (SubmitKind kind : kinds) {
+            double best = 0.0;
+            for (int r = 0; r < repeats; ++r) {
+                best = (std::max)(best, RunTinyTasks(threads, kind));
+            }
+            std::printf("%14s %14.0f %10.1f\n", SubmitKindName(kind), best, 1e9 / best);
+        }
+        return 0;
+    }
+
+    // --- latency ---
+
+    const size_t kLatencySamples = 5000;
+
+    const char* WaitStrategyName(WaitStrategy strategy) {
+        switch (strategy) {
+        case WaitStrategy::Block: return "Block";
+        case WaitStrategy::Spin: return "Spin";
+        case WaitStrategy::Yield: return "Yield";
+        default: return "SpinThenPark";
+        }
+    }
+
+    double Percentile(const std::vector<double>& sorted, double fraction) {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+        return sorted[(std::min)(index, sorted.size() - 1)];
+    }
+
+    void RunLatency(size_t threads, WaitStrategy strategy, std::chrono::microseconds gap) {
+        ThreadPoolOptions options = MakeOptions(threads, SchedulingMode::SharedQueue);
+        options.waitStrategy = strategy;
+        ThreadPool pool(options);
+
+        std::vector<double> samples;
+        samples.reserve(kLatencySamples);
+        for (size_t i = 0; i < kLatencySamples; ++i) {
+            // 忙等而不是 sleep_for：Windows 上 sleep_for 的精度约为一个系统时钟周期 (15.6 毫秒)
+            Clock::time_point resume = Clock::now() + gap;
+            while (Clock::now() < resume) std::this_thread::yield();
+
+            Clock::time_point started;
+            Latch done(1);
+            Clock::time_point submitted = Clock::now();
+            pool.post([&started, &done] {
+                started = Clock::now();
+                done.CountDown();
+            });
+            done.Wait();
+            samples.push_back(std::chrono::duration<double, std::micro>(started - submitted).count());
+        }
+
+        std::sort(samples.begin(), samples.end());
+        double total = 0.0;
+        for (double sample : samples) total += sample;
+        std::printf("%14s %10.1f %10.1f %10.1f %10.1f %10.1f\n", WaitStrategyName(strategy), total / samples.size(),
+            Percentile(samples, 0.5), Percentile(samples, 0.99), Percentile(samples, 0.999), samples.back());
+    }
+
+    int RunLatencies(size_t threads, std::chrono::microseconds gap) {
+        std::printf("latency: enqueue-to-start, %zu samples per strategy, %zu worker threads, %lld us between tasks\n",
+            kLatencySamples, threads, static_cast<long long>(gap.count()));
+        std::printf("%14s %10s %10s %10s %10s %10s\n", "strategy", "avg us", "p50 us", "p99 us", "p99.9 us", "max us");
+        const WaitStrategy strategies[4] = { WaitStrategy::Block, WaitStrategy::Spin, WaitStrategy::Yield, WaitStrategy::SpinThenPark };
+        for (WaitStrategy strategy : strategies) {
+            RunLatency(threads, strategy, gap);
+        }
+        return 0;
+    }
+
+    // --- numa ---
+
+    const size_t kNumaBlocks = 256;              // 生产任务数
+    const size_t kNumaBlockBytes = 1024 * 1024;  // 每个生产任务分配的内存
+    const size_t kNumaPieces = 16;               // 每块内存拆成的读取任务数
+
+    // 当前线程所在的 NUMA 节点
+    unsigned CurrentNode() {
+        PROCESSOR_NUMBER processor;
+        GetCurrentProcessorNumberEx(&processor);
+        USHORT node = 0;
+        if (!GetNumaProcessorNodeEx(&processor, &node)) return 0;
+        return node;
+    }
+
+    struct NumaRun {
+        double seconds = 0.0;
+        size_t remoteTasks = 0;
+        unsigned long long remoteBytes = 0;
+    };
+
+    struct NumaState {
+        ThreadPool* pool = nullptr;
+        std::vector<std::unique_ptr<unsigned char[]>> blocks;
+        std::vector<unsigned> blockNodes;
+        std::atomic<size_t> remoteTasks{ 0 };
+        std::atomic<unsigned long long> checksum{ 0 };
+        Latch* done = nullptr;
+    };
+
+    void IndexPiece(NumaState& state, size_t block, size_t piece) {
+        const size_t pieceBytes = kNumaBlockBytes / kNumaPieces;
+        if (CurrentNode() != state.blockNodes[block]) {
+            state.remoteTasks.fetch_add(1, std::memory_order_relaxed);
+        }
+        const unsigned char* data = state.blocks[block].get() + piece * pieceBytes;
+        unsigned long long hash = 1469598103934665603ull; // 按 8 字节字做 FNV-1a
+        for (size_t i = 0; i < pieceBytes; i += sizeof(unsigned long long)) {
+            unsigned long long word;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * 1099511628211ull;
+        }
+        state.checksum.fetch_add(hash, std::memory_order_relaxed);
+        state.done->CountDown();
+    }
+
+    void ProduceBlock(NumaState& state, size_t block) {
+        // 不做值初始化：页面在下面第一次写入时才分配到当前节点
+        state.blocks[block].reset(new unsigned char[kNumaBlockBytes]);
+        unsigned char* data = state.blocks[block].get();
+        for (size_t i = 0; i < kNumaBlockBytes; ++i) data[i] = static_cast<unsigned char>(i * 31 + block);
+        state.blockNodes[block] = CurrentNode();
+        for (size_t piece = 0; piece < kNumaPieces; ++piece) {
+            state.pool->post([&state, block, piece] { IndexPiece(state, block, piece); });
+        }
+        state.done->CountDown();
+    }
+
+    NumaRun RunNumaOnce(size_t threads, bool pinWorkers) {
+        ThreadPoolOptions options = MakeOptions(threads, SchedulingMode::WorkStealing);
+        options.pinWorkers = pinWorkers;
+        ThreadPool pool(options);
+
+        Latch done(kNumaBlocks * (kNumaPieces + 1));
+        NumaState state;
+        state.pool = &pool;
+        state.blocks.resize(kNumaBlocks);
+        state.blockNodes.resize(kNumaBlocks);
+        state.done = &done;
+
+        Clock::time_point start = Clock::now();
+        for (size_t block = 0; block < kNumaBlocks; ++block) {
+            pool.post([&state, block] { ProduceBlock(state, block); });
+        }
+        done.Wait();
+
+        NumaRun run;
+        run.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        run.remoteTasks = state.remoteTasks.load();
+        run.remoteBytes = static_cast<unsigned long long>(run.remoteTasks) * (kNumaBlockBytes / kNumaPieces);
+        return run;
+    }
+
+    int RunNuma(size_t threads, int repeats) {
+        const size_t readTasks = kNumaBlocks * kNumaPieces;
+        const double readMb = static_cast<double>(kNumaBlocks) * kNumaBlockBytes / 1e6;
+        std::printf("numa: %zu blocks of %zu KB, %zu read tasks (%.0f MB read) per run, %zu worker threads, %zu NUMA nodes\n",
+            kNumaBlocks, kNumaBlockBytes / 1024, readTasks, readMb, threads, CpuTopology::Get().nodeCount);
+        std::printf("%12s %10s %14s %14s\n", "placement", "MB/s", "remote tasks", "cross-node MB");
+        const bool pinModes[2] = { false, true };
+        for (bool pinWorkers : pinModes) {
+            NumaRun best;
+            for (int r = 0; r < repeats; ++r) {
+                NumaRun run = RunNumaOnce(threads, pinWorkers);
+                if (r == 0 || run.seconds < best.seconds) best = run;
+            }
+            std::printf("%12s %10.0f %13.1f%% %14.1f\n", pinWorkers ? "pinned" : "unpinned", readMb / best.seconds,
+                100.0 * best.remoteTasks / readTasks, best.remoteBytes / 1e6);
+        }
+        return 0;
+    }
+
+    void PrintUsage() {
+        std::fprintf(stderr, "用法: pool_bench scaling [最大线程数] [重复次数]\n"
+            "      pool_bench tasks [线程数] [重复次数]\n"
+            "      pool_bench latency [线程数] [间隔微秒]\n"
+            "      pool_bench numa [线程数] [重复次数]\n");
+    }
+
+    // 解析线程数参数，无效时返回 0
+    size_t ParseThreads(int argc, char* argv[], size_t defaultValue) {
+        if (argc <= 2) return defaultValue;
+        long value = std::atol(argv[2]);
+        if (value < 1) {
+            std::fprintf(stderr, "线程数无效: %s\n", argv[2]);
+            return 0;
+        }
+        return static_cast<size_t>(value);
+    }
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        PrintUsage();
+        return 2;
+    }
+    // 线程池的创建和关闭日志会输出到控制台，只保留警告
+    Logger::GetInstance().SetLogLevel(LogLevel::WARNING);
+
+    const char* command = argv[1];
+    int repeats = argc > 3 ? std::atoi(argv[3]) : 3;
+    if (repeats < 1) repeats = 1;
+
+    if (std::strcmp(command, "scaling") == 0) {
+        size_t maxThreads = ParseThreads(argc, argv, 64);
+        return maxThreads ? RunScaling(maxThreads, repeats) : 2;
+    }
+    if (std::strcmp(command, "tasks") == 0) {
+        size_t threads = ParseThreads(argc, argv, (std::max)(std::thread::hardware_concurrency(), 1u));
+        return threads ? RunTasks(threads, repeats) : 2;
+    }
+    if (std::strcmp(command, "latency") == 0) {
+        size_t threads = ParseThreads(argc, argv, 2);
+        long gapUs = argc > 3 ? std::atol(argv[3]) : 200;
+        return threads ? RunLatencies(threads, std::chrono::microseconds((std::max)(gapUs, 0L))) : 2;
+    }
+    if (std::strcmp(command, "numa") == 0) {
+        size_t threads = ParseThreads(argc, argv, (std::max)(std::thread::hardware_concurrency(), 1u));
+        return threads ? RunNuma(threads, repeats) : 2;
+    }
+    PrintUsage();
+    return 2;
+}
@@ -1,255 +1,534 @@
-#include "update.h"
-#include "network.h" 
-#include "log.h"
-#include "utils.h"   
-#include "globals.h" 
-#include "system_ops.h" 
-
-#include <vector>    // For std::vector
-#include <sstream>   // For std::wstringstream, std::istringstream
-#include <algorithm> // For std::replace, std::max (was missing for std::replace)
-#include <stdexcept> // For std::invalid_argument
-
-// For parsing JSON - placeholder. Use a real library.
-// #include "json.hpp" 
-// using json = nlohmann::json;
-
-namespace Update {
-
-    std::vector<int> ParseVersionString(const std::wstring& versionStr) {
-        std::vector<int> parts;
-        std::wstringstream wss(versionStr);
-        std::wstring segment;
-        while (std::getline(wss, segment, L'.')) {
-            if (segment.empty() && !wss.eof()) { // Handle cases like "1..2" -> treat empty segment as 0 or error
-                parts.push_back(0); // Or throw error
-                continue;
-            }
-            if (segment.empty() && wss.eof() && parts.empty()) { // Handle empty string input
-                throw std::invalid_argument("Empty version string segment or overall empty string");
-            }
-            if (segment.empty()) continue; // Skip trailing empty segments if any e.g. "1.2."
-
-            try {
-                parts.push_back(std::stoi(segment));
-            }
-            catch (const std::invalid_argument& ia) {
-                LOG_WARNING(L"Invalid version segment (not an int): '", segment, L"'. Error: ", Utf8ToWide(ia.what()).c_str());
-                throw std::invalid_argument("Version segment is not a valid integer");
-            }
-            catch (const std::out_of_range& oor) {
-                LOG_WARNING(L"Version segment out of range: '", segment, L"'. Error: ", Utf8ToWide(oor.what()).c_str());
-                throw std::invalid_argument("Version segment out of integer range");
-            }
-        }
-        if (parts.empty() && !versionStr.empty()) { // e.g. versionStr was "..."
-            throw std::invalid_argument("Version string contains no valid numeric parts.");
-        }
-        // No need to pad to 3 parts here, CompareVersions will handle different lengths.
-        return parts;
-    }
-
-    int CompareVersions(const std::wstring& version1, const std::wstring& version2) {
-        if (version1 == version2) return 0;
-
-        std::vector<int> v1_parts, v2_parts;
-        try {
-            v1_parts = ParseVersionString(version1);
-            v2_parts = ParseVersionString(version2);
-        }
-        catch (const std::invalid_argument& e) {
-            LOG_ERROR(L"Cannot compare versions due to parsing error: ", Utf8ToWide(e.what()).c_str());
-            throw;
-        }
-
-        size_t len = max(v1_parts.size(), v2_parts.size());
-        for (size_t i = 0; i < len; ++i) {
-            int p1 = (i < v1_parts.size()) ? v1_parts[i] : 0; // Pad with 0 for shorter version strings
-            int p2 = (i < v2_parts.size()) ? v2_parts[i] : 0;
-            if (p1 < p2) return -1;
-            if (p1 > p2) return 1;
-        }
-        return 0;
-    }
-
-
-    bool CheckForUpdates(
-        const std::wstring& currentVersion,
-        const std::string& updateCheckUrl, // URL is std::string
-        VersionInfo& outVersionInfo)
-    {
-        LOG_INFO(L"Checking for updates. Current version: ", currentVersion, L". Update URL: ", Utf8ToWide(updateCheckUrl).c_str());
-
-        std::string responseBody;
-        Network::ParsedUrl parsedUrl = Network::ParseUrl(updateCheckUrl); // C2589, C2059 fixed by assigning to var first
-        if (!parsedUrl.isValid) {
-            LOG_ERROR(L"Invalid update check URL: ", Utf8ToWide(updateCheckUrl).c_str());
-            return false;
-        }
-
-        // Construct full path for HttpGet
-        std::string fullPath = parsedUrl.path;
-        if (!parsedUrl.query.empty()) {
-            fullPath += "?" + parsedUrl.query;
-        }
-
-
-        // C2660: HttpGet takes 7 arguments. The call was missing some or had wrong types.
-        // bool HttpGet(const std::string& host, const std::string& path, unsigned short port,
-        //              std::string& responseBody, std::map<std::string, std::string>* responseHeadersOutParam = nullptr,
-        //              bool useHTTPSParam = false, int timeoutMsParam = 5000)
-        if (!Network::HttpGet(parsedUrl.host, fullPath, parsedUrl.port, responseBody,
-            nullptr, (parsedUrl.scheme == "https"), 10000 /*timeout 10s*/)) {
-            LOG_ERROR(L"Failed to fetch update information from: ", Utf8ToWide(updateCheckUrl).c_str());
-            return false;
-        }
-
-        if (responseBody.empty()) {
-            LOG_WARNING(L"Update check URL returned empty response: ", Utf8ToWide(updateCheckUrl).c_str());
-            return false;
-        }
-
-        // --- JSON Parsing Placeholder ---
-        // This part needs a real JSON library. The manual parsing is extremely fragile.
-        // Assuming a simple JSON structure:
-        // { "latestVersion": "1.2.3", "downloadUrl": "http://...", "releaseNotes": "..." }
-        // For the sake_of_compilation, this pseudo-parser will remain, but it's bad.
-        size_t verPos = responseBody.find("\"latestVersion\": \"");
-        size_t urlPos = responseBody.find("\"downloadUrl\": \"");
-        size_t notesPos = responseBody.find("\"releaseNotes\": \"");
-
-        if (verPos != std::string::npos && urlPos != std::string::npos && notesPos != std::string::npos) {
-            verPos += strlen("\"latestVersion\": \"");
-            urlPos += strlen("\"downloadUrl\": \"");
-            notesPos += strlen("\"releaseNotes\": \"");
-
-            size_t verEnd = responseBody.find("\"", verPos);
-            size_t urlEnd = responseBody.find("\"", urlPos);
-            size_t notesEnd = responseBody.find("\"", notesPos);
-
-            if (verEnd != std::string::npos && urlEnd != std::string::npos && notesEnd != std::string::npos) {
-                outVersionInfo.versionString = Utf8ToWide(responseBody.substr(verPos, verEnd - verPos));
-                // C2679: outVersionInfo.downloadUrl is wstring, RHS is string.
-                outVersionInfo.downloadUrl = responseBody.substr(urlPos, urlEnd - urlPos); // This is std::string
-                outVersionInfo.releaseNotes = Utf8ToWide(responseBody.substr(notesPos, notesEnd - notesPos));
-            }
-            else {
-                LOG_ERROR(L"Failed to parse update information (malformed pseudo-JSON - missing end quotes).");
-                LOG_DEBUG(L"Response body: ", Utf8ToWide(responseBody).c_str());
-                return false;
-            }
-        }
-        else {
-            LOG_ERROR(L"Failed to parse update information (expected fields not found in pseudo-JSON).");
-            LOG_DEBUG(L"Response body: ", Utf8ToWide(responseBody).c_str());
-            return false;
-        }
-
-
-        if (outVersionInfo.versionString.empty() || outVersionInfo.downloadUrl.empty()) {
-            LOG_ERROR(L"Parsed update information is incomplete (missing version or URL string).");
-            return false;
-        }
-
-        LOG_INFO(L"Latest version available: ", outVersionInfo.versionString, L". Download URL: ", Utf8ToWide(outVersionInfo.downloadUrl).c_str());
-        LOG_INFO(L"Release notes: ", outVersionInfo.releaseNotes);
-
-        try {
-            if (CompareVersions(outVersionInfo.versionString, currentVersion) > 0) {
-                LOG_INFO(L"A new version is available: ", outVersionInfo.versionString);
-                return true;
-            }
-            else {
-                LOG_INFO(L"Current version ", currentVersion, L" is up to date or newer.");
-                return false;
-            }
-        }
-        catch (const std::invalid_argument& e) {
-            LOG_ERROR(L"Error comparing versions: ", Utf8ToWide(e.what()).c_str());
-            return false;
-        }
-    }
-
-
-    bool DownloadAndApplyUpdate(
-        const VersionInfo& versionToUpdate, // versionToUpdate.downloadUrl is std::string
-        std::function<void(long long, long long)> progressCallback,
-        std::function<bool()> restartAppCallback)
-    {
-        // versionToUpdate.downloadUrl is std::string as per VersionInfo struct and parsing logic
-        if (versionToUpdate.downloadUrl.empty()) {
-            LOG_ERROR(L"Download URL for update is empty.");
-            return false;
-        }
-
-        std::wstring tempDir = g_appDataDir + L"\\Temp";
-        if (!DirectoryExists(tempDir)) {
-            if (!CreateDirectoryRecursive(tempDir)) {
-                LOG_ERROR(L"Failed to create temporary directory for update: ", tempDir.c_str());
-                return false;
-            }
-        }
-
-        std::wstring fileName = L"update_package_default_name.dat"; // Default name
-        // versionToUpdate.downloadUrl is std::string. Need to convert to wstring for find_last_of if used with L'/'
-        // Or, use std::string version of find_last_of with '/'
-        size_t lastSlashUrl = versionToUpdate.downloadUrl.find_last_of('/');
-        if (lastSlashUrl != std::string::npos) {
-            // C2664: Utf8ToWide expects std::string, versionToUpdate.downloadUrl.substr(...) is std::string. This is OK.
-            fileName = Utf8ToWide(versionToUpdate.downloadUrl.substr(lastSlashUrl + 1));
-        }
-
-        // Sanitize filename (basic)
-        // C2039, C3861 std::replace: needs <algorithm>. It operates on iterators.
-        std::replace(fileName.begin(), fileName.end(), L'?', L'_'); // Ok for wstring
-        std::replace(fileName.begin(), fileName.end(), L'&', L'_'); // Ok for wstring
-
-
-        std::wstring downloadedFilePath = tempDir + L"\\" + fileName;
-
-        LOG_INFO(L"Downloading update from: ", Utf8ToWide(versionToUpdate.downloadUrl).c_str(), L" to: ", downloadedFilePath.c_str());
-
-        // C2664: DownloadFile expects const std::string& for URL. versionToUpdate.downloadUrl is already std::string.
-        if (!Network::DownloadFile(versionToUpdate.downloadUrl, downloadedFilePath, progressCallback)) {
-            LOG_ERROR(L"Failed to download update package from: ", Utf8ToWide(versionToUpdate.downloadUrl).c_str());
-            if (FileExists(downloadedFilePath)) {
-                DeleteFileW(downloadedFilePath.c_str());
-            }
-            return false;
-        }
-
-        LOG_INFO(L"Update package downloaded successfully: ", downloadedFilePath.c_str());
-        LOG_WARNING(L"Update package verification (checksum/signature) is NOT IMPLEMENTED. This is a security risk.");
-
-        LOG_INFO(L"Update package ready at: ", downloadedFilePath.c_str());
-        LOG_INFO(L"To apply the update, the application typically needs to restart and run an updater/installer.");
-
-        if (restartAppCallback) {
-            LOG_INFO(L"Requesting application restart to apply update...");
-            PROCESS_INFORMATION pi;
-            if (SystemOps::ExecuteProcess(downloadedFilePath, L"", L"", false, &pi, false)) {
-                LOG_INFO(L"Launched updater/installer: ", downloadedFilePath.c_str(), L" PID: ", pi.dwProcessId);
-                CloseHandle(pi.hProcess);
-                CloseHandle(pi.hThread);
-
-                if (restartAppCallback()) {
-                    LOG_INFO(L"Restart callback initiated successfully.");
-                    return true;
-                }
-                else {
-                    LOG_ERROR(L"Restart callback failed to initiate application shutdown.");
-                    return false;
-                }
-            }
-            else {
-                LOG_ERROR(L"Failed to launch updater/installer: ", downloadedFilePath.c_str());
-                return false;
-            }
-        }
-        else {
-            LOG_WARNING(L"No restart callback provided. Update downloaded but not applied.");
-            return false;
-        }
-    }
-
-} // namespace Update
+#define LOG_MODULE LogModule::Update // 本文件的日志属于更新模块 (见 log.h)
+#include "update.h"
+#include "network.h" 
+#include "log.h"
+#include "utils.h"   
+#include "globals.h" 
+#include "system_ops.h" 
+#include "chunk_store.h"
+#include "zip_archive.h"
+#include "install.h"
+#include "mirrors.h"
+#include "coro.h"
+
+#include <vector>    // For std::vector
+#include <sstream>   // For std::wstringstream, std::istringstream
+#include <algorithm> // For std::replace, std::max (was missing for std::replace)
+#include <stdexcept> // For std::invalid_argument
+#include <cwctype>   // For towlower
+#include <cctype>    // For tolower
+
+// For parsing JSON - placeholder. Use a real library.
+// #include "json.hpp" 
+// using json = nlohmann::json;
+
+namespace Update {
+
+    // 从伪 JSON 中提取可选的字符串字段 ("key": "value")，字段不存在时返回 false
+    static bool ExtractOptionalField(const std::string& body, const std::string& key, std::string& outValue) {
+        std::string pattern = "\"" + key + "\": \"";
+        size_t pos = body.find(pattern);
+        if (pos == std::string::npos) {
+            return false;
+        }
+        pos += pattern.length();
+        size_t end = body.find("\"", pos);
+        if (end == std::string::npos) {
+            return false;
+        }
+        outValue = body.substr(pos, end - pos);
+        return true;
+    }
+
+    // 从伪 JSON 中提取可选的字符串数组字段 ("key": ["a", "b"])，字段不存在时返回 false
+    static bool ExtractOptionalArray(const std::string& body, const std::string& key, std::vector<std::string>& outValues) {
+        std::string pattern = "\"" + key + "\": [";
+        size_t pos = body.find(pattern);
+        if (pos == std::string::npos) {
+            return false;
+        }
+        pos += pattern.length();
+        size_t end = body.find(']', pos);
+        if (end == std::string::npos) {
+            return false;
+        }
+        while (true) {
+            size_t open = body.find('"', pos);
+            if (open == std::string::npos || open > end) break;
+            size_t close = body.find('"', open + 1);
+            if (close == std::string::npos || close > end) break;
+            outValues.push_back(body.substr(open + 1, close - open - 1));
+            pos = close + 1;
+        }
+        return true;
+    }
+
+    std::vector<int> ParseVersionString(const std::wstring& versionStr) {
+        std::vector<int> parts;
+        std::wstringstream wss(versionStr);
+        std::wstring segment;
+        while (std::getline(wss, segment, L'.')) {
+            if (segment.empty() && !wss.eof()) { // Handle cases like "1..2" -> treat empty segment as 0 or error
+                parts.push_back(0); // Or throw error
+                continue;
+            }
+            if (segment.empty() && wss.eof() && parts.empty()) { // Handle empty string input
+                throw std::invalid_argument("Empty version string segment or overall empty string");
+            }
+            if (segment.empty()) continue; // Skip trailing empty segments if any e.g. "1.2."
+
+            try {
+                parts.push_back(std::stoi(segment));
+            }
+            catch (const std::invalid_argument& ia) {
+                LOG_WARNING(L"Invalid version segment (not an int): '", segment, L"'. Error: ", Utf8ToWide(ia.what()).c_str());
+                throw std::invalid_argument("Version segment is not a valid integer");
+            }
+            catch (const std::out_of_range& oor) {
+                LOG_WARNING(L"Version segment out of range: '", segment, L"'. Error: ", Utf8ToWide(oor.what()).c_str());
+                throw std::invalid_argument("Version segment out of integer range");
+            }
+        }
+        if (parts.empty() && !versionStr.empty()) { // e.g. versionStr was "..."
+            throw std::invalid_argument("Version string contains no valid numeric parts.");
+        }
+        // No need to pad to 3 parts here, CompareVersions will handle different lengths.
+        return parts;
+    }
+
+    int CompareVersions(const std::wstring& version1, const std::wstring& version2) {
+        if (version1 == version2) return 0;
+
+        std::vector<int> v1_parts, v2_parts;
+        try {
+            v1_parts = ParseVersionString(version1);
+            v2_parts = ParseVersionString(version2);
+        }
+        catch (const std::invalid_argument& e) {
+            LOG_ERROR(L"Cannot compare versions due to parsing error: ", Utf8ToWide(e.what()).c_str());
+            throw;
+        }
+
+        size_t len = max(v1_parts.size(), v2_parts.size());
+        for (size_t i = 0; i < len; ++i) {
+            int p1 = (i < v1_parts.size()) ? v1_parts[i] : 0; // Pad with 0 for shorter version strings
+            int p2 = (i < v2_parts.size()) ? v2_parts[i] : 0;
+            if (p1 < p2) return -1;
+            if (p1 > p2) return 1;
+        }
+        return 0;
+    }
+
+
+    // 解析更新检查的响应并与当前版本比较 (同步与协程版本的检查共用)
+    static bool EvaluateUpdateResponse(
+        const std::string& responseBody,
+        const std::wstring& currentVersion,
+        const std::string& updateCheckUrl,
+        VersionInfo& outVersionInfo)
+    {
+        if (responseBody.empty()) {
+            LOG_WARNING(L"Update check URL returned empty response: ", Utf8ToWide(updateCheckUrl).c_str());
+            return false;
+        }
+
+        // --- JSON Parsing Placeholder ---
+        // This part needs a real JSON library. The manual parsing is extremely fragile.
+        // Assuming a simple JSON structure:
+        // { "latestVersion": "1.2.3", "downloadUrl": "http://...", "releaseNotes": "..." }
+        // Optional: "chunkIndexUrl": "http://..." enables incremental (chunked) download.
+        // Optional: "mirrors": ["http://...", ...] lists extra mirrors of the same package.
+        // Optional: "sha256": "<hex>" is checked against the downloaded package.
+        // For the sake_of_compilation, this pseudo-parser will remain, but it's bad.
+        size_t verPos = responseBody.find("\"latestVersion\": \"");
+        size_t urlPos = responseBody.find("\"downloadUrl\": \"");
+        size_t notesPos = responseBody.find("\"releaseNotes\": \"");
+
+        if (verPos != std::string::npos && urlPos != std::string::npos && notesPos != std::string::npos) {
+            verPos += strlen("\"latestVersion\": \"");
+            urlPos += strlen("\"downloadUrl\": \"");
+            notesPos += strlen("\"releaseNotes\": \"");
+
+            size_t verEnd = responseBody.find("\"", verPos);
+            size_t urlEnd = responseBody.find("\"", urlPos);
+            size_t notesEnd = responseBody.find("\"", notesPos);
+
+            if (verEnd != std::string::npos && urlEnd != std::string::npos && notesEnd != std::string::npos) {
+                outVersionInfo.versionString = Utf8ToWide(responseBody.substr(verPos, verEnd - verPos));
+                // C2679: outVersionInfo.downloadUrl is wstring, RHS is string.
+                outVersionInfo.downloadUrl = responseBody.substr(urlPos, urlEnd - urlPos); // This is std::string
+                outVersionInfo.releaseNotes = Utf8ToWide(responseBody.substr(notesPos, notesEnd - notesPos));
+                outVersionInfo.chunkIndexUrl.clear();
+                ExtractOptionalField(responseBody, "chunkIndexUrl", outVersionInfo.chunkIndexUrl);
+                outVersionInfo.mirrorUrls.clear();
+                ExtractOptionalArray(responseBody, "mirrors", outVersionInfo.mirrorUrls);
+                outVersionInfo.packageSha256.clear();
+                ExtractOptionalField(responseBody, "sha256", outVersionInfo.packageSha256);
+                std::transform(outVersionInfo.packageSha256.begin(), outVersionInfo.packageSha256.end(),
+                    outVersionInfo.packageSha256.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+            }
+            else {
+                LOG_ERROR(L"Failed to parse update information (malformed pseudo-JSON - missing end quotes).");
+                LOG_DEBUG(L"Response body: ", Utf8ToWide(responseBody).c_str());
+                return false;
+            }
+        }
+        else {
+            LOG_ERROR(L"Failed to parse update information (expected fields not found in pseudo-JSON).");
+            LOG_DEBUG(L"Response body: ", Utf8ToWide(responseBody).c_str());
+            return false;
+        }
+
+
+        if (outVersionInfo.versionString.empty() || outVersionInfo.downloadUrl.empty()) {
+            LOG_ERROR(L"Parsed update information is incomplete (missing version or URL string).");
+            return false;
+        }
+        // 版本号会用作暂存目录和版本目录名：只接受数字和点
+        if (!Install::IsValidVersionName(outVersionInfo.versionString)) {
+            LOG_ERROR(L"Rejected update information with invalid version string: ", outVersionInfo.versionString);
+            return false;
+        }
+
+        LOG_INFO(L"Latest version available: ", outVersionInfo.versionString, L". Download URL: ", Utf8ToWide(outVersionInfo.downloadUrl).c_str());
+        LOG_INFO(L"Release notes: ", outVersionInfo.releaseNotes);
+
+        try {
+            if (CompareVersions(outVersionInfo.versionString, currentVersion) > 0) {
+                LOG_INFO(L"A new version is available: ", outVersionInfo.versionString);
+                return true;
+            }
+            else {
+                LOG_INFO(L"Current version ", currentVersion, L" is up to date or newer.");
+                return false;
+            }
+        }
+        catch (const std::invalid_argument& e) {
+            LOG_ERROR(L"Error comparing versions: ", Utf8ToWide(e.what()).c_str());
+            return false;
+        }
+    }
+
+    bool CheckForUpdates(
+        const std::wstring& currentVersion,
+        const std::string& updateCheckUrl, // URL is std::string
+        VersionInfo& outVersionInfo,
+        std::map<std::string, std::string>* responseHeadersOut,
+        const CancellationToken& cancellation)
+    {
+        LOG_INFO(L"Checking for updates. Current version: ", currentVersion, L". Update URL: ", Utf8ToWide(updateCheckUrl).c_str());
+
+        std::string responseBody;
+        Network::ParsedUrl parsedUrl = Network::ParseUrl(updateCheckUrl); // C2589, C2059 fixed by assigning to var first
+        if (!parsedUrl.isValid) {
+            LOG_ERROR(L"Invalid update check URL: ", Utf8ToWide(updateCheckUrl).c_str());
+            return false;
+        }
+
+        // Construct full path for HttpGet
+        std::string fullPath = parsedUrl.path;
+        if (!parsedUrl.query.empty()) {
+            fullPath += "?" + parsedUrl.query;
+        }
+
+
+        // C2660: HttpGet takes 7 arguments. The call was missing some or had wrong types.
+        // bool HttpGet(const std::string& host, const std::string& path, unsigned short port,
+        //              std::string& responseBody, std::map<std::string, std::string>* responseHeadersOutParam = nullptr,
+        //              bool useHTTPSParam = false, int timeoutMsParam = 5000)
+        if (!Network::HttpGet(parsedUrl.host, fullPath, parsedUrl.port, responseBody,
+            responseHeadersOut, (parsedUrl.scheme == "https"), 10000 /*timeout 10s*/, nullptr, cancellation)) {
+            if (!cancellation.IsCancellationRequested()) {
+                LOG_ERROR(L"Failed to fetch update information from: ", Utf8ToWide(updateCheckUrl).c_str());
+            }
+            return false;
+        }
+
+        return EvaluateUpdateResponse(responseBody, currentVersion, updateCheckUrl, outVersionInfo);
+    }
+
+    Coro::Task<bool> CheckForUpdatesAsync(
+        ThreadPool& pool,
+        std::wstring currentVersion,
+        std::string updateCheckUrl,
+        VersionInfo& outVersionInfo,
+        std::map<std::string, std::string>* responseHeadersOut,
+        CancellationToken cancellation)
+    {
+        LOG_INFO(L"Checking for updates (async). Current version: ", currentVersion, L". Update URL: ", Utf8ToWide(updateCheckUrl).c_str());
+
+        // 请求在 Network 的事件循环中进行，等待期间不占用工作线程
+        Network::HttpResponse response = co_await Coro::HttpGet(pool, updateCheckUrl, nullptr, 10000 /*timeout 10s*/, cancellation);
+        if (response.canceled) {
+            co_return false;
+        }
+        if (!response.success) {
+            LOG_ERROR(L"Failed to fetch update information from: ", Utf8ToWide(updateCheckUrl).c_str());
+            co_return false;
+        }
+        if (responseHeadersOut) {
+            *responseHeadersOut = std::move(response.headers);
+        }
+
+        co_return EvaluateUpdateResponse(response.body, currentVersion, updateCheckUrl, outVersionInfo);
+    }
+
+
+    // ZIP 更新包解压后由包根目录下的此程序完成安装
+    static const wchar_t* kStagedInstallerName = L"setup.exe";
+
+    static bool IsZipPackage(const std::wstring& fileName) {
+        if (fileName.size() < 4) return false;
+        std::wstring ext = fileName.substr(fileName.size() - 4);
+        std::transform(ext.begin(), ext.end(), ext.begin(), ::towlower);
+        return ext == L".zip";
+    }
+
+    // 通过本地块库增量下载更新包，只获取本地缺失的块
+    static bool DownloadWithChunkStore(
+        const VersionInfo& versionToUpdate,
+        const std::string& packageUrl,
+        const std::wstring& tempDir,
+        const std::wstring& outputPath,
+        std::function<void(long long, long long)> progressCallback,
+        const CancellationToken& cancellation)
+    {
+        std::string indexText;
+        if (!Network::HttpGetUrl(versionToUpdate.chunkIndexUrl, indexText, nullptr, nullptr, 10000, cancellation)) {
+            LOG_WARNING(L"Failed to fetch chunk index from: ", Utf8ToWide(versionToUpdate.chunkIndexUrl).c_str());
+            return false;
+        }
+
+        Chunking::ChunkIndex index;
+        if (!Chunking::ParseChunkIndex(indexText, index)) {
+            LOG_WARNING(L"Invalid chunk index from: ", Utf8ToWide(versionToUpdate.chunkIndexUrl).c_str());
+            return false;
+        }
+
+        Chunking::ChunkStore store(g_appDataDir + L"\\Chunks");
+
+        // 之前留在临时目录中的更新包并入块库后删除，其内容由块库保存
+        WIN32_FIND_DATAW findData;
+        HANDLE hFind = FindFirstFileW((tempDir + L"\\*").c_str(), &findData);
+        if (hFind != INVALID_HANDLE_VALUE) {
+            do {
+                if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+                    continue;
+                }
+                std::wstring oldPackage = tempDir + L"\\" + findData.cFileName;
+                if (oldPackage != outputPath) {
+                    store.IngestFile(oldPackage, g_pThreadPool, cancellation);
+                    if (cancellation.IsCancellationRequested()) {
+                        break; // 没有完整并入块库的包留到下次
+                    }
+                    DeleteFileW(oldPackage.c_str());
+                }
+            } while (FindNextFileW(hFind, &findData));
+            FindClose(hFind);
+        }
+        if (cancellation.IsCancellationRequested()) {
+            return false;
+        }
+
+        if (!Chunking::AssembleFromChunks(packageUrl, index, store, g_pThreadPool, outputPath, progressCallback, cancellation)) {
+            return false;
+        }
+
+        store.Prune(index, cancellation); // 只保留当前版本的块，作为下次增量更新的基础
+        return true;
+    }
+
+
+    bool DownloadAndApplyUpdate(
+        const VersionInfo& versionToUpdate, // versionToUpdate.downloadUrl is std::string
+        std::function<void(long long, long long)> progressCallback,
+        std::function<bool()> restartAppCallback,
+        const CancellationToken& callerCancellation)
+    {
+        // versionToUpdate.downloadUrl is std::string as per VersionInfo struct and parsing logic
+        if (versionToUpdate.downloadUrl.empty()) {
+            LOG_ERROR(L"Download URL for update is empty.");
+            return false;
+        }
+
+        std::wstring tempDir = g_appDataDir + L"\\Temp";
+        if (!DirectoryExists(tempDir)) {
+            if (!CreateDirectoryRecursive(tempDir)) {
+                LOG_ERROR(L"Failed to create temporary directory for update: ", tempDir.c_str());
+                return false;
+            }
+        }
+
+        std::wstring fileName = L"update_package_default_name.dat"; // Default name
+        // versionToUpdate.downloadUrl is std::string. Need to convert to wstring for find_last_of if used with L'/'
+        // Or, use std::string version of find_last_of with '/'
+        size_t lastSlashUrl = versionToUpdate.downloadUrl.find_last_of('/');
+        if (lastSlashUrl != std::string::npos) {
+            // C2664: Utf8ToWide expects std::string, versionToUpdate.downloadUrl.substr(...) is std::string. This is OK.
+            fileName = Utf8ToWide(versionToUpdate.downloadUrl.substr(lastSlashUrl + 1));
+        }
+
+        // Sanitize filename (basic)
+        // C2039, C3861 std::replace: needs <algorithm>. It operates on iterators.
+        std::replace(fileName.begin(), fileName.end(), L'?', L'_'); // Ok for wstring
+        std::replace(fileName.begin(), fileName.end(), L'&', L'_'); // Ok for wstring
+
+
+        std::wstring downloadedFilePath = tempDir + L"\\" + fileName;
+
+        LOG_INFO(L"Downloading update from: ", Utf8ToWide(versionToUpdate.downloadUrl).c_str(), L" to: ", downloadedFilePath.c_str());
+
+        // 程序退出 (线程池关闭) 或调用方取消时中止下载
+        CancellationSource linked;
+        CancellationToken shutdown = g_pThreadPool ? g_pThreadPool->GetShutdownToken() : CancellationToken();
+        CancellationRegistration onShutdown = shutdown.Register([linked]() mutable { linked.Cancel(); });
+        CancellationRegistration onCallerCancel = callerCancellation.Register([linked]() mutable { linked.Cancel(); });
+        CancellationToken cancellation = linked.GetToken();
+
+        // 列出了镜像时先并行探测，按实测速度排序，最快的镜像优先
+        std::vector<Mirrors::MirrorStats> rankedMirrors;
+        long long packageSize = -1;
+        std::string packageUrl = versionToUpdate.downloadUrl;
+        if (!versionToUpdate.mirrorUrls.empty()) {
+            std::vector<std::string> urls{ versionToUpdate.downloadUrl };
+            for (const std::string& mirror : versionToUpdate.mirrorUrls) {
+                if (std::find(urls.begin(), urls.end(), mirror) == urls.end()) urls.push_back(mirror);
+            }
+            // urls[0] 是更新信息中的 downloadUrl：与它提供的文件不一致的镜像被排除
+            rankedMirrors = Mirrors::ProbeAndRank(urls, g_pThreadPool, &packageSize, cancellation);
+            if (cancellation.IsCancellationRequested()) {
+                LOG_INFO(L"Update download canceled.");
+                return false;
+            }
+            if (!rankedMirrors.empty() && rankedMirrors.front().reachable) {
+                packageUrl = rankedMirrors.front().url;
+            }
+        }
+
+        bool downloaded = false;
+        bool verified = false; // 已经按 packageSha256 校验过 (镜像分段下载在内部校验)
+        if (!versionToUpdate.chunkIndexUrl.empty()) {
+            downloaded = DownloadWithChunkStore(versionToUpdate, packageUrl, tempDir, downloadedFilePath, progressCallback, cancellation);
+            if (cancellation.IsCancellationRequested()) {
+                LOG_INFO(L"Update download canceled.");
+                return false;
+            }
+            if (!downloaded) {
+                LOG_WARNING(L"Incremental chunked download failed. Falling back to full package download.");
+            }
+        }
+
+        if (!downloaded && !rankedMirrors.empty()) {
+            // 分段下载，镜像失败时从当前偏移切换到下一个镜像
+            downloaded = Mirrors::DownloadWithFailover(rankedMirrors, packageSize, downloadedFilePath, progressCallback, cancellation,
+                versionToUpdate.packageSha256);
+            if (!downloaded) {
+                LOG_ERROR(L"Failed to download update package from any mirror.");
+                return false;
+            }
+            verified = !versionToUpdate.packageSha256.empty();
+        }
+
+        // C2664: DownloadFile expects const std::string& for URL. versionToUpdate.downloadUrl is already std::string.
+        if (!downloaded && !Network::DownloadFile(versionToUpdate.downloadUrl, downloadedFilePath, progressCallback, cancellation)) {
+            LOG_ERROR(L"Failed to download update package from: ", Utf8ToWide(versionToUpdate.downloadUrl).c_str());
+            if (FileExists(downloadedFilePath)) {
+                DeleteFileW(downloadedFilePath.c_str());
+            }
+            return false;
+        }
+
+        LOG_INFO(L"Update package downloaded successfully: ", downloadedFilePath.c_str());
+        if (!versionToUpdate.packageSha256.empty() && !verified) {
+            std::string actualHash;
+            if (!Sha256FileHex(downloadedFilePath, actualHash) || actualHash != versionToUpdate.packageSha256) {
+                LOG_ERROR(L"Update package hash mismatch: ", downloadedFilePath.c_str());
+                DeleteFileW(downloadedFilePath.c_str());
+                return false;
+            }
+        }
+        if (versionToUpdate.packageSha256.empty()) {
+            LOG_WARNING(L"Update information has no sha256. Package integrity is NOT verified. This is a security risk.");
+        }
+        LOG_WARNING(L"Update package signature verification is NOT IMPLEMENTED.");
+
+        // ZIP 更新包先并行解压到暂存目录，再运行包内的安装程序
+        std::wstring installerPath = downloadedFilePath;
+        std::wstring installerDir;
+        if (IsZipPackage(fileName)) {
+            if (!Install::IsValidVersionName(versionToUpdate.versionString)) {
+                LOG_ERROR(L"Refusing to stage update with invalid version string: ", versionToUpdate.versionString);
+                return false;
+            }
+            std::wstring stagingRoot = g_appDataDir + L"\\Staging";
+            std::wstring stagingDir = stagingRoot + L"\\" + versionToUpdate.versionString;
+            DeleteDirectoryUnder(stagingRoot, stagingDir); // 清理上次未完成的暂存
+            if (!Archive::ExtractZip(downloadedFilePath, stagingDir, g_pThreadPool, progressCallback, cancellation)) {
+                if (cancellation.IsCancellationRequested()) {
+                    LOG_INFO(L"Update staging canceled.");
+                    return false;
+                }
+                LOG_ERROR(L"Failed to stage update package: ", downloadedFilePath.c_str());
+                return false;
+            }
+
+            if (FileExists(stagingDir + L"\\" + Install::kManifestFileName)) {
+                // 带文件清单的包：在当前版本旁边构建新版本并原子切换，然后直接启动新版本
+                std::wstring versionDir;
+                if (!Install::InstallStagedVersion(stagingDir, versionToUpdate.versionString, progressCallback, &versionDir, cancellation)) {
+                    if (cancellation.IsCancellationRequested()) {
+                        LOG_INFO(L"Side-by-side installation canceled.");
+                        return false;
+                    }
+                    LOG_ERROR(L"Side-by-side installation failed for version: ", versionToUpdate.versionString);
+                    return false;
+                }
+                DeleteDirectoryUnder(stagingRoot, stagingDir);
+                Install::RemoveStaleVersions();
+
+                std::wstring exePath = GetExecutablePath();
+                installerPath = versionDir + exePath.substr(exePath.find_last_of(L"\\/"));
+                installerDir = versionDir;
+            }
+            else {
+                installerPath = stagingDir + L"\\" + kStagedInstallerName;
+                installerDir = stagingDir;
+            }
+            if (!FileExists(installerPath)) {
+                LOG_ERROR(L"Staged update package does not contain an executable to launch: ", installerPath.c_str());
+                return false;
+            }
+        }
+
+        LOG_INFO(L"Update package ready at: ", installerPath.c_str());
+        LOG_INFO(L"To apply the update, the application typically needs to restart and run an updater/installer.");
+
+        if (restartAppCallback) {
+            LOG_INFO(L"Requesting application restart to apply update...");
+            PROCESS_INFORMATION pi;
+            if (SystemOps::ExecuteProcess(installerPath, L"", installerDir, false, &pi, false)) {
+                LOG_INFO(L"Launched updater/installer: ", installerPath.c_str(), L" PID: ", pi.dwProcessId);
+                CloseHandle(pi.hProcess);
+                CloseHandle(pi.hThread);
+
+                if (restartAppCallback()) {
+                    LOG_INFO(L"Restart callback initiated successfully.");
+                    return true;
+                }
+                else {
+                    LOG_ERROR(L"Restart callback failed to initiate application shutdown.");
+                    return false;
+                }
+            }
+            else {
+                LOG_ERROR(L"Failed to launch updater/installer: ", installerPath.c_str());
+                return false;
+            }
+        }
+        else {
+            LOG_WARNING(L"No restart callback provided. Update downloaded but not applied.");
+            return false;
+        }
+    }
+
+} // namespace Update
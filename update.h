@@ -1,72 +1,104 @@
-#ifndef UPDATE_H
-#define UPDATE_H
-
-#include <string>
-#include <functional> // For std::function
-
-namespace Update {
-
-    struct VersionInfo {
-        std::wstring versionString; //  "1.2.3"
-        std::wstring downloadUrl;   // °صַ
-        std::wstring releaseNotes;  // ־
-        // ֶΣ緢ڡļСУ͵
-        // int major, minor, patch, build; // Parsed version numbers
-    };
-
-    /**
-     * @brief Ƿ°汾
-     * @param currentVersion ǰӦóİ汾ַ ( "1.0.0")
-     * @param updateCheckUrl ڻȡ°汾Ϣ URL (һ JSON ļ)
-     * @param outVersionInfo [out] °汾°汾Ϣ
-     * @return °汾򷵻 true򷵻 false
-     * ʧܣ󡢽ȣҲ false
-     */
-    bool CheckForUpdates(
-        const std::wstring& currentVersion,
-        const std::string& updateCheckUrl, // URL ͨ ASCII/UTF-8
-        VersionInfo& outVersionInfo
-    );
-
-    /**
-     * @brief زӦø¡
-     * @param versionToUpdate Ҫµİ汾Ϣ (ͨ CheckForUpdates ȡ)
-     * @param progressCallback Ȼص (ֽ, ֽ)
-     * @param restartAppCallback ɺӦóӦøµĻص
-     * ˻صӦرյǰʵصĸ³/װ
-     * @return غ׼³ɹ򷵻 trueʵӦøͨɸ³ɡ
-     *
-     * @note һ߶ȼ򻯵ģ͡ʵʵĸ¹̷ǳӣ漰
-     * 1. ظ° (ǰװѹļ)
-     * 2. ֤°Ժǩ (ȫ)
-     * 3. ѹ/׼¡
-     * 4. (ؼ) ǰеĳͨ޷ֱ滻ļ
-     * ͨǣ
-     * a. һС͵ĸ (updater.exe)
-     * b. ˳ updater.exe
-     * c. updater.exe 滻ļ
-     * d. updater.exe °汾
-     * e. updater.exe ˳ (ɾ)
-     * ߣ°һװزиðװ
-     */
-    bool DownloadAndApplyUpdate(
-        const VersionInfo& versionToUpdate,
-        std::function<void(long long, long long)> progressCallback,
-        std::function<bool()> restartAppCallback // Returns true if restart was initiated
-    );
-
-
-    /**
-     * @brief Ƚ汾ַ
-     * @param version1 汾ַ1 ( "1.2.3")
-     * @param version2 汾ַ2 ( "1.2.10")
-     * @return  0  version1 == version2
-     * >0  version1 > version2
-     * <0  version1 < version2
-     * Throws std::invalid_argument on parse error.
-     */
-    int CompareVersions(const std::wstring& version1, const std::wstring& version2);
-
-} // namespace Update
-
-#endif // UPDATE_H
+#ifndef UPDATE_H
+#define UPDATE_H
+
+#include <string>
+#include <functional> // For std::function
+#include <map>
+#include <vector>
+
+#include "coro.h"
+
+namespace Update {
+
+    struct VersionInfo {
+        std::wstring versionString; // 例如 "1.2.3"
+        std::string downloadUrl;    // 更新包的下载地址 (URL 为 ASCII/UTF-8)
+        std::string chunkIndexUrl;  // 块索引地址 (可选，提供时走增量下载，见 chunk_store.h)
+        std::vector<std::string> mirrorUrls; // 其他镜像上的同一更新包 (可选，与 downloadUrl 一起探测排序，见 mirrors.h)
+        std::string packageSha256;  // 更新包的 SHA-256 (可选，小写十六进制)：下载完成后校验
+        std::wstring releaseNotes;  // 更新日志或描述
+        // 可以添加其他字段，如发布日期、文件大小、校验和等
+        // int major, minor, patch, build; // Parsed version numbers
+    };
+
+    /**
+     * @brief 检查是否有新版本。
+     * @param currentVersion 当前应用程序的版本字符串 (例如 "1.0.0")。
+     * @param updateCheckUrl 用于获取最新版本信息的 URL (例如一个 JSON 文件)。
+     * @param outVersionInfo [out] 如果有新版本，这里会填充新版本的信息。
+     *        检查成功时 versionString 总会被填充为服务器上的最新版本，失败时保持为空。
+     * @param responseHeadersOut [out] 响应头 (可选，供调度器读取 Retry-After / Cache-Control)。
+     * @param cancellation 取消令牌 (可选)，取消时请求立即中止并返回 false。
+     * @return 如果有新版本则返回 true，否则返回 false。
+     * 如果检查失败（网络错误、解析错误、被取消等），也返回 false。
+     */
+    bool CheckForUpdates(
+        const std::wstring& currentVersion,
+        const std::string& updateCheckUrl, // URL 通常是 ASCII/UTF-8
+        VersionInfo& outVersionInfo,
+        std::map<std::string, std::string>* responseHeadersOut = nullptr,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+    /**
+     * @brief CheckForUpdates 的协程版本：等待网络响应时挂起，不阻塞线程池的工作线程。
+     * @param pool 恢复协程的线程池。
+     * @param outVersionInfo 协程结束前须保持有效。
+     * @return co_await 的结果与 CheckForUpdates 的返回值相同。
+     */
+    Coro::Task<bool> CheckForUpdatesAsync(
+        ThreadPool& pool,
+        std::wstring currentVersion,
+        std::string updateCheckUrl,
+        VersionInfo& outVersionInfo,
+        std::map<std::string, std::string>* responseHeadersOut = nullptr,
+        CancellationToken cancellation = CancellationToken()
+    );
+
+    /**
+     * @brief 下载并应用更新。
+     * @param versionToUpdate 要更新到的版本信息 (通常从 CheckForUpdates 获取)。
+     * @param progressCallback 进度回调 (已下载字节, 总字节)。
+     * @param restartAppCallback 更新完成后，用于请求应用程序重启以应用更新的回调。
+     * 此回调应负责关闭当前实例并启动新下载的更新程序/安装包。
+     * @param cancellation 调用方的取消令牌 (例如定时检查调度器的令牌)。
+     * 下载过程同时观察它和 g_pThreadPool 的关闭令牌，程序退出时不会等到下载超时。
+     * @return 如果下载和准备更新成功则返回 true。实际应用更新通常在重启后由更新程序完成。
+     *
+     * @note 这是一个高度简化的模型。实际的更新过程非常复杂，涉及：
+     * 1. 下载更新包 (可能是安装程序或压缩文件)。
+     * 2. 验证更新包的完整性和签名 (安全性)。
+     * 3. 解压/准备更新。
+     * 4. (关键) 当前运行的程序通常无法直接替换自身文件。
+     * 通常的做法是：
+     * a. 下载一个小型的更新引导程序 (updater.exe)。
+     * b. 主程序退出，并运行 updater.exe。
+     * c. updater.exe 替换主程序文件。
+     * d. updater.exe 重新启动主程序的新版本。
+     * e. updater.exe 自身退出 (可能自删除)。
+     * 或者，更新包本身是一个安装程序，主程序下载并运行该安装程序。
+     * ZIP 格式的更新包会先并行解压到 g_appDataDir\Staging\<版本>，再运行包根目录下的 setup.exe；
+     * 若包根目录带有文件清单 (files.manifest)，则改为并排安装 (见 install.h) 并直接启动新版本。
+     */
+    bool DownloadAndApplyUpdate(
+        const VersionInfo& versionToUpdate,
+        std::function<void(long long, long long)> progressCallback,
+        std::function<bool()> restartAppCallback, // Returns true if restart was initiated
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+
+    /**
+     * @brief 比较两个版本字符串。
+     * @param version1 版本字符串1 (例如 "1.2.3")。
+     * @param version2 版本字符串2 (例如 "1.2.10")。
+     * @return  0 如果 version1 == version2
+     * >0 如果 version1 > version2
+     * <0 如果 version1 < version2
+     * Throws std::invalid_argument on parse error.
+     */
+    int CompareVersions(const std::wstring& version1, const std::wstring& version2);
+
+} // namespace Update
+
+#endif // UPDATE_H
@@ -0,0 +1,417 @@
+#define LOG_MODULE LogModule::Update // 本文件的日志属于更新模块 (见 log.h)
+#include "update_scheduler.h"
+#include "threads.h"
+#include "config.h"
+#include "globals.h"    // For g_appVersion
+#include "log.h"
+#include "utils.h"      // For Utf8ToWide, WideToUtf8
+#include "system_ops.h" // For IsOnBatteryPower, IsNetworkMetered
+
+#include <ctime>
+#include <cstring>   // For strlen
+#include <sstream>
+#include <iomanip>   // For std::get_time
+#include <algorithm> // For std::clamp, std::transform
+
+namespace {
+
+    const wchar_t* kSettingsSection = L"Update";
+    const wchar_t* kStateSection = L"UpdateScheduler";
+
+    // 暂停 (电池/计费网络) 时的复查间隔
+    const std::chrono::seconds kPausedRecheckDelay(15 * 60);
+    // 检查失败后的首次重试间隔，之后按指数退避
+    const std::chrono::seconds kFailureRetryBase(5 * 60);
+    // 服务器提示的间隔上限，防止错误的响应头让客户端长期不再检查
+    const std::chrono::seconds kMaxServerHint(7 * 24 * 3600);
+    // 自适应间隔取平均发布间隔的 1/N
+    const int kChecksPerReleaseInterval = 8;
+    // 平均发布间隔的 EWMA 权重
+    const double kReleaseIntervalAlpha = 0.3;
+
+    long long WallClockNow() {
+        return static_cast<long long>(std::time(nullptr));
+    }
+
+    long long ParseInt64(const std::wstring& text, long long defaultValue) {
+        if (text.empty()) return defaultValue;
+        try {
+            return std::stoll(text);
+        }
+        catch (...) {
+            return defaultValue;
+        }
+    }
+
+    double ParseDouble(const std::wstring& text, double defaultValue) {
+        if (text.empty()) return defaultValue;
+        try {
+            return std::stod(text);
+        }
+        catch (...) {
+            return defaultValue;
+        }
+    }
+
+    // 响应头名称不区分大小写
+    const std::string* FindHeader(const std::map<std::string, std::string>& headers, const std::string& name) {
+        for (const auto& kv : headers) {
+            if (kv.first.size() == name.size() &&
+                std::equal(kv.first.begin(), kv.first.end(), name.begin(),
+                    [](char a, char b) { return ::tolower(static_cast<unsigned char>(a)) == ::tolower(static_cast<unsigned char>(b)); })) {
+                return &kv.second;
+            }
+        }
+        return nullptr;
+    }
+
+    // Retry-After: delta-seconds 或 HTTP-date (RFC 7231 7.1.3)
+    long long ParseRetryAfter(const std::string& value, long long now) {
+        if (value.empty()) return 0;
+        if (std::all_of(value.begin(), value.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            try {
+                return std::stoll(value);
+            }
+            catch (...) {
+                return 0;
+            }
+        }
+
+        // 例如 "Sun, 06 Nov 1994 08:49:37 GMT"
+        std::tm tm = {};
+        std::istringstream iss(value);
+        iss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+        if (iss.fail()) return 0;
+        long long when = static_cast<long long>(_mkgmtime(&tm));
+        return when > now ? when - now : 0;
+    }
+
+    // Cache-Control: max-age=N
+    long long ParseMaxAge(const std::string& value) {
+        std::string lower = value;
+        std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return static_cast<char>(::tolower(c)); });
+        size_t pos = lower.find("max-age=");
+        if (pos == std::string::npos) return 0;
+        pos += strlen("max-age=");
+        long long seconds = 0;
+        while (pos < lower.size() && lower[pos] >= '0' && lower[pos] <= '9') {
+            seconds = seconds * 10 + (lower[pos] - '0');
+            if (seconds > kMaxServerHint.count()) break;
+            ++pos;
+        }
+        return seconds;
+    }
+
+    // 服务器通过响应头给出的最短检查间隔
+    std::chrono::seconds ServerHint(const std::map<std::string, std::string>& headers, long long now) {
+        long long hint = 0;
+        if (const std::string* retryAfter = FindHeader(headers, "Retry-After")) {
+            hint = (std::max)(hint, ParseRetryAfter(*retryAfter, now));
+        }
+        if (const std::string* cacheControl = FindHeader(headers, "Cache-Control")) {
+            hint = (std::max)(hint, ParseMaxAge(*cacheControl));
+        }
+        return std::chrono::seconds((std::min)(hint, static_cast<long long>(kMaxServerHint.count())));
+    }
+
+} // namespace
+
+
+UpdateScheduler::UpdateScheduler(ThreadPool& pool, Config& config)
+    : m_pool(pool),
+    m_config(config),
+    m_settings(LoadSettings(config)),
+    m_stop(false),
+    m_running(false),
+    m_checkInFlight(false),
+    m_outstanding(0),
+    m_consecutiveFailures(0),
+    m_rng(std::random_device{}()) {
+}
+
+UpdateScheduler::~UpdateScheduler() {
+    Stop();
+}
+
+UpdateScheduler::Settings UpdateScheduler::LoadSettings(const Config& config) {
+    Settings s;
+    s.checkUrl = WideToUtf8(config.GetString(kSettingsSection, L"CheckUrl", L""));
+    s.checkIntervalMinutes = config.GetInt(kSettingsSection, L"CheckIntervalMinutes", s.checkIntervalMinutes);
+    s.minIntervalMinutes = config.GetInt(kSettingsSection, L"MinIntervalMinutes", s.minIntervalMinutes);
+    s.maxIntervalMinutes = config.GetInt(kSettingsSection, L"MaxIntervalMinutes", s.maxIntervalMinutes);
+    s.jitterPercent = config.GetInt(kSettingsSection, L"JitterPercent", s.jitterPercent);
+    s.pauseOnBattery = config.GetBool(kSettingsSection, L"PauseOnBattery", s.pauseOnBattery);
+    s.pauseOnMetered = config.GetBool(kSettingsSection, L"PauseOnMetered", s.pauseOnMetered);
+    s.initialDelaySeconds = config.GetInt(kSettingsSection, L"InitialDelaySeconds", s.initialDelaySeconds);
+
+    // 修正不合理的配置
+    s.minIntervalMinutes = (std::max)(s.minIntervalMinutes, 5);
+    s.maxIntervalMinutes = (std::max)(s.maxIntervalMinutes, s.minIntervalMinutes);
+    s.checkIntervalMinutes = std::clamp(s.checkIntervalMinutes, s.minIntervalMinutes, s.maxIntervalMinutes);
+    s.jitterPercent = std::clamp(s.jitterPercent, 0, 50);
+    s.initialDelaySeconds = (std::max)(s.initialDelaySeconds, 0);
+    return s;
+}
+
+bool UpdateScheduler::Start(std::function<void(const Update::VersionInfo&, const CancellationToken&)> onUpdateAvailable) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_running) return true;
+
+    if (m_settings.checkUrl.empty()) {
+        LOG_WARNING(L"Update check URL is not configured ([Update] CheckUrl). Scheduled update checks are disabled.");
+        return false;
+    }
+
+    m_onUpdateAvailable = std::move(onUpdateAvailable);
+
+    // 首次检查：启动延迟 (加抖动)，但如果上次运行时已安排了更晚的检查时间则沿用，
+    // 避免频繁重启程序导致额外的检查请求
+    std::chrono::seconds delay = ApplyJitter(std::chrono::seconds(m_settings.initialDelaySeconds), false);
+    long long persistedNext = ParseInt64(m_config.GetString(kStateSection, L"NextCheckAt", L""), 0);
+    long long untilPersisted = persistedNext - WallClockNow();
+    if (untilPersisted > delay.count()) {
+        delay = std::chrono::seconds((std::min)(untilPersisted, static_cast<long long>(m_settings.maxIntervalMinutes) * 60));
+    }
+
+    m_cancel = CancellationSource();
+    m_stop = false;
+    m_running = true;
+    lock.unlock();
+
+    ArmTimer(delay);
+    LOG_INFO(L"Update scheduler started. First check in ", delay.count(), L" seconds.");
+    return true;
+}
+
+void UpdateScheduler::Stop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (!m_running) return;
+    m_stop = true;
+    CancellationSource cancel = m_cancel;
+    lock.unlock();
+
+    // 取消尚未到期的定时器 (注册在令牌上)，进行中的检查立即中止，不必等到请求超时
+    cancel.Cancel();
+
+    // 等待已经到期、提交到线程池的定时任务和进行中的检查结束 (它们引用了 this)
+    lock.lock();
+    m_cv.wait(lock, [this] { return m_outstanding == 0; });
+    m_running = false;
+    LOG_INFO(L"Update scheduler stopped.");
+}
+
+void UpdateScheduler::CheckNow() {
+    TimerId timer;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running || m_stop || m_checkInFlight) return;
+        timer = m_timer;
+    }
+    // 定时器恰好已经到期时检查马上就会开始，不必重新安排
+    if (m_pool.CancelTimer(timer)) {
+        ArmTimer(std::chrono::seconds::zero());
+    }
+}
+
+void UpdateScheduler::ArmTimer(std::chrono::seconds delay) {
+    TaskOptions background;
+    background.priority = TaskPriority::Background; // 定时检查不与前台任务争抢线程
+    background.blocking = true;                     // 同步的网络请求
+    background.tag = "update-check";
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) return;
+        background.cancellation = m_cancel.GetToken();
+        m_outstanding += 2; // 定时器任务本身，以及本次调用 (返回前还会访问成员)
+    }
+
+    TimerId timer;
+    bool scheduled = true;
+    try {
+        timer = m_pool.post_after(delay, TimerTask{ this }, background);
+    }
+    catch (const std::exception& e) {
+        LOG_WARNING(L"Failed to schedule update check: ", Utf8ToWide(e.what()).c_str());
+        scheduled = false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (scheduled) {
+        m_timer = timer;
+    }
+    else {
+        --m_outstanding;
+    }
+    --m_outstanding;
+    m_cv.notify_all();
+}
+
+void UpdateScheduler::OnTimer() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stop) {
+            --m_outstanding;
+            m_cv.notify_all();
+            return;
+        }
+        m_checkInFlight = true; // 定时器任务的计数转给检查，由 ScheduleNext 或取消时释放
+    }
+    RunCheck();
+}
+
+void UpdateScheduler::OnTimerCanceled() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_outstanding;
+    m_cv.notify_all();
+}
+
+void UpdateScheduler::ScheduleNext(std::chrono::seconds delay) {
+    long long nextAt = WallClockNow() + delay.count();
+    m_config.SetString(kStateSection, L"NextCheckAt", std::to_wstring(nextAt));
+    if (!m_config.Save()) {
+        LOG_WARNING(L"Failed to persist update scheduler state.");
+    }
+
+    // 先安排下一次再结束本次检查，Stop 不会在两者之间返回
+    ArmTimer(delay);
+    LOG_INFO(L"Next update check in ", delay.count() / 60, L" minutes.");
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_checkInFlight = false;
+    --m_outstanding;
+    m_cv.notify_all();
+}
+
+void UpdateScheduler::RunCheck() {
+    if (m_settings.pauseOnBattery && SystemOps::IsOnBatteryPower()) {
+        LOG_INFO(L"Running on battery power. Scheduled update check paused.");
+        ScheduleNext(ApplyJitter(kPausedRecheckDelay, false));
+        return;
+    }
+    if (m_settings.pauseOnMetered && SystemOps::IsNetworkMetered()) {
+        LOG_INFO(L"Metered network connection detected. Scheduled update check paused.");
+        ScheduleNext(ApplyJitter(kPausedRecheckDelay, false));
+        return;
+    }
+
+    CancellationToken cancellation;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        cancellation = m_cancel.GetToken();
+    }
+
+    Update::VersionInfo info;
+    std::map<std::string, std::string> headers;
+    bool updateAvailable = false;
+    try {
+        updateAvailable = Update::CheckForUpdates(g_appVersion, m_settings.checkUrl, info, &headers, cancellation);
+    }
+    catch (const std::exception& e) {
+        LOG_WARNING(L"Scheduled update check threw: ", Utf8ToWide(e.what()).c_str());
+    }
+
+    // 调度器正在停止：不计为失败，也不安排下一次检查
+    if (cancellation.IsCancellationRequested()) {
+        LOG_INFO(L"Scheduled update check canceled.");
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_checkInFlight = false;
+        --m_outstanding;
+        m_cv.notify_all();
+        return;
+    }
+
+    long long now = WallClockNow();
+    // CheckForUpdates 在拿到并解析出服务器版本时才会填充 versionString
+    bool succeeded = !info.versionString.empty();
+
+    std::chrono::seconds delay;
+    if (succeeded) {
+        m_consecutiveFailures = 0;
+        RecordObservedVersion(info.versionString, now);
+        delay = ApplyJitter(AdaptiveInterval(), false);
+    }
+    else {
+        ++m_consecutiveFailures;
+        delay = ApplyJitter(FailureBackoff(), false);
+    }
+
+    // 服务器提示作为下限；提示占主导时只向上抖动，避免所有客户端在同一时刻重试
+    std::chrono::seconds hint = ServerHint(headers, now);
+    if (hint > delay) {
+        LOG_DEBUG(L"Honoring server-provided retry hint: ", hint.count(), L" seconds.");
+        delay = ApplyJitter(hint, true);
+    }
+
+    m_config.SetString(kStateSection, L"LastCheckAt", std::to_wstring(now));
+
+    if (updateAvailable && m_onUpdateAvailable) {
+        // 处理函数可能等待用户确认、下载整个更新包：作为独立任务执行，不计入 m_outstanding，
+        // Stop 不等待它，只通过令牌让它尽快结束。任务不引用 this
+        TaskOptions install;
+        install.blocking = true;
+        install.tag = "update-install";
+        try {
+            m_pool.post_with(install, [handler = m_onUpdateAvailable, info, cancellation]() {
+                if (cancellation.IsCancellationRequested()) {
+                    return;
+                }
+                try {
+                    handler(info, cancellation);
+                }
+                catch (const std::exception& e) {
+                    LOG_WARNING(L"Update-available handler threw: ", Utf8ToWide(e.what()).c_str());
+                }
+            });
+        }
+        catch (const std::exception& e) {
+            LOG_WARNING(L"Failed to start update-available handler: ", Utf8ToWide(e.what()).c_str());
+        }
+    }
+
+    ScheduleNext(delay);
+}
+
+void UpdateScheduler::RecordObservedVersion(const std::wstring& latestVersion, long long now) {
+    std::wstring lastSeen = m_config.GetString(kStateSection, L"LastSeenVersion", L"");
+    if (lastSeen == latestVersion) return;
+
+    if (!lastSeen.empty()) {
+        long long lastReleaseAt = ParseInt64(m_config.GetString(kStateSection, L"LastReleaseSeenAt", L""), 0);
+        if (lastReleaseAt > 0 && now > lastReleaseAt) {
+            double gapHours = static_cast<double>(now - lastReleaseAt) / 3600.0;
+            double avgHours = ParseDouble(m_config.GetString(kStateSection, L"AvgReleaseIntervalHours", L""), 0.0);
+            avgHours = (avgHours > 0.0) ? (kReleaseIntervalAlpha * gapHours + (1.0 - kReleaseIntervalAlpha) * avgHours) : gapHours;
+            m_config.SetString(kStateSection, L"AvgReleaseIntervalHours", std::to_wstring(avgHours));
+            LOG_INFO(L"New release observed (", latestVersion, L"). Average release interval: ", avgHours, L" hours.");
+        }
+    }
+
+    m_config.SetString(kStateSection, L"LastSeenVersion", latestVersion);
+    m_config.SetString(kStateSection, L"LastReleaseSeenAt", std::to_wstring(now));
+}
+
+std::chrono::seconds UpdateScheduler::AdaptiveInterval() const {
+    double avgHours = ParseDouble(m_config.GetString(kStateSection, L"AvgReleaseIntervalHours", L""), 0.0);
+    long long minutes = m_settings.checkIntervalMinutes;
+    if (avgHours > 0.0) {
+        // 发布越频繁检查越勤，但始终限制在 [Min, Max] 之间
+        minutes = static_cast<long long>(avgHours * 60.0 / kChecksPerReleaseInterval);
+        minutes = std::clamp<long long>(minutes, m_settings.minIntervalMinutes, m_settings.maxIntervalMinutes);
+    }
+    return std::chrono::seconds(minutes * 60);
+}
+
+std::chrono::seconds UpdateScheduler::FailureBackoff() const {
+    // 5 分钟起按 2 的幂退避，上限为最大检查间隔
+    int shift = (std::min)((std::max)(m_consecutiveFailures - 1, 0), 16);
+    long long seconds = kFailureRetryBase.count() << shift;
+    return std::chrono::seconds((std::min)(seconds, static_cast<long long>(m_settings.maxIntervalMinutes) * 60));
+}
+
+std::chrono::seconds UpdateScheduler::ApplyJitter(std::chrono::seconds delay, bool upwardOnly) {
+    if (m_settings.jitterPercent <= 0 || delay.count() <= 0) return delay;
+    double range = static_cast<double>(m_settings.jitterPercent) / 100.0;
+    std::uniform_real_distribution<double> dist(upwardOnly ? 0.0 : -range, range);
+    double factor = 1.0 + dist(m_rng);
+    return std::chrono::seconds(static_cast<long long>(static_cast<double>(delay.count()) * factor));
+}
@@ -0,0 +1,128 @@
+#ifndef UPDATE_SCHEDULER_H
+#define UPDATE_SCHEDULER_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <functional> // For std::function
+#include <condition_variable>
+
+#include "update.h"
+#include "timer_wheel.h" // For TimerId
+
+class ThreadPool;
+class Config;
+
+// 后台更新检查调度器：
+// 用线程池的定时器 (ThreadPool::post_after) 定时执行 Update::CheckForUpdates。检查间隔根据实际发布频率自适应调整，
+// 每次都加入随机抖动，避免所有客户端在同一时刻访问更新服务器；服务器返回的
+// Retry-After / Cache-Control: max-age 作为下一次检查的最短间隔。
+// 使用电池供电或按流量计费的网络时暂停检查。
+//
+// 配置项 ([Update] 节)：
+//   CheckUrl              更新信息地址
+//   CheckIntervalMinutes  尚无发布历史时的默认间隔 (默认 360)
+//   MinIntervalMinutes    自适应间隔下限 (默认 60)
+//   MaxIntervalMinutes    自适应间隔上限 (默认 1440)
+//   JitterPercent         随机抖动幅度，百分比 (默认 20)
+//   PauseOnBattery        电池供电时暂停 (默认 true)
+//   PauseOnMetered        计费网络时暂停 (默认 true)
+//   InitialDelaySeconds   启动后首次检查的延迟 (默认 60)
+// 调度状态保存在 [UpdateScheduler] 节，重启后沿用。
+
+class UpdateScheduler {
+public:
+    struct Settings {
+        std::string checkUrl;
+        int checkIntervalMinutes = 360;
+        int minIntervalMinutes = 60;
+        int maxIntervalMinutes = 1440;
+        int jitterPercent = 20;
+        bool pauseOnBattery = true;
+        bool pauseOnMetered = true;
+        int initialDelaySeconds = 60;
+    };
+
+    /**
+     * @brief 构造调度器并从配置中读取设置 (不启动)。
+     * @param pool 执行检查任务的线程池，生命周期须长于调度器。
+     * @param config 读取设置和保存调度状态的配置对象。
+     */
+    UpdateScheduler(ThreadPool& pool, Config& config);
+
+    /**
+     * @brief 析构函数，会调用 Stop()。
+     */
+    ~UpdateScheduler();
+
+    // 禁止拷贝和赋值
+    UpdateScheduler(const UpdateScheduler&) = delete;
+    UpdateScheduler& operator=(const UpdateScheduler&) = delete;
+
+    /**
+     * @brief 启动定时检查。
+     * @param onUpdateAvailable 发现新版本时作为独立的任务在线程池上调用 (可以弹出确认框、下载更新)。
+     *        Stop 不等待它结束，而是取消传给它的令牌。
+     * @return 未配置 CheckUrl 时返回 false，不启动。
+     */
+    bool Start(std::function<void(const Update::VersionInfo&, const CancellationToken&)> onUpdateAvailable);
+
+    /**
+     * @brief 停止定时检查，并等待正在执行的检查结束。
+     */
+    void Stop();
+
+    /**
+     * @brief 让下一次检查立即执行 (不影响之后的自适应间隔)。
+     */
+    void CheckNow();
+
+    const Settings& GetSettings() const { return m_settings; }
+
+    /**
+     * @brief 从配置中读取调度设置 (带默认值，并修正不合理的取值)。
+     */
+    static Settings LoadSettings(const Config& config);
+
+private:
+    // 定时器任务：被取消 (CheckNow 重新安排、Stop 或线程池关闭) 时通知调度器
+    struct TimerTask {
+        UpdateScheduler* scheduler;
+        void operator()() { scheduler->OnTimer(); }
+        void Cancel() { scheduler->OnTimerCanceled(); }
+    };
+
+    void ArmTimer(std::chrono::seconds delay); // 调用方不能持有 m_mutex (定时器可能被同步取消)
+    void OnTimer();
+    void OnTimerCanceled();
+    void RunCheck();
+    void ScheduleNext(std::chrono::seconds delay);
+
+    // 记录服务器上的最新版本，版本变化时更新平均发布间隔
+    void RecordObservedVersion(const std::wstring& latestVersion, long long now);
+    std::chrono::seconds AdaptiveInterval() const;
+    std::chrono::seconds FailureBackoff() const;
+    std::chrono::seconds ApplyJitter(std::chrono::seconds delay, bool upwardOnly);
+
+    ThreadPool& m_pool;
+    Config& m_config;
+    Settings m_settings;
+    std::function<void(const Update::VersionInfo&, const CancellationToken&)> m_onUpdateAvailable;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    TimerId m_timer;
+    CancellationSource m_cancel; // Stop 时取消定时器并中止进行中的检查请求；每次 Start 重新创建
+    bool m_stop;
+    bool m_running;
+    bool m_checkInFlight;
+    int m_outstanding;           // 引用 this 的定时器、检查和正在安排定时器的调用数，Stop 等待它归零
+
+    int m_consecutiveFailures; // 仅在检查任务中访问 (同一时刻最多一个检查)
+    std::mt19937 m_rng;        // 同上
+};
+
+#endif // UPDATE_SCHEDULER_H
@@ -1,160 +1,323 @@
-#include "utils.h"
-#include <shlwapi.h> // For PathFileExistsW, PathIsDirectoryW
-#include <fstream>
-#include <sstream>
-#include <algorithm> // For std::replace on older compilers, or manual loop.
-
-//  Shlwapi.lib
-#pragma comment(lib, "Shlwapi.lib")
-
-std::wstring GetExecutablePath() {
-    wchar_t path[MAX_PATH] = { 0 };
-    if (GetModuleFileNameW(NULL, path, MAX_PATH) == 0) {
-        // Լ¼־
-        // LOG_ERROR(L"Failed to get executable path. Error code: ", GetLastError());
-        return L"";
-    }
-    return std::wstring(path);
-}
-
-std::wstring GetExecutableDir() {
-    std::wstring exePath = GetExecutablePath();
-    if (exePath.empty()) {
-        return L"";
-    }
-    size_t lastSlash = exePath.find_last_of(L"\\/");
-    if (std::wstring::npos != lastSlash) {
-        return exePath.substr(0, lastSlash);
-    }
-    return L""; // ̫ܷΪ׳Լ
-}
-
-bool DirectoryExists(const std::wstring& dirPath) {
-    DWORD attributes = GetFileAttributesW(dirPath.c_str());
-    if (attributes == INVALID_FILE_ATTRIBUTES) {
-        return false; // ·Ч򲻿ɷ
-    }
-    return (attributes & FILE_ATTRIBUTE_DIRECTORY);
-}
-
-bool CreateDirectoryRecursive(const std::wstring& dirPath) {
-    if (DirectoryExists(dirPath)) {
-        return true;
-    }
-
-    // ԴǰĿ¼
-    if (CreateDirectoryW(dirPath.c_str(), NULL)) {
-        return true;
-    }
-
-    // ΪĿ¼ڶʧ (ERROR_PATH_NOT_FOUND)
-    if (GetLastError() == ERROR_PATH_NOT_FOUND) {
-        size_t pos = dirPath.find_last_of(L"\\/");
-        if (pos != std::wstring::npos) {
-            std::wstring parentDir = dirPath.substr(0, pos);
-            if (!parentDir.empty() && CreateDirectoryRecursive(parentDir)) {
-                // Ŀ¼ɹٴγԴǰĿ¼
-                return CreateDirectoryW(dirPath.c_str(), NULL) != 0;
-            }
-        }
-    }
-    // LOG_ERROR(L"Failed to create directory: ", dirPath, L". Error: ", GetLastError());
-    return false;
-}
-
-std::wstring Utf8ToWide(const std::string& utf8String) {
-    if (utf8String.empty()) {
-        return std::wstring();
-    }
-    int wideCharCount = MultiByteToWideChar(CP_UTF8, 0, utf8String.c_str(), -1, NULL, 0);
-    if (wideCharCount == 0) {
-        // LOG_ERROR(L"Failed to convert UTF-8 to WideChar (calculate length). Error: ", GetLastError());
-        return std::wstring();
-    }
-    std::wstring wideString(wideCharCount, 0);
-    if (MultiByteToWideChar(CP_UTF8, 0, utf8String.c_str(), -1, &wideString[0], wideCharCount) == 0) {
-        // LOG_ERROR(L"Failed to convert UTF-8 to WideChar. Error: ", GetLastError());
-        return std::wstring();
-    }
-    // MultiByteToWideChar with -1 for cchMultiByte null-terminates.
-    // The size wideCharCount includes space for the null terminator.
-    // If the string might have embedded nulls and you don't want that behavior, pass utf8String.length().
-    // Then, resize wideString appropriately.
-    // For typical C-style strings, -1 is fine.
-    // The wstring constructor used (wideCharCount, 0) might create a string one char too long if wideCharCount includes the null.
-    // Let's adjust:
-    wideString.resize(wcslen(wideString.c_str())); // Trim to actual length if conversion includes terminator
-    return wideString;
-}
-
-std::string WideToUtf8(const std::wstring& wideString) {
-    if (wideString.empty()) {
-        return std::string();
-    }
-    int utf8CharCount = WideCharToMultiByte(CP_UTF8, 0, wideString.c_str(), -1, NULL, 0, NULL, NULL);
-    if (utf8CharCount == 0) {
-        // LOG_ERROR(L"Failed to convert WideChar to UTF-8 (calculate length). Error: ", GetLastError());
-        return std::string();
-    }
-    std::string utf8String(utf8CharCount, 0);
-    if (WideCharToMultiByte(CP_UTF8, 0, wideString.c_str(), -1, &utf8String[0], utf8CharCount, NULL, NULL) == 0) {
-        // LOG_ERROR(L"Failed to convert WideChar to UTF-8. Error: ", GetLastError());
-        return std::string();
-    }
-    utf8String.resize(strlen(utf8String.c_str())); // Trim to actual length
-    return utf8String;
-}
-
-void ReplaceAll(std::wstring& str, const std::wstring& from, const std::wstring& to) {
-    if (from.empty())
-        return;
-    size_t start_pos = 0;
-    while ((start_pos = str.find(from, start_pos)) != std::wstring::npos) {
-        str.replace(start_pos, from.length(), to);
-        start_pos += to.length(); //  'to'  'from'  ReplaceAll("aaaa", "aa", "aaa")
-    }
-}
-
-bool FileExists(const std::wstring& filePath) {
-    // PathFileExistsW Ҫ shlwapi.h  Shlwapi.lib
-    return PathFileExistsW(filePath.c_str()) == TRUE;
-}
-
-bool ReadFileToString(const std::wstring& filePath, std::string& content) {
-    std::ifstream file(filePath, std::ios::in | std::ios::binary);
-    if (!file.is_open()) {
-        // LOG_WARNING(L"Failed to open file for reading (binary): ", filePath);
-        return false;
-    }
-    std::ostringstream ss;
-    ss << file.rdbuf();
-    content = ss.str();
-    file.close();
-    return true;
-}
-
-bool ReadFileToWString(const std::wstring& filePath, std::wstring& content) {
-    // ļǿַ ( UTF-16 LEWindows )
-    // һ԰ȫֽڶȻתΪ wstring ı (Ƽ)
-    // ׳ķȷļ룬Ȼת
-    std::wifstream file(filePath, std::ios::in); // Ĭģʽ locale
-    if (!file.is_open()) {
-        // LOG_WARNING(L"Failed to open file for reading (wide): ", filePath);
-        return false;
-    }
-
-    // // ѡ locale ȷļ룬 UTF-8
-    // try {
-    //     file.imbue(std::locale(std::locale(), new std::codecvt_utf8<wchar_t>));
-    // } catch (const std::exception& e) {
-    //     // LOG_ERROR(L"Failed to imbue locale for wifstream: ", e.what());
-    //     // Fallback or error
-    // }
-
-    std::wstringstream wss;
-    wss << file.rdbuf();
-    content = wss.str();
-    file.close();
-    return true;
-}
-
+#include "utils.h"
+#include <shlwapi.h> // For PathFileExistsW, PathIsDirectoryW
+#include <bcrypt.h>  // For BCrypt SHA-256
+#include <fstream>
+#include <sstream>
+#include <algorithm> // For std::replace on older compilers, or manual loop.
+#include <cwctype>   // For towlower
+
+// 链接 Shlwapi.lib
+#pragma comment(lib, "Shlwapi.lib")
+// 链接 Bcrypt.lib
+#pragma comment(lib, "Bcrypt.lib")
+
+std::wstring GetExecutablePath() {
+    wchar_t path[MAX_PATH] = { 0 };
+    if (GetModuleFileNameW(NULL, path, MAX_PATH) == 0) {
+        // 错误处理，可以记录日志
+        // LOG_ERROR(L"Failed to get executable path. Error code: ", GetLastError());
+        return L"";
+    }
+    return std::wstring(path);
+}
+
+std::wstring GetExecutableDir() {
+    std::wstring exePath = GetExecutablePath();
+    if (exePath.empty()) {
+        return L"";
+    }
+    size_t lastSlash = exePath.find_last_of(L"\\/");
+    if (std::wstring::npos != lastSlash) {
+        return exePath.substr(0, lastSlash);
+    }
+    return L""; // 不太可能发生，但作为健壮性检查
+}
+
+bool DirectoryExists(const std::wstring& dirPath) {
+    DWORD attributes = GetFileAttributesW(dirPath.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) {
+        return false; // 路径无效或不可访问
+    }
+    return (attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+bool CreateDirectoryRecursive(const std::wstring& dirPath) {
+    if (DirectoryExists(dirPath)) {
+        return true;
+    }
+
+    // 尝试创建当前目录
+    if (CreateDirectoryW(dirPath.c_str(), NULL)) {
+        return true;
+    }
+
+    // 如果因为父目录不存在而失败 (ERROR_PATH_NOT_FOUND)
+    if (GetLastError() == ERROR_PATH_NOT_FOUND) {
+        size_t pos = dirPath.find_last_of(L"\\/");
+        if (pos != std::wstring::npos) {
+            std::wstring parentDir = dirPath.substr(0, pos);
+            if (!parentDir.empty() && CreateDirectoryRecursive(parentDir)) {
+                // 父目录创建成功后，再次尝试创建当前目录
+                return CreateDirectoryW(dirPath.c_str(), NULL) != 0;
+            }
+        }
+    }
+    // LOG_ERROR(L"Failed to create directory: ", dirPath, L". Error: ", GetLastError());
+    return false;
+}
+
+bool DeleteDirectoryRecursive(const std::wstring& dirPath) {
+    DWORD attributes = GetFileAttributesW(dirPath.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        return true;
+    }
+    // 目录本身是联接点 / 符号链接：只删除链接，不进入它指向的目录
+    if (attributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+        return RemoveDirectoryW(dirPath.c_str()) != 0;
+    }
+
+    bool allDeleted = true;
+    WIN32_FIND_DATAW findData;
+    HANDLE hFind = FindFirstFileW((dirPath + L"\\*").c_str(), &findData);
+    if (hFind == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        std::wstring name = findData.cFileName;
+        if (name == L"." || name == L"..") {
+            continue;
+        }
+        std::wstring fullPath = dirPath + L"\\" + name;
+        DWORD entryAttributes = findData.dwFileAttributes;
+        if (entryAttributes & FILE_ATTRIBUTE_REPARSE_POINT) {
+            // 链接本身删除即可，不跟随 (否则会删除树外的文件)
+            bool removed = (entryAttributes & FILE_ATTRIBUTE_DIRECTORY) ? RemoveDirectoryW(fullPath.c_str()) != 0 : DeleteFileW(fullPath.c_str()) != 0;
+            allDeleted = removed && allDeleted;
+            continue;
+        }
+        if (entryAttributes & FILE_ATTRIBUTE_READONLY) {
+            SetFileAttributesW(fullPath.c_str(), entryAttributes & ~FILE_ATTRIBUTE_READONLY);
+        }
+        if (entryAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            allDeleted = DeleteDirectoryRecursive(fullPath) && allDeleted;
+        }
+        else {
+            allDeleted = DeleteFileW(fullPath.c_str()) && allDeleted;
+        }
+    } while (FindNextFileW(hFind, &findData));
+    FindClose(hFind);
+
+    if (attributes & FILE_ATTRIBUTE_READONLY) {
+        SetFileAttributesW(dirPath.c_str(), attributes & ~FILE_ATTRIBUTE_READONLY);
+    }
+    return RemoveDirectoryW(dirPath.c_str()) != 0 && allDeleted;
+}
+
+// 展开为完整路径 (解析 "." 和 ".."，统一分隔符)，去掉末尾的 '\'
+static std::wstring GetFullPath(const std::wstring& path) {
+    DWORD length = GetFullPathNameW(path.c_str(), 0, NULL, NULL);
+    if (length == 0) {
+        return L"";
+    }
+    std::wstring fullPath(length, L'\0');
+    length = GetFullPathNameW(path.c_str(), length, &fullPath[0], NULL);
+    if (length == 0 || length >= fullPath.size()) {
+        return L"";
+    }
+    fullPath.resize(length);
+    while (fullPath.size() > 1 && fullPath.back() == L'\\') {
+        fullPath.pop_back();
+    }
+    return fullPath;
+}
+
+bool DeleteDirectoryUnder(const std::wstring& rootDir, const std::wstring& dirPath) {
+    std::wstring root = GetFullPath(rootDir);
+    std::wstring target = GetFullPath(dirPath);
+    // 路径不区分大小写：target 须以 "root\" 开头且后面还有内容
+    bool below = !root.empty() && target.size() > root.size() + 1 && target[root.size()] == L'\\'
+        && std::equal(root.begin(), root.end(), target.begin(), [](wchar_t a, wchar_t b) { return towlower(a) == towlower(b); });
+    if (!below) {
+        return false;
+    }
+    return DeleteDirectoryRecursive(target);
+}
+
+std::wstring Utf8ToWide(const std::string& utf8String) {
+    if (utf8String.empty()) {
+        return std::wstring();
+    }
+    int wideCharCount = MultiByteToWideChar(CP_UTF8, 0, utf8String.c_str(), -1, NULL, 0);
+    if (wideCharCount == 0) {
+        // LOG_ERROR(L"Failed to convert UTF-8 to WideChar (calculate length). Error: ", GetLastError());
+        return std::wstring();
+    }
+    std::wstring wideString(wideCharCount, 0);
+    if (MultiByteToWideChar(CP_UTF8, 0, utf8String.c_str(), -1, &wideString[0], wideCharCount) == 0) {
+        // LOG_ERROR(L"Failed to convert UTF-8 to WideChar. Error: ", GetLastError());
+        return std::wstring();
+    }
+    // MultiByteToWideChar with -1 for cchMultiByte null-terminates.
+    // The size wideCharCount includes space for the null terminator.
+    // If the string might have embedded nulls and you don't want that behavior, pass utf8String.length().
+    // Then, resize wideString appropriately.
+    // For typical C-style strings, -1 is fine.
+    // The wstring constructor used (wideCharCount, 0) might create a string one char too long if wideCharCount includes the null.
+    // Let's adjust:
+    wideString.resize(wcslen(wideString.c_str())); // Trim to actual length if conversion includes terminator
+    return wideString;
+}
+
+std::string WideToUtf8(const std::wstring& wideString) {
+    if (wideString.empty()) {
+        return std::string();
+    }
+    int utf8CharCount = WideCharToMultiByte(CP_UTF8, 0, wideString.c_str(), -1, NULL, 0, NULL, NULL);
+    if (utf8CharCount == 0) {
+        // LOG_ERROR(L"Failed to convert WideChar to UTF-8 (calculate length). Error: ", GetLastError());
+        return std::string();
+    }
+    std::string utf8String(utf8CharCount, 0);
+    if (WideCharToMultiByte(CP_UTF8, 0, wideString.c_str(), -1, &utf8String[0], utf8CharCount, NULL, NULL) == 0) {
+        // LOG_ERROR(L"Failed to convert WideChar to UTF-8. Error: ", GetLastError());
+        return std::string();
+    }
+    utf8String.resize(strlen(utf8String.c_str())); // Trim to actual length
+    return utf8String;
+}
+
+void ReplaceAll(std::wstring& str, const std::wstring& from, const std::wstring& to) {
+    if (from.empty())
+        return;
+    size_t start_pos = 0;
+    while ((start_pos = str.find(from, start_pos)) != std::wstring::npos) {
+        str.replace(start_pos, from.length(), to);
+        start_pos += to.length(); // 处理 'to' 包含 'from' 的情况，例如 ReplaceAll("aaaa", "aa", "aaa")
+    }
+}
+
+bool FileExists(const std::wstring& filePath) {
+    // PathFileExistsW 需要 shlwapi.h 和 Shlwapi.lib
+    return PathFileExistsW(filePath.c_str()) == TRUE;
+}
+
+bool ReadFileToString(const std::wstring& filePath, std::string& content) {
+    std::ifstream file(filePath, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        // LOG_WARNING(L"Failed to open file for reading (binary): ", filePath);
+        return false;
+    }
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    content = ss.str();
+    file.close();
+    return true;
+}
+
+bool ReadFileToWString(const std::wstring& filePath, std::wstring& content) {
+    // 这个函数假设文件是宽字符编码 (如 UTF-16 LE，Windows 常见)
+    // 或者是一个可以安全地逐字节读入然后转换为 wstring 的编码 (不推荐)
+    // 更健壮的方法是确定文件编码，然后进行转换
+    std::wifstream file(filePath, std::ios::in); // 默认模式可能依赖于 locale
+    if (!file.is_open()) {
+        // LOG_WARNING(L"Failed to open file for reading (wide): ", filePath);
+        return false;
+    }
+
+    // // 可选：设置 locale 以正确处理文件编码，例如 UTF-8
+    // try {
+    //     file.imbue(std::locale(std::locale(), new std::codecvt_utf8<wchar_t>));
+    // } catch (const std::exception& e) {
+    //     // LOG_ERROR(L"Failed to imbue locale for wifstream: ", e.what());
+    //     // Fallback or error
+    // }
+
+    std::wstringstream wss;
+    wss << file.rdbuf();
+    content = wss.str();
+    file.close();
+    return true;
+}
+
+// 算法句柄打开代价较高，进程内只打开一次 (BCrypt 句柄可跨线程共享)
+static BCRYPT_ALG_HANDLE GetSha256Provider() {
+    static BCRYPT_ALG_HANDLE hAlg = [] {
+        BCRYPT_ALG_HANDLE h = NULL;
+        if (!BCRYPT_SUCCESS(BCryptOpenAlgorithmProvider(&h, BCRYPT_SHA256_ALGORITHM, NULL, 0))) {
+            h = NULL;
+        }
+        return h;
+    }();
+    return hAlg;
+}
+
+static std::string DigestToHex(const unsigned char* digest, size_t size) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        hex[i * 2] = kHex[digest[i] >> 4];
+        hex[i * 2 + 1] = kHex[digest[i] & 0x0F];
+    }
+    return hex;
+}
+
+std::string Sha256Hex(const void* data, size_t size) {
+    BCRYPT_ALG_HANDLE hAlg = GetSha256Provider();
+    if (!hAlg) {
+        return std::string();
+    }
+    BCRYPT_HASH_HANDLE hHash = NULL;
+    if (!BCRYPT_SUCCESS(BCryptCreateHash(hAlg, &hHash, NULL, 0, NULL, 0, 0))) {
+        return std::string();
+    }
+
+    unsigned char digest[32];
+    bool ok = true;
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    while (size > 0 && ok) {
+        ULONG block = static_cast<ULONG>(size > 0x40000000 ? 0x40000000 : size); // BCryptHashData takes a ULONG length
+        ok = BCRYPT_SUCCESS(BCryptHashData(hHash, const_cast<PUCHAR>(p), block, 0));
+        p += block;
+        size -= block;
+    }
+    ok = ok && BCRYPT_SUCCESS(BCryptFinishHash(hHash, digest, sizeof(digest), 0));
+    BCryptDestroyHash(hHash);
+    return ok ? DigestToHex(digest, sizeof(digest)) : std::string();
+}
+
+bool Sha256FileHex(const std::wstring& filePath, std::string& outHex) {
+    outHex.clear();
+    BCRYPT_ALG_HANDLE hAlg = GetSha256Provider();
+    if (!hAlg) {
+        return false;
+    }
+
+    std::ifstream file(filePath, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    BCRYPT_HASH_HANDLE hHash = NULL;
+    if (!BCRYPT_SUCCESS(BCryptCreateHash(hAlg, &hHash, NULL, 0, NULL, 0, 0))) {
+        return false;
+    }
+
+    std::vector<char> buffer(256 * 1024);
+    bool ok = true;
+    while (ok && file) {
+        file.read(buffer.data(), buffer.size());
+        std::streamsize got = file.gcount();
+        if (got > 0) {
+            ok = BCRYPT_SUCCESS(BCryptHashData(hHash, reinterpret_cast<PUCHAR>(buffer.data()), static_cast<ULONG>(got), 0));
+        }
+    }
+    ok = ok && !file.bad();
+
+    unsigned char digest[32];
+    ok = ok && BCRYPT_SUCCESS(BCryptFinishHash(hHash, digest, sizeof(digest), 0));
+    BCryptDestroyHash(hHash);
+    if (ok) {
+        outHex = DigestToHex(digest, sizeof(digest));
+    }
+    return ok;
+}
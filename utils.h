@@ -1,73 +1,105 @@
-#ifndef UTILS_H
-#define UTILS_H
-
-#include <string>
-#include <vector>
-#include <windows.h> // For MAX_PATH, GetModuleFileNameW etc.
-
-/**
- * @brief ȡǰִļ·
- * @return ִļ·ʧ򷵻ؿַ
- */
-std::wstring GetExecutablePath();
-
-/**
- * @brief ȡǰִļڵĿ¼
- * @return ִļĿ¼·ʧ򷵻ؿַ
- */
-std::wstring GetExecutableDir();
-
-/**
- * @brief Ŀ¼Ƿڡ
- * @param dirPath Ŀ¼·
- * @return Ŀ¼򷵻 true򷵻 false
- */
-bool DirectoryExists(const std::wstring& dirPath);
-
-/**
- * @brief ݹ鴴Ŀ¼
- * @param dirPath ҪĿ¼·
- * @return ɹĿ¼Ѵ򷵻 true򷵻 false
- */
-bool CreateDirectoryRecursive(const std::wstring& dirPath);
-
-/**
- * @brief  UTF-8 ַתΪַ (wstring)
- * @param utf8String UTF-8 ַ
- * @return תĿַʧ򷵻ؿַ
- */
-std::wstring Utf8ToWide(const std::string& utf8String);
-
-/**
- * @brief ַ (wstring) תΪ UTF-8 ַ
- * @param wideString ַ
- * @return ת UTF-8 ַʧ򷵻ؿַ
- */
-std::string WideToUtf8(const std::wstring& wideString);
-
-/**
- * @brief 滻ַгֵӴ
- * @param str ַ (޸)
- * @param from Ҫ滻Ӵ
- * @param to 滻Ӵ
- */
-void ReplaceAll(std::wstring& str, const std::wstring& from, const std::wstring& to);
-
-/**
- * @brief ļǷڡ
- * @param filePath ļ·
- * @return ļ򷵻 true򷵻 false
- */
-bool FileExists(const std::wstring& filePath);
-
-/**
- * @brief ȡļݵַ
- * @param filePath ļ·
- * @param content ȡļ ()
- * @return ɹȡ򷵻 true򷵻 false
- */
-bool ReadFileToString(const std::wstring& filePath, std::string& content); // ȡΪ byte string
-bool ReadFileToWString(const std::wstring& filePath, std::wstring& content); // ȡΪ wide string (ļ)
-
-
-#endif // UTILS_H
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <string>
+#include <vector>
+#include <windows.h> // For MAX_PATH, GetModuleFileNameW etc.
+
+/**
+ * @brief 获取当前可执行文件的完整路径。
+ * @return 可执行文件的路径，失败则返回空字符串。
+ */
+std::wstring GetExecutablePath();
+
+/**
+ * @brief 获取当前可执行文件所在的目录。
+ * @return 可执行文件所在目录的路径，失败则返回空字符串。
+ */
+std::wstring GetExecutableDir();
+
+/**
+ * @brief 检查目录是否存在。
+ * @param dirPath 目录路径。
+ * @return 如果目录存在则返回 true，否则返回 false。
+ */
+bool DirectoryExists(const std::wstring& dirPath);
+
+/**
+ * @brief 递归创建目录。
+ * @param dirPath 要创建的目录路径。
+ * @return 如果成功创建或目录已存在则返回 true，否则返回 false。
+ */
+bool CreateDirectoryRecursive(const std::wstring& dirPath);
+
+/**
+ * @brief 递归删除目录及其中的全部内容。
+ * @param dirPath 要删除的目录路径。
+ * @return 删除成功或目录本不存在时返回 true；任何一项删除失败时返回 false。
+ * @note 联接点和符号链接只删除链接本身，不进入它们指向的目录。只读文件先清除只读属性再删除。
+ */
+bool DeleteDirectoryRecursive(const std::wstring& dirPath);
+
+/**
+ * @brief 只在 dirPath 严格位于 rootDir 之下时递归删除它 (两者先展开为完整路径，"..\" 等不能越出 rootDir)。
+ * @param rootDir 允许删除的范围，rootDir 本身不会被删除。
+ * @param dirPath 要删除的目录路径。
+ * @return 删除成功或目录本不存在时返回 true；路径不在 rootDir 之下时不删除并返回 false。
+ */
+bool DeleteDirectoryUnder(const std::wstring& rootDir, const std::wstring& dirPath);
+
+/**
+ * @brief 将 UTF-8 编码的字符串转换为宽字符串 (wstring)。
+ * @param utf8String UTF-8 字符串。
+ * @return 转换后的宽字符串，失败则返回空字符串。
+ */
+std::wstring Utf8ToWide(const std::string& utf8String);
+
+/**
+ * @brief 将宽字符串 (wstring) 转换为 UTF-8 编码的字符串。
+ * @param wideString 宽字符串。
+ * @return 转换后的 UTF-8 字符串，失败则返回空字符串。
+ */
+std::string WideToUtf8(const std::wstring& wideString);
+
+/**
+ * @brief 替换字符串中所有出现的子串。
+ * @param str 主字符串 (将被修改)。
+ * @param from 要被替换的子串。
+ * @param to 用于替换的子串。
+ */
+void ReplaceAll(std::wstring& str, const std::wstring& from, const std::wstring& to);
+
+/**
+ * @brief 检查文件是否存在。
+ * @param filePath 文件路径。
+ * @return 如果文件存在则返回 true，否则返回 false。
+ */
+bool FileExists(const std::wstring& filePath);
+
+/**
+ * @brief 读取整个文件的内容到字符串。
+ * @param filePath 文件路径。
+ * @param content 读取到的文件内容 (输出参数)。
+ * @return 如果成功读取则返回 true，否则返回 false。
+ */
+bool ReadFileToString(const std::wstring& filePath, std::string& content); // 读取为 byte string
+bool ReadFileToWString(const std::wstring& filePath, std::wstring& content); // 读取为 wide string (假设文件编码兼容)
+
+/**
+ * @brief 计算一段内存的 SHA-256 摘要。
+ * @param data 数据指针。
+ * @param size 数据长度（字节）。
+ * @return 小写十六进制摘要字符串，失败则返回空字符串。
+ */
+std::string Sha256Hex(const void* data, size_t size);
+
+/**
+ * @brief 计算文件内容的 SHA-256 摘要。
+ * @param filePath 文件路径。
+ * @param outHex [out] 小写十六进制摘要字符串。
+ * @return 成功返回 true，否则返回 false。
+ */
+bool Sha256FileHex(const std::wstring& filePath, std::string& outHex);
+
+
+#endif // UTILS_H
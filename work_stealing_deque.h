@@ -0,0 +1,136 @@
+#ifndef WORK_STEALING_DEQUE_H
+#define WORK_STEALING_DEQUE_H
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Chase-Lev 工作窃取双端队列 (按 Le, Pop, Cohen, Zappa Nardelli 2013 的 C11 内存模型版本实现)。
+// 只有所有者线程可以调用 Push / Pop (从底部，后进先出，缓存局部性好)，
+// 其他线程通过 Steal 从顶部取走最早的元素。Steal 之间以及 Steal 与 Pop 争抢最后一个元素时靠 CAS 仲裁。
+// 元素类型须为可平凡拷贝的指针类值，空值 (T{}) 表示"没有取到"。
+// 容量不足时由所有者线程扩容；旧的环形数组保留到队列销毁，因为窃取者可能仍在读取它。
+
+template<typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable<T>::value, "WorkStealingDeque stores trivially copyable values");
+
+public:
+    explicit WorkStealingDeque(size_t initialCapacity = 256)
+        : m_top(0), m_bottom(0) {
+        size_t capacity = 1;
+        while (capacity < initialCapacity) capacity <<= 1;
+        m_buffers.emplace_back(new Buffer(capacity));
+        m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    // 禁止拷贝和赋值
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /**
+     * @brief 压入一个元素 (仅所有者线程)。
+     */
+    void Push(T item) {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_acquire);
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        if (b - t > static_cast<int64_t>(buffer->capacity) - 1) {
+            buffer = Grow(buffer, t, b);
+        }
+        buffer->Put(b, item);
+        m_bottom.store(b + 1, std::memory_order_release); // 与 Steal 中对 bottom 的 acquire 读配对，发布元素
+    }
+
+    /**
+     * @brief 弹出最近压入的元素 (仅所有者线程)。
+     * @return 队列为空 (或最后一个元素被窃取) 时返回 T{}。
+     */
+    T Pop() {
+        int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+
+        T item{};
+        if (t <= b) {
+            item = buffer->Get(b);
+            if (t == b) {
+                // 最后一个元素：与窃取者竞争
+                if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                    item = T{};
+                }
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+            }
+        }
+        else {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /**
+     * @brief 从顶部窃取最早压入的元素 (任意线程)。
+     * @return 队列为空或与其他线程竞争失败时返回 T{}。
+     */
+    T Steal() {
+        int64_t t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = m_bottom.load(std::memory_order_acquire);
+
+        if (t < b) {
+            Buffer* buffer = m_buffer.load(std::memory_order_acquire);
+            T item = buffer->Get(t);
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return T{};
+            }
+            return item;
+        }
+        return T{};
+    }
+
+    /**
+     * @brief 近似的元素数量 (并发修改时仅供参考)。
+     */
+    size_t SizeApprox() const {
+        int64_t b = m_bottom.load(std::memory_order_relaxed);
+        int64_t t = m_top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    bool EmptyApprox() const { return SizeApprox() == 0; }
+
+private:
+    struct Buffer {
+        explicit Buffer(size_t cap) : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+
+        T Get(int64_t index) const { return slots[static_cast<size_t>(index) & mask].load(std::memory_order_relaxed); }
+        void Put(int64_t index, T item) { slots[static_cast<size_t>(index) & mask].store(item, std::memory_order_relaxed); }
+
+        size_t capacity;
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Buffer* Grow(Buffer* old, int64_t t, int64_t b) {
+        Buffer* bigger = new Buffer(old->capacity * 2);
+        for (int64_t i = t; i < b; ++i) {
+            bigger->Put(i, old->Get(i));
+        }
+        m_buffers.emplace_back(bigger); // 旧数组保留，窃取者可能仍持有其指针
+        m_buffer.store(bigger, std::memory_order_release);
+        return bigger;
+    }
+
+    // top 和 bottom 分别由窃取者和所有者频繁修改，放在不同缓存行上避免伪共享
+    alignas(64) std::atomic<int64_t> m_top;
+    alignas(64) std::atomic<int64_t> m_bottom;
+    alignas(64) std::atomic<Buffer*> m_buffer;
+    std::vector<std::unique_ptr<Buffer>> m_buffers; // 仅所有者线程修改
+};
+
+#endif // WORK_STEALING_DEQUE_H
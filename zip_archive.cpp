@@ -0,0 +1,408 @@
+#define LOG_MODULE LogModule::Update // 本文件的日志属于更新模块 (见 log.h)
+#include "zip_archive.h"
+#include "compression.h"
+#include "threads.h"
+#include "task_group.h"
+#include "log.h"
+#include "utils.h"
+
+#include <algorithm> // For std::sort, std::min
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+
+namespace Archive {
+
+    namespace {
+
+        const uint32_t kLocalHeaderSig = 0x04034b50;
+        const uint32_t kCentralHeaderSig = 0x02014b50;
+        const uint32_t kEndOfCentralDirSig = 0x06054b50;
+        const uint32_t kZip64EndOfCentralDirSig = 0x06064b50;
+        const uint32_t kZip64LocatorSig = 0x07064b50;
+
+        uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+        uint32_t ReadU32(const uint8_t* p) { return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24); }
+        uint64_t ReadU64(const uint8_t* p) { return static_cast<uint64_t>(ReadU32(p)) | (static_cast<uint64_t>(ReadU32(p + 4)) << 32); }
+
+        // 拒绝绝对路径、盘符和 ".." 段，防止解压到暂存目录之外
+        bool IsSafeEntryName(const std::string& name) {
+            if (name.empty() || name[0] == '/' || name[0] == '\\' || name.find(':') != std::string::npos) {
+                return false;
+            }
+            size_t start = 0;
+            while (start <= name.size()) {
+                size_t end = name.find_first_of("/\\", start);
+                if (end == std::string::npos) end = name.size();
+                if (name.compare(start, end - start, "..") == 0) {
+                    return false;
+                }
+                start = end + 1;
+            }
+            return true;
+        }
+
+        std::wstring EntryPath(const std::wstring& rootDir, const std::string& name) {
+            std::wstring relative = Utf8ToWide(name);
+            std::replace(relative.begin(), relative.end(), L'/', L'\\');
+            while (!relative.empty() && relative.back() == L'\\') relative.pop_back();
+            return rootDir + L"\\" + relative;
+        }
+
+    } // namespace
+
+    ZipReader::ZipReader() : m_hFile(INVALID_HANDLE_VALUE), m_hMapping(NULL), m_view(nullptr), m_size(0) {}
+
+    ZipReader::~ZipReader() {
+        Close();
+    }
+
+    bool ZipReader::Open(const std::wstring& zipPath) {
+        Close();
+
+        m_hFile = CreateFileW(zipPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_hFile == INVALID_HANDLE_VALUE) {
+            LOG_ERROR(L"Failed to open ZIP file: ", zipPath.c_str(), L" Error: ", GetLastError());
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart < 22) {
+            LOG_ERROR(L"ZIP file is too small or its size cannot be read: ", zipPath.c_str());
+            Close();
+            return false;
+        }
+        m_size = static_cast<uint64_t>(fileSize.QuadPart);
+
+        m_hMapping = CreateFileMappingW(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_hMapping) {
+            m_view = static_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (!m_view) {
+            LOG_ERROR(L"Failed to map ZIP file into memory: ", zipPath.c_str(), L" Error: ", GetLastError());
+            Close();
+            return false;
+        }
+
+        if (!ReadCentralDirectory()) {
+            LOG_ERROR(L"Invalid or unsupported ZIP central directory: ", zipPath.c_str());
+            Close();
+            return false;
+        }
+
+        LOG_INFO(L"ZIP file mapped: ", zipPath.c_str(), L" (", m_entries.size(), L" entries)");
+        return true;
+    }
+
+    void ZipReader::Close() {
+        if (m_view) {
+            UnmapViewOfFile(m_view);
+            m_view = nullptr;
+        }
+        if (m_hMapping) {
+            CloseHandle(m_hMapping);
+            m_hMapping = NULL;
+        }
+        if (m_hFile != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_hFile);
+            m_hFile = INVALID_HANDLE_VALUE;
+        }
+        m_size = 0;
+        m_entries.clear();
+    }
+
+    bool ZipReader::ReadCentralDirectory() {
+        // 从文件尾向前查找 EOCD (其后最多跟 65535 字节的注释)
+        uint64_t searchStart = m_size > 22 + 65535 ? m_size - 22 - 65535 : 0;
+        uint64_t eocd = m_size;
+        for (uint64_t pos = m_size - 22 + 1; pos-- > searchStart;) {
+            if (ReadU32(m_view + pos) == kEndOfCentralDirSig) {
+                eocd = pos;
+                break;
+            }
+        }
+        if (eocd == m_size) {
+            return false;
+        }
+
+        uint64_t entryCount = ReadU16(m_view + eocd + 10);
+        uint64_t cdSize = ReadU32(m_view + eocd + 12);
+        uint64_t cdOffset = ReadU32(m_view + eocd + 16);
+
+        // Zip64：EOCD 前紧跟定位记录
+        if (eocd >= 20 && ReadU32(m_view + eocd - 20) == kZip64LocatorSig) {
+            uint64_t eocd64 = ReadU64(m_view + eocd - 20 + 8);
+            // 偏移来自文件内容：用减法比较，避免 eocd64 + 56 溢出回绕
+            if (m_size < 56 || eocd64 > m_size - 56 || ReadU32(m_view + eocd64) != kZip64EndOfCentralDirSig) {
+                return false;
+            }
+            entryCount = ReadU64(m_view + eocd64 + 32);
+            cdSize = ReadU64(m_view + eocd64 + 40);
+            cdOffset = ReadU64(m_view + eocd64 + 48);
+        }
+
+        if (cdOffset > m_size || cdSize > m_size - cdOffset) {
+            return false;
+        }
+
+        m_entries.clear();
+        // 条目数同样不可信：每个中央目录项至少 46 字节，按目录大小限制预留的数量
+        m_entries.reserve(static_cast<size_t>((std::min)(entryCount, cdSize / 46)));
+        uint64_t pos = cdOffset;
+        const uint64_t cdEnd = cdOffset + cdSize;
+        for (uint64_t i = 0; i < entryCount; ++i) {
+            if (pos + 46 > cdEnd || ReadU32(m_view + pos) != kCentralHeaderSig) {
+                return false;
+            }
+            const uint8_t* h = m_view + pos;
+            uint16_t flags = ReadU16(h + 8);
+            uint16_t nameLen = ReadU16(h + 28);
+            uint16_t extraLen = ReadU16(h + 30);
+            uint16_t commentLen = ReadU16(h + 32);
+            if (pos + 46 + nameLen + extraLen + commentLen > cdEnd) {
+                return false;
+            }
+
+            ZipEntry entry;
+            entry.method = ReadU16(h + 10);
+            entry.crc32 = ReadU32(h + 16);
+            entry.compressedSize = ReadU32(h + 20);
+            entry.uncompressedSize = ReadU32(h + 24);
+            entry.localHeaderOffset = ReadU32(h + 42);
+            entry.name.assign(reinterpret_cast<const char*>(h + 46), nameLen);
+            entry.isDirectory = !entry.name.empty() && entry.name.back() == '/';
+
+            // Zip64 扩展字段：只包含原字段为 0xFFFFFFFF 的那些值，顺序固定
+            const uint8_t* extra = h + 46 + nameLen;
+            const uint8_t* extraEnd = extra + extraLen;
+            while (extra + 4 <= extraEnd) {
+                uint16_t id = ReadU16(extra);
+                uint16_t size = ReadU16(extra + 2);
+                const uint8_t* field = extra + 4;
+                if (field + size > extraEnd) break;
+                if (id == 0x0001) {
+                    const uint8_t* p = field;
+                    if (entry.uncompressedSize == 0xFFFFFFFF && p + 8 <= field + size) { entry.uncompressedSize = ReadU64(p); p += 8; }
+                    if (entry.compressedSize == 0xFFFFFFFF && p + 8 <= field + size) { entry.compressedSize = ReadU64(p); p += 8; }
+                    if (entry.localHeaderOffset == 0xFFFFFFFF && p + 8 <= field + size) { entry.localHeaderOffset = ReadU64(p); p += 8; }
+                }
+                extra = field + size;
+            }
+
+            if (flags & 0x0001) {
+                LOG_ERROR(L"Encrypted ZIP entries are not supported: ", Utf8ToWide(entry.name).c_str());
+                return false;
+            }
+            if (!IsSafeEntryName(entry.name)) {
+                LOG_ERROR(L"Unsafe path in ZIP entry rejected: ", Utf8ToWide(entry.name).c_str());
+                return false;
+            }
+            if (!entry.isDirectory && entry.method != 0 && entry.method != 8) {
+                LOG_ERROR(L"Unsupported ZIP compression method ", entry.method, L" for entry: ", Utf8ToWide(entry.name).c_str());
+                return false;
+            }
+
+            m_entries.push_back(std::move(entry));
+            pos += 46 + nameLen + extraLen + commentLen;
+        }
+        return true;
+    }
+
+    const uint8_t* ZipReader::GetEntryData(const ZipEntry& entry) const {
+        uint64_t pos = entry.localHeaderOffset;
+        if (m_size < 30 || pos > m_size - 30 || ReadU32(m_view + pos) != kLocalHeaderSig) {
+            return nullptr;
+        }
+        uint64_t dataStart = pos + 30 + ReadU16(m_view + pos + 26) + ReadU16(m_view + pos + 28);
+        if (dataStart > m_size || entry.compressedSize > m_size - dataStart) {
+            return nullptr;
+        }
+        return m_view + dataStart;
+    }
+
+    bool ZipReader::ExtractEntry(const ZipEntry& entry, const std::wstring& outputPath) const {
+        const uint8_t* data = GetEntryData(entry);
+        if (!data) {
+            LOG_ERROR(L"Corrupt local header for ZIP entry: ", Utf8ToWide(entry.name).c_str());
+            return false;
+        }
+        if (entry.method == 0 && entry.compressedSize != entry.uncompressedSize) {
+            LOG_ERROR(L"Stored ZIP entry has mismatched sizes: ", Utf8ToWide(entry.name).c_str());
+            return false;
+        }
+
+        HANDLE hOut = CreateFileW(outputPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hOut == INVALID_HANDLE_VALUE) {
+            LOG_ERROR(L"Failed to create output file: ", outputPath.c_str(), L" Error: ", GetLastError());
+            return false;
+        }
+
+        bool ok = true;
+        if (entry.uncompressedSize > 0) {
+            // 预分配：一次性设置文件长度，避免逐块扩展带来的碎片和元数据更新
+            LARGE_INTEGER size;
+            size.QuadPart = static_cast<LONGLONG>(entry.uncompressedSize);
+            ok = SetFilePointerEx(hOut, size, NULL, FILE_BEGIN) && SetEndOfFile(hOut);
+
+            HANDLE hOutMapping = NULL;
+            uint8_t* outView = nullptr;
+            if (ok) {
+                hOutMapping = CreateFileMappingW(hOut, NULL, PAGE_READWRITE, 0, 0, NULL);
+                outView = hOutMapping ? static_cast<uint8_t*>(MapViewOfFile(hOutMapping, FILE_MAP_WRITE, 0, 0, 0)) : nullptr;
+                ok = outView != nullptr;
+            }
+
+            if (ok) {
+                size_t outSize = static_cast<size_t>(entry.uncompressedSize);
+                if (entry.method == 0) {
+                    memcpy(outView, data, outSize);
+                }
+                else {
+                    size_t written = 0;
+                    ok = Compression::Inflate(data, static_cast<size_t>(entry.compressedSize), outView, outSize, &written) && written == outSize;
+                }
+                ok = ok && Compression::Crc32(outView, outSize) == entry.crc32;
+            }
+
+            if (outView) UnmapViewOfFile(outView);
+            if (hOutMapping) CloseHandle(hOutMapping);
+        }
+        else {
+            ok = entry.crc32 == 0;
+        }
+        CloseHandle(hOut);
+
+        if (!ok) {
+            LOG_ERROR(L"Failed to extract ZIP entry (corrupt data or I/O error): ", Utf8ToWide(entry.name).c_str());
+            DeleteFileW(outputPath.c_str());
+        }
+        return ok;
+    }
+
+
+    // 小文件合并成批再提交，避免每个几 KB 的条目都付出一次调度开销
+    static const uint64_t kMinBatchBytes = 1024 * 1024;
+
+    bool ExtractZip(
+        const std::wstring& zipPath,
+        const std::wstring& stagingDir,
+        ThreadPool* pool,
+        std::function<void(long long, long long)> progressCallback,
+        const CancellationToken& cancellation)
+    {
+        ZipReader reader;
+        if (!reader.Open(zipPath)) {
+            return false;
+        }
+        const std::vector<ZipEntry>& entries = reader.GetEntries();
+
+        // 1. 先顺序创建全部目录，并行阶段只写文件
+        std::set<std::wstring> directories;
+        directories.insert(stagingDir);
+        std::vector<const ZipEntry*> files;
+        long long totalBytes = 0;
+        for (const ZipEntry& entry : entries) {
+            std::wstring path = EntryPath(stagingDir, entry.name);
+            if (entry.isDirectory) {
+                directories.insert(path);
+                continue;
+            }
+            directories.insert(path.substr(0, path.find_last_of(L'\\')));
+            files.push_back(&entry);
+            totalBytes += static_cast<long long>(entry.uncompressedSize);
+        }
+        for (const std::wstring& dir : directories) {
+            if (!DirectoryExists(dir) && !CreateDirectoryRecursive(dir)) {
+                LOG_ERROR(L"Failed to create staging directory: ", dir.c_str());
+                return false;
+            }
+        }
+
+        // 2. 大条目优先调度，使最后完成的都是小任务，减少尾部等待
+        std::sort(files.begin(), files.end(), [](const ZipEntry* a, const ZipEntry* b) {
+            return a->uncompressedSize > b->uncompressedSize;
+        });
+
+        std::vector<std::vector<const ZipEntry*>> batches;
+        uint64_t batchBytes = kMinBatchBytes;
+        for (const ZipEntry* entry : files) {
+            if (batchBytes >= kMinBatchBytes) {
+                batches.emplace_back();
+                batchBytes = 0;
+            }
+            batches.back().push_back(entry);
+            batchBytes += entry->uncompressedSize;
+        }
+
+        LOG_INFO(L"Extracting ", files.size(), L" files (", totalBytes, L" bytes) in ", batches.size(), L" batches to: ", stagingDir.c_str());
+
+        std::atomic<long long> extractedBytes(0);
+        auto extractBatch = [&reader, &stagingDir, &extractedBytes](const std::vector<const ZipEntry*>& batch, const CancellationToken& token) {
+            for (const ZipEntry* entry : batch) {
+                if (token.IsCancellationRequested()) {
+                    return false;
+                }
+                if (!reader.ExtractEntry(*entry, EntryPath(stagingDir, entry->name))) {
+                    return false;
+                }
+                extractedBytes += static_cast<long long>(entry->uncompressedSize);
+            }
+            return true;
+        };
+
+        // 3. 并行解压。子任务引用栈上的 reader 和 batches，用任务组保证函数返回前它们全部结束：
+        //    提交失败 (线程池关闭、队列已满) 的批次由 Wait 在当前线程执行；任一批次失败时取消其余批次
+        bool allOk = true;
+        if (progressCallback) {
+            progressCallback(0, totalBytes);
+        }
+        if (pool) {
+            std::mutex progressMutex;
+            TaskOptions options;
+            options.cancellation = cancellation;
+            options.tag = "zip-extract";
+            TaskGroup group(*pool, options);
+            for (const auto& batch : batches) {
+                group.Spawn([&, &batch](const CancellationToken& token) {
+                    if (!extractBatch(batch, token)) {
+                        throw std::runtime_error("ZIP entry extraction failed");
+                    }
+                    if (progressCallback) {
+                        std::lock_guard<std::mutex> lock(progressMutex);
+                        progressCallback(extractedBytes.load(), totalBytes);
+                    }
+                });
+            }
+            try {
+                group.Wait();
+            }
+            catch (const std::exception& e) {
+                if (!cancellation.IsCancellationRequested()) {
+                    LOG_ERROR(L"ZIP extraction stopped: ", Utf8ToWide(e.what()).c_str());
+                }
+                allOk = false;
+            }
+        }
+        else {
+            for (const auto& batch : batches) {
+                allOk = extractBatch(batch, cancellation) && allOk;
+                if (progressCallback) {
+                    progressCallback(extractedBytes.load(), totalBytes);
+                }
+            }
+        }
+
+        if (cancellation.IsCancellationRequested()) {
+            LOG_INFO(L"ZIP extraction canceled: ", zipPath.c_str());
+            return false;
+        }
+        if (!allOk) {
+            LOG_ERROR(L"ZIP extraction failed: ", zipPath.c_str());
+            return false;
+        }
+        LOG_INFO(L"ZIP extraction complete: ", zipPath.c_str());
+        return true;
+    }
+
+} // namespace Archive
@@ -0,0 +1,96 @@
+#ifndef ZIP_ARCHIVE_H
+#define ZIP_ARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional> // For std::function (progress callback)
+
+#include "cancellation.h"
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+class ThreadPool;
+
+namespace Archive {
+
+    struct ZipEntry {
+        std::string name;                // 条目名 (UTF-8，'/' 分隔)
+        uint16_t method = 0;             // 0 = 存储, 8 = DEFLATE
+        uint32_t crc32 = 0;
+        uint64_t compressedSize = 0;
+        uint64_t uncompressedSize = 0;
+        uint64_t localHeaderOffset = 0;
+        bool isDirectory = false;
+    };
+
+    // 通过内存映射读取 ZIP 文件：中央目录直接在映射视图上解析，
+    // 条目数据也从视图解压，不需要额外的读缓冲。
+    // Open 之后对象只读，可被多个线程同时调用 ExtractEntry。
+    class ZipReader {
+    public:
+        ZipReader();
+        ~ZipReader();
+
+        // 禁止拷贝和赋值
+        ZipReader(const ZipReader&) = delete;
+        ZipReader& operator=(const ZipReader&) = delete;
+
+        /**
+         * @brief 映射 ZIP 文件并解析中央目录 (支持 Zip64)。
+         * @param zipPath ZIP 文件路径。
+         * @return 成功返回 true。
+         */
+        bool Open(const std::wstring& zipPath);
+
+        /**
+         * @brief 解除映射并关闭文件。
+         */
+        void Close();
+
+        const std::vector<ZipEntry>& GetEntries() const { return m_entries; }
+
+        /**
+         * @brief 解压单个条目到指定路径。
+         * @param entry 要解压的条目。
+         * @param outputPath 输出文件路径 (父目录须已存在)。
+         * @return 解压成功且 CRC 校验通过返回 true。
+         * @note 输出文件先按解压后大小预分配，再映射后直接解压到映射视图中。
+         */
+        bool ExtractEntry(const ZipEntry& entry, const std::wstring& outputPath) const;
+
+    private:
+        bool ReadCentralDirectory();
+        const uint8_t* GetEntryData(const ZipEntry& entry) const;
+
+        HANDLE m_hFile;
+        HANDLE m_hMapping;
+        const uint8_t* m_view;
+        uint64_t m_size;
+        std::vector<ZipEntry> m_entries;
+    };
+
+    /**
+     * @brief 并行解压 ZIP 更新包到暂存目录。
+     * @param zipPath ZIP 文件路径。
+     * @param stagingDir 暂存目录 (不存在则创建)。
+     * @param pool 用于并行解压的线程池 (为空则在当前线程顺序解压)。
+     * @param progressCallback 进度回调 (已解压字节数, 总字节数)。
+     * @param cancellation 取消令牌 (可选)：取消后不再解压新的条目并返回 false。
+     * @return 全部条目解压成功返回 true。
+     * @note 条目名中包含绝对路径或 ".." 的包会被拒绝。
+     */
+    bool ExtractZip(
+        const std::wstring& zipPath,
+        const std::wstring& stagingDir,
+        ThreadPool* pool,
+        std::function<void(long long, long long)> progressCallback = nullptr,
+        const CancellationToken& cancellation = CancellationToken()
+    );
+
+} // namespace Archive
+
+#endif // ZIP_ARCHIVE_H